@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+"""
+Convert an ASPECT ascii data file (as read by the 'ascii data' plugins)
+into the equivalent binary file, which ASPECT can memory-map instead of
+parsing it at startup. The binary format is described in the
+documentation of the class aspect::Utilities::AsciiDataLookup.
+
+Usage: ascii_data_to_binary.py dim input.txt output.bin
+
+The binary file is written in the byte order of the machine this script
+runs on, which has to be the same as the one of the machine ASPECT runs
+on.
+"""
+
+import array
+import struct
+import sys
+
+
+def convert(dim, input_name, output_name):
+    points = None
+    names = []
+    numbers = array.array('d')
+
+    with open(input_name) as input_file:
+        for line in input_file:
+            if line.startswith('#'):
+                words = line[1:].split()
+                if 'POINTS:' in words:
+                    index = words.index('POINTS:')
+                    points = [int(n) for n in words[index+1:index+1+dim]]
+                continue
+
+            words = line.split()
+            if not words:
+                continue
+
+            try:
+                numbers.extend(float(w) for w in words)
+            except ValueError:
+                if names or numbers:
+                    raise
+                # the optional line with the column names
+                names = [w.lower() for w in words[dim:]]
+
+    if points is None or len(points) != dim:
+        sys.exit("Could not find a '# POINTS:' header with %d entries in %s."
+                 % (dim, input_name))
+
+    n_points = 1
+    for n in points:
+        n_points *= n
+
+    if len(numbers) % n_points != 0 or len(numbers) // n_points <= dim:
+        sys.exit("The number of values in %s does not match the POINTS header."
+                 % input_name)
+    n_columns = len(numbers) // n_points
+    n_components = n_columns - dim
+
+    if names and len(names) != n_components:
+        sys.exit("The number of column names in %s does not match the number "
+                 "of data columns." % input_name)
+
+    # coordinates along each axis, and the data one component after the other
+    coordinates = array.array('d')
+    stride = 1
+    for d in range(dim):
+        coordinates.extend(numbers[i * stride * n_columns + d]
+                           for i in range(points[d]))
+        stride *= points[d]
+
+    extrema = array.array('d')
+    values = array.array('d')
+    for c in range(n_components):
+        component = numbers[dim + c::n_columns]
+        extrema.extend([min(component), max(component)])
+        values.extend(component)
+
+    name_block = ''.join(name + '\n' for name in names).encode('ascii')
+    name_block += b'\0' * (-len(name_block) % 8)
+
+    all_points = points + [1] * (3 - dim)
+    header = b'ASPECTBD' + struct.pack('=7Q', 1, dim, n_components,
+                                       all_points[0], all_points[1],
+                                       all_points[2], len(name_block))
+
+    with open(output_name, 'wb') as output_file:
+        output_file.write(header)
+        output_file.write(name_block)
+        extrema.tofile(output_file)
+        coordinates.tofile(output_file)
+        values.tofile(output_file)
+
+
+if __name__ == '__main__':
+    if len(sys.argv) != 4:
+        sys.exit(__doc__)
+    convert(int(sys.argv[1]), sys.argv[2], sys.argv[3])
@@ -27,7 +27,10 @@
 #include <aspect/compat.h>
 
 #include <array>
+#include <exception>
 #include <deal.II/base/function_lib.h>
+#include <deal.II/base/table.h>
+#include <deal.II/base/thread_management.h>
 
 
 namespace aspect
@@ -63,11 +66,33 @@ namespace aspect
 
           /**
            * Loads a gplates .gpml velocity file. Throws an exception if the
-           * file does not exist.
+           * file does not exist. The file is read and parsed by the first
+           * process of @p comm, which then sends the velocity tables to the
+           * other processes.
            */
           void load_file(const std::string &filename,
                          const MPI_Comm &comm);
 
+          /**
+           * The first of the two parts of load_file(): Read and parse a
+           * gplates .gpml velocity file on the current process only, if
+           * @p read_file_content is true, and keep the velocity tables until
+           * distribute_file() is called. This function does not communicate
+           * and does not throw (errors are reported by distribute_file()),
+           * so it can run on a separate thread while the velocities that
+           * are currently loaded are in use.
+           */
+          void read_file(const std::string &filename,
+                         const bool read_file_content);
+
+          /**
+           * The second of the two parts of load_file(): Send the velocity
+           * tables read by read_file() on the first process of @p comm to
+           * all other processes, and use them for surface_velocity().
+           * Throws an exception on all processes if reading the file failed.
+           */
+          void distribute_file(const MPI_Comm &comm);
+
           /**
            * Returns the computed surface velocity in cartesian coordinates.
            * Takes as input the position. Actual velocity interpolation is
@@ -83,6 +108,14 @@ namespace aspect
            */
           std::array<std::unique_ptr<typename Functions::InterpolatedUniformGridData<2> >, 2> velocities;
 
+          /**
+           * The velocity tables (for the theta and the phi component) read by
+           * read_file() that are not yet used by @p velocities, and any error
+           * that happened while reading them.
+           */
+          std::array<Table<2,double>, 2> read_velocity_values;
+          std::exception_ptr read_file_exception;
+
           /**
            * Distances between adjacent point in the Lat/Long grid
            */
@@ -183,6 +216,12 @@ namespace aspect
          */
         GPlates ();
 
+        /**
+         * Destructor. Waits for the velocity file that is read in the
+         * background, if any.
+         */
+        ~GPlates ();
+
         /**
          * Return the boundary velocity as a function of position. For the
          * current class, this function returns value from gplates.
@@ -207,7 +246,8 @@ namespace aspect
          * A function that is called at the beginning of each time step. For
          * the current plugin, this function loads the next velocity files if
          * necessary and outputs a warning if the end of the set of velocity
-         * files is reached.
+         * files is reached. The velocity file after the next one is read on
+         * a background thread while the model time is between two files.
          */
         virtual
         void
@@ -329,6 +369,31 @@ namespace aspect
          */
         std::shared_ptr<internal::GPlatesLookup<dim> > old_lookup;
 
+        /**
+         * Pointer to an object into which the velocity file after the one in
+         * lookup is read in the background.
+         */
+        std::shared_ptr<internal::GPlatesLookup<dim> > next_lookup;
+
+        /**
+         * The thread that reads a velocity file into next_lookup.
+         */
+        Threads::Thread<void> prefetch_thread;
+
+        /**
+         * Whether a velocity file is read (or has been read) into
+         * next_lookup, and its number.
+         */
+        bool next_file_prefetched;
+        int prefetched_file_number;
+
+        /**
+         * Start reading the velocity file with number @p file_number into
+         * next_lookup on a background thread, if the file exists.
+         */
+        void
+        prefetch_file (const int file_number);
+
         /**
          * Handles the update of the velocity data in lookup. The input
          * parameter makes sure that both velocity files (n and n+1) can be
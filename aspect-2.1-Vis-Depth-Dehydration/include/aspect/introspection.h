@@ -233,6 +233,29 @@ namespace aspect
        */
       const ComponentMasks component_masks;
 
+      /**
+       * The indices of the shape functions of the finite element that belong
+       * to the Stokes system (i.e., to the velocity and pressure components,
+       * see is_stokes_component()), in increasing order. Entry @p i_stokes of
+       * this vector is the index among all shape functions of a cell that
+       * corresponds to the <code>i_stokes</code>th Stokes degree of freedom
+       * of the cell, which is the numbering the Stokes assemblers use for
+       * their local matrices and vectors.
+       *
+       * This vector, as well as stokes_shape_function_components, only
+       * depends on the finite element and is filled by
+       * Simulator::setup_introspection(). Using it avoids having to call
+       * FiniteElement::system_to_component_index() for every shape function
+       * on every cell and every quadrature point during assembly.
+       */
+      std::vector<unsigned int> stokes_shape_function_indices;
+
+      /**
+       * The vector component of each of the shape functions listed in
+       * stokes_shape_function_indices.
+       */
+      std::vector<unsigned int> stokes_shape_function_components;
+
       /**
        * @}
        */
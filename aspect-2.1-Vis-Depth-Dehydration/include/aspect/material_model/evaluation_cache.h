@@ -0,0 +1,170 @@
+/*
+  Copyright (C) 2019 by the authors of the ASPECT code.
+
+  This file is part of ASPECT.
+
+  ASPECT is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2, or (at your option)
+  any later version.
+
+  ASPECT is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with ASPECT; see the file LICENSE.  If not see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _aspect_material_model_evaluation_cache_h
+#define _aspect_material_model_evaluation_cache_h
+
+#include <aspect/global.h>
+#include <aspect/material_model/interface.h>
+
+#include <mutex>
+#include <vector>
+
+namespace aspect
+{
+  namespace MaterialModel
+  {
+    using namespace dealii;
+
+    /**
+     * A cache for the results of MaterialModel::Interface::evaluate().
+     *
+     * Within one time step, the material model is typically evaluated on the
+     * same cells and quadrature points several times: in the assembly of the
+     * Stokes system and of the advection systems, when computing the time
+     * step size, and in many postprocessors. For expensive material models,
+     * these repeated evaluations can make up a significant fraction of the
+     * run time. This class stores the outputs of recent evaluations for each
+     * cell and returns them if the material model is asked for the same
+     * inputs again.
+     *
+     * Entries are keyed by the active cell index of
+     * MaterialModelInputs::current_cell. An entry is only reused if the
+     * time step number and the nonlinear iteration are the same as when it
+     * was stored, and if all inputs (positions, which identify the
+     * quadrature rule, temperature, pressure, pressure gradient, velocity,
+     * compositional fields, and strain rate if present) are bitwise
+     * identical. The latter means that two evaluations on the same solution
+     * vector and the same quadrature rule share their results, while any
+     * change of the solution or linearization point automatically leads to
+     * a new evaluation. Evaluations that use additional inputs or request
+     * additional outputs, or that are not associated with a cell, are never
+     * cached.
+     *
+     * The cache has to be reinitialized with reinit() whenever the mesh
+     * changes. It is safe to call evaluate() from several threads at the
+     * same time, also for the same cell.
+     *
+     * @ingroup MaterialModels
+     */
+    template <int dim>
+    class EvaluationCache
+    {
+      public:
+        /**
+         * Constructor. @p max_entries_per_cell is the number of different
+         * evaluations (for example, with different quadrature rules) that
+         * are kept for each cell.
+         */
+        EvaluationCache (const unsigned int max_entries_per_cell = 4);
+
+        /**
+         * Remove all stored results and prepare the cache for a mesh with
+         * @p n_active_cells active cells. This does not reset the counters
+         * returned by get_statistics().
+         */
+        void reinit (const unsigned int n_active_cells);
+
+        /**
+         * Fill @p out with the material properties for the inputs @p in,
+         * either from a previous evaluation of @p material_model with the
+         * same inputs in the same time step and nonlinear iteration, or
+         * by calling @p material_model.evaluate() and storing the result.
+         */
+        void evaluate (const Interface<dim>            &material_model,
+                       const MaterialModelInputs<dim>  &in,
+                       MaterialModelOutputs<dim>       &out,
+                       const unsigned int               timestep_number,
+                       const unsigned int               nonlinear_iteration);
+
+        /**
+         * Return the number of calls to evaluate() since the last call to
+         * reset_statistics() that could be served from the cache, and the
+         * number of calls that had to evaluate the material model. Calls
+         * that bypass the cache are not counted.
+         */
+        std::pair<unsigned long int, unsigned long int>
+        get_statistics () const;
+
+        /**
+         * Set the counters returned by get_statistics() to zero.
+         */
+        void reset_statistics ();
+
+      private:
+        /**
+         * The result of one evaluation of the material model, together with
+         * the data that identifies the evaluation.
+         */
+        struct Entry
+        {
+          Entry ();
+
+          unsigned int timestep_number;
+          unsigned int nonlinear_iteration;
+
+          /**
+           * All inputs of the evaluation, written one after the other into
+           * a single vector, see pack_inputs().
+           */
+          std::vector<double> inputs;
+
+          MaterialModelOutputs<dim> outputs;
+        };
+
+        /**
+         * Write all inputs that influence the evaluation of the material
+         * model into a single vector, including the sizes of the individual
+         * input arrays.
+         */
+        static void pack_inputs (const MaterialModelInputs<dim> &in,
+                                 std::vector<double> &packed_inputs);
+
+        /**
+         * Copy the material properties (but not the additional outputs)
+         * from @p source to @p destination.
+         */
+        static void copy_outputs (const MaterialModelOutputs<dim> &source,
+                                  MaterialModelOutputs<dim> &destination);
+
+        const unsigned int max_entries_per_cell;
+
+        /**
+         * The stored entries, indexed by the active cell index.
+         */
+        std::vector<std::vector<Entry> > entries;
+
+        /**
+         * Mutexes that guard the entries. The entries of a cell are guarded
+         * by the mutex with the index active_cell_index % n_mutexes.
+         */
+        static const unsigned int n_mutexes = 64;
+        std::mutex mutexes[n_mutexes];
+
+        /**
+         * Counters for the statistics, guarded by the mutexes of the cells.
+         */
+        std::vector<unsigned long int> n_hits;
+        std::vector<unsigned long int> n_misses;
+    };
+  }
+}
+
+#endif
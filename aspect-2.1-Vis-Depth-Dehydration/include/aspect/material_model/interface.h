@@ -36,6 +36,8 @@
 #include <deal.II/fe/component_mask.h>
 #include <deal.II/numerics/data_postprocessor.h>
 #include <deal.II/base/signaling_nan.h>
+#include <deal.II/base/aligned_vector.h>
+#include <deal.II/base/vectorization.h>
 
 namespace aspect
 {
@@ -491,6 +493,109 @@ namespace aspect
     };
 
 
+    /**
+     * A structure-of-arrays version of the scalar inputs in
+     * MaterialModelInputs, used by material models that implement
+     * Interface::evaluate_batch(). The values of all evaluation points are
+     * stored contiguously in batches of VectorizedArray<double>, so that a
+     * material model can evaluate its formulas for several points at once
+     * using the SIMD instructions of the processor.
+     *
+     * If the number of points is not a multiple of the SIMD width, the
+     * unused lanes of the last batch are filled with the values of the last
+     * point. This way, all lanes hold physically meaningful values and the
+     * evaluation does not divide by zero or take the logarithm of zero in
+     * lanes whose results are later discarded.
+     */
+    template <int dim>
+    struct MaterialModelBatchInputs
+    {
+      /**
+       * Constructor. Copy the temperature, pressure, and compositional
+       * fields of all points in @p in into batches, and compute the square
+       * root of the absolute value of the second invariant of the deviatoric
+       * strain rate if @p in contains strain rates.
+       */
+      MaterialModelBatchInputs (const MaterialModelInputs<dim> &in);
+
+      /**
+       * The number of evaluation points stored in this object.
+       */
+      unsigned int n_points;
+
+      /**
+       * The number of batches, i.e., the number of points divided by the
+       * SIMD width and rounded up.
+       */
+      unsigned int n_batches;
+
+      /**
+       * Temperature and pressure at the evaluation points, one entry per
+       * batch.
+       */
+      AlignedVector<VectorizedArray<double> > temperature;
+      AlignedVector<VectorizedArray<double> > pressure;
+
+      /**
+       * Values of the compositional fields at the evaluation points. The
+       * outer index runs over the compositional fields and the inner index
+       * over the batches.
+       */
+      std::vector<AlignedVector<VectorizedArray<double> > > composition;
+
+      /**
+       * The square root of the absolute value of the second invariant of the
+       * deviatoric strain rate, $\sqrt{|II(\varepsilon(\mathbf u)^{dev})|}$,
+       * at the evaluation points. Empty if the viscosity does not need to be
+       * computed, i.e., if MaterialModelInputs::strain_rate is empty.
+       */
+      AlignedVector<VectorizedArray<double> > strain_rate_invariant;
+    };
+
+
+
+    /**
+     * A structure-of-arrays version of the scalar outputs in
+     * MaterialModelOutputs, filled by Interface::evaluate_batch(). The
+     * layout of the arrays matches the one of MaterialModelBatchInputs.
+     */
+    template <int dim>
+    struct MaterialModelBatchOutputs
+    {
+      /**
+       * Constructor. Allocate the arrays for the points in @p in.
+       */
+      MaterialModelBatchOutputs (const MaterialModelBatchInputs<dim> &in);
+
+      /**
+       * Copy the values of all valid lanes into the corresponding members of
+       * @p out. The viscosity is only copied if @p copy_viscosities is true.
+       * Reaction terms and additional outputs are not touched, and have to
+       * be filled separately by the material model.
+       */
+      void unpack (MaterialModelOutputs<dim> &out,
+                   const bool copy_viscosities) const;
+
+      /**
+       * The number of evaluation points, as in MaterialModelBatchInputs.
+       */
+      unsigned int n_points;
+
+      /**
+       * The material properties at the evaluation points. See the members
+       * of MaterialModelOutputs with the same names for their meaning.
+       */
+      AlignedVector<VectorizedArray<double> > viscosities;
+      AlignedVector<VectorizedArray<double> > densities;
+      AlignedVector<VectorizedArray<double> > thermal_expansion_coefficients;
+      AlignedVector<VectorizedArray<double> > specific_heat;
+      AlignedVector<VectorizedArray<double> > thermal_conductivities;
+      AlignedVector<VectorizedArray<double> > compressibilities;
+      AlignedVector<VectorizedArray<double> > entropy_derivative_pressure;
+      AlignedVector<VectorizedArray<double> > entropy_derivative_temperature;
+    };
+
+
     /**
      * A namespace in which we define how material model outputs should be
      * averaged on each cell.
@@ -1034,6 +1139,33 @@ namespace aspect
         virtual
         void evaluate (const MaterialModel::MaterialModelInputs<dim> &in,
                        MaterialModel::MaterialModelOutputs<dim> &out) const = 0;
+
+        /**
+         * Return whether this material model implements evaluate_batch(). The
+         * default implementation returns false.
+         */
+        virtual
+        bool supports_batched_evaluation () const;
+
+        /**
+         * Function to compute the scalar material properties for a whole set
+         * of points at once, stored as a structure of arrays so that the
+         * computations can use SIMD instructions. If
+         * MaterialModelBatchInputs::strain_rate_invariant is empty, the
+         * viscosity does not need to be computed.
+         *
+         * Material models that implement this function typically call it
+         * from their evaluate() function after converting the inputs with
+         * the constructor of MaterialModelBatchInputs, and keep their
+         * point-by-point implementation only for the cases the batched
+         * version does not cover (for example, additional outputs). Models
+         * that do not implement this function are only ever evaluated through
+         * evaluate(); the default implementation throws an exception.
+         */
+        virtual
+        void evaluate_batch (const MaterialModel::MaterialModelBatchInputs<dim> &in,
+                             MaterialModel::MaterialModelBatchOutputs<dim> &out) const;
+
         /**
          * @name Functions used in dealing with run-time parameters
          * @{
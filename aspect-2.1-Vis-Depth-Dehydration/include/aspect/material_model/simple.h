@@ -44,9 +44,26 @@ namespace aspect
     class Simple : public MaterialModel::Interface<dim>, public ::aspect::SimulatorAccess<dim>
     {
       public:
+        /**
+         * Evaluate the material model. This function converts the inputs
+         * into batches and calls evaluate_batch().
+         */
         virtual void evaluate(const MaterialModel::MaterialModelInputs<dim> &in,
                               MaterialModel::MaterialModelOutputs<dim> &out) const;
 
+        /**
+         * This model implements evaluate_batch().
+         */
+        virtual bool supports_batched_evaluation () const;
+
+        /**
+         * Evaluate the material model for batches of points at once. The
+         * viscosity is always computed, independent of whether strain rates
+         * are provided, since it does not depend on them.
+         */
+        virtual void evaluate_batch(const MaterialModel::MaterialModelBatchInputs<dim> &in,
+                                    MaterialModel::MaterialModelBatchOutputs<dim> &out) const;
+
         /**
          * @name Qualitative properties one can ask a material model
          * @{
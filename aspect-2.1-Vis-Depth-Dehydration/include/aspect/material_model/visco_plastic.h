@@ -128,6 +128,23 @@ namespace aspect
         virtual void evaluate(const MaterialModel::MaterialModelInputs<dim> &in,
                               MaterialModel::MaterialModelOutputs<dim> &out) const;
 
+        /**
+         * Return whether evaluate_batch() can be used, which is the case
+         * if no strain weakening is used.
+         */
+        virtual bool supports_batched_evaluation () const;
+
+        /**
+         * Evaluate the material model for batches of points at once. This
+         * computes the same quantities as evaluate() for models without
+         * strain weakening. evaluate() calls this function unless viscosity
+         * derivatives or plastic additional outputs are requested, or the
+         * thermal conductivity has to be computed from the reference density
+         * profile, which all require information per point.
+         */
+        virtual void evaluate_batch(const MaterialModel::MaterialModelBatchInputs<dim> &in,
+                                    MaterialModel::MaterialModelBatchOutputs<dim> &out) const;
+
         /**
          * Return whether the model is compressible or not.  Incompressibility
          * does not necessarily imply that the density is constant; rather, it
@@ -53,6 +53,14 @@ namespace aspect
         void
         execute (Vector<float> &error_indicators) const;
 
+        /**
+         * Request the Kelly error indicators of all compositional fields, which
+         * execute() combines into the refinement indicators.
+         */
+        virtual
+        std::set<unsigned int>
+        required_kelly_error_indicators () const;
+
         /**
          * Declare the parameters this class takes through input files.
          */
@@ -26,7 +26,9 @@
 #include <aspect/plugins.h>
 #include <aspect/simulator_access.h>
 
+#include <map>
 #include <memory>
+#include <set>
 #include <deal.II/base/table_handler.h>
 #include <deal.II/base/parameter_handler.h>
 #include <deal.II/distributed/tria.h>
@@ -128,6 +130,24 @@ namespace aspect
         void
         tag_additional_cells () const;
 
+        /**
+         * Return the indices of the advection fields (zero for the
+         * temperature, and <code>c+1</code> for compositional field
+         * <code>c</code>, as returned by
+         * Simulator::AdvectionField::field_index()) whose Kelly error
+         * indicators this plugin obtains through
+         * Manager::get_kelly_error_indicators() in execute(). The manager
+         * computes the indicators of all fields requested by all active
+         * plugins before it executes them, in as few sweeps over the faces
+         * of the mesh as possible. Each sweep handles up to three fields of
+         * the same polynomial degree, and needs one temporary copy of the
+         * solution vector per field if it handles more than one. The
+         * default implementation returns an empty set.
+         */
+        virtual
+        std::set<unsigned int>
+        required_kelly_error_indicators () const;
+
         /**
          * Declare the parameters this class takes through input files.
          * Derived classes should overload this function if they actually do
@@ -206,6 +226,19 @@ namespace aspect
         void
         tag_additional_cells () const;
 
+        /**
+         * Return the Kelly error indicators of the advection field with index
+         * @p field_index (zero for the temperature, and <code>c+1</code> for
+         * compositional field <code>c</code>), one for each active cell.
+         * While execute() runs, this returns the indicators that execute()
+         * computed for all fields requested through
+         * Interface::required_kelly_error_indicators(). Otherwise, or if the
+         * field was not requested, the indicators are computed for this
+         * field alone.
+         */
+        Vector<float>
+        get_kelly_error_indicators (const unsigned int field_index) const;
+
         /**
          * Declare the parameters of all known mesh refinement plugins, as
          * well as of ones this class has itself.
@@ -319,6 +352,24 @@ namespace aspect
          * parameter file.
          */
         std::list<std::unique_ptr<Interface<dim> > > mesh_refinement_objects;
+
+        /**
+         * The Kelly error indicators of the advection fields requested by the
+         * active plugins, indexed by the field index. These are only stored
+         * while execute() runs.
+         */
+        mutable std::map<unsigned int, Vector<float> > kelly_error_indicators;
+
+        /**
+         * Compute the Kelly error indicators of the advection fields with the
+         * given indices, and store them in kelly_error_indicators. Fields
+         * with the same polynomial degree are estimated together in sweeps
+         * over at most three fields. Each sweep gives the estimator one
+         * copy of the solution per field, in which all other fields are
+         * zero. The copies are reused from one sweep to the next.
+         */
+        void
+        compute_kelly_error_indicators (const std::set<unsigned int> &field_indices) const;
     };
 
 
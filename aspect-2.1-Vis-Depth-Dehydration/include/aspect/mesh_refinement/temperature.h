@@ -52,6 +52,14 @@ namespace aspect
         virtual
         void
         execute (Vector<float> &error_indicators) const;
+
+        /**
+         * Request the Kelly error indicators of the temperature field, which
+         * execute() combines into the refinement indicators.
+         */
+        virtual
+        std::set<unsigned int>
+        required_kelly_error_indicators () const;
     };
   }
 }
@@ -75,6 +75,140 @@ namespace aspect
       };
     };
 
+    /**
+     * A structure that contains enum values that identify the linear
+     * solver that is used for the Stokes system.
+     */
+    struct StokesSolverType
+    {
+      enum Kind
+      {
+        block_amg,
+        direct_solver,
+        block_gmg
+      };
+
+      /**
+       * This function translates an input string into the
+       * available enum options.
+       */
+      static
+      Kind
+      parse(const std::string &input)
+      {
+        if (input == "block AMG")
+          return StokesSolverType::block_amg;
+        else if (input == "direct solver")
+          return StokesSolverType::direct_solver;
+        else if (input == "block GMG")
+          return StokesSolverType::block_gmg;
+        else
+          AssertThrow(false, ExcNotImplemented());
+
+        return StokesSolverType::Kind();
+      }
+    };
+
+    /**
+     * A structure that contains enum values that identify how the AMG
+     * preconditioner of the Stokes system is treated when it has to be
+     * rebuilt after the Stokes matrix changed.
+     */
+    struct AMGReusePolicy
+    {
+      enum Kind
+      {
+        never,
+        reuse_hierarchy,
+        reuse_preconditioner
+      };
+
+      /**
+       * This function translates an input string into the
+       * available enum options.
+       */
+      static
+      Kind
+      parse(const std::string &input)
+      {
+        if (input == "never")
+          return AMGReusePolicy::never;
+        else if (input == "reuse hierarchy")
+          return AMGReusePolicy::reuse_hierarchy;
+        else if (input == "reuse preconditioner")
+          return AMGReusePolicy::reuse_preconditioner;
+        else
+          AssertThrow(false, ExcNotImplemented());
+
+        return AMGReusePolicy::Kind();
+      }
+    };
+
+    /**
+     * This enum represents the different choices for deciding whether a
+     * Stokes solve starts with the cheap or with the expensive solver
+     * phase. See the corresponding entries in the parameter file for more
+     * information.
+     */
+    struct StokesSolverPhaseSelection
+    {
+      enum Kind
+      {
+        fixed,
+        automatic
+      };
+
+      /**
+       * This function translates an input string into the
+       * available enum options.
+       */
+      static
+      Kind
+      parse(const std::string &input)
+      {
+        if (input == "fixed")
+          return StokesSolverPhaseSelection::fixed;
+        else if (input == "automatic")
+          return StokesSolverPhaseSelection::automatic;
+        else
+          AssertThrow(false, ExcNotImplemented());
+
+        return StokesSolverPhaseSelection::Kind();
+      }
+    };
+
+    /**
+     * This enum represents the different choices for the time integration
+     * of the reactions in the operator splitting solver scheme. See the
+     * corresponding entries in the parameter file for more information.
+     */
+    struct ReactionSolverType
+    {
+      enum Kind
+      {
+        forward_euler,
+        adaptive_runge_kutta
+      };
+
+      /**
+       * This function translates an input string into the
+       * available enum options.
+       */
+      static
+      Kind
+      parse(const std::string &input)
+      {
+        if (input == "forward euler")
+          return ReactionSolverType::forward_euler;
+        else if (input == "adaptive runge kutta")
+          return ReactionSolverType::adaptive_runge_kutta;
+        else
+          AssertThrow(false, ExcNotImplemented());
+
+        return ReactionSolverType::Kind();
+      }
+    };
+
     /**
      * @brief The NullspaceRemoval struct
      */
@@ -328,6 +462,7 @@ namespace aspect
     bool                           use_conduction_timestep;
     bool                           convert_to_years;
     std::string                    output_directory;
+    bool                           append_to_output_files;
     double                         surface_pressure;
     double                         adiabatic_surface_temperature;
     unsigned int                   timing_output_frequency;
@@ -348,10 +483,13 @@ namespace aspect
     double                         composition_solver_tolerance;
 
     // subsection: Stokes parameters
+    typename StokesSolverType::Kind stokes_solver_type;
     bool                           use_direct_stokes_solver;
     double                         linear_stokes_solver_tolerance;
     unsigned int                   n_cheap_stokes_solver_steps;
     unsigned int                   n_expensive_stokes_solver_steps;
+    typename StokesSolverPhaseSelection::Kind stokes_solver_phase_selection;
+    bool                           keep_stokes_krylov_space_between_phases;
     double                         linear_solver_A_block_tolerance;
     bool                           use_full_A_block_preconditioner;
     double                         linear_solver_S_block_tolerance;
@@ -362,10 +500,16 @@ namespace aspect
     unsigned int                   AMG_smoother_sweeps;
     double                         AMG_aggregation_threshold;
     bool                           AMG_output_details;
+    typename AMGReusePolicy::Kind  AMG_reuse_policy;
+    double                         AMG_reuse_viscosity_change_threshold;
+    unsigned int                   AMG_reuse_iteration_threshold;
 
     // subsection: Operator splitting parameters
     double                         reaction_time_step;
     unsigned int                   reaction_steps_per_advection_step;
+    typename ReactionSolverType::Kind reaction_solver_type;
+    double                         reaction_solver_relative_tolerance;
+    double                         reaction_solver_absolute_tolerance;
 
     // subsection: Diffusion solver parameters
     double                         diffusion_length_scale;
@@ -453,6 +597,8 @@ namespace aspect
     double                         refinement_fraction;
     double                         coarsening_fraction;
     bool                           adapt_by_fraction_of_cells;
+    bool                           use_measured_cell_costs;
+    double                         measured_cell_cost_weight;
     unsigned int                   min_grid_level;
     std::vector<double>            additional_refinement_times;
     unsigned int                   adaptive_refinement_interval;
@@ -490,6 +636,8 @@ namespace aspect
      */
     int                            checkpoint_time_secs;
     int                            checkpoint_steps;
+    bool                           checkpoint_in_background;
+    int                            checkpoint_compression_level;
     /**
      * @}
      */
@@ -506,6 +654,7 @@ namespace aspect
     unsigned int                   composition_degree;
     std::string                    pressure_normalization;
     MaterialModel::MaterialAveraging::AveragingOperation material_averaging;
+    bool                           cache_material_model_evaluations;
 
     /**
      * @}
@@ -80,6 +80,11 @@ namespace aspect
            * responsibility of this function to compute the new location of
            * the particles.
            * @param [in] dt The length of the integration timestep.
+           *
+           * This function is called for the particles of different cells
+           * concurrently on several threads, so implementations have to
+           * make sure that they do not modify data shared between cells
+           * without synchronization.
            */
           virtual
           void
@@ -25,6 +25,8 @@
 
 #include <aspect/simulator_access.h>
 
+#include <mutex>
+
 
 namespace aspect
 {
@@ -125,6 +127,12 @@ namespace aspect
            */
           std::map<types::particle_index, Point<dim> >   loc0;
 
+          /**
+           * A mutex that guards insertions into loc0, since
+           * local_integrate_step() is called for several cells in parallel.
+           */
+          std::mutex loc0_mutex;
+
       };
 
     }
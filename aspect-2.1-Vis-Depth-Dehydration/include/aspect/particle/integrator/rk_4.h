@@ -23,6 +23,8 @@
 
 #include <aspect/particle/integrator/interface.h>
 
+#include <mutex>
+
 namespace aspect
 {
   namespace Particle
@@ -131,6 +133,12 @@ namespace aspect
            */
           std::map<types::particle_index, Tensor<1,dim> > k1, k2, k3;
 
+          /**
+           * A mutex that guards insertions into the maps above, since
+           * local_integrate_step() is called for several cells in parallel.
+           */
+          std::mutex data_mutex;
+
       };
     }
   }
@@ -35,7 +35,9 @@
 
 #include <boost/serialization/map.hpp>
 #include <boost/range/iterator_range.hpp>
+#include <boost/signals2/connection.hpp>
 
+#include <array>
 #include <functional>
 
 #if !DEAL_II_VERSION_GTE(9,0,0)
@@ -416,6 +418,91 @@ namespace aspect
          */
         unsigned int data_offset;
 
+        /**
+         * Connection to the signal of the triangulation that is triggered
+         * whenever the mesh changes. It marks the cell location cache below
+         * as outdated.
+         */
+        boost::signals2::connection mesh_change_connection;
+
+        /**
+         * Whether the cell location cache below has to be rebuilt before it
+         * can be used, because the mesh changed since it was last built.
+         */
+        bool cell_location_cache_outdated;
+
+        /**
+         * For every vertex the set of active cells adjacent to it, as
+         * computed by GridTools::vertex_to_cell_map(), and the corresponding
+         * normalized directions from the vertex to the cell centers, as
+         * computed by vertex_to_cell_centers_directions().
+         */
+        std::vector<std::set<active_cell_it> > cached_vertex_to_cells;
+        std::vector<std::vector<Tensor<1,spacedim> > > cached_vertex_to_cell_centers;
+
+        /**
+         * All locally owned and ghost cells, together with an axis-parallel
+         * box (given by its lower and upper corner) that contains the cell.
+         */
+        std::vector<active_cell_it> located_cells;
+        std::vector<std::pair<Point<spacedim>,Point<spacedim> > > located_cell_boxes;
+
+        /**
+         * A uniform grid of buckets that covers the boxes of all
+         * located_cells. Each bucket stores the indices (into located_cells)
+         * of the cells whose box overlaps it, so that finding the cell around
+         * a point only requires to look at the few cells in one bucket.
+         */
+        Point<spacedim> bucket_origin;
+        Tensor<1,spacedim> bucket_size;
+        std::array<unsigned int,spacedim> n_buckets;
+        std::vector<std::vector<unsigned int> > cell_buckets;
+
+        /**
+         * Rebuild the vertex to cell maps and the cell buckets if the mesh
+         * changed since they were last built.
+         */
+        void
+        update_cell_location_cache();
+
+        /**
+         * Find the cell around @p location by walking from @p cell across
+         * the faces through which the straight line from the cell to
+         * @p location leaves each cell. If a locally owned or ghost cell
+         * containing @p location is found within a few steps, @p cell and
+         * @p reference_location are set to this cell and the position of
+         * @p location in its reference coordinates, and the function returns
+         * true. Otherwise the arguments are not changed and the function
+         * returns false.
+         */
+        bool
+        find_cell_by_walking(const Point<spacedim> &location,
+                             active_cell_it &cell,
+                             Point<dim> &reference_location) const;
+
+        /**
+         * Find the cell around @p location among the cells adjacent to the
+         * vertex of @p cell that is closest to @p location, testing the cells
+         * in the order of how well the direction to their center aligns with
+         * the direction to @p location. Arguments and return value have the
+         * same meaning as for find_cell_by_walking().
+         */
+        bool
+        find_cell_around_closest_vertex(const Point<spacedim> &location,
+                                        active_cell_it &cell,
+                                        Point<dim> &reference_location) const;
+
+        /**
+         * Find the locally owned or ghost cell around @p location using the
+         * cell buckets. Arguments and return value have the same meaning as
+         * for find_cell_by_walking(), except that the initial value of
+         * @p cell is not used.
+         */
+        bool
+        find_cell_in_buckets(const Point<spacedim> &location,
+                             active_cell_it &cell,
+                             Point<dim> &reference_location) const;
+
         /**
          * Calculates the number of particles in the global model domain.
          */
@@ -25,6 +25,10 @@
 
 #include <deal.II/base/array_view.h>
 
+#include <memory>
+#include <mutex>
+#include <vector>
+
 #if !DEAL_II_VERSION_GTE(9,0,0)
 
 namespace aspect
@@ -39,6 +43,18 @@ namespace aspect
      * same amount it is more efficient to let this be handled by a central
      * manager that does not need to allocate/deallocate memory every time a
      * particle is constructed/destroyed.
+     *
+     * The pool allocates memory in large chunks that each hold the
+     * properties of many particles one after the other. Slots that are
+     * released by deallocate_properties_array() are kept in a list of free
+     * slots and handed out again by the next call to
+     * allocate_properties_array(), so that the properties of particles stay
+     * in a few contiguous blocks of memory and creating or moving particles
+     * does not cause calls to the system allocator. Memory is only returned
+     * to the system when the pool is destroyed.
+     *
+     * Slots can be allocated and deallocated from several threads at the
+     * same time.
      */
     class PropertyPool
     {
@@ -81,7 +97,8 @@ namespace aspect
 
         /**
          * Reserves the dynamic memory needed for storing the properties of
-         * @p size particles.
+         * @p size particles. If the pool already provides at least @p size
+         * slots, this function does nothing.
          */
         void reserve(const std::size_t size);
 
@@ -95,6 +112,40 @@ namespace aspect
          * The number of properties that are reserved per particle.
          */
         const unsigned int n_properties;
+
+        /**
+         * Allocate a new chunk of memory with space for @p n_slots particles
+         * and add its slots to the list of free slots. This function must be
+         * called with the pool_mutex locked.
+         */
+        void add_chunk (const std::size_t n_slots);
+
+        /**
+         * The minimal number of slots that are allocated at once if the pool
+         * runs out of free slots.
+         */
+        static const std::size_t min_slots_per_chunk = 4096;
+
+        /**
+         * The chunks of memory that store the properties.
+         */
+        std::vector<std::unique_ptr<double[]> > chunks;
+
+        /**
+         * The total number of slots in all chunks.
+         */
+        std::size_t n_slots;
+
+        /**
+         * Slots that are currently not used by any particle. New slots are
+         * taken from the end of this vector.
+         */
+        std::vector<Handle> free_slots;
+
+        /**
+         * A mutex that guards the chunks and the list of free slots.
+         */
+        std::mutex pool_mutex;
     };
 
   }
@@ -48,6 +48,7 @@
 
 #include <deal.II/base/timer.h>
 #include <deal.II/base/array_view.h>
+#include <deal.II/base/polynomial.h>
 
 #include <boost/serialization/unique_ptr.hpp>
 
@@ -319,6 +320,99 @@ namespace aspect
          */
         bool update_ghost_particles;
 
+        /**
+         * Whether particles are written into a separate file when a
+         * checkpoint is created, instead of being attached to the cells of
+         * the triangulation and stored together with the mesh.
+         */
+        bool checkpoint_particles_in_separate_file;
+
+        /**
+         * Whether the particles of the last checkpoint were written into a
+         * separate file. This is set when a checkpoint is created and is
+         * stored with the serialized data of the checkpoint, so that on
+         * resume the particles are read from where the checkpoint put them,
+         * independent of the setting of the current run and of any particle
+         * file that an earlier run may have left in the output directory.
+         */
+        bool checkpoint_has_separate_particle_file;
+
+        /**
+         * Return the name of the file into which write_particle_checkpoint()
+         * writes the particles of a checkpoint. The file is named after the
+         * mesh file of the checkpoint, so that it is moved around together
+         * with the mesh files when checkpoints are rotated. If
+         * @p for_writing is true, the name is the one under which the file
+         * is written by create_snapshot(), which may be a temporary name if
+         * checkpoints are written in the background. Otherwise, it is the
+         * name under which the file of the last checkpoint can be found.
+         */
+        std::string
+        particle_checkpoint_file_name (const bool for_writing) const;
+
+        /**
+         * Write all locally owned particles, together with the data of the
+         * integrator, into the file @p filename with one collective MPI I/O
+         * operation.
+         *
+         * The file starts with a header that contains a format version, the
+         * number of processes that wrote the file, and the size of one
+         * particle record. Then follows an index with one entry per
+         * writing process, containing the position of the process' first
+         * particle record in the file, its number of particles, and a box
+         * that contains the locations of all of these particles. The
+         * particle records follow the index. Each record identifies the
+         * cell the particle is in by its coarse cell and the path of child
+         * indices from the coarse cell to the active cell, which does not
+         * depend on how the mesh is distributed, and then contains the id,
+         * location, reference location and properties of the particle, and
+         * the data of the integrator.
+         */
+        void
+        write_particle_checkpoint (const std::string &filename) const;
+
+        /**
+         * Read the particles written by write_particle_checkpoint() from
+         * the file @p filename. Every process only reads the particle
+         * records of those processes whose particles may lie in its locally
+         * owned cells, and inserts the particles that are in one of its
+         * locally owned cells. The file may have been written by a
+         * different number of processes than the current one.
+         */
+        void
+        read_particle_checkpoint (const std::string &filename);
+
+        /**
+         * The order in which local_advect_particles() visits the shape
+         * functions of the velocity element. If the velocity element is a
+         * tensor product of one-dimensional Lagrange polynomials, the k-th
+         * entry is the index of the shape function that has the k-th support
+         * point in lexicographic order, otherwise this is the identity.
+         */
+        std::vector<unsigned int> velocity_dof_order;
+
+        /**
+         * The cell-local indices of the degrees of freedom of the velocity
+         * (and, with melt transport, of the fluid velocity) for the shape
+         * functions in the order of velocity_dof_order. The entry for shape
+         * function k and direction d is at position k*dim+d.
+         */
+        std::vector<unsigned int> velocity_system_indices;
+        std::vector<unsigned int> fluid_velocity_system_indices;
+
+        /**
+         * If the velocity element is a tensor product element, the
+         * one-dimensional Lagrange polynomials it is built from, otherwise
+         * an empty vector.
+         */
+        std::vector<Polynomials::Polynomial<double> > velocity_basis_1d;
+
+        /**
+         * Fill the tables above. Called before the first advection step.
+         */
+        void
+        setup_velocity_evaluation ();
+
         /**
          * Get a map between subdomain id and the neighbor index. In other words
          * the returned map answers the question: Given a subdomain id, which
@@ -352,6 +446,71 @@ namespace aspect
          */
         void advect_particles();
 
+        /**
+         * Scratch data for the loops over all cells in initialize_particles(),
+         * update_particles(), and advect_particles(). These loops run in
+         * parallel on several threads, and each thread works on its own copy
+         * of this object, so that the arrays below only need to be allocated
+         * once per thread rather than once per cell.
+         */
+        struct ScratchData
+        {
+          /**
+           * The degrees of freedom of the current cell.
+           */
+          std::vector<types::global_dof_index> cell_dof_indices;
+
+          /**
+           * The current and old velocities at the locations of the particles
+           * in the current cell.
+           */
+          std::vector<Tensor<1,dim> > velocities;
+          std::vector<Tensor<1,dim> > old_velocities;
+
+          /**
+           * The current and old (fluid) velocity values at the support points
+           * of the current cell, in the order of World::velocity_dof_order.
+           */
+          std::vector<Tensor<1,dim> > velocity_coefficients;
+          std::vector<Tensor<1,dim> > old_velocity_coefficients;
+          std::vector<Tensor<1,dim> > fluid_velocity_coefficients;
+          std::vector<Tensor<1,dim> > old_fluid_velocity_coefficients;
+
+          /**
+           * The values of the one-dimensional basis polynomials in all
+           * coordinate directions at the location of one particle, and
+           * temporary storage for the evaluation of the velocity by sum
+           * factorization.
+           */
+          std::vector<double>         basis_values_1d;
+          std::vector<Tensor<1,dim> > partial_sums;
+
+          /**
+           * The reference locations of the particles in the current cell, and
+           * the values and gradients of the solution at these locations.
+           */
+          std::vector<Point<dim> >                  positions;
+          std::vector<Vector<double> >              values;
+          std::vector<std::vector<Tensor<1,dim> > > gradients;
+        };
+
+        /**
+         * The loops over all cells mentioned above do not need to write any
+         * data into global objects after a cell has been processed, so this
+         * object is empty. It is only needed because WorkStream requires it.
+         */
+        struct CopyData
+        {};
+
+        /**
+         * Call @p worker for every locally owned cell, in parallel on
+         * several threads. Each thread uses its own ScratchData object.
+         */
+        void
+        run_on_locally_owned_cells (const std::function<void (const typename DoFHandler<dim>::active_cell_iterator &,
+                                                              ScratchData &,
+                                                              CopyData &)> &worker);
+
         /**
          * Initialize the particle properties of one cell.
          */
@@ -365,7 +524,8 @@ namespace aspect
         void
         local_update_particles(const typename DoFHandler<dim>::active_cell_iterator &cell,
                                const typename ParticleHandler<dim>::particle_iterator &begin_particle,
-                               const typename ParticleHandler<dim>::particle_iterator &end_particle);
+                               const typename ParticleHandler<dim>::particle_iterator &end_particle,
+                               ScratchData &scratch);
 
         /**
          * Advect the particles of one cell. Performs only one step for
@@ -378,7 +538,8 @@ namespace aspect
         void
         local_advect_particles(const typename DoFHandler<dim>::active_cell_iterator &cell,
                                const typename ParticleHandler<dim>::particle_iterator &begin_particle,
-                               const typename ParticleHandler<dim>::particle_iterator &end_particle);
+                               const typename ParticleHandler<dim>::particle_iterator &end_particle,
+                               ScratchData &scratch);
     };
 
     /* -------------------------- inline and template functions ---------------------- */
@@ -392,6 +553,7 @@ namespace aspect
       // It works correctly when archiving the content of the pointer instead.
       ar
       &(*particle_handler)
+      &checkpoint_has_separate_particle_file
       ;
     }
   }
@@ -140,6 +140,13 @@ namespace aspect
          */
         std::vector<DataPoint> entries;
 
+        /**
+         * The number of entries that have been written to the text output
+         * file in this run of the program. Only used on the root process
+         * and if ascii_output is set.
+         */
+        unsigned int n_entries_written;
+
         /**
          * Set the time output was supposed to be written. In the simplest
          * case, this is the previous last output time plus the interval, but
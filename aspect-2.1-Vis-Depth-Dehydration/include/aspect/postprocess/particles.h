@@ -33,6 +33,8 @@
 #endif
 
 #include <deal.II/base/data_out_base.h>
+
+#include <cstdint>
 #include <tuple>
 
 namespace aspect
@@ -345,6 +347,36 @@ namespace aspect
         void write_master_files (const internal::ParticleOutput<dim> &data_out,
                                  const std::string &solution_file_prefix,
                                  const std::vector<std::string> &filenames);
+
+        /**
+         * The names of the particle properties that are written by the
+         * "binary series" output format. If empty, all properties are
+         * written.
+         */
+        std::vector<std::string> binary_series_properties;
+
+        /**
+         * The size of the file <code>particles/particles.bin</code> after
+         * the last output step of the "binary series" output format, i.e.,
+         * the position at which the next output step is appended.
+         */
+        std::uint64_t binary_series_file_size;
+
+        /**
+         * The lines of the index file <code>particles/particles.bin.index</code>
+         * that describe the output steps written so far, one line per step.
+         */
+        std::vector<std::string> binary_series_index_entries;
+
+        /**
+         * Append the ids, locations, and selected properties of all particles
+         * to the file <code>particles/particles.bin</code>, and describe
+         * the new output step in the index file. All processes write their
+         * particles with collective MPI I/O operations, using a buffer of
+         * bounded size, so that the memory needed does not grow with the
+         * number of particles of a process.
+         */
+        void write_binary_series (const double time_in_years_or_seconds);
 #endif
     };
   }
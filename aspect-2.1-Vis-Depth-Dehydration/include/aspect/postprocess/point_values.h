@@ -27,6 +27,8 @@
 
 #include <deal.II/base/data_out_base.h>
 
+#include <boost/signals2/connection.hpp>
+
 
 namespace aspect
 {
@@ -48,6 +50,20 @@ namespace aspect
          */
         PointValues ();
 
+        /**
+         * Destructor.
+         */
+        virtual
+        ~PointValues ();
+
+        /**
+         * Connect to the triangulation so that the evaluation points are
+         * located again whenever the mesh changes.
+         */
+        virtual
+        void
+        initialize ();
+
         /**
          * Evaluate the solution and determine the values at the
          * selected points.
@@ -100,6 +116,15 @@ namespace aspect
          */
         void set_last_output_time (const double current_time);
 
+        /**
+         * Find the locally owned cells that contain evaluation points and
+         * store these cells together with the positions of the points in
+         * their reference coordinates. Every point is assigned to exactly
+         * one process, namely the one with the lowest rank among all
+         * processes that own a cell around the point.
+         */
+        void locate_evaluation_points ();
+
         /**
          * Interval between the generation of output in seconds.
          */
@@ -124,6 +149,38 @@ namespace aspect
          * as natural coordinates or not.
          */
         bool use_natural_coordinates;
+
+        /**
+         * Whether the evaluation points have to be located again before
+         * the next evaluation, because the mesh changed or the points have
+         * not been located yet. This only tracks changes of the
+         * triangulation; if the mesh is deformed by a free surface, the
+         * points are located again at every output.
+         */
+        bool evaluation_points_outdated;
+
+        /**
+         * Connection to the signal of the triangulation that is triggered
+         * whenever the mesh changes.
+         */
+        boost::signals2::connection mesh_change_connection;
+
+        /**
+         * The indices of the evaluation points that are evaluated on this
+         * process, sorted by the cells that contain them, together with
+         * these cells and the positions of the points in the reference
+         * coordinates of the cells.
+         */
+        std::vector<unsigned int> local_point_indices;
+        std::vector<typename DoFHandler<dim>::active_cell_iterator> local_point_cells;
+        std::vector<Point<dim> > local_point_reference_locations;
+
+        /**
+         * The number of entries of point_values that have been written to
+         * the output file in this run of the program. Only used on the root
+         * process.
+         */
+        unsigned int n_point_values_written;
     };
   }
 }
@@ -475,6 +475,11 @@ namespace aspect
          */
         bool write_higher_order_output;
 
+        /**
+         * The zlib compression level used for the data in vtu files.
+         */
+        DataOutBase::VtkFlags::ZlibCompressionLevel compression_level;
+
         /**
          * For free surface computations Aspect uses an Arbitrary-Lagrangian-
          * Eulerian formulation to handle deforming the domain, so the mesh
@@ -50,6 +50,7 @@ DEAL_II_ENABLE_EXTRA_DIAGNOSTICS
 #include <aspect/lateral_averaging.h>
 #include <aspect/simulator_signals.h>
 #include <aspect/material_model/interface.h>
+#include <aspect/material_model/evaluation_cache.h>
 #include <aspect/heating_model/interface.h>
 #include <aspect/geometry_model/initial_topography_model/interface.h>
 #include <aspect/geometry_model/interface.h>
@@ -100,6 +101,12 @@ namespace aspect
   template <int dim>
   class VolumeOfFluidHandler;
 
+  template <int dim>
+  class StokesMatrixFreeHandler;
+
+  template <int dim, int velocity_degree>
+  class StokesMatrixFreeHandlerImplementation;
+
   namespace internal
   {
     namespace Assembly
@@ -207,6 +214,11 @@ namespace aspect
        */
       typedef typename Parameters<dim>::NullspaceRemoval NullspaceRemoval;
 
+      /**
+       * Import Stokes solver type.
+       */
+      typedef typename Parameters<dim>::StokesSolverType StokesSolverType;
+
 
       /**
        * A structure that is used as an argument to functions that can work on
@@ -581,6 +593,20 @@ namespace aspect
        */
       void build_stokes_preconditioner ();
 
+      /**
+       * Determine whether the current Stokes preconditioner can be kept (or
+       * only updated) rather than rebuilt from scratch, according to the
+       * ``AMG reuse policy'' and its thresholds. This compares the cell
+       * averages of the logarithm of the viscosity recorded during the last
+       * assembly of the Stokes matrix with those at the time of the last
+       * full rebuild of the preconditioner, and the number of iterations
+       * of the last Stokes solve with the allowed maximum.
+       *
+       * This function is implemented in
+       * <code>source/simulator/assembly.cc</code>.
+       */
+      bool stokes_preconditioner_can_be_reused () const;
+
       /**
        * Initialize the preconditioner for the advection equation of field
        * index.
@@ -668,9 +694,15 @@ namespace aspect
       double solve_advection (const AdvectionField &advection_field);
 
       /**
-       * Interpolate a particular particle property to the solution field.
+       * Interpolate the particle properties that belong to the given
+       * advection fields to the solution field. All fields are handled in
+       * a single loop over the cells, so that the particle interpolator is
+       * only asked once per cell for all properties.
+       *
+       * This function is implemented in
+       * <code>source/simulator/initial_conditions.cc</code>.
        */
-      void interpolate_particle_properties (const AdvectionField &advection_field);
+      void interpolate_particle_properties (const std::vector<AdvectionField> &advection_fields);
 
       /**
        * Solve the Stokes linear system.
@@ -798,6 +830,20 @@ namespace aspect
        */
       void create_snapshot();
 
+      /**
+       * If checkpoint files are written in the background (see the
+       * ``Write checkpoint in background thread'' parameter), wait until the
+       * files of the last checkpoint have been completely written, and
+       * throw an exception on all processes if writing them failed. Since
+       * this requires communication, the function has to be called on all
+       * processes at the same time. If checkpoint files are not written in
+       * the background, this function does nothing.
+       *
+       * This function is implemented in
+       * <code>source/simulator/checkpoint_restart.cc</code>.
+       */
+      void wait_for_checkpoint_writer();
+
       /**
        * Restore the state of this program from a set of files in the output
        * directory. In reality, however, only some variables are stored (in
@@ -1168,7 +1214,13 @@ namespace aspect
        * As the ordinary differential equation in any given point is independent
        * from the solution at all other points, we do not have to assemble a matrix,
        * but just need to loop over all node locations for the temperature and
-       * compositional fields and compute the update to the solution.
+       * compositional fields and compute the update to the solution. Every
+       * locally owned node is visited only once, and the nodes of many cells are
+       * handed to the material and heating models together, in batches that are
+       * processed in parallel. Depending on the ``Reaction solver type'', the
+       * equations are integrated with a fixed number of forward Euler steps, or
+       * with an embedded Runge-Kutta method that adapts the step size separately
+       * at every node.
        *
        * The function also updates the old solution vectors with the reaction update
        * so that the advection time stepping scheme will have the correct field terms
@@ -1308,31 +1360,23 @@ namespace aspect
        */
       double get_maximal_velocity (const LinearAlgebra::BlockVector &solution) const;
 
-      /**
-       * Compute the variation (i.e., the difference between maximal and
-       * minimal value) of the entropy $(T-\bar T)^2$ where $\bar T$ is the
-       * average temperature throughout the domain given as argument to this
-       * function.
-       *
-       * This function is used in computing the artificial diffusion
-       * stabilization term.
-       *
-       * This function is implemented in
-       * <code>source/simulator/assembly.cc</code>.
-       */
-      double get_entropy_variation (const double average_field,
-                                    const AdvectionField &advection_field) const;
-
       /**
        * Compute the minimal and maximal temperature throughout the domain from
        * a solution vector extrapolated from the previous time steps. This is
        * needed to compute the artificial diffusion stabilization terms.
        *
+       * If @p maximal_old_velocity is not a null pointer, the maximal
+       * velocity of the old solution, as get_maximal_velocity(old_solution)
+       * would compute it, is computed in the same loop over all cells and
+       * with the same MPI reduction, and is stored in the object it points
+       * to.
+       *
        * This function is implemented in
        * <code>source/simulator/helper_functions.cc</code>.
        */
       std::pair<double,double>
-      get_extrapolated_advection_field_range (const AdvectionField &advection_field) const;
+      get_extrapolated_advection_field_range (const AdvectionField &advection_field,
+                                              double *maximal_old_velocity = nullptr) const;
 
       /**
        * Check if timing output should be written in this timestep, and if so
@@ -1399,17 +1443,25 @@ namespace aspect
        * Compute the artificial diffusion coefficient value on a cell given
        * the values and gradients of the solution passed as arguments.
        *
+       * If the coefficient depends on the variation of the entropy
+       * $(T-\bar T)^2$ throughout the domain, which is only known after
+       * all cells have been visited, the value that is returned is only an
+       * upper bound. In this case, @p entropy_viscosity_numerator is set
+       * to the value that has to be divided by the entropy variation,
+       * and the coefficient is the minimum of the returned value and this
+       * quotient. Otherwise, @p entropy_viscosity_numerator is set to -1.
+       *
        * This function is implemented in
-       * <code>source/simulator/assembly.cc</code>.
+       * <code>source/simulator/entropy_viscosity.cc</code>.
        */
       double
       compute_viscosity(internal::Assembly::Scratch::AdvectionSystem<dim> &scratch,
                         const double                        global_u_infty,
                         const double                        global_field_variation,
                         const double                        average_field,
-                        const double                        global_entropy_variation,
                         const double                        cell_diameter,
-                        const AdvectionField     &advection_field) const;
+                        const AdvectionField               &advection_field,
+                        double                             &entropy_viscosity_numerator) const;
 
       /**
        * Compute the residual of one advection equation to be used for the
@@ -1463,6 +1515,22 @@ namespace aspect
                                            const bool                                                   compute_strainrate,
                                            MaterialModel::MaterialModelInputs<dim> &material_model_inputs) const;
 
+      /**
+       * Evaluate the material model for the inputs @p in and write the
+       * results into @p out. If the ``Cache material model evaluations''
+       * parameter is set, results of previous evaluations with identical
+       * inputs on the same cell in the same time step and nonlinear
+       * iteration are reused instead of evaluating the material model
+       * again; otherwise this function simply calls
+       * MaterialModel::Interface::evaluate().
+       *
+       * This function is implemented in
+       * <code>source/simulator/assembly.cc</code>.
+       */
+      void
+      evaluate_material_model (const MaterialModel::MaterialModelInputs<dim> &in,
+                               MaterialModel::MaterialModelOutputs<dim> &out) const;
+
 
       /**
        * Return whether the Stokes matrix depends on the values of the
@@ -1542,6 +1610,32 @@ namespace aspect
        */
       void output_statistics();
 
+      /**
+       * If measured cell costs are used for load balancing, compute the
+       * factor that converts the measured cost of a cell into its weight
+       * for the next repartitioning of the mesh, and write the measured
+       * cost per process, and the resulting imbalance, to screen and into
+       * the statistics object. This function needs to be called on all
+       * processes before the mesh is refined.
+       *
+       * This function is implemented in
+       * <code>source/simulator/helper_functions.cc</code>.
+       */
+      void prepare_measured_cost_cell_weights();
+
+      /**
+       * The function connected to the cell_weight signal of the
+       * triangulation if measured cell costs are used for load balancing.
+       * It returns the weight of @p cell based on the measured cost of the
+       * cell (or its children, if they are coarsened).
+       *
+       * This function is implemented in
+       * <code>source/simulator/helper_functions.cc</code>.
+       */
+      unsigned int
+      measured_cost_cell_weight (const typename parallel::distributed::Triangulation<dim>::cell_iterator &cell,
+                                 const typename parallel::distributed::Triangulation<dim>::CellStatus status) const;
+
       /**
        * This routine computes the initial (nonlinear) Stokes residual that is
        * needed as a convergence criterion in models with solver schemes that do
@@ -1638,6 +1732,27 @@ namespace aspect
        * or if we want to terminate altogether.
        */
       Threads::Thread<>                   output_statistics_thread;
+
+      /**
+       * If the statistics file is only extended instead of being rewritten
+       * (see Parameters::append_to_output_files), these variables store the
+       * column descriptions at the top of the file and the number of rows
+       * that have already been handed to the thread that writes the
+       * statistics file, so that output_statistics() only needs to format
+       * the rows that were added since.
+       */
+      std::string                         statistics_file_header;
+      unsigned int                        n_statistics_rows_written;
+
+      /**
+       * In create_snapshot(), the files of a checkpoint may be written on a
+       * separate thread on processor zero. This variable is the handle for
+       * this thread, and the string below collects the error message if
+       * writing the files failed. Both are used in
+       * wait_for_checkpoint_writer().
+       */
+      Threads::Thread<>                   checkpoint_writer_thread;
+      std::string                         checkpoint_writer_error;
       /**
        * @}
        */
@@ -1817,6 +1932,41 @@ namespace aspect
       bool                                                      assemble_newton_stokes_system;
       bool                                                      rebuild_stokes_preconditioner;
 
+      /**
+       * The cell average of the base-10 logarithm of the viscosity, indexed
+       * by the active cell index, as computed during the last assembly of
+       * the Stokes matrix, and the same quantity at the time the AMG
+       * preconditioner was last built from scratch. Only filled if the
+       * ``AMG reuse policy'' allows reusing the preconditioner.
+       */
+      Vector<float>                                             stokes_cell_log_viscosities;
+      Vector<float>                                             amg_cell_log_viscosities;
+
+      /**
+       * The number of outer iterations the last iterative solve of the
+       * Stokes system needed.
+       */
+      unsigned int                                              n_last_stokes_solver_iterations;
+
+      /**
+       * The number of Stokes solves since the cheap solver phase last
+       * failed to converge, or numbers::invalid_unsigned_int if it did not
+       * fail in the last solve that tried it. Used to skip the cheap phase
+       * if the ``Stokes solver phase selection'' is ``automatic''.
+       */
+      unsigned int                                              n_stokes_solves_since_cheap_phase_failed;
+
+      /**
+       * The wall time in seconds spent in the assembly of the Stokes and
+       * advection systems on each cell since the mesh was last changed,
+       * indexed by the active cell index, and the factor computed by
+       * prepare_measured_cost_cell_weights() that converts these times
+       * into cell weights. The vector is empty if measured cell costs are
+       * not used for load balancing.
+       */
+      Vector<float>                                             measured_cell_costs;
+      double                                                    measured_cost_to_cell_weight;
+
       /**
        * @}
        */
@@ -1830,11 +1980,26 @@ namespace aspect
        */
       std::unique_ptr<FreeSurfaceHandler<dim> > free_surface;
 
+      /**
+       * Unique pointer for an instance of the StokesMatrixFreeHandler. This
+       * object is only created if the Stokes system is solved with the
+       * matrix-free geometric multigrid solver.
+       */
+      std::unique_ptr<StokesMatrixFreeHandler<dim> > stokes_matrix_free;
+
+      /**
+       * Unique pointer for the cache of material model evaluations. This
+       * object is only created if the cache was enabled in the input file,
+       * see evaluate_material_model().
+       */
+      std::unique_ptr<MaterialModel::EvaluationCache<dim> > material_model_cache;
+
       friend class boost::serialization::access;
       friend class SimulatorAccess<dim>;
       friend class FreeSurfaceHandler<dim>;   // FreeSurfaceHandler needs access to the internals of the Simulator
       friend class VolumeOfFluidHandler<dim>; // VolumeOfFluidHandler needs access to the internals of the Simulator
       friend struct Parameters<dim>;
+      template <int, int> friend class StokesMatrixFreeHandlerImplementation; // needs access to the internals of the Simulator
   };
 }
 
@@ -47,6 +47,24 @@ namespace aspect
   {
     namespace Assembly
     {
+      /**
+       * Convert a reference to one of the scratch or copy data base classes
+       * below into a reference to the derived class @p Derived. Assemblers
+       * are called once per cell (or face) and always receive the derived
+       * class that matches them, so the type is only verified with a
+       * dynamic_cast in debug mode, and a static_cast is used otherwise.
+       */
+      template <class Derived, class Base>
+      inline
+      Derived &
+      checked_cast (Base &base)
+      {
+        Assert (dynamic_cast<Derived *>(&base) != nullptr,
+                ExcMessage ("The scratch or copy data object handed to an assembler "
+                            "is not of the type the assembler expects."));
+        return static_cast<Derived &>(base);
+      }
+
       namespace Scratch
       {
         /**
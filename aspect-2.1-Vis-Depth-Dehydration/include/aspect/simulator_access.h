@@ -537,6 +537,17 @@ namespace aspect
                                            const bool                                                   compute_strainrate,
                                            MaterialModel::MaterialModelInputs<dim> &material_model_inputs) const;
 
+      /**
+       * This function simply calls Simulator<dim>::evaluate_material_model()
+       * with the given arguments. It evaluates the material model like
+       * get_material_model().evaluate(), but may return the stored result
+       * of an earlier evaluation with the same inputs if the user has
+       * enabled caching of material model evaluations.
+       */
+      void
+      evaluate_material_model (const MaterialModel::MaterialModelInputs<dim> &material_model_inputs,
+                               MaterialModel::MaterialModelOutputs<dim>      &material_model_outputs) const;
+
       /**
        * Return a pointer to the gravity model description.
        */
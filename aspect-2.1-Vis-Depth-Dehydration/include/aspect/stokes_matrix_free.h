@@ -0,0 +1,511 @@
+/*
+  Copyright (C) 2019 by the authors of the ASPECT code.
+
+  This file is part of ASPECT.
+
+  ASPECT is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2, or (at your option)
+  any later version.
+
+  ASPECT is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with ASPECT; see the file LICENSE.  If not see
+  <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef _aspect_stokes_matrix_free_h
+#define _aspect_stokes_matrix_free_h
+
+#include <aspect/global.h>
+#include <aspect/simulator.h>
+
+#if DEAL_II_VERSION_GTE(9,1,0)
+
+#include <deal.II/matrix_free/matrix_free.h>
+#include <deal.II/matrix_free/operators.h>
+#include <deal.II/matrix_free/fe_evaluation.h>
+
+#include <deal.II/lac/la_parallel_vector.h>
+#include <deal.II/lac/la_parallel_block_vector.h>
+#include <deal.II/lac/precondition.h>
+
+#include <deal.II/multigrid/mg_constrained_dofs.h>
+#include <deal.II/multigrid/mg_transfer_matrix_free.h>
+#include <deal.II/multigrid/mg_coarse.h>
+#include <deal.II/multigrid/mg_smoother.h>
+#include <deal.II/multigrid/mg_matrix.h>
+
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/fe/fe_dgq.h>
+#include <deal.II/fe/fe_system.h>
+
+#endif
+
+namespace aspect
+{
+  using namespace dealii;
+
+#if DEAL_II_VERSION_GTE(9,1,0)
+  /**
+   * Typedef for the number type used in the geometric multigrid
+   * preconditioner. The outer Krylov solver always works in double
+   * precision.
+   */
+  typedef double GMGNumberType;
+
+  /**
+   * Matrix-free operators on the Stokes system. The viscosity is evaluated
+   * in every quadrature point on the active level; on the coarser levels
+   * of the multigrid hierarchy it is represented by one value per cell.
+   */
+  namespace MatrixFreeStokesOperators
+  {
+    /**
+     * The data every operator in this namespace needs on the cells it
+     * works on. One object of this type is stored for the active level
+     * and one for every level of the multigrid hierarchy, and the
+     * operators only keep a pointer to it, so that updating the
+     * viscosity does not require to reinitialize the operators.
+     */
+    template <int dim, typename number>
+    struct OperatorCellData
+    {
+      /**
+       * Twice the viscosity, stored for every cell batch of the
+       * MatrixFree object this data belongs to (first index) and every
+       * quadrature point (second index).
+       */
+      Table<2, VectorizedArray<number> > viscosity_x_2;
+
+      /**
+       * The factor by which the pressure is scaled in the Stokes system.
+       */
+      double pressure_scaling;
+
+      /**
+       * Whether to include the term that stems from the deviatoric strain
+       * rate of compressible models.
+       */
+      bool is_compressible;
+
+      /**
+       * Return the memory consumption of this object in bytes.
+       */
+      std::size_t
+      memory_consumption () const;
+    };
+
+
+
+    /**
+     * Operator for the entire Stokes block, i.e., the operator
+     * @f[
+     *   \begin{pmatrix} A & B^T \\ B & 0 \end{pmatrix}
+     * @f]
+     * applied without ever assembling a matrix. The first block of
+     * the vectors it works on is the velocity, which is described by the
+     * first DoFHandler in the MatrixFree object, and the second block the
+     * pressure, described by the second DoFHandler.
+     */
+    template <int dim, int degree_v, typename number>
+    class StokesOperator
+      : public MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::BlockVector<number> >
+    {
+      public:
+        /**
+         * Constructor.
+         */
+        StokesOperator ();
+
+        /**
+         * Reset the object.
+         */
+        void clear () override;
+
+        /**
+         * Set the pointer to the cell data that describe the viscosity
+         * and the other coefficients of the operator.
+         */
+        void set_cell_data (const OperatorCellData<dim,number> &data);
+
+        /**
+         * Computing the diagonal of the Stokes operator is not needed and
+         * therefore not implemented.
+         */
+        void compute_diagonal () override;
+
+        /**
+         * Compute dst = Stokes_operator*src without imposing the
+         * constraints on @p src, i.e., constrained entries of @p src
+         * enter the product with the values they have. This is used to
+         * move the contribution of inhomogeneous boundary values to the
+         * right hand side.
+         */
+        void apply_without_constraints (dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+                                        const dealii::LinearAlgebra::distributed::BlockVector<number> &src) const;
+
+      private:
+        /**
+         * Perform the matrix-vector product with the Stokes operator.
+         */
+        void apply_add (dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+                        const dealii::LinearAlgebra::distributed::BlockVector<number> &src) const override;
+
+        /**
+         * Apply the operator on a range of cells.
+         */
+        void local_apply (const dealii::MatrixFree<dim, number> &data,
+                          dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+                          const dealii::LinearAlgebra::distributed::BlockVector<number> &src,
+                          const std::pair<unsigned int, unsigned int> &cell_range) const;
+
+        /**
+         * Like local_apply(), but read the values of @p src without
+         * resolving constraints.
+         */
+        void local_apply_without_constraints (const dealii::MatrixFree<dim, number> &data,
+                                              dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+                                              const dealii::LinearAlgebra::distributed::BlockVector<number> &src,
+                                              const std::pair<unsigned int, unsigned int> &cell_range) const;
+
+        /**
+         * The implementation of the two functions above.
+         */
+        void do_local_apply (const dealii::MatrixFree<dim, number> &data,
+                             dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+                             const dealii::LinearAlgebra::distributed::BlockVector<number> &src,
+                             const std::pair<unsigned int, unsigned int> &cell_range,
+                             const bool resolve_constraints) const;
+
+        /**
+         * Pointer to the coefficients of the operator.
+         */
+        const OperatorCellData<dim,number> *cell_data;
+    };
+
+
+
+    /**
+     * Operator for the pressure mass matrix weighted by the inverse
+     * viscosity, which is the approximation of the Schur complement
+     * we use in the block preconditioner.
+     */
+    template <int dim, int degree_p, typename number>
+    class MassMatrixOperator
+      : public MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::Vector<number> >
+    {
+      public:
+        /**
+         * Constructor.
+         */
+        MassMatrixOperator ();
+
+        /**
+         * Reset the object.
+         */
+        void clear () override;
+
+        /**
+         * Set the pointer to the cell data that describe the viscosity
+         * and the pressure scaling.
+         */
+        void set_cell_data (const OperatorCellData<dim,number> &data);
+
+        /**
+         * Compute the inverse of the diagonal of the operator, used as
+         * preconditioner.
+         */
+        void compute_diagonal () override;
+
+      private:
+        void apply_add (dealii::LinearAlgebra::distributed::Vector<number> &dst,
+                        const dealii::LinearAlgebra::distributed::Vector<number> &src) const override;
+
+        void local_apply (const dealii::MatrixFree<dim, number> &data,
+                          dealii::LinearAlgebra::distributed::Vector<number> &dst,
+                          const dealii::LinearAlgebra::distributed::Vector<number> &src,
+                          const std::pair<unsigned int, unsigned int> &cell_range) const;
+
+        void local_compute_diagonal (const MatrixFree<dim,number> &data,
+                                     dealii::LinearAlgebra::distributed::Vector<number> &dst,
+                                     const unsigned int &dummy,
+                                     const std::pair<unsigned int,unsigned int> &cell_range) const;
+
+        const OperatorCellData<dim,number> *cell_data;
+    };
+
+
+
+    /**
+     * Operator for the velocity block $A$ of the Stokes system. This
+     * operator is used both on the active level (to solve with $A$ in
+     * the expensive phase of the Stokes solver) and on all levels of the
+     * multigrid hierarchy, where its diagonal is used in the Chebyshev
+     * smoother.
+     */
+    template <int dim, int degree_v, typename number>
+    class ABlockOperator
+      : public MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::Vector<number> >
+    {
+      public:
+        /**
+         * Constructor.
+         */
+        ABlockOperator ();
+
+        /**
+         * Reset the object.
+         */
+        void clear () override;
+
+        /**
+         * Set the pointer to the cell data that describe the viscosity.
+         */
+        void set_cell_data (const OperatorCellData<dim,number> &data);
+
+        /**
+         * Compute the inverse of the diagonal of the operator, used by
+         * the Chebyshev smoother.
+         */
+        void compute_diagonal () override;
+
+      private:
+        void apply_add (dealii::LinearAlgebra::distributed::Vector<number> &dst,
+                        const dealii::LinearAlgebra::distributed::Vector<number> &src) const override;
+
+        void local_apply (const dealii::MatrixFree<dim, number> &data,
+                          dealii::LinearAlgebra::distributed::Vector<number> &dst,
+                          const dealii::LinearAlgebra::distributed::Vector<number> &src,
+                          const std::pair<unsigned int, unsigned int> &cell_range) const;
+
+        void local_compute_diagonal (const MatrixFree<dim,number> &data,
+                                     dealii::LinearAlgebra::distributed::Vector<number> &dst,
+                                     const unsigned int &dummy,
+                                     const std::pair<unsigned int,unsigned int> &cell_range) const;
+
+        const OperatorCellData<dim,number> *cell_data;
+    };
+  }
+#endif
+
+
+
+  /**
+   * Base class for the matrix-free Stokes solver that is used when
+   * "Stokes solver type" is set to "block GMG". Instead of assembling the
+   * Stokes blocks of the system matrix and building an algebraic multigrid
+   * preconditioner for the velocity block, the Stokes operator is applied
+   * matrix-free and the velocity block is preconditioned by a geometric
+   * multigrid V-cycle with Chebyshev smoothing on the level hierarchy of
+   * the p4est triangulation.
+   *
+   * The actual work is done in the derived class
+   * StokesMatrixFreeHandlerImplementation, which is templated on the
+   * polynomial degree of the velocity element.
+   */
+  template <int dim>
+  class StokesMatrixFreeHandler
+  {
+    public:
+      /**
+       * Destructor.
+       */
+      virtual ~StokesMatrixFreeHandler () = default;
+
+      /**
+       * Solve the Stokes system with the current right hand side
+       * and return the pair of the initial nonlinear residual and the
+       * final linear residual, like Simulator::solve_stokes(). The
+       * Stokes part of the solution is written both into
+       * @p distributed_stokes_solution and into the solution vector of
+       * the simulator.
+       */
+      virtual
+      std::pair<double,double>
+      solve (LinearAlgebra::BlockVector &distributed_stokes_solution) = 0;
+
+      /**
+       * Compute the norm of the residual of the Stokes system with zero
+       * velocity and the pressure of the current linearization point,
+       * like Simulator::compute_initial_stokes_residual() does with the
+       * assembled system matrix, but using the matrix-free Stokes
+       * operator.
+       */
+      virtual
+      double
+      compute_initial_stokes_residual () = 0;
+
+      /**
+       * Set up the DoFHandler objects, constraints, and MatrixFree
+       * objects on the active level and all multigrid levels. Called from
+       * Simulator::setup_dofs().
+       */
+      virtual void setup_dofs () = 0;
+
+      /**
+       * Evaluate the material model in the quadrature points of all
+       * locally owned cells and store the viscosity for the operators on
+       * the active level and on all multigrid levels.
+       */
+      virtual void evaluate_material_model () = 0;
+
+      /**
+       * Subtract the contribution of inhomogeneous velocity constraints
+       * from the right hand side. The right hand side of the Stokes
+       * system is assembled with the matrix-based assemblers, but without
+       * a matrix the inhomogeneities can not be taken into account at that
+       * point.
+       */
+      virtual void correct_stokes_rhs () = 0;
+
+      /**
+       * Compute the diagonals of the level operators and set up the
+       * Chebyshev smoothers of the multigrid preconditioner.
+       */
+      virtual void build_preconditioner () = 0;
+
+      /**
+       * Return the memory consumption of the matrix-free data structures
+       * in bytes.
+       */
+      virtual std::size_t get_memory_consumption () const = 0;
+
+      /**
+       * Declare the parameters this class takes.
+       */
+      static
+      void declare_parameters (ParameterHandler &prm);
+  };
+
+
+
+#if DEAL_II_VERSION_GTE(9,1,0)
+  /**
+   * The implementation of the matrix-free Stokes solver for a velocity
+   * element of polynomial degree @p velocity_degree. The pressure uses
+   * continuous elements of one degree less.
+   */
+  template <int dim, int velocity_degree>
+  class StokesMatrixFreeHandlerImplementation : public StokesMatrixFreeHandler<dim>
+  {
+    public:
+      /**
+       * Initialize this class, allowing it to read in relevant parameters
+       * as well as giving it a reference to the Simulator that owns it,
+       * since it needs to make fairly extensive use of the internals of
+       * the simulator.
+       */
+      StokesMatrixFreeHandlerImplementation (Simulator<dim> &simulator,
+                                             ParameterHandler &prm);
+
+      std::pair<double,double>
+      solve (LinearAlgebra::BlockVector &distributed_stokes_solution) override;
+
+      double
+      compute_initial_stokes_residual () override;
+
+      void setup_dofs () override;
+
+      void evaluate_material_model () override;
+
+      void correct_stokes_rhs () override;
+
+      void build_preconditioner () override;
+
+      std::size_t get_memory_consumption () const override;
+
+    private:
+      /**
+       * Parse the parameters this class takes.
+       */
+      void parse_parameters (ParameterHandler &prm);
+
+      /**
+       * Add the Dirichlet and no-normal-flux boundary conditions of the
+       * velocity to the multigrid constraints.
+       */
+      void setup_mg_boundary_constraints ();
+
+      /**
+       * Copy the viscosity from the cell-wise vector on each multigrid
+       * level into the level cell data.
+       */
+      void fill_level_cell_data ();
+
+      typedef dealii::LinearAlgebra::distributed::Vector<double> VectorType;
+      typedef dealii::LinearAlgebra::distributed::BlockVector<double> BlockVectorType;
+      typedef dealii::LinearAlgebra::distributed::Vector<GMGNumberType> GMGVectorType;
+
+      typedef MatrixFreeStokesOperators::StokesOperator<dim,velocity_degree,double> StokesMatrixType;
+      typedef MatrixFreeStokesOperators::MassMatrixOperator<dim,velocity_degree-1,double> SchurComplementMatrixType;
+      typedef MatrixFreeStokesOperators::ABlockOperator<dim,velocity_degree,double> ABlockMatrixType;
+      typedef MatrixFreeStokesOperators::ABlockOperator<dim,velocity_degree,GMGNumberType> GMGABlockMatrixType;
+
+      typedef PreconditionChebyshev<GMGABlockMatrixType,GMGVectorType> SmootherType;
+
+      Simulator<dim> &sim;
+
+      /**
+       * Run-time parameters of the multigrid preconditioner.
+       */
+      unsigned int chebyshev_degree;
+      double chebyshev_smoothing_range;
+
+      /**
+       * DoFHandlers and finite elements for the velocity and the pressure,
+       * and a piecewise constant element used to move the viscosity onto
+       * the multigrid levels.
+       */
+      DoFHandler<dim> dof_handler_v;
+      DoFHandler<dim> dof_handler_p;
+      DoFHandler<dim> dof_handler_projection;
+
+      FESystem<dim> fe_v;
+      FESystem<dim> fe_p;
+      FE_DGQ<dim> fe_projection;
+
+      /**
+       * Homogeneous constraints on the active level.
+       */
+      ConstraintMatrix constraints_v;
+      ConstraintMatrix constraints_p;
+
+      /**
+       * Objects on the active level.
+       */
+      MatrixFreeStokesOperators::OperatorCellData<dim,double> active_cell_data;
+      StokesMatrixType stokes_matrix;
+      ABlockMatrixType velocity_matrix;
+      SchurComplementMatrixType mass_matrix;
+
+      /**
+       * Objects on the multigrid levels.
+       */
+      MGLevelObject<MatrixFreeStokesOperators::OperatorCellData<dim,GMGNumberType> > level_cell_data;
+      MGLevelObject<GMGABlockMatrixType> mg_matrices;
+      MGLevelObject<MatrixFreeOperators::MGInterfaceOperator<GMGABlockMatrixType> > mg_interface_matrices;
+      MGConstrainedDoFs mg_constrained_dofs;
+      MGConstrainedDoFs mg_constrained_dofs_projection;
+      MGTransferMatrixFree<dim,GMGNumberType> mg_transfer;
+      MGTransferMatrixFree<dim,double> mg_transfer_projection;
+      MGSmootherPrecondition<GMGABlockMatrixType,SmootherType,GMGVectorType> mg_smoother;
+      MGCoarseGridApplySmoother<GMGVectorType> mg_coarse;
+
+      /**
+       * The cell-wise averaged viscosity on the active level and its
+       * representation on all multigrid levels.
+       */
+      dealii::LinearAlgebra::distributed::Vector<double> active_viscosity_vector;
+      MGLevelObject<dealii::LinearAlgebra::distributed::Vector<double> > level_viscosity_vector;
+  };
+#endif
+}
+
+
+#endif
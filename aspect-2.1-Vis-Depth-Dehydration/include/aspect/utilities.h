@@ -25,10 +25,12 @@
 #include <aspect/global.h>
 
 #include <array>
+#include <exception>
 #include <deal.II/base/point.h>
 #include <deal.II/base/conditional_ostream.h>
 #include <deal.II/base/table_indices.h>
 #include <deal.II/base/function_lib.h>
+#include <deal.II/base/thread_management.h>
 #include <deal.II/dofs/dof_handler.h>
 #include <deal.II/fe/component_mask.h>
 
@@ -337,6 +339,32 @@ namespace aspect
                                                       double theta,   // colatitude (radians)
                                                       double phi );   // longitude (radians)
 
+    /**
+     * Evaluate all real spherical harmonics up to and including degree
+     * @p max_degree at the point given by the colatitude @p theta and
+     * the longitude @p phi (both in radians). The normalization is the
+     * same as in real_spherical_harmonic(), but instead of evaluating
+     * every function separately, the associated Legendre functions of all
+     * degrees and orders are computed together with the stable three-term
+     * recurrence for fully normalized functions, and the $\cos m\phi$ and
+     * $\sin m\phi$ factors by repeated rotation. This is much cheaper
+     * than calling real_spherical_harmonic() for each degree and order if
+     * all of them are needed at the same point.
+     *
+     * On return, @p cos_components and @p sin_components have
+     * $(l_{max}+1)(l_{max}+2)/2$ entries each, and the value for
+     * degree $l$ and order $0\le m\le l$ is stored at index
+     * $l(l+1)/2+m$, i.e., in the same order in which a loop over all
+     * degrees and, for each degree, over all orders would visit them. The
+     * vectors are resized if necessary, which makes it possible to reuse
+     * them across many points without allocating memory.
+     */
+    void real_spherical_harmonics (const unsigned int max_degree,
+                                   const double theta,
+                                   const double phi,
+                                   std::vector<double> &cos_components,
+                                   std::vector<double> &sin_components);
+
     /**
      * A struct to enable numerical output with a comma as thousands separator
      */
@@ -539,6 +567,31 @@ namespace aspect
      * followed by the second and so on in order to assign the correct data to
      * the prescribed coordinates. The coordinates do not need to be
      * equidistant.
+     *
+     * Instead of a text file, the data can also be provided in a binary
+     * format that contains the same table, and that can be created from
+     * a text file with write_binary_file(). A binary file starts with the
+     * eight characters 'ASPECTBD', followed by the 64-bit unsigned integers
+     * format version (currently 1), @p dim, the number of data components,
+     * the number of grid points in each of the three coordinate directions
+     * (1 for unused directions), and the number of bytes of the block of
+     * column names that follows the header. This block contains the names
+     * of the data columns separated by newlines, padded with zeros to a
+     * multiple of eight bytes. It is followed by the minimum and maximum of
+     * each data component (in this order, for all components), the
+     * coordinate values in each direction (first all coordinates of the
+     * first direction, then of the second, and so on), and finally the data
+     * values, one component after the other, each in the same order as the
+     * lines of a text file. All values are stored as double precision
+     * numbers in the byte order of the machine that wrote the file.
+     *
+     * Binary files are memory-mapped by every process, so reading them does
+     * not require any parsing, and processes on the same machine share the
+     * data through the page cache of the operating system. Text files are
+     * only parsed by the first process; the data table is then placed into
+     * a memory window that is shared by all processes on the same machine
+     * (if the MPI library supports MPI-3 shared memory), so that only one
+     * copy of the table is kept per machine.
      */
     template <int dim>
     class AsciiDataLookup
@@ -565,14 +618,65 @@ namespace aspect
         AsciiDataLookup(const double scale_factor);
 
         /**
-         * Loads a data text file. Throws an exception if the file does not
-         * exist, if the data file format is incorrect or if the file grid
-         * changes over model runtime.
+         * Destructor. Releases the memory that holds the data table.
+         */
+        ~AsciiDataLookup();
+
+        /**
+         * Loads a data file, either in text or in binary format (see the
+         * documentation of this class). Throws an exception if the file does
+         * not exist, if the data file format is incorrect or if the file grid
+         * changes over model runtime. This function needs to be called on all
+         * processes of @p communicator.
          */
         void
         load_file(const std::string &filename,
                   const MPI_Comm &communicator);
 
+        /**
+         * The first of the two parts of load_file(): Read and parse a data
+         * file on the current process only, if @p read_file_content is true,
+         * and keep the result until distribute_file() is called. This
+         * function does not communicate and does not throw (errors are
+         * reported by distribute_file()), so it can run on a separate
+         * thread, for example to read the next file of a time series
+         * while the current one is still in use. The data that is
+         * currently available through get_data() must not be used while
+         * this function runs, because the parsing already overwrites the
+         * coordinates of the table.
+         *
+         * load_file() reads the file on the first process of its
+         * communicator, so @p read_file_content should only be true on
+         * that process. If the file is a binary file, this function only
+         * asks the operating system to start reading it, because every
+         * process maps binary files into its own memory.
+         */
+        void
+        read_file(const std::string &filename,
+                  const bool read_file_content);
+
+        /**
+         * The second of the two parts of load_file(): Distribute the data
+         * that was read by read_file() to all processes of
+         * @p communicator, and make it available through get_data().
+         * Throws an exception on all processes if reading the file
+         * failed. This function needs to be called on all processes of
+         * @p communicator, after read_file() has been called (and has
+         * finished) on all of them.
+         */
+        void
+        distribute_file(const MPI_Comm &communicator);
+
+        /**
+         * Write the currently loaded data table into a file in the binary
+         * format described in the documentation of this class. The data is
+         * written without the scale factor applied, so that the file can be
+         * used in place of the file it was read from. This can be used to
+         * convert text files into binary files.
+         */
+        void
+        write_binary_file(const std::string &filename) const;
+
         /**
          * Returns the computed data (velocity, temperature, etc. - according
          * to the used plugin) in Cartesian coordinates.
@@ -637,11 +741,40 @@ namespace aspect
         std::vector<std::string> data_component_names;
 
         /**
-         * Interpolation functions to access the data.
-         * Either InterpolatedUniformGridData or InterpolatedTensorProductGridData;
-         * the type is determined from the grid specified in the data file.
+         * A pointer to the data values of all components, stored one
+         * component after the other, each in the order of the lines of the
+         * data file (i.e., with the first coordinate ascending first). The
+         * values are interpolated linearly in each coordinate direction by
+         * get_data(), in the same way as the InterpolatedUniformGridData
+         * or InterpolatedTensorProductGridData classes would do, depending
+         * on whether the coordinates are equidistant. The data is stored
+         * without the scale factor applied.
+         *
+         * Depending on how the data was read, this points into
+         * @p local_data_values, into the window @p shared_data_window shared
+         * among the processes on one machine, or into the memory mapped
+         * binary file @p mapped_file.
+         */
+        const double *data_values;
+
+        /**
+         * The memory for the data values if they are neither shared between
+         * processes nor memory mapped.
          */
-        std::vector<std::unique_ptr<Function<dim>>> data;
+        std::vector<double> local_data_values;
+
+        /**
+         * The MPI window shared by all processes on one machine that holds
+         * the data values, or MPI_WIN_NULL.
+         */
+        MPI_Win shared_data_window;
+
+        /**
+         * The start and the size of the memory mapped binary data file, or
+         * nullptr and zero.
+         */
+        void        *mapped_file;
+        std::size_t  mapped_file_size;
 
         /**
          * The coordinate values in each direction as specified in the data file.
@@ -675,6 +808,19 @@ namespace aspect
          */
         bool coordinate_values_are_equidistant;
 
+        /**
+         * The name of the file last passed to read_file(), whether that
+         * file is a binary file, and, if the file content was read on this
+         * process, the data values and component extrema of a text file
+         * and any error that happened while reading it. These are used by
+         * distribute_file().
+         */
+        std::string         read_filename;
+        bool                read_file_is_binary;
+        std::vector<double> read_data_values;
+        std::vector<double> read_component_extrema;
+        std::exception_ptr  read_file_exception;
+
         /**
          * Computes the table indices of each entry in the input data file.
          * The index depends on dim, grid_dim and the number of components.
@@ -682,6 +828,40 @@ namespace aspect
         TableIndices<dim>
         compute_table_indices(const unsigned int i) const;
 
+        /**
+         * Parse the content of a data text file. Fills the names of the
+         * data columns, the number of points, and the coordinate values,
+         * and returns the data values in the order described for
+         * @p data_values, as well as the minimum and maximum of each data
+         * component (one after the other).
+         */
+        void
+        parse_text_file(const std::string &file_content,
+                        const std::string &filename,
+                        std::vector<double> &values,
+                        std::vector<double> &component_extrema);
+
+        /**
+         * Memory map a binary data file and read its header. Fills the
+         * names of the data columns, the number of points, the coordinate
+         * values, and @p data_values. Returns the minimum and maximum of
+         * each data component.
+         */
+        std::vector<double>
+        map_binary_file(const std::string &filename);
+
+        /**
+         * Release the memory that holds the data values.
+         */
+        void
+        release_data_values();
+
+        /**
+         * Check that the number of grid points @p points in each direction
+         * matches the one of previously read files, and store them.
+         */
+        void
+        set_table_points(const TableIndices<dim> &points);
     };
 
     /**
@@ -748,6 +928,12 @@ namespace aspect
          */
         AsciiDataBoundary();
 
+        /**
+         * Destructor. Waits for the data files that are read in the
+         * background, if any.
+         */
+        ~AsciiDataBoundary();
+
         /**
          * Initialization function. This function is called once at the
          * beginning of the program. Checks preconditions.
@@ -762,6 +948,12 @@ namespace aspect
          * the current plugin, this function loads the next data files if
          * necessary and outputs a warning if the end of the set of data files
          * is reached.
+         *
+         * While the model time is between two data files, the files that
+         * will be needed after the next one are read and parsed on a
+         * background thread, so that the time step at which the model time
+         * crosses into the next interval only needs to distribute the data
+         * among the processes.
          */
         void
         update();
@@ -877,6 +1069,34 @@ namespace aspect
         std::map<types::boundary_id,
             std::unique_ptr<aspect::Utilities::AsciiDataLookup<dim-1> > > old_lookups;
 
+        /**
+         * Map between the boundary id and the data objects into which the
+         * files after the ones in @p lookups are read in the background.
+         */
+        std::map<types::boundary_id,
+            std::unique_ptr<aspect::Utilities::AsciiDataLookup<dim-1> > > next_lookups;
+
+        /**
+         * The thread that reads the data files into @p next_lookups.
+         */
+        Threads::Thread<void> prefetch_thread;
+
+        /**
+         * Whether data files are read (or have been read) into
+         * @p next_lookups, and their number.
+         */
+        bool next_files_prefetched;
+        int prefetched_file_number;
+
+        /**
+         * Start reading the data files with number @p file_number into
+         * @p next_lookups on a background thread, if these files exist for
+         * all boundaries. The data is distributed among the processes by
+         * update_data() once it is needed.
+         */
+        void
+        prefetch_files (const int file_number);
+
         /**
          * Handles the update of the data in lookup.
          */
@@ -26,6 +26,7 @@
 #include <deal.II/base/utilities.h>
 #include <deal.II/base/table.h>
 #include <fstream>
+#include <functional>
 #include <iostream>
 
 #include <boost/property_tree/xml_parser.hpp>
@@ -147,67 +148,129 @@ namespace aspect
       GPlatesLookup<dim>::load_file(const std::string &filename,
                                     const MPI_Comm &comm)
       {
-        // Read data from disk and distribute among processes
-        std::istringstream filecontent(
-          Utilities::read_and_distribute_file_content(filename, comm));
+        read_file(filename, Utilities::MPI::this_mpi_process(comm) == 0);
+        distribute_file(comm);
+      }
 
-        boost::property_tree::ptree pt;
+      template <int dim>
+      void
+      GPlatesLookup<dim>::read_file(const std::string &filename,
+                                    const bool read_file_content)
+      {
+        read_velocity_values[0].reinit(0,0);
+        read_velocity_values[1].reinit(0,0);
+        read_file_exception = std::exception_ptr();
 
-        // populate tree structure pt
-        read_xml(filecontent, pt);
+        if (read_file_content == false)
+          return;
 
-        const unsigned int n_points = pt.get_child("gpml:FeatureCollection.gml:featureMember.gpml:VelocityField.gml:domainSet.gml:MultiPoint").size();
+        // This function may run on a thread other than the one that called
+        // MPI_Init, so it must not communicate. Keep any error until
+        // distribute_file() can tell the other processes about it.
+        try
+          {
+            std::ifstream filestream(filename.c_str());
+            AssertThrow (filestream,
+                         ExcMessage (std::string("Could not open file <") + filename + ">."));
 
-        // These formulas look magic, but they are the proper solution to the equation:
-        // n_points = n_theta * n_phi with n_phi = 2 * (n_theta - 1)
-        // From the XML information we only know n_points, but need n_theta
-        // and n_phi to properly size the arrays and get the grip point positions
-        const double dn_theta = 0.5 + std::sqrt(0.25 + n_points/2);
-        const unsigned int n_theta = static_cast<unsigned int> (dn_theta);
-        const unsigned int n_phi = static_cast<unsigned int> (2 * (dn_theta - 1));
+            boost::property_tree::ptree pt;
 
-        AssertThrow(dn_theta - n_theta <= 1e-5,
-                    ExcMessage("The velocity file has a grid structure that is not readable. Please refer to the manual for a proper grid structure."));
+            // populate tree structure pt
+            read_xml(filestream, pt);
 
-        delta_theta =   numbers::PI / (n_theta-1);
-        delta_phi   = 2*numbers::PI / n_phi;
+            const unsigned int n_points = pt.get_child("gpml:FeatureCollection.gml:featureMember.gpml:VelocityField.gml:domainSet.gml:MultiPoint").size();
 
-        /**
-         * Two tables (one for the theta and one for the phi component)
-         * which contain the velocities at every point.
-         * velocity_values[0] is the table for the theta component, whereas
-         * velocity_values[1] is the table for the phi component.
-         */
-        Table<2,double> velocity_values[2] = {Table<2,double>(n_theta,n_phi), Table<2,double>(n_theta,n_phi)};
+            // These formulas look magic, but they are the proper solution to the equation:
+            // n_points = n_theta * n_phi with n_phi = 2 * (n_theta - 1)
+            // From the XML information we only know n_points, but need n_theta
+            // and n_phi to properly size the arrays and get the grip point positions
+            const double dn_theta = 0.5 + std::sqrt(0.25 + n_points/2);
+            const unsigned int n_theta = static_cast<unsigned int> (dn_theta);
+            const unsigned int n_phi = static_cast<unsigned int> (2 * (dn_theta - 1));
+
+            AssertThrow(dn_theta - n_theta <= 1e-5,
+                        ExcMessage("The velocity file has a grid structure that is not readable. Please refer to the manual for a proper grid structure."));
+
+            read_velocity_values[0].reinit(n_theta,n_phi);
+            read_velocity_values[1].reinit(n_theta,n_phi);
+
+            std::string velos = pt.get<std::string>("gpml:FeatureCollection.gml:featureMember.gpml:VelocityField.gml:rangeSet.gml:DataBlock.gml:tupleList");
+            std::stringstream in(velos, std::ios::in);
+            AssertThrow (in,
+                         ExcMessage (std::string("Could not find velocities. Is file native gpml format for velocities?")));
+
+            // The lat-lon mesh has changed its starting longitude in gplates1.4
+            // correct for this while reading in the velocity data
+            unsigned int longitude_correction = 0;
+            if (gplates_1_4_or_higher(pt))
+              longitude_correction = n_phi/2;
+
+            unsigned int i = 0;
+            char sep;
+            Tensor<1,2> spherical_velocities;
+
+            while (in >> spherical_velocities[0] >> sep >> spherical_velocities[1])
+              {
+                const double cmyr_si = 0.01/year_in_seconds;
 
-        std::string velos = pt.get<std::string>("gpml:FeatureCollection.gml:featureMember.gpml:VelocityField.gml:rangeSet.gml:DataBlock.gml:tupleList");
-        std::stringstream in(velos, std::ios::in);
-        AssertThrow (in,
-                     ExcMessage (std::string("Could not find velocities. Is file native gpml format for velocities?")));
+                const unsigned int idx_theta = i / n_phi;
+                const unsigned int idx_phi = (i + longitude_correction) % n_phi;
 
-        // The lat-lon mesh has changed its starting longitude in gplates1.4
-        // correct for this while reading in the velocity data
-        unsigned int longitude_correction = 0;
-        if (gplates_1_4_or_higher(pt))
-          longitude_correction = n_phi/2;
+                read_velocity_values[0][idx_theta][idx_phi]= spherical_velocities[0] * cmyr_si;
+                read_velocity_values[1][idx_theta][idx_phi]= spherical_velocities[1] * cmyr_si;
 
-        unsigned int i = 0;
-        char sep;
-        Tensor<1,2> spherical_velocities;
+                i++;
+              }
 
-        while (in >> spherical_velocities[0] >> sep >> spherical_velocities[1])
+            AssertThrow(i == n_points,
+                        ExcMessage (std::string("Number of read in points does not match number of points in file. File corrupted?")));
+          }
+        catch (...)
           {
-            const double cmyr_si = 0.01/year_in_seconds;
+            read_file_exception = std::current_exception();
+          }
+      }
 
-            const unsigned int idx_theta = i / n_phi;
-            const unsigned int idx_phi = (i + longitude_correction) % n_phi;
+      template <int dim>
+      void
+      GPlatesLookup<dim>::distribute_file(const MPI_Comm &comm)
+      {
+        // broadcast the failure state, then throw
+        int read_failed = (read_file_exception ? 1 : 0);
+        MPI_Bcast(&read_failed, 1, MPI_INT, 0, comm);
+        if (read_failed == 1)
+          {
+            if (Utilities::MPI::this_mpi_process(comm) == 0)
+              {
+                std::exception_ptr read_exception;
+                std::swap(read_exception, read_file_exception);
+                std::rethrow_exception(read_exception);
+              }
+            else
+              throw QuietException();
+          }
+
+        // Only the first process has parsed the XML file. Send the
+        // (much smaller) velocity tables to the other processes, rather
+        // than the file content that every process would have to parse.
+        unsigned int n_points[2] = {static_cast<unsigned int>(read_velocity_values[0].n_rows()),
+                                    static_cast<unsigned int>(read_velocity_values[0].n_cols())
+                                   };
+        MPI_Bcast(n_points, 2, MPI_UNSIGNED, 0, comm);
 
-            velocity_values[0][idx_theta][idx_phi]= spherical_velocities[0] * cmyr_si;
-            velocity_values[1][idx_theta][idx_phi]= spherical_velocities[1] * cmyr_si;
+        const unsigned int n_theta = n_points[0];
+        const unsigned int n_phi = n_points[1];
 
-            i++;
+        for (unsigned int i = 0; i < 2; i++)
+          {
+            if (Utilities::MPI::this_mpi_process(comm) != 0)
+              read_velocity_values[i].reinit(n_theta,n_phi);
+            MPI_Bcast(&read_velocity_values[i][0][0], n_theta*n_phi, MPI_DOUBLE, 0, comm);
           }
 
+        delta_theta =   numbers::PI / (n_theta-1);
+        delta_phi   = 2*numbers::PI / n_phi;
+
         // number of intervals in the direction of theta and phi
         std::array<unsigned int,2> table_intervals;
         table_intervals[0] = n_theta - 1;
@@ -229,11 +292,9 @@ namespace aspect
             velocities[i]
               = std_cxx14::make_unique<Functions::InterpolatedUniformGridData<2>> (grid_extent,
                                                                                    table_intervals,
-                                                                                   velocity_values[i]);
+                                                                                   read_velocity_values[i]);
+            read_velocity_values[i].reinit(0,0);
           }
-
-        AssertThrow(i == n_points,
-                    ExcMessage (std::string("Number of read in points does not match number of points in file. File corrupted?")));
       }
 
       template <int dim>
@@ -539,10 +600,21 @@ namespace aspect
       point2("0.0,0.0"),
       lithosphere_thickness(0.0),
       lookup(),
-      old_lookup()
+      old_lookup(),
+      next_lookup(),
+      next_file_prefetched(false),
+      prefetched_file_number(0)
     {}
 
 
+    template <int dim>
+    GPlates<dim>::~GPlates ()
+    {
+      // the background thread writes into next_lookup
+      prefetch_thread.join ();
+    }
+
+
     template <int dim>
     void
     GPlates<dim>::initialize ()
@@ -565,6 +637,7 @@ namespace aspect
         {
           lookup = std::make_shared<internal::GPlatesLookup<dim>>(pointone, pointtwo);
           old_lookup = std::make_shared<internal::GPlatesLookup<dim>>(pointone, pointtwo);
+          next_lookup = std::make_shared<internal::GPlatesLookup<dim>>(pointone, pointtwo);
         }
       else
         AssertThrow (false,ExcMessage ("This gplates plugin can only be used when using "
@@ -618,6 +691,40 @@ namespace aspect
           else
             end_time_dependence ();
         }
+
+      // Start reading the file that follows the two we just loaded.
+      if (time_dependent)
+        prefetch_file ((decreasing_file_order)
+                       ?
+                       (current_file_number - 2)
+                       :
+                       (current_file_number + 2));
+    }
+
+
+    template <int dim>
+    void
+    GPlates<dim>::prefetch_file (const int file_number)
+    {
+      // If the file does not exist, update_data() will notice that once it
+      // needs the file.
+      const std::string filename (create_filename (file_number));
+      if (!Utilities::fexists(filename))
+        return;
+
+      // Only the first process reads the file. Determine this here,
+      // because the background thread must not make any MPI calls.
+      const bool read_file_content =
+        (Utilities::MPI::this_mpi_process(this->get_mpi_communicator()) == 0);
+
+      next_file_prefetched = true;
+      prefetched_file_number = file_number;
+
+      internal::GPlatesLookup<dim> *const next = next_lookup.get();
+      prefetch_thread = Threads::new_thread (std::function<void ()>([next, filename, read_file_content]()
+      {
+        next->read_file(filename, read_file_content);
+      }));
     }
 
 
@@ -672,7 +779,21 @@ namespace aspect
 
               const bool load_both_files = std::abs(current_file_number - old_file_number) >= 1;
 
+              // The file we need next may still be read in the background.
+              prefetch_thread.join ();
+
               update_data(load_both_files);
+
+              next_file_prefetched = false;
+
+              // Start reading the file of the following interval, so that
+              // it is available once the model time gets there.
+              if (time_dependent)
+                prefetch_file ((decreasing_file_order)
+                               ?
+                               (current_file_number - 2)
+                               :
+                               (current_file_number + 2));
             }
 
           time_weight = (time_since_start / data_file_time_step)
@@ -719,8 +840,19 @@ namespace aspect
                         << filename << "." << std::endl << std::endl;
       if (Utilities::fexists(filename))
         {
-          lookup.swap(old_lookup);
-          lookup->load_file(filename,this->get_mpi_communicator());
+          // If the file was already read in the background, we only need to
+          // distribute its velocities, and the current data becomes the old data.
+          if (next_file_prefetched && prefetched_file_number == next_file_number)
+            {
+              next_lookup->distribute_file(this->get_mpi_communicator());
+              lookup.swap(old_lookup);
+              lookup.swap(next_lookup);
+            }
+          else
+            {
+              lookup.swap(old_lookup);
+              lookup->load_file(filename,this->get_mpi_communicator());
+            }
         }
 
       // If next file does not exist, end time dependent part with current_time_step.
@@ -0,0 +1,245 @@
+/*
+  Copyright (C) 2019 by the authors of the ASPECT code.
+
+  This file is part of ASPECT.
+
+  ASPECT is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2, or (at your option)
+  any later version.
+
+  ASPECT is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with ASPECT; see the file LICENSE.  If not see
+  <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <aspect/material_model/evaluation_cache.h>
+
+#include <cstring>
+
+namespace aspect
+{
+  namespace MaterialModel
+  {
+    template <int dim>
+    EvaluationCache<dim>::Entry::Entry ()
+      :
+      timestep_number (numbers::invalid_unsigned_int),
+      nonlinear_iteration (numbers::invalid_unsigned_int),
+      outputs (0, 0)
+    {}
+
+
+
+    template <int dim>
+    EvaluationCache<dim>::EvaluationCache (const unsigned int max_entries_per_cell)
+      :
+      max_entries_per_cell (max_entries_per_cell),
+      n_hits (n_mutexes, 0),
+      n_misses (n_mutexes, 0)
+    {
+      Assert (max_entries_per_cell > 0, ExcLowerRange (max_entries_per_cell, 1));
+    }
+
+
+
+    template <int dim>
+    void
+    EvaluationCache<dim>::reinit (const unsigned int n_active_cells)
+    {
+      entries.clear ();
+      entries.resize (n_active_cells);
+    }
+
+
+
+    template <int dim>
+    void
+    EvaluationCache<dim>::evaluate (const Interface<dim>            &material_model,
+                                    const MaterialModelInputs<dim>  &in,
+                                    MaterialModelOutputs<dim>       &out,
+                                    const unsigned int               timestep_number,
+                                    const unsigned int               nonlinear_iteration)
+    {
+      // we can only cache evaluations on a cell, and we do not know how to
+      // store additional inputs and outputs
+      if (in.current_cell.state() != IteratorState::valid
+          || in.additional_inputs.size() > 0
+          || out.additional_outputs.size() > 0
+          || in.current_cell->active_cell_index() >= entries.size())
+        {
+          material_model.evaluate (in, out);
+          return;
+        }
+
+      const unsigned int cell_index = in.current_cell->active_cell_index();
+      std::mutex &mutex = mutexes[cell_index % n_mutexes];
+
+      std::vector<double> packed_inputs;
+      pack_inputs (in, packed_inputs);
+
+      // see if we have a matching entry
+      {
+        std::lock_guard<std::mutex> lock (mutex);
+        for (const Entry &entry : entries[cell_index])
+          if (entry.timestep_number == timestep_number
+              && entry.nonlinear_iteration == nonlinear_iteration
+              && entry.inputs.size() == packed_inputs.size()
+              && std::memcmp (entry.inputs.data(), packed_inputs.data(),
+                              packed_inputs.size() * sizeof(double)) == 0)
+            {
+              copy_outputs (entry.outputs, out);
+              ++n_hits[cell_index % n_mutexes];
+              return;
+            }
+      }
+
+      // if not, evaluate the material model without holding the lock, and
+      // then store the result
+      material_model.evaluate (in, out);
+
+      std::lock_guard<std::mutex> lock (mutex);
+      ++n_misses[cell_index % n_mutexes];
+
+      std::vector<Entry> &cell_entries = entries[cell_index];
+
+      // replace an entry from an earlier time step or nonlinear iteration
+      // if there is one, otherwise add a new entry or replace the oldest one
+      typename std::vector<Entry>::iterator target = cell_entries.end();
+      for (typename std::vector<Entry>::iterator entry = cell_entries.begin(); entry != cell_entries.end(); ++entry)
+        if (entry->timestep_number != timestep_number
+            || entry->nonlinear_iteration != nonlinear_iteration)
+          {
+            target = entry;
+            break;
+          }
+
+      if (target == cell_entries.end())
+        {
+          if (cell_entries.size() < max_entries_per_cell)
+            {
+              cell_entries.emplace_back ();
+              target = cell_entries.end() - 1;
+            }
+          else
+            {
+              cell_entries.erase (cell_entries.begin());
+              cell_entries.emplace_back ();
+              target = cell_entries.end() - 1;
+            }
+        }
+
+      target->timestep_number = timestep_number;
+      target->nonlinear_iteration = nonlinear_iteration;
+      target->inputs.swap (packed_inputs);
+      copy_outputs (out, target->outputs);
+    }
+
+
+
+    template <int dim>
+    std::pair<unsigned long int, unsigned long int>
+    EvaluationCache<dim>::get_statistics () const
+    {
+      unsigned long int hits = 0;
+      unsigned long int misses = 0;
+      for (unsigned int i=0; i<n_mutexes; ++i)
+        {
+          hits += n_hits[i];
+          misses += n_misses[i];
+        }
+      return std::make_pair (hits, misses);
+    }
+
+
+
+    template <int dim>
+    void
+    EvaluationCache<dim>::reset_statistics ()
+    {
+      std::fill (n_hits.begin(), n_hits.end(), 0);
+      std::fill (n_misses.begin(), n_misses.end(), 0);
+    }
+
+
+
+    template <int dim>
+    void
+    EvaluationCache<dim>::pack_inputs (const MaterialModelInputs<dim> &in,
+                                       std::vector<double> &packed_inputs)
+    {
+      const unsigned int n_points = in.temperature.size();
+      const unsigned int n_compositional_fields = (n_points > 0 ? in.composition[0].size() : 0);
+
+      packed_inputs.clear ();
+      packed_inputs.reserve (5 + n_points * (2 + 3*dim + n_compositional_fields
+                                             + SymmetricTensor<2,dim>::n_independent_components));
+
+      // first the sizes of all arrays, so that inputs with and without
+      // strain rates (or other optional inputs) are never confused
+      packed_inputs.push_back (n_points);
+      packed_inputs.push_back (n_compositional_fields);
+      packed_inputs.push_back (in.pressure_gradient.size());
+      packed_inputs.push_back (in.velocity.size());
+      packed_inputs.push_back (in.strain_rate.size());
+
+      for (unsigned int q=0; q<n_points; ++q)
+        {
+          for (unsigned int d=0; d<dim; ++d)
+            packed_inputs.push_back (in.position[q][d]);
+          packed_inputs.push_back (in.temperature[q]);
+          packed_inputs.push_back (in.pressure[q]);
+          for (unsigned int c=0; c<n_compositional_fields; ++c)
+            packed_inputs.push_back (in.composition[q][c]);
+        }
+
+      for (unsigned int q=0; q<in.pressure_gradient.size(); ++q)
+        for (unsigned int d=0; d<dim; ++d)
+          packed_inputs.push_back (in.pressure_gradient[q][d]);
+
+      for (unsigned int q=0; q<in.velocity.size(); ++q)
+        for (unsigned int d=0; d<dim; ++d)
+          packed_inputs.push_back (in.velocity[q][d]);
+
+      for (unsigned int q=0; q<in.strain_rate.size(); ++q)
+        for (unsigned int i=0; i<SymmetricTensor<2,dim>::n_independent_components; ++i)
+          packed_inputs.push_back (in.strain_rate[q].access_raw_entry(i));
+    }
+
+
+
+    template <int dim>
+    void
+    EvaluationCache<dim>::copy_outputs (const MaterialModelOutputs<dim> &source,
+                                        MaterialModelOutputs<dim> &destination)
+    {
+      destination.viscosities = source.viscosities;
+      destination.densities = source.densities;
+      destination.thermal_expansion_coefficients = source.thermal_expansion_coefficients;
+      destination.specific_heat = source.specific_heat;
+      destination.thermal_conductivities = source.thermal_conductivities;
+      destination.compressibilities = source.compressibilities;
+      destination.entropy_derivative_pressure = source.entropy_derivative_pressure;
+      destination.entropy_derivative_temperature = source.entropy_derivative_temperature;
+      destination.reaction_terms = source.reaction_terms;
+    }
+  }
+}
+
+// explicit instantiations
+namespace aspect
+{
+  namespace MaterialModel
+  {
+#define INSTANTIATE(dim) \
+  template class EvaluationCache<dim>;
+
+    ASPECT_INSTANTIATE(INSTANTIATE)
+  }
+}
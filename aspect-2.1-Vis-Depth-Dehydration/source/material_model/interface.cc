@@ -106,6 +106,28 @@ namespace aspect
     {}
 
 
+
+    template <int dim>
+    bool
+    Interface<dim>::supports_batched_evaluation () const
+    {
+      return false;
+    }
+
+
+
+    template <int dim>
+    void
+    Interface<dim>::evaluate_batch (const MaterialModel::MaterialModelBatchInputs<dim> &/*in*/,
+                                    MaterialModel::MaterialModelBatchOutputs<dim> &/*out*/) const
+    {
+      AssertThrow (false,
+                   ExcMessage ("This material model does not implement a batched "
+                               "evaluation. Check supports_batched_evaluation() "
+                               "before calling evaluate_batch(), or use evaluate()."));
+    }
+
+
 // -------------------------------- Deal with registering material models and automating
 // -------------------------------- their setup and selection at run time
 
@@ -413,6 +435,79 @@ namespace aspect
     {}
 
 
+
+    template <int dim>
+    MaterialModelBatchInputs<dim>::MaterialModelBatchInputs (const MaterialModelInputs<dim> &in)
+      :
+      n_points (in.temperature.size()),
+      n_batches ((n_points + VectorizedArray<double>::n_array_elements - 1) / VectorizedArray<double>::n_array_elements),
+      temperature (n_batches),
+      pressure (n_batches),
+      composition (n_points > 0 ? in.composition[0].size() : 0,
+                   AlignedVector<VectorizedArray<double> > (n_batches)),
+      strain_rate_invariant (in.strain_rate.size() > 0 ? n_batches : 0)
+    {
+      const unsigned int width = VectorizedArray<double>::n_array_elements;
+
+      for (unsigned int batch=0; batch<n_batches; ++batch)
+        for (unsigned int v=0; v<width; ++v)
+          {
+            // fill unused lanes of the last batch with the last point
+            const unsigned int i = std::min (batch*width + v, n_points-1);
+
+            temperature[batch][v] = in.temperature[i];
+            pressure[batch][v] = in.pressure[i];
+            for (unsigned int c=0; c<composition.size(); ++c)
+              composition[c][batch][v] = in.composition[i][c];
+
+            if (strain_rate_invariant.size() > 0)
+              strain_rate_invariant[batch][v] = std::sqrt(std::fabs(second_invariant(deviator(in.strain_rate[i]))));
+          }
+    }
+
+
+
+    template <int dim>
+    MaterialModelBatchOutputs<dim>::MaterialModelBatchOutputs (const MaterialModelBatchInputs<dim> &in)
+      :
+      n_points (in.n_points),
+      viscosities (in.n_batches),
+      densities (in.n_batches),
+      thermal_expansion_coefficients (in.n_batches),
+      specific_heat (in.n_batches),
+      thermal_conductivities (in.n_batches),
+      compressibilities (in.n_batches),
+      entropy_derivative_pressure (in.n_batches),
+      entropy_derivative_temperature (in.n_batches)
+    {}
+
+
+
+    template <int dim>
+    void
+    MaterialModelBatchOutputs<dim>::unpack (MaterialModelOutputs<dim> &out,
+                                            const bool copy_viscosities) const
+    {
+      const unsigned int width = VectorizedArray<double>::n_array_elements;
+
+      for (unsigned int i=0; i<n_points; ++i)
+        {
+          const unsigned int batch = i / width;
+          const unsigned int v = i % width;
+
+          if (copy_viscosities)
+            out.viscosities[i] = viscosities[batch][v];
+          out.densities[i] = densities[batch][v];
+          out.thermal_expansion_coefficients[i] = thermal_expansion_coefficients[batch][v];
+          out.specific_heat[i] = specific_heat[batch][v];
+          out.thermal_conductivities[i] = thermal_conductivities[batch][v];
+          out.compressibilities[i] = compressibilities[batch][v];
+          out.entropy_derivative_pressure[i] = entropy_derivative_pressure[batch][v];
+          out.entropy_derivative_temperature[i] = entropy_derivative_temperature[batch][v];
+        }
+    }
+
+
     namespace MaterialAveraging
     {
       std::string get_averaging_operation_names ()
@@ -956,6 +1051,10 @@ namespace aspect
   \
   template struct MaterialModelOutputs<dim>; \
   \
+  template struct MaterialModelBatchInputs<dim>; \
+  \
+  template struct MaterialModelBatchOutputs<dim>; \
+  \
   template class AdditionalMaterialOutputs<dim>; \
   \
   template class NamedAdditionalMaterialOutputs<dim>; \
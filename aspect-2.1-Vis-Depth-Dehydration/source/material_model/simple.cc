@@ -32,57 +32,106 @@ namespace aspect
     evaluate(const MaterialModel::MaterialModelInputs<dim> &in,
              MaterialModel::MaterialModelOutputs<dim> &out) const
     {
+      const MaterialModel::MaterialModelBatchInputs<dim> batch_in (in);
+      MaterialModel::MaterialModelBatchOutputs<dim> batch_out (batch_in);
+
+      evaluate_batch (batch_in, batch_out);
+      batch_out.unpack (out, true);
+
+      // Change in composition due to chemical reactions at the
+      // given positions. The term reaction_terms[i][c] is the
+      // change in compositional field c at point i.
       for (unsigned int i=0; i < in.position.size(); ++i)
+        for (unsigned int c=0; c<in.composition[i].size(); ++c)
+          out.reaction_terms[i][c] = 0.0;
+    }
+
+
+
+    template <int dim>
+    bool
+    Simple<dim>::
+    supports_batched_evaluation () const
+    {
+      return true;
+    }
+
+
+
+    template <int dim>
+    void
+    Simple<dim>::
+    evaluate_batch(const MaterialModel::MaterialModelBatchInputs<dim> &in,
+                   MaterialModel::MaterialModelBatchOutputs<dim> &out) const
+    {
+      typedef VectorizedArray<double> vector_t;
+      const unsigned int width = vector_t::n_array_elements;
+
+      // the part of the exponent of the Arrhenius law that is evaluated
+      // at the bottom of the model, which is the same for all points
+      const double reference_exponent = (activation_energy_zxb+reference_rho*gravity_cons_zxb*model_height_zxb*activation_volume_zxb)
+                                        /(gas_constant_zxb*model_bottom_tem_zxb);
+      const double log_composition_viscosity_prefactor = std::log(composition_viscosity_prefactor);
+      const bool has_composition = (in.composition.size() > 0);
+
+      for (unsigned int batch=0; batch<in.n_batches; ++batch)
         {
-          //const double delta_temp = in.temperature[i]-reference_T;
-          const double temperature_dependence
-            = ((in.pressure[i]<=3300*9.8*80000) || (in.temperature[i]>=1120.7+273+132.9*in.pressure[i]/1e9-5.1*(in.pressure[i]/1e9)*(in.pressure[i]/1e9))
-               ?
-               std::max(std::min(200*std::exp((activation_energy_zxb+in.pressure[i]*activation_volume_zxb)/(gas_constant_zxb*in.temperature[i])-(activation_energy_zxb+reference_rho*gravity_cons_zxb*model_height_zxb*activation_volume_zxb)/(gas_constant_zxb*model_bottom_tem_zxb)),
-                                 maximum_thermal_prefactor),
-                        minimum_thermal_prefactor)
-               :
-               std::max(std::min(1*std::exp((activation_energy_zxb+in.pressure[i]*activation_volume_zxb)/(gas_constant_zxb*in.temperature[i])-(activation_energy_zxb+reference_rho*gravity_cons_zxb*model_height_zxb*activation_volume_zxb)/(gas_constant_zxb*model_bottom_tem_zxb)),
-                                 maximum_thermal_prefactor),
-                        minimum_thermal_prefactor));
-
-          out.viscosities[i] = ((composition_viscosity_prefactor != 1.0) && (in.composition[i].size()>0))
-                               ?
-                               // Geometric interpolation
-                               std::pow(10.0, ((1-in.composition[i][0]) * std::log10(eta *
-                                                                                     temperature_dependence)
-                                               + in.composition[i][0] * std::log10(eta *
-                                                                                   composition_viscosity_prefactor *
-                                                                                   temperature_dependence)))
-                               :
-                               temperature_dependence * eta;
-
-          const double c = (in.composition[i].size()>0)
-                           ?
-                           std::max(0.0, in.composition[i][0])
-                           :
-                           0.0;
-
-          out.densities[i] = reference_rho * (1 - thermal_alpha * (in.temperature[i] - reference_T))
-                             + compositional_delta_rho * c;
-
-          out.thermal_expansion_coefficients[i] = thermal_alpha;
-          out.specific_heat[i] = reference_specific_heat;
-          out.thermal_conductivities[i] = k_value;
-          out.compressibilities[i] = 0.0;
+          const vector_t &temperature = in.temperature[batch];
+          const vector_t &pressure = in.pressure[batch];
+
+          // The prefactor of the Arrhenius law is larger for the dehydrated
+          // mantle, i.e., above a depth of 80 km or above the solidus. This
+          // is the only branch of the model, so evaluate it lane by lane and
+          // do everything else on whole batches.
+          vector_t arrhenius_prefactor;
+          for (unsigned int v=0; v<width; ++v)
+            {
+              const double p = pressure[v];
+              const double T = temperature[v];
+              arrhenius_prefactor[v] = ((p<=3300*9.8*80000) || (T>=1120.7+273+132.9*p/1e9-5.1*(p/1e9)*(p/1e9))
+                                        ?
+                                        200
+                                        :
+                                        1);
+            }
+
+          const vector_t temperature_dependence
+            = std::max(std::min(arrhenius_prefactor
+                                * std::exp((activation_energy_zxb+pressure*activation_volume_zxb)/(gas_constant_zxb*temperature)
+                                           - reference_exponent),
+                                make_vectorized_array(maximum_thermal_prefactor)),
+                       make_vectorized_array(minimum_thermal_prefactor));
+
+          // Geometric interpolation between eta and eta*xi, which is the
+          // same as multiplying by xi^c
+          if ((composition_viscosity_prefactor != 1.0) && has_composition)
+            out.viscosities[batch] = eta * temperature_dependence
+                                     * std::exp(in.composition[0][batch] * log_composition_viscosity_prefactor);
+          else
+            out.viscosities[batch] = temperature_dependence * eta;
+
+          const vector_t c = (has_composition
+                              ?
+                              std::max(make_vectorized_array(0.0), in.composition[0][batch])
+                              :
+                              make_vectorized_array(0.0));
+
+          out.densities[batch] = reference_rho * (1. - thermal_alpha * (temperature - reference_T))
+                                 + compositional_delta_rho * c;
+
+          out.thermal_expansion_coefficients[batch] = thermal_alpha;
+          out.specific_heat[batch] = reference_specific_heat;
+          out.thermal_conductivities[batch] = k_value;
+          out.compressibilities[batch] = 0.0;
           // Pressure derivative of entropy at the given positions.
-          out.entropy_derivative_pressure[i] = 0.0;
+          out.entropy_derivative_pressure[batch] = 0.0;
           // Temperature derivative of entropy at the given positions.
-          out.entropy_derivative_temperature[i] = 0.0;
-          // Change in composition due to chemical reactions at the
-          // given positions. The term reaction_terms[i][c] is the
-          // change in compositional field c at point i.
-          for (unsigned int c=0; c<in.composition[i].size(); ++c)
-            out.reaction_terms[i][c] = 0.0;
+          out.entropy_derivative_temperature[batch] = 0.0;
         }
     }
 
 
+
     template <int dim>
     double
     Simple<dim>::
@@ -534,6 +534,32 @@ namespace aspect
     evaluate(const MaterialModel::MaterialModelInputs<dim> &in,
              MaterialModel::MaterialModelOutputs<dim> &out) const
     {
+      // Use the batched evaluation whenever we do not need to fill
+      // quantities that are only available point by point
+      if (supports_batched_evaluation()
+          &&
+          out.template get_additional_output<MaterialModel::MaterialModelDerivatives<dim> >() == nullptr
+          &&
+          out.template get_additional_output<PlasticAdditionalOutputs<dim> >() == nullptr
+          &&
+          !(this->get_parameters().formulation_temperature_equation ==
+            Parameters<dim>::Formulation::TemperatureEquation::reference_density_profile &&
+            this->get_adiabatic_conditions().is_initialized()))
+        {
+          const MaterialModel::MaterialModelBatchInputs<dim> batch_in (in);
+          MaterialModel::MaterialModelBatchOutputs<dim> batch_out (batch_in);
+
+          evaluate_batch (batch_in, batch_out);
+          batch_out.unpack (out, in.strain_rate.size() > 0);
+
+          // Without strain weakening, there are no changes in the compositional fields
+          for (unsigned int i=0; i < in.temperature.size(); ++i)
+            for (unsigned int c=0; c<in.composition[i].size(); ++c)
+              out.reaction_terms[i][c] = 0.0;
+
+          return;
+        }
+
       // Store which components do not represent volumetric compositions (e.g. strain components).
       const ComponentMask volumetric_compositions = get_volumetric_composition_mask();
 
@@ -636,6 +662,232 @@ namespace aspect
         compute_finite_strain_reaction_terms(in, out);
     }
 
+    template <int dim>
+    bool
+    ViscoPlastic<dim>::
+    supports_batched_evaluation () const
+    {
+      return (use_strain_weakening == false);
+    }
+
+
+
+    template <int dim>
+    void
+    ViscoPlastic<dim>::
+    evaluate_batch(const MaterialModel::MaterialModelBatchInputs<dim> &in,
+                   MaterialModel::MaterialModelBatchOutputs<dim> &out) const
+    {
+      Assert (supports_batched_evaluation(), ExcNotImplemented());
+
+      typedef VectorizedArray<double> vector_t;
+      const unsigned int width = vector_t::n_array_elements;
+      const unsigned int n_phases = in.composition.size() + 1;
+
+      AssertThrow (n_phases == densities.size(),
+                   ExcMessage ("The number of compositional fields handed to the material "
+                               "model does not match the number of material parameters."));
+
+      // Precompute the parts of the flow laws and of the yield strength that
+      // do not depend on the evaluation point. Without strain weakening, the
+      // cohesion and friction angle of each phase are constant, and the
+      // Drucker-Prager yield strength is of the form a + b * max(p,0).
+      std::vector<double> diffusion_prefactors (n_phases);
+      std::vector<double> dislocation_prefactors (n_phases);
+      std::vector<double> yield_strength_constants (n_phases);
+      std::vector<double> yield_strength_pressure_factors (n_phases);
+      for (unsigned int j=0; j<n_phases; ++j)
+        {
+          diffusion_prefactors[j] = 0.5 / prefactors_diffusion[j] *
+                                    std::pow(grain_size, grain_size_exponents_diffusion[j]);
+          dislocation_prefactors[j] = 0.5 * std::pow(prefactors_dislocation[j],-1/stress_exponents_dislocation[j]);
+
+          const double sin_phi = std::sin(angles_internal_friction[j]);
+          const double cos_phi = std::cos(angles_internal_friction[j]);
+          const double strength_inv_part = 1. / (std::sqrt(3.0) * (3.0 + sin_phi));
+          yield_strength_constants[j] = (dim==3
+                                         ?
+                                         6.0 * cohesions[j] * cos_phi * strength_inv_part
+                                         :
+                                         cohesions[j] * cos_phi);
+          yield_strength_pressure_factors[j] = (dim==3
+                                                ?
+                                                6.0 * sin_phi * strength_inv_part
+                                                :
+                                                sin_phi);
+        }
+
+      const bool compute_viscosity = (in.strain_rate_invariant.size() > 0);
+      const bool first_timestep = (this->get_timestep_number() == 0);
+
+      AlignedVector<vector_t> volume_fractions (n_phases);
+      AlignedVector<vector_t> composition_viscosities (n_phases);
+
+      for (unsigned int batch=0; batch<in.n_batches; ++batch)
+        {
+          // Compute the volume fractions as in MaterialUtilities::compute_volume_fractions():
+          // clip the compositional fields to [0,1] and normalize them if their sum exceeds one.
+          vector_t sum_composition = make_vectorized_array(0.0);
+          for (unsigned int c=0; c<in.composition.size(); ++c)
+            {
+              volume_fractions[c+1] = std::min(std::max(in.composition[c][batch], make_vectorized_array(0.0)),
+                                               make_vectorized_array(1.0));
+              sum_composition += volume_fractions[c+1];
+            }
+          volume_fractions[0] = std::max(1.0 - sum_composition, make_vectorized_array(0.0));
+          const vector_t normalization = std::max(sum_composition, make_vectorized_array(1.0));
+          for (unsigned int c=0; c<in.composition.size(); ++c)
+            volume_fractions[c+1] /= normalization;
+
+          // Equation of state and thermodynamic properties
+          const vector_t &temperature = in.temperature[batch];
+          const vector_t &pressure = in.pressure[batch];
+
+          vector_t density = make_vectorized_array(0.0);
+          vector_t thermal_expansivity = make_vectorized_array(0.0);
+          vector_t specific_heat = make_vectorized_array(0.0);
+          vector_t thermal_diffusivity = make_vectorized_array(0.0);
+          for (unsigned int j=0; j<n_phases; ++j)
+            {
+              const vector_t temperature_factor = (1.0 - thermal_expansivities[j] * (temperature - reference_T));
+
+              density += volume_fractions[j] * densities[j] * temperature_factor;
+              thermal_expansivity += volume_fractions[j] * thermal_expansivities[j];
+              specific_heat += volume_fractions[j] * heat_capacities[j];
+              thermal_diffusivity += volume_fractions[j] * thermal_diffusivities[j];
+            }
+
+          out.densities[batch] = density;
+          out.thermal_expansion_coefficients[batch] = thermal_expansivity;
+          out.specific_heat[batch] = specific_heat;
+          out.thermal_conductivities[batch] = thermal_diffusivity * specific_heat * density;
+          out.compressibilities[batch] = 0.0;
+          out.entropy_derivative_pressure[batch] = 0.0;
+          out.entropy_derivative_temperature[batch] = 0.0;
+
+          if (compute_viscosity == false)
+            continue;
+
+          // The effective strain rate. As in calculate_isostrain_viscosities(), use the
+          // reference strain rate in the first time step if the strain rate vanishes.
+          vector_t edot_ii;
+          for (unsigned int v=0; v<width; ++v)
+            edot_ii[v] = ((first_timestep && in.strain_rate_invariant[batch][v] <= std::numeric_limits<double>::min())
+                          ?
+                          ref_strain_rate
+                          :
+                          std::max(in.strain_rate_invariant[batch][v], min_strain_rate));
+          const vector_t log_edot_ii = std::log(edot_ii);
+
+          const vector_t temperature_for_viscosity = temperature + adiabatic_temperature_gradient_for_viscosity*pressure;
+          const vector_t inverse_RT = 1.0 / (constants::gas_constant*temperature_for_viscosity);
+          const vector_t positive_pressure = std::max(pressure, make_vectorized_array(0.0));
+
+          for (unsigned int j=0; j<n_phases; ++j)
+            {
+              // Power law creep, see calculate_isostrain_viscosities(). The
+              // strain rate dependence of dislocation creep is folded into
+              // the exponential to save one call to std::pow.
+              const vector_t viscosity_diffusion = diffusion_prefactors[j] *
+                                                   std::exp((activation_energies_diffusion[j] + pressure*activation_volumes_diffusion[j]) * inverse_RT);
+
+              const vector_t viscosity_dislocation = dislocation_prefactors[j] *
+                                                     std::exp((activation_energies_dislocation[j] + pressure*activation_volumes_dislocation[j]) * inverse_RT
+                                                              / stress_exponents_dislocation[j]
+                                                              + log_edot_ii * ((1. - stress_exponents_dislocation[j])/stress_exponents_dislocation[j]));
+
+              vector_t viscosity_pre_yield = make_vectorized_array(0.0);
+              switch (viscous_flow_law)
+                {
+                  case diffusion:
+                    viscosity_pre_yield = viscosity_diffusion;
+                    break;
+                  case dislocation:
+                    viscosity_pre_yield = viscosity_dislocation;
+                    break;
+                  case composite:
+                    viscosity_pre_yield = (viscosity_diffusion * viscosity_dislocation)/(viscosity_diffusion + viscosity_dislocation);
+                    break;
+                  default:
+                    AssertThrow(false, ExcNotImplemented());
+                    break;
+                }
+
+              // Drucker-Prager yield strength, limited by max_yield_strength
+              const vector_t yield_strength = std::min(yield_strength_constants[j]
+                                                       + yield_strength_pressure_factors[j] * positive_pressure,
+                                                       make_vectorized_array(max_yield_strength));
+
+              vector_t viscosity_yield = viscosity_pre_yield;
+              switch (yield_mechanism)
+                {
+                  case stress_limiter:
+                  {
+                    const vector_t viscosity_limiter = yield_strength / (2.0 * ref_strain_rate)
+                                                       * std::exp((log_edot_ii - std::log(ref_strain_rate))
+                                                                  * (1./exponents_stress_limiter[j] - 1.0));
+                    viscosity_yield = 1. / ( 1./viscosity_limiter + 1./viscosity_pre_yield);
+                    break;
+                  }
+                  case drucker_prager:
+                  {
+                    // If the viscous stress is greater than the yield strength,
+                    // rescale the viscosity back to the yield surface
+                    const vector_t viscous_stress = 2. * viscosity_pre_yield * edot_ii;
+                    const vector_t plastic_viscosity = yield_strength / (2. * edot_ii);
+                    for (unsigned int v=0; v<width; ++v)
+                      if (viscous_stress[v] >= yield_strength[v])
+                        viscosity_yield[v] = plastic_viscosity[v];
+                    break;
+                  }
+                  default:
+                    AssertThrow(false, ExcNotImplemented());
+                    break;
+                }
+
+              composition_viscosities[j] = std::min(std::max(viscosity_yield, make_vectorized_array(min_visc)),
+                                                    make_vectorized_array(max_visc));
+            }
+
+          // Average the viscosities of the phases as in MaterialUtilities::average_value()
+          vector_t viscosity = make_vectorized_array(0.0);
+          switch (viscosity_averaging)
+            {
+              case MaterialUtilities::arithmetic:
+                for (unsigned int j=0; j<n_phases; ++j)
+                  viscosity += volume_fractions[j] * composition_viscosities[j];
+                break;
+              case MaterialUtilities::harmonic:
+                for (unsigned int j=0; j<n_phases; ++j)
+                  viscosity += volume_fractions[j] / composition_viscosities[j];
+                viscosity = 1.0 / viscosity;
+                break;
+              case MaterialUtilities::geometric:
+                for (unsigned int j=0; j<n_phases; ++j)
+                  viscosity += volume_fractions[j] * std::log(composition_viscosities[j]);
+                viscosity = std::exp(viscosity);
+                break;
+              case MaterialUtilities::maximum_composition:
+                for (unsigned int v=0; v<width; ++v)
+                  {
+                    unsigned int max_index = 0;
+                    for (unsigned int j=1; j<n_phases; ++j)
+                      if (volume_fractions[j][v] > volume_fractions[max_index][v])
+                        max_index = j;
+                    viscosity[v] = composition_viscosities[max_index][v];
+                  }
+                break;
+              default:
+                AssertThrow(false, ExcNotImplemented());
+                break;
+            }
+
+          out.viscosities[batch] = viscosity;
+        }
+    }
+
+
+
     template <int dim>
     double
     ViscoPlastic<dim>::
@@ -21,9 +21,6 @@
 
 #include <aspect/mesh_refinement/composition.h>
 
-#include <deal.II/base/quadrature_lib.h>
-#include <deal.II/numerics/error_estimator.h>
-
 namespace aspect
 {
   namespace MeshRefinement
@@ -36,27 +33,29 @@ namespace aspect
                    ExcMessage ("This refinement criterion cannot be used when no "
                                "compositional fields are active!"));
       indicators = 0;
-      Vector<float> this_indicator (indicators.size());
-      QGauss<dim-1> quadrature (this->introspection().polynomial_degree.compositional_fields+1);
 
+      // the indicators of all fields are computed at once by the
+      // manager, so we only need to add them up here
       for (unsigned int c=0; c<this->n_compositional_fields(); ++c)
         {
-          this_indicator = 0;
-          KellyErrorEstimator<dim>::estimate (this->get_mapping(),
-                                              this->get_dof_handler(),
-                                              quadrature,
-                                              std::map<types::boundary_id,const Function<dim>*>(),
-                                              this->get_solution(),
-                                              this_indicator,
-                                              this->introspection().component_masks.compositional_fields[c],
-                                              nullptr,
-                                              0,
-                                              this->get_triangulation().locally_owned_subdomain());
           // compute indicators += c*this_indicator:
-          indicators.add(composition_scaling_factors[c], this_indicator);
+          indicators.add(composition_scaling_factors[c],
+                         this->get_mesh_refinement_manager().get_kelly_error_indicators(c+1));
         }
     }
 
+
+
+    template <int dim>
+    std::set<unsigned int>
+    Composition<dim>::required_kelly_error_indicators () const
+    {
+      std::set<unsigned int> field_indices;
+      for (unsigned int c=0; c<this->n_compositional_fields(); ++c)
+        field_indices.insert (c+1);
+      return field_indices;
+    }
+
     template <int dim>
     void
     Composition<dim>::
@@ -22,6 +22,10 @@
 #include <aspect/mesh_refinement/interface.h>
 #include <aspect/utilities.h>
 
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/numerics/error_estimator.h>
+
+#include <algorithm>
 #include <typeinfo>
 
 
@@ -62,6 +66,14 @@ namespace aspect
     {}
 
 
+    template <int dim>
+    std::set<unsigned int>
+    Interface<dim>::required_kelly_error_indicators () const
+    {
+      return std::set<unsigned int>();
+    }
+
+
     template <int dim>
     void
     Interface<dim>::declare_parameters (ParameterHandler &)
@@ -155,6 +167,22 @@ namespace aspect
     {
       Assert (mesh_refinement_objects.size() > 0, ExcInternalError());
 
+      // compute the Kelly error indicators of all advection fields
+      // the plugins need at once, rather than one field at a time
+      // in each plugin
+      std::set<unsigned int> kelly_field_indices;
+      for (typename std::list<std::unique_ptr<Interface<dim> > >::const_iterator
+           p = mesh_refinement_objects.begin();
+           p != mesh_refinement_objects.end(); ++p)
+        {
+          const std::set<unsigned int> field_indices = (*p)->required_kelly_error_indicators();
+          kelly_field_indices.insert (field_indices.begin(), field_indices.end());
+        }
+
+      kelly_error_indicators.clear();
+      if (kelly_field_indices.size() > 0)
+        compute_kelly_error_indicators (kelly_field_indices);
+
       // call the execute() functions of all plugins we have
       // here in turns. then normalize the output vector and
       // verify that its values are non-negative numbers
@@ -229,6 +257,9 @@ namespace aspect
             }
         }
 
+      // the indicators are only valid for the current solution
+      kelly_error_indicators.clear();
+
       // now merge the results
       switch  (merge_operation)
         {
@@ -259,6 +290,139 @@ namespace aspect
     }
 
 
+    template <int dim>
+    Vector<float>
+    Manager<dim>::get_kelly_error_indicators (const unsigned int field_index) const
+    {
+      const typename std::map<unsigned int, Vector<float> >::const_iterator
+      indicators = kelly_error_indicators.find (field_index);
+      if (indicators != kelly_error_indicators.end())
+        return indicators->second;
+
+      // the indicators were not computed by execute(), so compute
+      // them now, but do not keep them
+      compute_kelly_error_indicators (std::set<unsigned int> {field_index});
+
+      Vector<float> field_indicators;
+      field_indicators.swap (kelly_error_indicators[field_index]);
+      kelly_error_indicators.erase (field_index);
+
+      return field_indicators;
+    }
+
+
+
+    template <int dim>
+    void
+    Manager<dim>::compute_kelly_error_indicators (const std::set<unsigned int> &field_indices) const
+    {
+      const Introspection<dim> &introspection = this->introspection();
+
+      // The same quadrature formula is used for all fields in one sweep over
+      // the faces, so group the fields by their polynomial degree. Usually,
+      // this yields one group for the temperature and one for all
+      // compositional fields, or a single group if the degrees are the same.
+      std::map<unsigned int, std::vector<unsigned int> > fields_by_degree;
+      for (const unsigned int field_index : field_indices)
+        {
+          AssertThrow (field_index <= this->n_compositional_fields(),
+                       ExcMessage ("There is no advection field with index "
+                                   + Utilities::int_to_string(field_index) + "."));
+
+          const unsigned int degree = (field_index == 0
+                                       ?
+                                       introspection.polynomial_degree.temperature
+                                       :
+                                       introspection.polynomial_degree.compositional_fields);
+          fields_by_degree[degree].push_back (field_index);
+        }
+
+      // The Kelly estimator adds up the face jumps of all components
+      // selected by the component mask, but it can estimate the errors
+      // of several vectors in one sweep. To get one indicator per field,
+      // we therefore select several fields at once, and give the
+      // estimator one vector per field in which all other fields are
+      // zero. This way, the faces, their neighbors, and the shape
+      // function gradients on them are only computed once per sweep.
+      // Each of these vectors has the size of the whole solution, so we
+      // limit the number of fields per sweep, and reuse the vectors for
+      // the next fields by replacing only the block of the field they
+      // hold.
+      const unsigned int max_fields_per_sweep = 3;
+      std::vector<LinearAlgebra::BlockVector> field_solutions;
+      std::vector<unsigned int> field_solution_blocks;
+
+      for (const auto &fields : fields_by_degree)
+        {
+          const std::vector<unsigned int> &field_group = fields.second;
+
+          for (unsigned int first_field=0; first_field<field_group.size(); first_field+=max_fields_per_sweep)
+            {
+              const unsigned int n_fields = std::min (max_fields_per_sweep,
+                                                      static_cast<unsigned int>(field_group.size()) - first_field);
+
+              ComponentMask component_mask (introspection.n_components, false);
+              std::vector<const LinearAlgebra::BlockVector *> solutions;
+              std::vector<Vector<float> *> indicators;
+
+              for (unsigned int i=0; i<n_fields; ++i)
+                {
+                  const unsigned int field_index = field_group[first_field+i];
+
+                  component_mask = component_mask | (field_index == 0
+                                                     ?
+                                                     introspection.component_masks.temperature
+                                                     :
+                                                     introspection.component_masks.compositional_fields[field_index-1]);
+
+                  // a single field can be estimated on the solution itself
+                  if (n_fields == 1)
+                    solutions.push_back (&this->get_solution());
+                  else
+                    {
+                      const unsigned int block = (field_index == 0
+                                                  ?
+                                                  introspection.block_indices.temperature
+                                                  :
+                                                  introspection.block_indices.compositional_fields[field_index-1]);
+
+                      if (i == field_solutions.size())
+                        {
+                          field_solutions.emplace_back ();
+                          field_solutions[i].reinit (this->get_solution());
+                          field_solution_blocks.push_back (block);
+                        }
+                      else if (field_solution_blocks[i] != block)
+                        {
+                          field_solutions[i].block(field_solution_blocks[i]) = 0;
+                          field_solution_blocks[i] = block;
+                        }
+
+                      field_solutions[i].block(block) = this->get_solution().block(block);
+                      solutions.push_back (&field_solutions[i]);
+                    }
+
+                  Vector<float> &field_indicators = kelly_error_indicators[field_index];
+                  field_indicators.reinit (this->get_triangulation().n_active_cells());
+                  indicators.push_back (&field_indicators);
+                }
+
+              KellyErrorEstimator<dim>::estimate (this->get_mapping(),
+                                                  this->get_dof_handler(),
+                                                  QGauss<dim-1> (fields.first+1),
+                                                  std::map<types::boundary_id,const Function<dim>*>(),
+                                                  solutions,
+                                                  indicators,
+                                                  component_mask,
+                                                  nullptr,
+                                                  0,
+                                                  this->get_triangulation().locally_owned_subdomain());
+            }
+        }
+    }
+
+
+
     template <int dim>
     void
     Manager<dim>::tag_additional_cells () const
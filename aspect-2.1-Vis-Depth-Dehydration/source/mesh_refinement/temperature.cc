@@ -21,9 +21,6 @@
 
 #include <aspect/mesh_refinement/temperature.h>
 
-#include <deal.II/base/quadrature_lib.h>
-#include <deal.II/numerics/error_estimator.h>
-
 namespace aspect
 {
   namespace MeshRefinement
@@ -32,20 +29,16 @@ namespace aspect
     void
     Temperature<dim>::execute(Vector<float> &indicators) const
     {
-      indicators = 0;
+      indicators = this->get_mesh_refinement_manager().get_kelly_error_indicators(0);
+    }
+
 
-      QGauss<dim-1> quadrature (this->introspection().polynomial_degree.temperature+1);
 
-      KellyErrorEstimator<dim>::estimate (this->get_mapping(),
-                                          this->get_dof_handler(),
-                                          quadrature,
-                                          std::map<types::boundary_id,const Function<dim>*>(),
-                                          this->get_solution(),
-                                          indicators,
-                                          this->introspection().component_masks.temperature,
-                                          nullptr,
-                                          0,
-                                          this->get_triangulation().locally_owned_subdomain());
+    template <int dim>
+    std::set<unsigned int>
+    Temperature<dim>::required_kelly_error_indicators () const
+    {
+      return std::set<unsigned int> {0};
     }
   }
 }
@@ -53,6 +53,12 @@ namespace aspect
         typename std::vector<Tensor<1,dim> >::const_iterator old_velocity = old_velocities.begin();
         typename std::vector<Tensor<1,dim> >::const_iterator velocity = velocities.begin();
 
+        // This function is called for several cells in parallel. In the
+        // first step, collect the new entries of loc0 and only insert them
+        // at the end, while holding the lock. In the second step, loc0 is
+        // only read, which is safe without a lock.
+        std::vector<std::pair<types::particle_index, Point<dim> > > new_loc0;
+
         for (typename ParticleHandler<dim>::particle_iterator it = begin_particle;
              it != end_particle; ++it, ++velocity, ++old_velocity)
           {
@@ -60,12 +66,16 @@ namespace aspect
             const Point<dim> loc = it->get_location();
             if (integrator_substep == 0)
               {
-                loc0[particle_id] = loc;
+                new_loc0.emplace_back(particle_id, loc);
                 it->set_location(loc + 0.5 * dt * (*old_velocity));
               }
             else if (integrator_substep == 1)
               {
-                it->set_location(loc0[particle_id] + dt * (*old_velocity + *velocity) / 2.0);
+                const typename std::map<types::particle_index, Point<dim> >::const_iterator
+                particle_loc0 = loc0.find(particle_id);
+                Assert(particle_loc0 != loc0.end(), ExcInternalError());
+
+                it->set_location(particle_loc0->second + dt * (*old_velocity + *velocity) / 2.0);
               }
             else
               {
@@ -73,6 +83,12 @@ namespace aspect
                        ExcMessage("The RK2 integrator should never continue after two integration steps."));
               }
           }
+
+        if (new_loc0.size() > 0)
+          {
+            std::lock_guard<std::mutex> lock(loc0_mutex);
+            loc0.insert(new_loc0.begin(), new_loc0.end());
+          }
       }
 
       template <int dim>
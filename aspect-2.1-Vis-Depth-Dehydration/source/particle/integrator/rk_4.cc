@@ -55,30 +55,44 @@ namespace aspect
         typename std::vector<Tensor<1,dim> >::const_iterator old_velocity = old_velocities.begin();
         typename std::vector<Tensor<1,dim> >::const_iterator velocity = velocities.begin();
 
+        // This function is called for several cells in parallel. Each
+        // step only inserts into the maps that are not read in the same
+        // step, so we can read without a lock, collect the new entries,
+        // and only insert them at the end while holding the lock.
+        std::vector<std::pair<types::particle_index, Point<dim> > > new_loc0;
+        std::vector<std::pair<types::particle_index, Tensor<1,dim> > > new_k;
+
         for (typename ParticleHandler<dim>::particle_iterator it = begin_particle;
              it != end_particle; ++it, ++velocity, ++old_velocity)
           {
             const types::particle_index particle_id = it->get_id();
             if (integrator_substep == 0)
               {
-                loc0[particle_id] = it->get_location();
-                k1[particle_id] = dt * (*old_velocity);
-                it->set_location(it->get_location() + 0.5*k1[particle_id]);
+                const Tensor<1,dim> k1_particle = dt * (*old_velocity);
+                new_loc0.emplace_back(particle_id, it->get_location());
+                new_k.emplace_back(particle_id, k1_particle);
+                it->set_location(it->get_location() + 0.5*k1_particle);
               }
             else if (integrator_substep == 1)
               {
-                k2[particle_id] = dt * (*old_velocity + *velocity) / 2.0;
-                it->set_location(loc0[particle_id] + 0.5*k2[particle_id]);
+                const Tensor<1,dim> k2_particle = dt * (*old_velocity + *velocity) / 2.0;
+                new_k.emplace_back(particle_id, k2_particle);
+                it->set_location(loc0.find(particle_id)->second + 0.5*k2_particle);
               }
             else if (integrator_substep == 2)
               {
-                k3[particle_id] = dt * (*old_velocity + *velocity) / 2.0;
-                it->set_location(loc0[particle_id] + k3[particle_id]);
+                const Tensor<1,dim> k3_particle = dt * (*old_velocity + *velocity) / 2.0;
+                new_k.emplace_back(particle_id, k3_particle);
+                it->set_location(loc0.find(particle_id)->second + k3_particle);
               }
             else if (integrator_substep == 3)
               {
                 const Tensor<1,dim> k4 = dt * (*velocity);
-                it->set_location(loc0[particle_id] + (k1[particle_id] + 2.0*k2[particle_id] + 2.0*k3[particle_id] + k4)/6.0);
+                it->set_location(loc0.find(particle_id)->second
+                                 + (k1.find(particle_id)->second
+                                    + 2.0*k2.find(particle_id)->second
+                                    + 2.0*k3.find(particle_id)->second
+                                    + k4)/6.0);
               }
             else
               {
@@ -86,6 +100,16 @@ namespace aspect
                        ExcMessage("The RK4 integrator should never continue after four integration steps."));
               }
           }
+
+        if (integrator_substep < 3 && new_k.size() > 0)
+          {
+            std::lock_guard<std::mutex> lock(data_mutex);
+            loc0.insert(new_loc0.begin(), new_loc0.end());
+
+            std::map<types::particle_index, Tensor<1,dim> > &k = (integrator_substep == 0 ? k1 :
+                                                                   (integrator_substep == 1 ? k2 : k3));
+            k.insert(new_k.begin(), new_k.end());
+          }
       }
 
       template <int dim>
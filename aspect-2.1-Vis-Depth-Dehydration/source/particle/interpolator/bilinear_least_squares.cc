@@ -24,16 +24,124 @@
 
 #include <deal.II/grid/grid_tools.h>
 #include <deal.II/base/signaling_nan.h>
-#include <deal.II/lac/full_matrix.templates.h>
 
 #include <boost/lexical_cast.hpp>
 
+#include <cmath>
+#include <limits>
+
 namespace aspect
 {
   namespace Particle
   {
     namespace Interpolator
     {
+      namespace
+      {
+        /**
+         * Compute the pseudo-inverse of the symmetric positive semi-definite
+         * @p n by @p n matrix @p matrix, and store it in @p inverse.
+         * Eigenvalues smaller than @p threshold times the largest eigenvalue
+         * are treated as zero, which makes this function equivalent to
+         * LAPACKFullMatrix::compute_inverse_svd() for the normal matrices
+         * of the least squares problems below, which can be rank deficient
+         * if the particles in a cell happen to lie on a line. In contrast to
+         * the LAPACK function, this function works on fixed-size arrays on
+         * the stack and does not allocate any memory.
+         *
+         * The eigenvalue decomposition is computed with the cyclic Jacobi
+         * method, which converges in very few sweeps for small matrices.
+         */
+        template <unsigned int n>
+        void
+        compute_symmetric_pseudo_inverse (const double (&matrix)[n][n],
+                                          const double threshold,
+                                          double (&inverse)[n][n])
+        {
+          double a[n][n];
+          double eigenvectors[n][n];
+          for (unsigned int i=0; i<n; ++i)
+            for (unsigned int j=0; j<n; ++j)
+              {
+                a[i][j] = matrix[i][j];
+                eigenvectors[i][j] = (i == j ? 1.0 : 0.0);
+              }
+
+          const unsigned int max_sweeps = 50;
+          for (unsigned int sweep=0; sweep<max_sweeps; ++sweep)
+            {
+              double diagonal_norm = 0.0;
+              double off_diagonal_norm = 0.0;
+              for (unsigned int i=0; i<n; ++i)
+                {
+                  diagonal_norm += a[i][i] * a[i][i];
+                  for (unsigned int j=i+1; j<n; ++j)
+                    off_diagonal_norm += a[i][j] * a[i][j];
+                }
+
+              if (off_diagonal_norm <= std::numeric_limits<double>::epsilon()
+                  * std::numeric_limits<double>::epsilon() * diagonal_norm)
+                break;
+
+              for (unsigned int p=0; p<n; ++p)
+                for (unsigned int q=p+1; q<n; ++q)
+                  if (a[p][q] != 0.0)
+                    {
+                      // choose the rotation that eliminates a[p][q]
+                      const double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                      const double t = (theta >= 0.0 ? 1.0 : -1.0)
+                                       / (std::abs(theta) + std::sqrt(theta*theta + 1.0));
+                      const double c = 1.0 / std::sqrt(t*t + 1.0);
+                      const double s = t * c;
+
+                      for (unsigned int k=0; k<n; ++k)
+                        {
+                          const double a_kp = a[k][p];
+                          const double a_kq = a[k][q];
+                          a[k][p] = c * a_kp - s * a_kq;
+                          a[k][q] = s * a_kp + c * a_kq;
+                        }
+                      for (unsigned int k=0; k<n; ++k)
+                        {
+                          const double a_pk = a[p][k];
+                          const double a_qk = a[q][k];
+                          a[p][k] = c * a_pk - s * a_qk;
+                          a[q][k] = s * a_pk + c * a_qk;
+                        }
+                      for (unsigned int k=0; k<n; ++k)
+                        {
+                          const double v_kp = eigenvectors[k][p];
+                          const double v_kq = eigenvectors[k][q];
+                          eigenvectors[k][p] = c * v_kp - s * v_kq;
+                          eigenvectors[k][q] = s * v_kp + c * v_kq;
+                        }
+                    }
+            }
+
+          double largest_eigenvalue = 0.0;
+          for (unsigned int i=0; i<n; ++i)
+            largest_eigenvalue = std::max(largest_eigenvalue, std::abs(a[i][i]));
+
+          double inverse_eigenvalues[n];
+          for (unsigned int i=0; i<n; ++i)
+            inverse_eigenvalues[i] = (a[i][i] > threshold * largest_eigenvalue
+                                      ?
+                                      1.0 / a[i][i]
+                                      :
+                                      0.0);
+
+          for (unsigned int i=0; i<n; ++i)
+            for (unsigned int j=0; j<n; ++j)
+              {
+                inverse[i][j] = 0.0;
+                for (unsigned int k=0; k<n; ++k)
+                  inverse[i][j] += eigenvectors[i][k] * inverse_eigenvalues[k] * eigenvectors[j][k];
+              }
+        }
+      }
+
+
+
       template <int dim>
       std::vector<std::vector<double> >
       BilinearLeastSquares<dim>::properties_at_points(const ParticleHandler<dim> &particle_handler,
@@ -52,10 +160,6 @@ namespace aspect
         AssertThrow(dim == 2,
                     ExcMessage("Currently, the particle interpolator `bilinear' is only supported for 2D models."));
 
-        AssertThrow(selected_properties.n_selected_components(n_particle_properties) == 1,
-                    ExcNotImplemented("Interpolation of multiple components is not supported."));
-
-
         const Point<dim> approximated_cell_midpoint = std::accumulate (positions.begin(), positions.end(), Point<dim>())
                                                       / static_cast<double> (positions.size());
 
@@ -94,64 +198,73 @@ namespace aspect
                                "interpolation scheme does not support this case. "));
 
 
-        // Noticed that the size of matrix A is n_particles x matrix_dimension
-        // which usually is not a square matrix. Therefore, we solve Ax=r by
-        // solving A^TAx= A^Tr.
+        // The matrix A of the least squares problem Ax=r has the size
+        // n_particles x matrix_dimension and is usually not square. Therefore,
+        // we solve the normal equations A^TAx=A^Tr instead. The matrix A^TA
+        // is the same for all properties, so we assemble it and the right hand
+        // sides A^Tr of all selected properties in a single loop over the
+        // particles, without ever forming A itself.
         const unsigned int matrix_dimension = 4;
-        dealii::LAPACKFullMatrix<double> A(n_particles, matrix_dimension);
-        Vector<double> r(n_particles);
-        r = 0;
+        double B[matrix_dimension][matrix_dimension] = {};
+        std::vector<double> c_ATr(n_particle_properties * matrix_dimension, 0.0);
 
-        unsigned int index = 0;
         const double cell_diameter = found_cell->diameter();
         for (typename ParticleHandler<dim>::particle_iterator particle = particle_range.begin();
-             particle != particle_range.end(); ++particle, ++index)
+             particle != particle_range.end(); ++particle)
           {
-            const double particle_property_value = particle->get_properties()[property_index];
-            r[index] = particle_property_value;
-
             const Point<dim> position = particle->get_location();
-            A(index,0) = 1;
-            A(index,1) = (position[0] - approximated_cell_midpoint[0])/cell_diameter;
-            A(index,2) = (position[1] - approximated_cell_midpoint[1])/cell_diameter;
-            A(index,3) = (position[0] - approximated_cell_midpoint[0]) * (position[1] - approximated_cell_midpoint[1])/std::pow(cell_diameter,2);
+            const double x = (position[0] - approximated_cell_midpoint[0])/cell_diameter;
+            const double y = (position[1] - approximated_cell_midpoint[1])/cell_diameter;
+            const double A_row[matrix_dimension] = {1, x, y, x * y};
+
+            for (unsigned int i=0; i<matrix_dimension; ++i)
+              for (unsigned int j=0; j<matrix_dimension; ++j)
+                B[i][j] += A_row[i] * A_row[j];
+
+            const ArrayView<const double> particle_properties = particle->get_properties();
+            for (unsigned int property = 0; property < n_particle_properties; ++property)
+              if (selected_properties[property])
+                for (unsigned int i=0; i<matrix_dimension; ++i)
+                  c_ATr[property * matrix_dimension + i] += A_row[i] * particle_properties[property];
           }
 
-        dealii::LAPACKFullMatrix<double> B(matrix_dimension, matrix_dimension);
-
-        Vector<double> c_ATr(matrix_dimension);
-        Vector<double> c(matrix_dimension);
-
-        const double threshold = 1e-15;
-        unsigned int index_positions = 0;
-
         // Matrix A can be rank deficient if it does not have full rank, therefore singular.
-        // To circumvent this issue, we solve A^TAx=A^Tr by using singular value
-        // decomposition (SVD).
-        A.Tmmult(B, A, false);
-        A.Tvmult(c_ATr,r);
-
-        dealii::LAPACKFullMatrix<double> B_inverse(B);
-        B_inverse.compute_inverse_svd(threshold);
-        B_inverse.vmult(c, c_ATr);
+        // To circumvent this issue, we solve A^TAx=A^Tr by using the pseudo-inverse
+        // of A^TA, which is the same as using a singular value decomposition (SVD).
+        const double threshold = 1e-15;
+        double B_inverse[matrix_dimension][matrix_dimension];
+        compute_symmetric_pseudo_inverse (B, threshold, B_inverse);
 
-        for (typename std::vector<Point<dim> >::const_iterator itr = positions.begin(); itr != positions.end(); ++itr, ++index_positions)
-          {
-            const Point<dim> support_point = *itr;
-            double interpolated_value = c[0] +
-                                        c[1]*(support_point[0] - approximated_cell_midpoint[0])/cell_diameter +
-                                        c[2]*(support_point[1] - approximated_cell_midpoint[1])/cell_diameter +
-                                        c[3]*(support_point[0] - approximated_cell_midpoint[0])*(support_point[1] - approximated_cell_midpoint[1])/std::pow(cell_diameter,2);
-
-            // Overshoot and undershoot correction of interpolated particle property.
-            if (use_global_valued_limiter)
-              {
-                interpolated_value = std::min(interpolated_value, global_maximum_particle_properties[property_index]);
-                interpolated_value = std::max(interpolated_value, global_minimum_particle_properties[property_index]);
-              }
+        for (unsigned int property = 0; property < n_particle_properties; ++property)
+          if (selected_properties[property])
+            {
+              double c[matrix_dimension];
+              for (unsigned int i=0; i<matrix_dimension; ++i)
+                {
+                  c[i] = 0.0;
+                  for (unsigned int j=0; j<matrix_dimension; ++j)
+                    c[i] += B_inverse[i][j] * c_ATr[property * matrix_dimension + j];
+                }
+
+              unsigned int index_positions = 0;
+              for (typename std::vector<Point<dim> >::const_iterator itr = positions.begin(); itr != positions.end(); ++itr, ++index_positions)
+                {
+                  const Point<dim> support_point = *itr;
+                  const double x = (support_point[0] - approximated_cell_midpoint[0])/cell_diameter;
+                  const double y = (support_point[1] - approximated_cell_midpoint[1])/cell_diameter;
+                  double interpolated_value = c[0] + c[1]*x + c[2]*y + c[3]*x*y;
+
+                  // Overshoot and undershoot correction of interpolated particle property.
+                  if (use_global_valued_limiter)
+                    {
+                      interpolated_value = std::min(interpolated_value, global_maximum_particle_properties[property]);
+                      interpolated_value = std::max(interpolated_value, global_minimum_particle_properties[property]);
+                    }
+
+                  cell_properties[index_positions][property] = interpolated_value;
+                }
+            }
 
-            cell_properties[index_positions][property_index] = interpolated_value;
-          }
         return cell_properties;
       }
 
@@ -251,7 +364,8 @@ namespace aspect
                                             "bilinear least squares",
                                             "Interpolates particle properties onto a vector of points using a "
                                             "bilinear least squares method. Currently only 2D models are "
-                                            "supported. Note that deal.II must be configured with BLAS/LAPACK.")
+                                            "supported. All selected properties are interpolated together, "
+                                            "using the same least squares matrix.")
     }
   }
 }
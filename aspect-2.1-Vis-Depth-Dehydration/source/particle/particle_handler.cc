@@ -41,7 +41,8 @@ namespace aspect
       size_callback(),
       store_callback(),
       load_callback(),
-      data_offset(numbers::invalid_unsigned_int)
+      data_offset(numbers::invalid_unsigned_int),
+      cell_location_cache_outdated(true)
     {}
 
 
@@ -62,14 +63,27 @@ namespace aspect
       size_callback(),
       store_callback(),
       load_callback(),
-      data_offset(numbers::invalid_unsigned_int)
-    {}
+      data_offset(numbers::invalid_unsigned_int),
+      cell_location_cache_outdated(true)
+    {
+      mesh_change_connection = triangulation.signals.any_change.connect([this]()
+      {
+        this->cell_location_cache_outdated = true;
+      });
+    }
 
 
 
     template <int dim,int spacedim>
     ParticleHandler<dim,spacedim>::~ParticleHandler()
-    {}
+    {
+      // the particles return their property slots to the property pool
+      // when they are destroyed, so they have to go before the pool does
+      particles.clear();
+      ghost_particles.clear();
+
+      mesh_change_connection.disconnect();
+    }
 
 
 
@@ -82,6 +96,15 @@ namespace aspect
       triangulation = &tria;
       mapping = &mapp;
 
+      // Keep track of changes of the mesh, which invalidate the cached
+      // information used to find the cells of particles
+      mesh_change_connection.disconnect();
+      mesh_change_connection = tria.signals.any_change.connect([this]()
+      {
+        this->cell_location_cache_outdated = true;
+      });
+      cell_location_cache_outdated = true;
+
       // Create the memory pool that will store all particle properties
       property_pool = std_cxx14::make_unique<PropertyPool>(n_properties);
     }
@@ -208,6 +231,7 @@ namespace aspect
     void
     ParticleHandler<dim,spacedim>::insert_particles(const std::multimap<Particles::internal::LevelInd, Particle<dim,spacedim> > &new_particles)
     {
+      property_pool->reserve(particles.size() + new_particles.size());
       particles.insert(new_particles.begin(),new_particles.end());
       update_cached_numbers();
     }
@@ -219,6 +243,7 @@ namespace aspect
     ParticleHandler<dim,spacedim>::insert_particles(const std::multimap<typename Triangulation<dim,spacedim>::active_cell_iterator,
                                                     Particle<dim,spacedim> > &new_particles)
     {
+      property_pool->reserve(particles.size() + new_particles.size());
       for (auto particle = new_particles.begin(); particle != new_particles.end(); ++particle)
         particles.insert(particles.end(),
                          std::make_pair(internal::LevelInd(particle->first->level(),particle->first->index()),
@@ -450,6 +475,310 @@ namespace aspect
 
 
 
+    template <int dim, int spacedim>
+    void
+    ParticleHandler<dim,spacedim>::update_cell_location_cache()
+    {
+      if (!cell_location_cache_outdated)
+        return;
+
+      cached_vertex_to_cells = GridTools::vertex_to_cell_map(*triangulation);
+      cached_vertex_to_cell_centers = vertex_to_cell_centers_directions(cached_vertex_to_cells);
+
+      // Collect a box around every locally owned and ghost cell. The box
+      // spanned by the vertices is enlarged a bit, because the mapping
+      // may curve the faces of the cell beyond its vertices.
+      located_cells.clear();
+      located_cell_boxes.clear();
+
+      Point<spacedim> lower_corner, upper_corner;
+      for (const auto &cell : triangulation->active_cell_iterators())
+        if (!cell->is_artificial())
+          {
+            Point<spacedim> cell_lower = cell->vertex(0);
+            Point<spacedim> cell_upper = cell->vertex(0);
+            for (unsigned int v=1; v<GeometryInfo<dim>::vertices_per_cell; ++v)
+              for (unsigned int d=0; d<spacedim; ++d)
+                {
+                  cell_lower[d] = std::min(cell_lower[d], cell->vertex(v)[d]);
+                  cell_upper[d] = std::max(cell_upper[d], cell->vertex(v)[d]);
+                }
+
+            const double tolerance = 0.1 * cell->diameter();
+            for (unsigned int d=0; d<spacedim; ++d)
+              {
+                cell_lower[d] -= tolerance;
+                cell_upper[d] += tolerance;
+              }
+
+            if (located_cells.empty())
+              {
+                lower_corner = cell_lower;
+                upper_corner = cell_upper;
+              }
+            else
+              for (unsigned int d=0; d<spacedim; ++d)
+                {
+                  lower_corner[d] = std::min(lower_corner[d], cell_lower[d]);
+                  upper_corner[d] = std::max(upper_corner[d], cell_upper[d]);
+                }
+
+            located_cells.push_back(cell);
+            located_cell_boxes.push_back(std::make_pair(cell_lower, cell_upper));
+          }
+
+      // Distribute the cells into a uniform grid of buckets with about
+      // one bucket per cell
+      const unsigned int n_buckets_per_direction
+        = std::max(1u, static_cast<unsigned int>(std::pow(static_cast<double>(located_cells.size()), 1./spacedim)));
+
+      bucket_origin = lower_corner;
+      unsigned int n_total_buckets = 1;
+      for (unsigned int d=0; d<spacedim; ++d)
+        {
+          n_buckets[d] = n_buckets_per_direction;
+          bucket_size[d] = std::max((upper_corner[d] - lower_corner[d]) / n_buckets[d],
+                                    std::numeric_limits<double>::min());
+          n_total_buckets *= n_buckets[d];
+        }
+
+      cell_buckets.clear();
+      cell_buckets.resize(n_total_buckets);
+
+      for (unsigned int c=0; c<located_cells.size(); ++c)
+        {
+          std::array<unsigned int,spacedim> first_bucket, last_bucket;
+          for (unsigned int d=0; d<spacedim; ++d)
+            {
+              first_bucket[d] = std::min(static_cast<unsigned int>((located_cell_boxes[c].first[d] - bucket_origin[d]) / bucket_size[d]),
+                                         n_buckets[d]-1);
+              last_bucket[d] = std::min(static_cast<unsigned int>((located_cell_boxes[c].second[d] - bucket_origin[d]) / bucket_size[d]),
+                                        n_buckets[d]-1);
+            }
+
+          // Loop over all buckets between first_bucket and last_bucket
+          std::array<unsigned int,spacedim> bucket = first_bucket;
+          while (true)
+            {
+              unsigned int bucket_index = 0;
+              for (unsigned int d=spacedim; d>0; --d)
+                bucket_index = bucket_index * n_buckets[d-1] + bucket[d-1];
+              cell_buckets[bucket_index].push_back(c);
+
+              unsigned int d = 0;
+              for (; d<spacedim; ++d)
+                {
+                  if (bucket[d] < last_bucket[d])
+                    {
+                      ++bucket[d];
+                      break;
+                    }
+                  bucket[d] = first_bucket[d];
+                }
+              if (d == spacedim)
+                break;
+            }
+        }
+
+      cell_location_cache_outdated = false;
+    }
+
+
+
+    template <int dim, int spacedim>
+    bool
+    ParticleHandler<dim,spacedim>::find_cell_by_walking(const Point<spacedim> &location,
+                                                        active_cell_it &cell,
+                                                        Point<dim> &reference_location) const
+    {
+      // Particles usually move by at most a few cells per time step, if we
+      // need more steps than this the straight-line walk is likely stuck
+      // (e.g. at a curved boundary) and one of the other search methods
+      // will be faster.
+      const unsigned int max_steps = 2 * GeometryInfo<dim>::faces_per_cell;
+
+      active_cell_it current_cell = cell;
+      for (unsigned int step=0; step<max_steps; ++step)
+        {
+          Point<dim> p_unit;
+          try
+            {
+              p_unit = mapping->transform_real_to_unit_cell(current_cell, location);
+            }
+          catch (typename Mapping<dim>::ExcTransformationFailed &)
+            {
+              return false;
+            }
+
+          if (GeometryInfo<dim>::is_inside_unit_cell(p_unit))
+            {
+              cell = current_cell;
+              reference_location = p_unit;
+              return true;
+            }
+
+          // The straight line from the cell to the particle leaves the
+          // cell through the face in whose direction the reference
+          // coordinates of the particle are farthest outside the unit cell
+          unsigned int exit_face = numbers::invalid_unsigned_int;
+          double max_distance = 0.0;
+          for (unsigned int d=0; d<dim; ++d)
+            {
+              if (-p_unit[d] > max_distance)
+                {
+                  max_distance = -p_unit[d];
+                  exit_face = 2*d;
+                }
+              if (p_unit[d] - 1.0 > max_distance)
+                {
+                  max_distance = p_unit[d] - 1.0;
+                  exit_face = 2*d+1;
+                }
+            }
+
+          if (exit_face == numbers::invalid_unsigned_int
+              || current_cell->at_boundary(exit_face))
+            return false;
+
+          active_cell_it next_cell;
+          if (current_cell->neighbor(exit_face)->has_children())
+            {
+              // The neighbor is refined, continue with the child adjacent
+              // to the face that is closest to the particle
+              double min_distance = std::numeric_limits<double>::max();
+              for (unsigned int subface=0; subface<current_cell->face(exit_face)->n_children(); ++subface)
+                {
+                  const active_cell_it child (current_cell->neighbor_child_on_subface(exit_face, subface));
+                  const double distance = child->center().distance(location);
+                  if (distance < min_distance)
+                    {
+                      min_distance = distance;
+                      next_cell = child;
+                    }
+                }
+            }
+          else
+            next_cell = current_cell->neighbor(exit_face);
+
+          if (next_cell->is_artificial())
+            return false;
+
+          current_cell = next_cell;
+        }
+
+      return false;
+    }
+
+
+
+    template <int dim, int spacedim>
+    bool
+    ParticleHandler<dim,spacedim>::find_cell_around_closest_vertex(const Point<spacedim> &location,
+                                                                   active_cell_it &cell,
+                                                                   Point<dim> &reference_location) const
+    {
+      const unsigned int closest_vertex = get_closest_vertex_of_cell(cell,location);
+      Tensor<1,spacedim> vertex_to_particle = location - cell->vertex(closest_vertex);
+      vertex_to_particle /= vertex_to_particle.norm();
+
+      const unsigned int closest_vertex_index = cell->vertex_index(closest_vertex);
+      const unsigned int n_neighbor_cells = cached_vertex_to_cells[closest_vertex_index].size();
+
+      std::vector<unsigned int> neighbor_permutation(n_neighbor_cells);
+      for (unsigned int i=0; i<n_neighbor_cells; ++i)
+        neighbor_permutation[i] = i;
+
+      std::sort(neighbor_permutation.begin(),
+                neighbor_permutation.end(),
+                [&] (const unsigned int a,
+                     const unsigned int b) -> bool
+      {
+        return compare_particle_association(a,
+        b,
+        vertex_to_particle,
+        cached_vertex_to_cell_centers[closest_vertex_index]);
+      }
+               );
+
+      // Search all of the cells adjacent to the closest vertex of the previous cell
+      // Most likely we will find the particle in them.
+      for (unsigned int i=0; i<n_neighbor_cells; ++i)
+        {
+          try
+            {
+              typename std::set<active_cell_it>::const_iterator neighbor_cell = cached_vertex_to_cells[closest_vertex_index].begin();
+              std::advance(neighbor_cell,neighbor_permutation[i]);
+              if ((*neighbor_cell)->is_artificial())
+                continue;
+
+              const Point<dim> p_unit = mapping->transform_real_to_unit_cell(*neighbor_cell,
+                                                                             location);
+              if (GeometryInfo<dim>::is_inside_unit_cell(p_unit))
+                {
+                  cell = *neighbor_cell;
+                  reference_location = p_unit;
+                  return true;
+                }
+            }
+          catch (typename Mapping<dim>::ExcTransformationFailed &)
+            {}
+        }
+
+      return false;
+    }
+
+
+
+    template <int dim, int spacedim>
+    bool
+    ParticleHandler<dim,spacedim>::find_cell_in_buckets(const Point<spacedim> &location,
+                                                        active_cell_it &cell,
+                                                        Point<dim> &reference_location) const
+    {
+      unsigned int bucket_index = 0;
+      for (unsigned int d=spacedim; d>0; --d)
+        {
+          const double coordinate = (location[d-1] - bucket_origin[d-1]) / bucket_size[d-1];
+          if (coordinate < 0 || coordinate >= n_buckets[d-1])
+            return false;
+
+          bucket_index = bucket_index * n_buckets[d-1] + static_cast<unsigned int>(coordinate);
+        }
+
+      for (const unsigned int c : cell_buckets[bucket_index])
+        {
+          bool inside_box = true;
+          for (unsigned int d=0; d<spacedim; ++d)
+            if (location[d] < located_cell_boxes[c].first[d]
+                || location[d] > located_cell_boxes[c].second[d])
+              {
+                inside_box = false;
+                break;
+              }
+
+          if (!inside_box)
+            continue;
+
+          try
+            {
+              const Point<dim> p_unit = mapping->transform_real_to_unit_cell(located_cells[c],
+                                                                             location);
+              if (GeometryInfo<dim>::is_inside_unit_cell(p_unit))
+                {
+                  cell = located_cells[c];
+                  reference_location = p_unit;
+                  return true;
+                }
+            }
+          catch (typename Mapping<dim>::ExcTransformationFailed &)
+            {}
+        }
+
+      return false;
+    }
+
+
+
     template <int dim, int spacedim>
     void
     ParticleHandler<dim,spacedim>::sort_particles_into_subdomains_and_cells()
@@ -514,96 +843,37 @@ namespace aspect
           moved_cells[i].reserve(static_cast<vector_size> (particles_out_of_cell.size()*0.25));
         }
 
-      {
-        // Create a map from vertices to adjacent cells
-        const std::vector<std::set<typename Triangulation<dim,spacedim>::active_cell_iterator> >
-        vertex_to_cells(GridTools::vertex_to_cell_map(*triangulation));
-
-        // Create a corresponding map of vectors from vertex to cell center
-        const std::vector<std::vector<Tensor<1,spacedim> > > vertex_to_cell_centers(vertex_to_cell_centers_directions(vertex_to_cells));
-
-        std::vector<unsigned int> neighbor_permutation;
+      // Make sure the information used to find the new cells of particles
+      // is up to date. It only needs to be rebuilt after the mesh changed.
+      update_cell_location_cache();
 
+      {
         // Find the cells that the particles moved to.
         typename std::vector<particle_iterator>::iterator it = particles_out_of_cell.begin(),
                                                           end_particle = particles_out_of_cell.end();
 
         for (; it!=end_particle; ++it)
           {
-            // The cell the particle is in
-            Point<spacedim> current_reference_position;
-            bool found_cell = false;
+            const Point<spacedim> location = (*it)->get_location();
 
-            // Check if the particle is in one of the old cell's neighbors
-            // that are adjacent to the closest vertex
+            // The cell the particle is in
             active_cell_it current_cell = (*it)->get_surrounding_cell(*triangulation);
-
-            const unsigned int closest_vertex = get_closest_vertex_of_cell(current_cell,(*it)->get_location());
-            Tensor<1,spacedim> vertex_to_particle = (*it)->get_location() - current_cell->vertex(closest_vertex);
-            vertex_to_particle /= vertex_to_particle.norm();
-
-            const unsigned int closest_vertex_index = current_cell->vertex_index(closest_vertex);
-            const unsigned int n_neighbor_cells = vertex_to_cells[closest_vertex_index].size();
-
-            neighbor_permutation.resize(n_neighbor_cells);
-            for (unsigned int i=0; i<n_neighbor_cells; ++i)
-              neighbor_permutation[i] = i;
-
-            std::sort(neighbor_permutation.begin(),
-                      neighbor_permutation.end(),
-                      [&] (const unsigned int a,
-                           const unsigned int b) -> bool
-            {
-              return compare_particle_association(a,
-              b,
-              vertex_to_particle,
-              vertex_to_cell_centers[closest_vertex_index]);
-            }
-                     );
-
-            // Search all of the cells adjacent to the closest vertex of the previous cell
-            // Most likely we will find the particle in them.
-            for (unsigned int i=0; i<n_neighbor_cells; ++i)
-              {
-                try
-                  {
-                    typename std::set<typename Triangulation<dim>::active_cell_iterator>::const_iterator cell = vertex_to_cells[closest_vertex_index].begin();
-                    std::advance(cell,neighbor_permutation[i]);
-                    const Point<dim> p_unit = mapping->transform_real_to_unit_cell(*cell,
-                                                                                   (*it)->get_location());
-                    if (GeometryInfo<dim>::is_inside_unit_cell(p_unit))
-                      {
-                        current_cell = *cell;
-                        current_reference_position = p_unit;
-                        found_cell = true;
-                        break;
-                      }
-                  }
-                catch (typename Mapping<dim>::ExcTransformationFailed &)
-                  {}
-              }
-
-            if (!found_cell)
+            Point<dim> current_reference_position;
+
+            // Most particles only moved into a nearby cell, which we find
+            // by walking from their old cell towards their new position.
+            // If that fails, check the neighbors of the old cell that are
+            // adjacent to the closest vertex, and finally look for the new
+            // cell among all locally owned and ghost cells. This last case
+            // is rare.
+            if (!find_cell_by_walking(location, current_cell, current_reference_position)
+                && !find_cell_around_closest_vertex(location, current_cell, current_reference_position)
+                && !find_cell_in_buckets(location, current_cell, current_reference_position))
               {
-                // The particle is not in a neighbor of the old cell.
-                // Look for the new cell in the whole local domain.
-                // This case is rare.
-                try
-                  {
-                    const std::pair<const typename parallel::distributed::Triangulation<dim>::active_cell_iterator,
-                          Point<dim> > current_cell_and_position =
-                            GridTools::find_active_cell_around_point<> (*mapping,
-                                                                        *triangulation,
-                                                                        (*it)->get_location());
-                    current_cell = current_cell_and_position.first;
-                    current_reference_position = current_cell_and_position.second;
-                  }
-                catch (GridTools::ExcPointNotFound<dim> &)
-                  {
-                    // We can find no cell for this particle. It has left the
-                    // domain due to an integration error or an open boundary.
-                    continue;
-                  }
+                // We can find no cell for this particle. It has left the
+                // local domain and its ghost cells due to an integration
+                // error or an open boundary.
+                continue;
               }
 
             // If we are here, we found a cell and reference position for this particle
@@ -613,8 +883,11 @@ namespace aspect
             // Mark it for MPI transfer otherwise
             if (current_cell->is_locally_owned())
               {
+                // Move the particle out of its old place instead of copying
+                // it, so that its properties stay in the same slot of the
+                // property pool. The hollow particle is removed below.
                 sorted_particles.push_back(std::make_pair(Particles::internal::LevelInd(current_cell->level(),current_cell->index()),
-                                                          (*it)->particle->second));
+                                                          std::move((*it)->particle->second)));
               }
             else
               {
@@ -625,20 +898,24 @@ namespace aspect
           }
       }
 
-      // Sort the updated particles. This pre-sort speeds up inserting
-      // them into particles to O(N) complexity.
-      std::multimap<Particles::internal::LevelInd,Particle <dim,spacedim> > sorted_particles_map;
-
       // Exchange particles between processors if we have more than one process
+      std::multimap<Particles::internal::LevelInd,Particle <dim,spacedim> > received_particles;
       if (dealii::Utilities::MPI::n_mpi_processes(triangulation->get_communicator()) > 1)
-        send_recv_particles(moved_particles,sorted_particles_map,moved_cells);
-
-      sorted_particles_map.insert(sorted_particles.begin(),sorted_particles.end());
+        send_recv_particles(moved_particles,received_particles,moved_cells);
 
+      // Only the particles that left their cell are touched from here on:
+      // remove them from their old position and move them (together with
+      // the received particles) into their new cell. Particles that stayed
+      // in their cell are neither copied nor moved.
       for (unsigned int i=0; i<particles_out_of_cell.size(); ++i)
         remove_particle(particles_out_of_cell[i]);
 
-      particles.insert(sorted_particles_map.begin(),sorted_particles_map.end());
+      for (auto &particle : sorted_particles)
+        particles.insert(std::move(particle));
+
+      for (auto &particle : received_particles)
+        particles.insert(std::move(particle));
+
       update_cached_numbers();
     }
 
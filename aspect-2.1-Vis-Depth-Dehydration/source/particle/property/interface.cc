@@ -291,6 +291,11 @@ namespace aspect
         std::vector<double> particle_properties;
         particle_properties.reserve(property_information.n_components());
 
+        // The interpolator computes all properties at once, so only ask it
+        // once, when the first property that needs to be interpolated is
+        // encountered, and reuse the result for all other properties.
+        std::vector<std::vector<double> > interpolated_properties;
+
         unsigned int property_index = 0;
         for (typename std::list<std::shared_ptr<Interface<dim> > >::const_iterator
              p = property_list.begin(); p!=property_list.end(); ++p, ++property_index)
@@ -313,21 +318,25 @@ namespace aspect
 
                 case aspect::Particle::Property::interpolate:
                 {
-                  typename parallel::distributed::Triangulation<dim>::cell_iterator found_cell;
-
-                  if (cell == typename parallel::distributed::Triangulation<dim>::active_cell_iterator())
+                  if (interpolated_properties.size() == 0)
                     {
-                      found_cell = (GridTools::find_active_cell_around_point<> (this->get_mapping(),
-                                                                                this->get_triangulation(),
-                                                                                particle_location)).first;
+                      typename parallel::distributed::Triangulation<dim>::active_cell_iterator found_cell;
+
+                      if (cell == typename parallel::distributed::Triangulation<dim>::active_cell_iterator())
+                        {
+                          found_cell = (GridTools::find_active_cell_around_point<> (this->get_mapping(),
+                                                                                    this->get_triangulation(),
+                                                                                    particle_location)).first;
+                        }
+                      else
+                        found_cell = cell;
+
+                      interpolated_properties = interpolator.properties_at_points(particle_handler,
+                                                                                  std::vector<Point<dim> > (1,particle_location),
+                                                                                  ComponentMask(property_information.n_components(),true),
+                                                                                  found_cell);
                     }
-                  else
-                    found_cell = cell;
 
-                  const std::vector<std::vector<double> > interpolated_properties = interpolator.properties_at_points(particle_handler,
-                                                                                    std::vector<Point<dim> > (1,particle_location),
-                                                                                    ComponentMask(property_information.n_components(),true),
-                                                                                    found_cell);
                   for (unsigned int property_component = 0; property_component < property_information.get_components_by_plugin_index(property_index); ++property_component)
                     particle_properties.push_back(interpolated_properties[0][property_information.get_position_by_plugin_index(property_index)+property_component]);
                   break;
@@ -21,6 +21,8 @@
 #include <aspect/particle/property_pool.h>
 #include <aspect/particle/particle.h>
 
+#include <algorithm>
+
 #if !DEAL_II_VERSION_GTE(9,0,0)
 
 namespace aspect
@@ -32,7 +34,8 @@ namespace aspect
 
     PropertyPool::PropertyPool (const unsigned int n_properties_per_slot)
       :
-      n_properties (n_properties_per_slot)
+      n_properties (n_properties_per_slot),
+      n_slots (0)
     {}
 
 
@@ -40,10 +43,17 @@ namespace aspect
     PropertyPool::Handle
     PropertyPool::allocate_properties_array ()
     {
-      if (n_properties > 0)
-        return new double[n_properties];
+      if (n_properties == 0)
+        return invalid_handle;
+
+      std::lock_guard<std::mutex> lock (pool_mutex);
 
-      return invalid_handle;
+      if (free_slots.empty())
+        add_chunk (std::max (n_slots, min_slots_per_chunk));
+
+      const Handle handle = free_slots.back();
+      free_slots.pop_back();
+      return handle;
     }
 
 
@@ -51,7 +61,11 @@ namespace aspect
     void
     PropertyPool::deallocate_properties_array (Handle handle)
     {
-      delete[] handle;
+      if (handle == invalid_handle)
+        return;
+
+      std::lock_guard<std::mutex> lock (pool_mutex);
+      free_slots.push_back (handle);
     }
 
 
@@ -66,9 +80,32 @@ namespace aspect
     void
     PropertyPool::reserve(const std::size_t size)
     {
-      (void)size;
+      if (n_properties == 0)
+        return;
+
+      std::lock_guard<std::mutex> lock (pool_mutex);
+      if (size > n_slots)
+        add_chunk (std::max (size - n_slots, min_slots_per_chunk));
+    }
+
+
+
+    void
+    PropertyPool::add_chunk (const std::size_t n_new_slots)
+    {
+      chunks.emplace_back (new double[n_new_slots * n_properties]);
+      double *const chunk = chunks.back().get();
+
+      // add the new slots in reverse order, so that consecutive allocations
+      // return consecutive slots of the chunk
+      free_slots.reserve (free_slots.size() + n_new_slots);
+      for (std::size_t i=n_new_slots; i>0; --i)
+        free_slots.push_back (chunk + (i-1) * n_properties);
+
+      n_slots += n_new_slots;
     }
 
+
     unsigned int
     PropertyPool::n_properties_per_slot() const
     {
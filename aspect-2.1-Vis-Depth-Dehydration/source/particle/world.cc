@@ -26,18 +26,29 @@
 #include <aspect/citation_info.h>
 
 #include <deal.II/base/quadrature_lib.h>
+#include <deal.II/base/work_stream.h>
+#include <deal.II/base/utilities.h>
+#include <deal.II/grid/filtered_iterator.h>
 #include <deal.II/fe/fe_values.h>
 #include <deal.II/grid/grid_tools.h>
 #include <boost/serialization/map.hpp>
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
 namespace aspect
 {
   namespace Particle
   {
     template <int dim>
     World<dim>::World()
+      :
+      checkpoint_has_separate_particle_file (false)
     {}
 
     template <int dim>
@@ -174,6 +185,14 @@ namespace aspect
       signals.pre_checkpoint_store_user_data.connect(
         [&] (typename parallel::distributed::Triangulation<dim> &)
       {
+        checkpoint_has_separate_particle_file = checkpoint_particles_in_separate_file;
+        if (checkpoint_particles_in_separate_file)
+          {
+            TimerOutput::Scope timer_section(this->get_computing_timer(), "Particles: Write checkpoint");
+            write_particle_checkpoint (particle_checkpoint_file_name(true));
+            return;
+          }
+
 #if !DEAL_II_VERSION_GTE(9,1,0)
         particle_handler->register_store_callback_function(false);
 #else
@@ -184,7 +203,15 @@ namespace aspect
       signals.post_resume_load_user_data.connect(
         [&] (typename parallel::distributed::Triangulation<dim> &)
       {
-        particle_handler->register_load_callback_function(true);
+        // The checkpoint contains a separate particle file if it was written
+        // with this option, independent of the setting of the current run.
+        // Otherwise the particles are attached to the triangulation. The
+        // serialized data of the checkpoint, which has already been loaded,
+        // records which of the two it is.
+        if (checkpoint_has_separate_particle_file)
+          read_particle_checkpoint (particle_checkpoint_file_name(false));
+        else
+          particle_handler->register_load_callback_function(true);
       });
 
       signals.post_refinement_load_user_data.connect(
@@ -447,25 +474,28 @@ namespace aspect
     void
     World<dim>::local_update_particles(const typename DoFHandler<dim>::active_cell_iterator &cell,
                                        const typename ParticleHandler<dim>::particle_iterator &begin_particle,
-                                       const typename ParticleHandler<dim>::particle_iterator &end_particle)
+                                       const typename ParticleHandler<dim>::particle_iterator &end_particle,
+                                       ScratchData &scratch)
     {
       const unsigned int particles_in_cell = std::distance(begin_particle,end_particle);
       const unsigned int solution_components = this->introspection().n_components;
 
-      Vector<double>              value (solution_components);
-      std::vector<Tensor<1,dim> > gradient (solution_components,Tensor<1,dim>());
-
-      std::vector<Vector<double> >              values(particles_in_cell,value);
-      std::vector<std::vector<Tensor<1,dim> > > gradients(particles_in_cell,gradient);
-      std::vector<Point<dim> >                  positions(particles_in_cell);
+      // resize the arrays of the scratch object. this only allocates
+      // memory if the current cell has more particles than any cell
+      // this thread has worked on before
+      scratch.values.resize(particles_in_cell, Vector<double>(solution_components));
+      scratch.gradients.resize(particles_in_cell, std::vector<Tensor<1,dim> >(solution_components));
+      scratch.positions.resize(particles_in_cell);
 
       typename ParticleHandler<dim>::particle_iterator it = begin_particle;
       for (unsigned int i = 0; it!=end_particle; ++it,++i)
         {
-          positions[i] = it->get_reference_location();
+          scratch.positions[i] = it->get_reference_location();
         }
 
-      const Quadrature<dim> quadrature_formula(positions);
+      // the quadrature points differ from cell to cell, so the FEValues
+      // object can not be kept in the scratch object
+      const Quadrature<dim> quadrature_formula(scratch.positions);
       const UpdateFlags update_flags = property_manager->get_needed_update_flags();
       FEValues<dim> fe_value (this->get_mapping(),
                               this->get_fe(),
@@ -475,30 +505,207 @@ namespace aspect
       fe_value.reinit (cell);
       if (update_flags & update_values)
         fe_value.get_function_values (this->get_solution(),
-                                      values);
+                                      scratch.values);
       if (update_flags & update_gradients)
         fe_value.get_function_gradients (this->get_solution(),
-                                         gradients);
+                                         scratch.gradients);
 
       it = begin_particle;
       for (unsigned int i = 0; it!=end_particle; ++it,++i)
         {
           property_manager->update_one_particle(it,
-                                                values[i],
-                                                gradients[i]);
+                                                scratch.values[i],
+                                                scratch.gradients[i]);
+        }
+    }
+
+    namespace
+    {
+      /**
+       * Evaluate the function with the given @p coefficients in a tensor
+       * product basis with @p n_1d one-dimensional basis functions per
+       * coordinate direction. The coefficients are given in lexicographic
+       * order, and @p basis_values_1d contains the values of the
+       * one-dimensional basis functions, first all of them for the first
+       * coordinate direction, then for the second, and so on. The sum is
+       * computed by sum factorization, i.e., by contracting one coordinate
+       * direction after the other, which needs n_1d^dim instead of
+       * dim*n_1d^dim operations. @p partial_sums is used as temporary
+       * storage.
+       */
+      template <int dim>
+      Tensor<1,dim>
+      evaluate_tensor_product (const std::vector<Tensor<1,dim> > &coefficients,
+                               const unsigned int n_1d,
+                               const std::vector<double> &basis_values_1d,
+                               std::vector<Tensor<1,dim> > &partial_sums)
+      {
+        const Tensor<1,dim> *input = coefficients.data();
+        unsigned int n_inputs = coefficients.size();
+
+        for (unsigned int d=0; d<dim; ++d)
+          {
+            // contract the fastest running index. writing the results into
+            // the same array that we read from is safe, because result r is
+            // only written after all inputs r*n_1d,...,(r+1)*n_1d-1 have
+            // been read, and later results only read inputs behind these.
+            const unsigned int n_outputs = n_inputs / n_1d;
+            const double *values = &basis_values_1d[d*n_1d];
+            for (unsigned int r=0; r<n_outputs; ++r)
+              {
+                Tensor<1,dim> sum;
+                for (unsigned int i=0; i<n_1d; ++i)
+                  sum += input[r*n_1d+i] * values[i];
+                partial_sums[r] = sum;
+              }
+
+            input = partial_sums.data();
+            n_inputs = n_outputs;
+          }
+
+        return input[0];
+      }
+    }
+
+
+
+    template <int dim>
+    void
+    World<dim>::setup_velocity_evaluation ()
+    {
+      const FiniteElement<dim> &velocity_fe = this->get_fe().base_element(this->introspection()
+                                                                          .base_elements.velocities);
+      const unsigned int dofs_per_cell = velocity_fe.dofs_per_cell;
+
+      velocity_basis_1d.clear();
+      velocity_dof_order.clear();
+
+      // check whether the velocity element is a tensor product of Lagrange
+      // polynomials. this is the case if the coordinates of its support points
+      // are taken from one set of n_1d points in every direction, and if the
+      // products of the Lagrange polynomials for these points are its
+      // shape functions
+      if (velocity_fe.has_support_points())
+        {
+          const std::vector<Point<dim> > &support_points = velocity_fe.get_unit_support_points();
+          const double tolerance = 1e-12;
+
+          std::vector<double> nodes;
+          for (unsigned int j=0; j<dofs_per_cell; ++j)
+            nodes.push_back(support_points[j][0]);
+          std::sort(nodes.begin(), nodes.end());
+          nodes.erase(std::unique(nodes.begin(), nodes.end(),
+                                  [&](const double a, const double b)
+          {
+            return std::abs(a-b) < tolerance;
+          }),
+          nodes.end());
+
+          const unsigned int n_1d = nodes.size();
+          bool is_tensor_product = (n_1d > 1 && Utilities::fixed_power<dim>(n_1d) == dofs_per_cell);
+
+          std::vector<unsigned int> dof_order (dofs_per_cell, numbers::invalid_unsigned_int);
+          for (unsigned int j=0; j<dofs_per_cell && is_tensor_product; ++j)
+            {
+              unsigned int lexicographic_index = 0;
+              unsigned int stride = 1;
+              for (unsigned int d=0; d<dim; ++d, stride *= n_1d)
+                {
+                  unsigned int i = 0;
+                  while (i<n_1d && std::abs(nodes[i] - support_points[j][d]) >= tolerance)
+                    ++i;
+                  if (i == n_1d)
+                    {
+                      is_tensor_product = false;
+                      break;
+                    }
+                  lexicographic_index += i * stride;
+                }
+
+              if (is_tensor_product && dof_order[lexicographic_index] == numbers::invalid_unsigned_int)
+                dof_order[lexicographic_index] = j;
+              else
+                is_tensor_product = false;
+            }
+
+          if (is_tensor_product)
+            {
+              std::vector<Point<1> > nodes_1d (n_1d);
+              for (unsigned int i=0; i<n_1d; ++i)
+                nodes_1d[i][0] = nodes[i];
+              const std::vector<Polynomials::Polynomial<double> > basis_1d
+                = Polynomials::generate_complete_Lagrange_basis(nodes_1d);
+
+              // make sure the products of the one-dimensional polynomials
+              // really are the shape functions of the element
+              Point<dim> test_point;
+              for (unsigned int d=0; d<dim; ++d)
+                test_point[d] = 0.3 + 0.17*d;
+
+              for (unsigned int k=0; k<dofs_per_cell && is_tensor_product; ++k)
+                {
+                  double value = 1.0;
+                  unsigned int index = k;
+                  for (unsigned int d=0; d<dim; ++d, index /= n_1d)
+                    value *= basis_1d[index % n_1d].value(test_point[d]);
+
+                  if (std::abs(value - velocity_fe.shape_value(dof_order[k], test_point)) > 1e-10)
+                    is_tensor_product = false;
+                }
+
+              if (is_tensor_product)
+                {
+                  velocity_basis_1d = basis_1d;
+                  velocity_dof_order = dof_order;
+                }
+            }
+        }
+
+      if (velocity_dof_order.empty())
+        {
+          velocity_dof_order.resize(dofs_per_cell);
+          for (unsigned int j=0; j<dofs_per_cell; ++j)
+            velocity_dof_order[j] = j;
+        }
+
+      // compute the indices of the velocity degrees of freedom within the
+      // degrees of freedom of a cell once, rather than for every cell
+      velocity_system_indices.resize(dofs_per_cell * dim);
+      for (unsigned int k=0; k<dofs_per_cell; ++k)
+        for (unsigned int dir=0; dir<dim; ++dir)
+          velocity_system_indices[k*dim+dir]
+            = this->get_fe().component_to_system_index(this->introspection().component_indices.velocities[dir],
+                                                       velocity_dof_order[k]);
+
+      fluid_velocity_system_indices.clear();
+      if (this->include_melt_transport())
+        {
+          const unsigned int fluid_component_index = this->introspection().variable("fluid velocity").first_component_index;
+
+          fluid_velocity_system_indices.resize(dofs_per_cell * dim);
+          for (unsigned int k=0; k<dofs_per_cell; ++k)
+            for (unsigned int dir=0; dir<dim; ++dir)
+              fluid_velocity_system_indices[k*dim+dir]
+                = this->get_fe().component_to_system_index(fluid_component_index + dir,
+                                                           velocity_dof_order[k]);
         }
     }
 
+
+
     template <int dim>
     void
     World<dim>::local_advect_particles(const typename DoFHandler<dim>::active_cell_iterator &cell,
                                        const typename ParticleHandler<dim>::particle_iterator &begin_particle,
-                                       const typename ParticleHandler<dim>::particle_iterator &end_particle)
+                                       const typename ParticleHandler<dim>::particle_iterator &end_particle,
+                                       ScratchData &scratch)
     {
       const unsigned int particles_in_cell = std::distance(begin_particle,end_particle);
 
-      std::vector<Tensor<1,dim> >  velocity(particles_in_cell);
-      std::vector<Tensor<1,dim> >  old_velocity(particles_in_cell);
+      std::vector<Tensor<1,dim> > &velocity = scratch.velocities;
+      std::vector<Tensor<1,dim> > &old_velocity = scratch.old_velocities;
+      velocity.assign(particles_in_cell, Tensor<1,dim>());
+      old_velocity.assign(particles_in_cell, Tensor<1,dim>());
 
       // Below we manually evaluate the solution at all support points of the
       // current cell, and then use the shape functions to interpolate the
@@ -508,69 +715,92 @@ namespace aspect
       // for other cells, it is much faster to do the work manually. Also this
       // function is quite performance critical.
 
-      std::vector<types::global_dof_index> cell_dof_indices (this->get_fe().dofs_per_cell);
+      std::vector<types::global_dof_index> &cell_dof_indices = scratch.cell_dof_indices;
+      cell_dof_indices.resize (this->get_fe().dofs_per_cell);
       cell->get_dof_indices (cell_dof_indices);
 
       const FiniteElement<dim> &velocity_fe = this->get_fe().base_element(this->introspection()
                                                                           .base_elements.velocities);
+      const unsigned int n_velocity_dofs = velocity_fe.dofs_per_cell;
 
       const bool compute_fluid_velocity = this->include_melt_transport() &&
                                           property_manager->get_data_info().fieldname_exists("melt_presence");
 
-      const unsigned int fluid_component_index = (compute_fluid_velocity ?
-                                                  this->introspection().variable("fluid velocity").first_component_index
-                                                  :
-                                                  numbers::invalid_unsigned_int);
-
       // In regions without melt, the fluid velocity equals the solid velocity, so we can use it for all particles.
       std::vector<bool> use_fluid_velocity((compute_fluid_velocity ?
                                             particles_in_cell
                                             :
                                             0), compute_fluid_velocity);
 
-      for (unsigned int j=0; j<velocity_fe.dofs_per_cell; ++j)
-        {
-          Tensor<1,dim> velocity_at_support_point;
-          Tensor<1,dim> old_velocity_at_support_point;
-
-          for (unsigned int dir=0; dir<dim; ++dir)
-            {
-              const unsigned int support_point_index
-                = this->get_fe().component_to_system_index(this->introspection()
-                                                           .component_indices.velocities[dir],j);
+      // gather the current and old velocity values at all support points
+      // of the cell once, so that the evaluation for each particle below
+      // only works on these local arrays
+      const LinearAlgebra::BlockVector &solution = this->get_solution();
+      const LinearAlgebra::BlockVector &old_solution = this->get_old_solution();
 
-              velocity_at_support_point[dir] = this->get_solution()[cell_dof_indices[support_point_index]];
-              old_velocity_at_support_point[dir] = this->get_old_solution()[cell_dof_indices[support_point_index]];
-            }
-
-          Tensor<1,dim> fluid_velocity_at_support_point;
-          Tensor<1,dim> old_fluid_velocity_at_support_point;
+      scratch.velocity_coefficients.resize(n_velocity_dofs);
+      scratch.old_velocity_coefficients.resize(n_velocity_dofs);
+      for (unsigned int k=0; k<n_velocity_dofs; ++k)
+        for (unsigned int dir=0; dir<dim; ++dir)
+          {
+            const types::global_dof_index dof_index = cell_dof_indices[velocity_system_indices[k*dim+dir]];
+            scratch.velocity_coefficients[k][dir] = solution(dof_index);
+            scratch.old_velocity_coefficients[k][dir] = old_solution(dof_index);
+          }
 
-          if (compute_fluid_velocity)
+      if (compute_fluid_velocity)
+        {
+          scratch.fluid_velocity_coefficients.resize(n_velocity_dofs);
+          scratch.old_fluid_velocity_coefficients.resize(n_velocity_dofs);
+          for (unsigned int k=0; k<n_velocity_dofs; ++k)
             for (unsigned int dir=0; dir<dim; ++dir)
               {
-                const unsigned int support_point_index
-                  = this->get_fe().component_to_system_index(fluid_component_index + dir,j);
-
-                fluid_velocity_at_support_point[dir] = this->get_solution()[cell_dof_indices[support_point_index]];
-                old_fluid_velocity_at_support_point[dir] = this->get_old_solution()[cell_dof_indices[support_point_index]];
+                const types::global_dof_index dof_index = cell_dof_indices[fluid_velocity_system_indices[k*dim+dir]];
+                scratch.fluid_velocity_coefficients[k][dir] = solution(dof_index);
+                scratch.old_fluid_velocity_coefficients[k][dir] = old_solution(dof_index);
               }
+        }
+
+      if (velocity_basis_1d.size() > 0)
+        {
+          // the velocity element is a tensor product element: evaluate the
+          // one-dimensional polynomials at the particle location, and then
+          // the velocities by sum factorization
+          const unsigned int n_1d = velocity_basis_1d.size();
+          scratch.basis_values_1d.resize(dim * n_1d);
+          scratch.partial_sums.resize(n_velocity_dofs / n_1d);
 
           typename ParticleHandler<dim>::particle_iterator it = begin_particle;
           for (unsigned int particle_index = 0; it!=end_particle; ++it,++particle_index)
             {
-              // melt FE uses the same FE so the shape value is the same
-              const double shape_value = velocity_fe.shape_value(j,it->get_reference_location());
+              const Point<dim> reference_location = it->get_reference_location();
+              for (unsigned int d=0; d<dim; ++d)
+                for (unsigned int i=0; i<n_1d; ++i)
+                  scratch.basis_values_1d[d*n_1d+i] = velocity_basis_1d[i].value(reference_location[d]);
+
+              // melt FE uses the same FE so the shape values are the same
+              const bool use_fluid = (compute_fluid_velocity && use_fluid_velocity[particle_index]);
+              velocity[particle_index] = evaluate_tensor_product(use_fluid ? scratch.fluid_velocity_coefficients : scratch.velocity_coefficients,
+                                                                 n_1d, scratch.basis_values_1d, scratch.partial_sums);
+              old_velocity[particle_index] = evaluate_tensor_product(use_fluid ? scratch.old_fluid_velocity_coefficients : scratch.old_velocity_coefficients,
+                                                                     n_1d, scratch.basis_values_1d, scratch.partial_sums);
+            }
+        }
+      else
+        {
+          typename ParticleHandler<dim>::particle_iterator it = begin_particle;
+          for (unsigned int particle_index = 0; it!=end_particle; ++it,++particle_index)
+            {
+              const Point<dim> reference_location = it->get_reference_location();
+              const bool use_fluid = (compute_fluid_velocity && use_fluid_velocity[particle_index]);
+              const std::vector<Tensor<1,dim> > &particle_coefficients = (use_fluid ? scratch.fluid_velocity_coefficients : scratch.velocity_coefficients);
+              const std::vector<Tensor<1,dim> > &old_particle_coefficients = (use_fluid ? scratch.old_fluid_velocity_coefficients : scratch.old_velocity_coefficients);
 
-              if (compute_fluid_velocity && use_fluid_velocity[particle_index])
-                {
-                  velocity[particle_index] += fluid_velocity_at_support_point * shape_value;
-                  old_velocity[particle_index] += old_fluid_velocity_at_support_point * shape_value;
-                }
-              else
+              for (unsigned int k=0; k<n_velocity_dofs; ++k)
                 {
-                  velocity[particle_index] += velocity_at_support_point * shape_value;
-                  old_velocity[particle_index] += old_velocity_at_support_point * shape_value;
+                  const double shape_value = velocity_fe.shape_value(velocity_dof_order[k],reference_location);
+                  velocity[particle_index] += particle_coefficients[k] * shape_value;
+                  old_velocity[particle_index] += old_particle_coefficients[k] * shape_value;
                 }
             }
         }
@@ -582,6 +812,30 @@ namespace aspect
                                        this->get_timestep());
     }
 
+    template <int dim>
+    void
+    World<dim>::run_on_locally_owned_cells (const std::function<void (const typename DoFHandler<dim>::active_cell_iterator &,
+                                                                      ScratchData &,
+                                                                      CopyData &)> &worker)
+    {
+      typedef
+      FilteredIterator<typename DoFHandler<dim>::active_cell_iterator>
+      CellFilter;
+
+      // the work on the particles of one cell does not modify anything
+      // outside of these particles, so there is nothing to copy into
+      // global objects
+      WorkStream::
+      run (CellFilter (IteratorFilters::LocallyOwnedCell(),
+                       this->get_dof_handler().begin_active()),
+           CellFilter (IteratorFilters::LocallyOwnedCell(),
+                       this->get_dof_handler().end()),
+           worker,
+           [](const CopyData &) {},
+           ScratchData(),
+           CopyData());
+    }
+
     template <int dim>
     void
     World<dim>::setup_initial_state ()
@@ -626,30 +880,27 @@ namespace aspect
       for (ParticleIterator<dim> particle = particle_handler->begin(); particle!=particle_handler->end(); ++particle)
         particle->set_property_pool(particle_handler->get_property_pool());
 
-
-      // TODO: Change this loop over all cells to use the WorkStream interface
       if (property_manager->get_n_property_components() > 0)
         {
           TimerOutput::Scope timer_section(this->get_computing_timer(), "Particles: Initialize properties");
 
           particle_handler->get_property_pool().reserve(2 * particle_handler->n_locally_owned_particles());
 
-          // Loop over all cells and initialize the particles cell-wise
-          typename DoFHandler<dim>::active_cell_iterator
-          cell = this->get_dof_handler().begin_active(),
-          endc = this->get_dof_handler().end();
+          // Loop over all cells in parallel and initialize the particles cell-wise
+          auto worker = [&](const typename DoFHandler<dim>::active_cell_iterator &cell,
+                            ScratchData &,
+                            CopyData &)
+          {
+            const typename ParticleHandler<dim>::particle_iterator_range
+            particles_in_cell = particle_handler->particles_in_cell(cell);
 
-          for (; cell!=endc; ++cell)
-            if (cell->is_locally_owned())
-              {
-                typename ParticleHandler<dim>::particle_iterator_range
-                particles_in_cell = particle_handler->particles_in_cell(cell);
+            // Only initialize particles, if there are any in this cell
+            if (particles_in_cell.begin() != particles_in_cell.end())
+              local_initialize_particles(particles_in_cell.begin(),
+                                         particles_in_cell.end());
+          };
 
-                // Only initialize particles, if there are any in this cell
-                if (particles_in_cell.begin() != particles_in_cell.end())
-                  local_initialize_particles(particles_in_cell.begin(),
-                                             particles_in_cell.end());
-              }
+          run_on_locally_owned_cells (worker);
           if (update_ghost_particles &&
               dealii::Utilities::MPI::n_mpi_processes(this->get_mpi_communicator()) > 1)
             {
@@ -663,29 +914,27 @@ namespace aspect
     void
     World<dim>::update_particles()
     {
-      // TODO: Change this loop over all cells to use the WorkStream interface
-
       if (property_manager->get_n_property_components() > 0)
         {
           TimerOutput::Scope timer_section(this->get_computing_timer(), "Particles: Update properties");
 
-          // Loop over all cells and update the particles cell-wise
-          typename DoFHandler<dim>::active_cell_iterator
-          cell = this->get_dof_handler().begin_active(),
-          endc = this->get_dof_handler().end();
-
-          for (; cell!=endc; ++cell)
-            if (cell->is_locally_owned())
-              {
-                typename ParticleHandler<dim>::particle_iterator_range
-                particles_in_cell = particle_handler->particles_in_cell(cell);
+          // Loop over all cells in parallel and update the particles cell-wise
+          auto worker = [&](const typename DoFHandler<dim>::active_cell_iterator &cell,
+                            ScratchData &scratch,
+                            CopyData &)
+          {
+            const typename ParticleHandler<dim>::particle_iterator_range
+            particles_in_cell = particle_handler->particles_in_cell(cell);
+
+            // Only update particles, if there are any in this cell
+            if (particles_in_cell.begin() != particles_in_cell.end())
+              local_update_particles(cell,
+                                     particles_in_cell.begin(),
+                                     particles_in_cell.end(),
+                                     scratch);
+          };
 
-                // Only update particles, if there are any in this cell
-                if (particles_in_cell.begin() != particles_in_cell.end())
-                  local_update_particles(cell,
-                                         particles_in_cell.begin(),
-                                         particles_in_cell.end());
-              }
+          run_on_locally_owned_cells (worker);
         }
     }
 
@@ -694,26 +943,28 @@ namespace aspect
     World<dim>::advect_particles()
     {
       {
-        // TODO: Change this loop over all cells to use the WorkStream interface
         TimerOutput::Scope timer_section(this->get_computing_timer(), "Particles: Advect");
 
-        // Loop over all cells and advect the particles cell-wise
-        typename DoFHandler<dim>::active_cell_iterator
-        cell = this->get_dof_handler().begin_active(),
-        endc = this->get_dof_handler().end();
+        if (velocity_dof_order.empty())
+          setup_velocity_evaluation();
 
-        for (; cell!=endc; ++cell)
-          if (cell->is_locally_owned())
-            {
-              const typename ParticleHandler<dim>::particle_iterator_range
-              particles_in_cell = particle_handler->particles_in_cell(cell);
-
-              // Only advect particles, if there are any in this cell
-              if (particles_in_cell.begin() != particles_in_cell.end())
-                local_advect_particles(cell,
-                                       particles_in_cell.begin(),
-                                       particles_in_cell.end());
-            }
+        // Loop over all cells in parallel and advect the particles cell-wise
+        auto worker = [&](const typename DoFHandler<dim>::active_cell_iterator &cell,
+                          ScratchData &scratch,
+                          CopyData &)
+        {
+          const typename ParticleHandler<dim>::particle_iterator_range
+          particles_in_cell = particle_handler->particles_in_cell(cell);
+
+          // Only advect particles, if there are any in this cell
+          if (particles_in_cell.begin() != particles_in_cell.end())
+            local_advect_particles(cell,
+                                   particles_in_cell.begin(),
+                                   particles_in_cell.end(),
+                                   scratch);
+        };
+
+        run_on_locally_owned_cells (worker);
 
         // If particles fell out of the mesh, put them back in if they have crossed
         // a periodic boundary. If they have left the mesh otherwise, they will be
@@ -756,6 +1007,422 @@ namespace aspect
         }
     }
 
+    namespace
+    {
+      /**
+       * The version of the format of particle checkpoint files, written
+       * into the header of each file.
+       */
+      const std::uint64_t particle_checkpoint_format_version = 1;
+
+      /**
+       * Describe the cell @p cell in a way that does not depend on how the
+       * mesh is distributed among processes: by the index of its coarse
+       * cell, its level, and the indices of the children on the path from
+       * the coarse cell to @p cell, using three bits per level.
+       */
+      template <int dim>
+      void
+      encode_cell (typename Triangulation<dim>::cell_iterator cell,
+                   std::uint32_t &coarse_cell_index,
+                   std::uint32_t &level,
+                   std::uint64_t &child_path)
+      {
+        AssertThrow (cell->level() <= 64/3,
+                     ExcMessage ("Particle checkpoint files can only describe cells "
+                                 "up to refinement level 21."));
+
+        level = cell->level();
+        child_path = 0;
+        while (cell->level() > 0)
+          {
+            const typename Triangulation<dim>::cell_iterator parent = cell->parent();
+            unsigned int child_index = 0;
+            while (parent->child(child_index) != cell)
+              ++child_index;
+
+            child_path |= static_cast<std::uint64_t>(child_index) << (3*(cell->level()-1));
+            cell = parent;
+          }
+        coarse_cell_index = cell->index();
+      }
+
+      /**
+       * Find the cell described by the output of encode_cell(). Return
+       * the end iterator if the cell is not part of the mesh on this
+       * process, i.e., if it lies in the artificial part of the mesh.
+       */
+      template <int dim>
+      typename Triangulation<dim>::cell_iterator
+      decode_cell (const Triangulation<dim> &triangulation,
+                   const std::uint32_t coarse_cell_index,
+                   const std::uint32_t level,
+                   const std::uint64_t child_path)
+      {
+        typename Triangulation<dim>::cell_iterator cell (&triangulation, 0, coarse_cell_index);
+        for (unsigned int l=1; l<=level; ++l)
+          {
+            if (!cell->has_children())
+              return triangulation.end();
+            cell = cell->child((child_path >> (3*(l-1))) & 7);
+          }
+        return cell;
+      }
+    }
+
+
+
+    template <int dim>
+    std::string
+    World<dim>::particle_checkpoint_file_name (const bool for_writing) const
+    {
+      // This has to match the name of the mesh file in
+      // Simulator::create_snapshot()
+      return this->get_output_directory()
+             + "restart.mesh"
+             + (for_writing && this->get_parameters().checkpoint_in_background ? ".tmp" : "")
+             + ".particles";
+    }
+
+
+
+    template <int dim>
+    void
+    World<dim>::write_particle_checkpoint (const std::string &filename) const
+    {
+      const MPI_Comm comm = this->get_mpi_communicator();
+      const unsigned int n_processes = Utilities::MPI::n_mpi_processes(comm);
+      const unsigned int my_rank = Utilities::MPI::this_mpi_process(comm);
+
+      const unsigned int n_properties = property_manager->get_n_property_components();
+      const std::size_t record_size = 2*sizeof(std::uint32_t) + 2*sizeof(std::uint64_t)
+                                      + (2*dim + n_properties) * sizeof(double)
+                                      + integrator->get_data_size();
+
+      // Pack all locally owned particles cell by cell into one buffer,
+      // and compute a box around their locations
+      std::uint64_t n_local_particles = particle_handler->n_locally_owned_particles();
+      AssertThrow (n_local_particles < static_cast<std::uint64_t>(std::numeric_limits<int>::max()),
+                   ExcMessage ("Too many particles on one process for writing a particle checkpoint file."));
+
+      std::vector<char> buffer (n_local_particles * record_size);
+      std::vector<double> bounding_box (2*dim);
+      for (unsigned int d=0; d<dim; ++d)
+        {
+          bounding_box[d] = std::numeric_limits<double>::max();
+          bounding_box[dim+d] = -std::numeric_limits<double>::max();
+        }
+
+      char *record = buffer.data();
+      const auto pack = [&record] (const void *data, const std::size_t size)
+      {
+        std::memcpy (record, data, size);
+        record += size;
+      };
+
+      for (const auto &cell : this->get_triangulation().active_cell_iterators())
+        if (cell->is_locally_owned())
+          {
+            const boost::iterator_range<typename ParticleHandler<dim>::particle_iterator>
+            particles_in_cell = particle_handler->particles_in_cell(cell);
+
+            if (particles_in_cell.begin() == particles_in_cell.end())
+              continue;
+
+            std::uint32_t coarse_cell_index, level;
+            std::uint64_t child_path;
+            encode_cell<dim> (cell, coarse_cell_index, level, child_path);
+
+            for (typename ParticleHandler<dim>::particle_iterator particle = particles_in_cell.begin();
+                 particle != particles_in_cell.end(); ++particle)
+              {
+                const std::uint64_t id = particle->get_id();
+                const Point<dim> location = particle->get_location();
+                const Point<dim> reference_location = particle->get_reference_location();
+
+                pack (&coarse_cell_index, sizeof(coarse_cell_index));
+                pack (&level, sizeof(level));
+                pack (&child_path, sizeof(child_path));
+                pack (&id, sizeof(id));
+                for (unsigned int d=0; d<dim; ++d)
+                  pack (&location[d], sizeof(double));
+                for (unsigned int d=0; d<dim; ++d)
+                  pack (&reference_location[d], sizeof(double));
+                if (n_properties > 0)
+                  pack (&particle->get_properties()[0], n_properties * sizeof(double));
+                record = static_cast<char *>(integrator->write_data(particle, record));
+
+                for (unsigned int d=0; d<dim; ++d)
+                  {
+                    bounding_box[d] = std::min (bounding_box[d], location[d]);
+                    bounding_box[dim+d] = std::max (bounding_box[dim+d], location[d]);
+                  }
+              }
+          }
+      Assert (record == buffer.data() + buffer.size(), ExcInternalError());
+
+      // Determine where the records of this process start, and collect
+      // the index of the file on the root process. MPI_Exscan leaves the
+      // result on the first process undefined.
+      std::uint64_t first_record = 0;
+      MPI_Exscan (&n_local_particles, &first_record, 1, MPI_UINT64_T, MPI_SUM, comm);
+      if (my_rank == 0)
+        first_record = 0;
+
+      std::uint64_t local_index_entry[2] = { first_record, n_local_particles };
+      std::vector<std::uint64_t> index_entries (my_rank == 0 ? 2*n_processes : 0);
+      std::vector<double> index_boxes (my_rank == 0 ? 2*dim*n_processes : 0);
+      MPI_Gather (local_index_entry, 2, MPI_UINT64_T,
+                  index_entries.data(), 2, MPI_UINT64_T, 0, comm);
+      MPI_Gather (bounding_box.data(), 2*dim, MPI_DOUBLE,
+                  index_boxes.data(), 2*dim, MPI_DOUBLE, 0, comm);
+
+      const std::size_t header_size = 3*sizeof(std::uint64_t)
+                                      + n_processes * (2*sizeof(std::uint64_t) + 2*dim*sizeof(double));
+
+      // The root process has moved the file of the previous checkpoint out
+      // of the way before it got here. Make sure nobody opens the file
+      // before that.
+      MPI_Barrier (comm);
+
+      MPI_File file;
+      int ierr = MPI_File_open (comm, const_cast<char *>(filename.c_str()),
+                                MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file);
+      AssertThrow (ierr == MPI_SUCCESS,
+                   ExcMessage ("Could not open the particle checkpoint file <" + filename + "> for writing."));
+      MPI_File_set_size (file, 0);
+
+      MPI_Datatype record_type;
+      MPI_Type_contiguous (static_cast<int>(record_size), MPI_BYTE, &record_type);
+      MPI_Type_commit (&record_type);
+
+      // Only the root process writes the header, but all processes have
+      // to know whether that worked before they enter the collective write
+      if (my_rank == 0)
+        {
+          std::vector<char> header (header_size);
+          record = header.data();
+
+          const std::uint64_t header_start[3] = { particle_checkpoint_format_version,
+                                                  n_processes,
+                                                  record_size
+                                                };
+          pack (header_start, sizeof(header_start));
+          for (unsigned int p=0; p<n_processes; ++p)
+            {
+              pack (&index_entries[2*p], 2*sizeof(std::uint64_t));
+              pack (&index_boxes[2*dim*p], 2*dim*sizeof(double));
+            }
+
+          ierr = MPI_File_write_at (file, 0, header.data(), static_cast<int>(header_size), MPI_BYTE, MPI_STATUS_IGNORE);
+        }
+      MPI_Bcast (&ierr, 1, MPI_INT, 0, comm);
+      if (ierr != MPI_SUCCESS)
+        {
+          MPI_Type_free (&record_type);
+          MPI_File_close (&file);
+          AssertThrow (false,
+                       ExcMessage ("Could not write the header of the particle checkpoint file <" + filename + ">."));
+        }
+
+      // Now write the records of all processes in one collective operation
+      ierr = MPI_File_write_at_all (file,
+                                    header_size + first_record * record_size,
+                                    buffer.data(),
+                                    static_cast<int>(n_local_particles),
+                                    record_type,
+                                    MPI_STATUS_IGNORE);
+      const bool write_failed
+        = (Utilities::MPI::max (ierr != MPI_SUCCESS ? 1 : 0, comm) == 1);
+
+      MPI_Type_free (&record_type);
+      MPI_File_close (&file);
+
+      AssertThrow (!write_failed,
+                   ExcMessage ("Could not write particles to the particle checkpoint file <" + filename + ">."));
+    }
+
+
+
+    template <int dim>
+    void
+    World<dim>::read_particle_checkpoint (const std::string &filename)
+    {
+      const MPI_Comm comm = this->get_mpi_communicator();
+
+      const unsigned int n_properties = property_manager->get_n_property_components();
+      const std::size_t integrator_data_size = integrator->get_data_size();
+      const std::size_t record_size = 2*sizeof(std::uint32_t) + 2*sizeof(std::uint64_t)
+                                      + (2*dim + n_properties) * sizeof(double)
+                                      + integrator_data_size;
+
+      MPI_File file;
+      int ierr = MPI_File_open (comm, const_cast<char *>(filename.c_str()),
+                                MPI_MODE_RDONLY, MPI_INFO_NULL, &file);
+      AssertThrow (ierr == MPI_SUCCESS,
+                   ExcMessage ("Could not open the particle checkpoint file <" + filename + "> for reading."));
+
+      // Read and check the header and the index
+      std::uint64_t header_start[3];
+      MPI_File_read_at_all (file, 0, header_start, 3, MPI_UINT64_T, MPI_STATUS_IGNORE);
+      AssertThrow (header_start[0] == particle_checkpoint_format_version,
+                   ExcMessage ("The particle checkpoint file <" + filename + "> has an unknown format."));
+      AssertThrow (header_start[2] == record_size,
+                   ExcMessage ("The particles in the particle checkpoint file <" + filename + "> "
+                               "have a different size than the ones of this computation. Did you "
+                               "change the particle properties or the particle integrator?"));
+
+      const std::uint64_t n_writers = header_start[1];
+      const std::size_t index_entry_size = 2*sizeof(std::uint64_t) + 2*dim*sizeof(double);
+      const std::size_t header_size = 3*sizeof(std::uint64_t) + n_writers * index_entry_size;
+
+      std::vector<char> index (n_writers * index_entry_size);
+      MPI_File_read_at_all (file, 3*sizeof(std::uint64_t), index.data(), static_cast<int>(index.size()), MPI_BYTE, MPI_STATUS_IGNORE);
+
+      // Compute a box around the locally owned cells. The box spanned by
+      // the vertices of a cell is enlarged a bit, because the mapping may
+      // curve the faces of the cell beyond its vertices.
+      std::vector<double> local_box (2*dim);
+      for (unsigned int d=0; d<dim; ++d)
+        {
+          local_box[d] = std::numeric_limits<double>::max();
+          local_box[dim+d] = -std::numeric_limits<double>::max();
+        }
+      for (const auto &cell : this->get_triangulation().active_cell_iterators())
+        if (cell->is_locally_owned())
+          {
+            const double tolerance = 0.1 * cell->diameter();
+            for (unsigned int v=0; v<GeometryInfo<dim>::vertices_per_cell; ++v)
+              for (unsigned int d=0; d<dim; ++d)
+                {
+                  local_box[d] = std::min (local_box[d], cell->vertex(v)[d] - tolerance);
+                  local_box[dim+d] = std::max (local_box[dim+d], cell->vertex(v)[d] + tolerance);
+                }
+          }
+
+      MPI_Datatype record_type;
+      MPI_Type_contiguous (static_cast<int>(record_size), MPI_BYTE, &record_type);
+      MPI_Type_commit (&record_type);
+
+      std::uint64_t n_particles_in_file = 0;
+      types::particle_index n_local_particles = 0;
+      std::vector<char> buffer;
+      std::vector<double> properties (n_properties);
+
+      for (std::uint64_t writer=0; writer<n_writers; ++writer)
+        {
+          std::uint64_t index_entry[2];
+          double writer_box[2*dim];
+          std::memcpy (index_entry, &index[writer*index_entry_size], sizeof(index_entry));
+          std::memcpy (writer_box, &index[writer*index_entry_size + sizeof(index_entry)], sizeof(writer_box));
+
+          const std::uint64_t first_record = index_entry[0];
+          const std::uint64_t n_records = index_entry[1];
+          n_particles_in_file += n_records;
+
+          // Only read the records of processes whose particles may lie in
+          // one of our cells
+          bool boxes_overlap = (n_records > 0);
+          for (unsigned int d=0; d<dim; ++d)
+            if (writer_box[dim+d] < local_box[d] || writer_box[d] > local_box[dim+d])
+              boxes_overlap = false;
+          if (!boxes_overlap)
+            continue;
+
+          buffer.resize (n_records * record_size);
+          ierr = MPI_File_read_at (file,
+                                   header_size + first_record * record_size,
+                                   buffer.data(),
+                                   static_cast<int>(n_records),
+                                   record_type,
+                                   MPI_STATUS_IGNORE);
+          AssertThrow (ierr == MPI_SUCCESS,
+                       ExcMessage ("Could not read particles from the particle checkpoint file <" + filename + ">."));
+
+          // The records are sorted by cell, so we only need to look up a
+          // cell if it differs from the one of the previous record
+          std::uint32_t previous_coarse_cell_index = numbers::invalid_unsigned_int;
+          std::uint32_t previous_level = numbers::invalid_unsigned_int;
+          std::uint64_t previous_child_path = 0;
+          bool cell_is_locally_owned = false;
+          typename Triangulation<dim>::active_cell_iterator cell;
+
+          const char *record = buffer.data();
+          const auto unpack = [&record] (void *data, const std::size_t size)
+          {
+            std::memcpy (data, record, size);
+            record += size;
+          };
+
+          for (std::uint64_t r=0; r<n_records; ++r)
+            {
+              std::uint32_t coarse_cell_index, level;
+              std::uint64_t child_path;
+              unpack (&coarse_cell_index, sizeof(coarse_cell_index));
+              unpack (&level, sizeof(level));
+              unpack (&child_path, sizeof(child_path));
+
+              if (coarse_cell_index != previous_coarse_cell_index
+                  || level != previous_level
+                  || child_path != previous_child_path)
+                {
+                  const typename Triangulation<dim>::cell_iterator located_cell
+                    = decode_cell<dim> (this->get_triangulation(), coarse_cell_index, level, child_path);
+
+                  cell_is_locally_owned = (located_cell != this->get_triangulation().end()
+                                           && located_cell->active()
+                                           && located_cell->is_locally_owned());
+                  if (cell_is_locally_owned)
+                    cell = located_cell;
+
+                  previous_coarse_cell_index = coarse_cell_index;
+                  previous_level = level;
+                  previous_child_path = child_path;
+                }
+
+              if (!cell_is_locally_owned)
+                {
+                  record += record_size - sizeof(coarse_cell_index) - sizeof(level) - sizeof(child_path);
+                  continue;
+                }
+
+              std::uint64_t id;
+              Point<dim> location, reference_location;
+              unpack (&id, sizeof(id));
+              for (unsigned int d=0; d<dim; ++d)
+                unpack (&location[d], sizeof(double));
+              for (unsigned int d=0; d<dim; ++d)
+                unpack (&reference_location[d], sizeof(double));
+
+              const typename ParticleHandler<dim>::particle_iterator particle
+                = particle_handler->insert_particle (Particle<dim> (location,
+                                                                    reference_location,
+                                                                    static_cast<types::particle_index>(id)),
+                                                     cell);
+
+              if (n_properties > 0)
+                {
+                  unpack (properties.data(), n_properties * sizeof(double));
+                  particle->set_properties (properties);
+                }
+
+              record = static_cast<const char *>(integrator->read_data(particle, record));
+              ++n_local_particles;
+            }
+        }
+
+      MPI_Type_free (&record_type);
+      MPI_File_close (&file);
+
+      particle_handler->update_cached_numbers();
+
+      AssertThrow (Utilities::MPI::sum (n_local_particles, comm) == n_particles_in_file,
+                   ExcMessage ("The particles read from the particle checkpoint file <" + filename + "> "
+                               "could not all be assigned to exactly one process."));
+    }
+
+
+
     template <int dim>
     void
     World<dim>::save (std::ostringstream &os) const
@@ -837,6 +1504,17 @@ namespace aspect
                              "particles in ghost cells need to be exchanged between the "
                              "processes neighboring this cell. This parameter determines "
                              "whether this transport is happening.");
+          prm.declare_entry ("Checkpoint particles in separate file", "false",
+                             Patterns::Bool (),
+                             "Whether particles should be written into a file of their "
+                             "own when a checkpoint is created, instead of being attached "
+                             "to the cells of the mesh and stored together with it. The "
+                             "separate file is written and read with a few collective "
+                             "parallel I/O operations, which is considerably faster for "
+                             "large numbers of particles. A computation can be resumed "
+                             "from checkpoints of either kind, independent of this "
+                             "parameter, and with a different number of processes than "
+                             "the one that wrote the checkpoint.");
         }
         prm.leave_subsection ();
       }
@@ -895,6 +1573,7 @@ namespace aspect
           particle_weight = prm.get_integer("Particle weight");
 
           update_ghost_particles = prm.get_bool("Update ghost particles");
+          checkpoint_particles_in_separate_file = prm.get_bool("Checkpoint particles in separate file");
 
           const std::vector<std::string> strategies = Utilities::split_string_list(prm.get ("Load balancing strategy"));
           AssertThrow(Utilities::has_unique_entries(strategies),
@@ -33,6 +33,7 @@
 
 
 #include <math.h>
+#include <sstream>
 
 namespace aspect
 {
@@ -78,7 +79,8 @@ namespace aspect
       // the first time around we get to check it
       last_output_time (std::numeric_limits<double>::quiet_NaN()),
       n_depth_zones (numbers::invalid_unsigned_int),
-      ascii_output(false)
+      ascii_output(false),
+      n_entries_written(0)
     {}
 
 
@@ -223,31 +225,48 @@ namespace aspect
           else
             {
               filename = (this->get_output_directory() + "depth_average.txt");
-              std::ofstream f(filename.c_str(), std::ofstream::out);
+
+              // if the file already contains all previous entries and we
+              // are allowed to append to it, only write the new entry.
+              // collect the output in a string first, so that appended data
+              // is written to the file in one piece
+              const bool append = (this->get_parameters().append_to_output_files
+                                   && n_entries_written > 0
+                                   && n_entries_written == entries.size()-1);
+              std::ostringstream output;
 
               // Write the header
-              f << "#       time" << "        depth";
-              for ( unsigned int i = 0; i < variables.size(); ++i)
-                f << " " << variables[i];
-              f << std::endl;
+              if (!append)
+                {
+                  output << "#       time" << "        depth";
+                  for ( unsigned int i = 0; i < variables.size(); ++i)
+                    output << " " << variables[i];
+                  output << '\n';
+                }
 
               // Output each data point in the entries object
-              for (typename std::vector<DataPoint>::const_iterator point = entries.begin();
+              for (typename std::vector<DataPoint>::const_iterator point = entries.begin() + (append ? n_entries_written : 0);
                    point != entries.end(); ++point)
                 {
                   double depth = max_depth/static_cast<double>(point->values[0].size())/2.0;
                   for (unsigned int d = 0; d < point->values[0].size(); ++d)
                     {
-                      f << std::setw(12)
-                        << (this->convert_output_to_years() ? point->time/year_in_seconds : point->time)
-                        << ' ' << std::setw(12) << depth;
+                      output << std::setw(12)
+                             << (this->convert_output_to_years() ? point->time/year_in_seconds : point->time)
+                             << ' ' << std::setw(12) << depth;
                       for ( unsigned int i = 0; i < variables.size(); ++i )
-                        f << ' ' << std::setw(12) << point->values[i][d];
-                      f << std::endl;
+                        output << ' ' << std::setw(12) << point->values[i][d];
+                      output << '\n';
                       depth+= max_depth/static_cast<double>(point->values[0].size() );
                     }
                 }
 
+              std::ofstream f(filename.c_str(),
+                              append ? std::ofstream::app : std::ofstream::out);
+              f << output.str();
+              f.flush();
+              n_entries_written = entries.size();
+
               AssertThrow (f, ExcMessage("Writing data to <" + filename +
                                          "> did not succeed in the `point values' "
                                          "postprocessor."));
@@ -153,12 +153,12 @@ namespace aspect
               // Evaluate the material model in the cell volume.
               MaterialModel::MaterialModelInputs<dim> in_volume(fe_volume_values, cell, this->introspection(), this->get_solution());
               MaterialModel::MaterialModelOutputs<dim> out_volume(fe_volume_values.n_quadrature_points, this->n_compositional_fields());
-              this->get_material_model().evaluate(in_volume, out_volume);
+              this->evaluate_material_model(in_volume, out_volume);
 
               // Evaluate the material model on the cell face.
               MaterialModel::MaterialModelInputs<dim> in_face(fe_face_values, cell, this->introspection(), this->get_solution());
               MaterialModel::MaterialModelOutputs<dim> out_face(fe_face_values.n_quadrature_points, this->n_compositional_fields());
-              this->get_material_model().evaluate(in_face, out_face);
+              this->evaluate_material_model(in_face, out_face);
 
               // Get solution values for the divergence of the velocity, which is not
               // computed by the material model.
@@ -291,7 +291,7 @@ namespace aspect
               // Evaluate the material model on the cell face.
               MaterialModel::MaterialModelInputs<dim> in_support(fe_support_values, cell, this->introspection(), this->get_solution());
               MaterialModel::MaterialModelOutputs<dim> out_support(fe_support_values.n_quadrature_points, this->n_compositional_fields());
-              this->get_material_model().evaluate(in_support, out_support);
+              this->evaluate_material_model(in_support, out_support);
 
               fe_support_values[this->introspection().extractors.velocities].get_function_values( topo_vector, stress_support_values );
               cell->face(face_idx)->get_dof_indices (face_dof_indices);
@@ -335,7 +335,7 @@ namespace aspect
               // Evaluate the material model on the cell face.
               MaterialModel::MaterialModelInputs<dim> in_output(fe_output_values, cell, this->introspection(), this->get_solution());
               MaterialModel::MaterialModelOutputs<dim> out_output(fe_output_values.n_quadrature_points, this->n_compositional_fields());
-              this->get_material_model().evaluate(in_output, out_output);
+              this->evaluate_material_model(in_output, out_output);
 
               fe_output_values[this->introspection().extractors.velocities].get_function_values( topo_vector, stress_output_values );
 
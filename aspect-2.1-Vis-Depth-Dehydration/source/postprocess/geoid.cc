@@ -39,38 +39,39 @@ namespace aspect
     std::pair<std::vector<double>,std::vector<double> >
     Geoid<dim>::to_spherical_harmonic_coefficients(const std::vector<std::vector<double> > &spherical_function) const
     {
-      std::vector<double> cosi(spherical_function.size(),0);
-      std::vector<double> sini(spherical_function.size(),0);
-      std::vector<double> coecos;
-      std::vector<double> coesin;
+      // the coefficients are stored for all degrees from min_degree to
+      // max_degree and, within each degree, for all orders
+      const unsigned int first_index = min_degree*(min_degree+1)/2;
+      const unsigned int n_coefficients = (max_degree+1)*(max_degree+2)/2 - first_index;
 
-      for (unsigned int ideg =  min_degree; ideg < max_degree+1; ideg++)
+      std::vector<double> coecos(n_coefficients, 0.);
+      std::vector<double> coesin(n_coefficients, 0.);
+
+      std::vector<double> cos_components;
+      std::vector<double> sin_components;
+
+      // do the spherical harmonic expansion by evaluating all spherical
+      // harmonics at once for each spherical infinitesimal and adding its
+      // contribution to all coefficients
+      for (unsigned int ds_num = 0; ds_num < spherical_function.size(); ds_num++)
         {
-          for (unsigned int iord = 0; iord < ideg+1; iord++)
-            {
-              // do the spherical harmonic expansion
-              for (unsigned int ds_num = 0; ds_num < spherical_function.size(); ds_num++)
-                {
-                  // normalization after Dahlen and Tromp, 1986, Appendix B.6
-                  const std::pair<double,double> sph_harm_vals = aspect::Utilities::real_spherical_harmonic(ideg,iord,spherical_function.at(ds_num).at(0),spherical_function.at(ds_num).at(1));
-                  const double cos_component = sph_harm_vals.first; // real / cos part
-                  const double sin_component = sph_harm_vals.second; // imaginary / sine part
+          // normalization after Dahlen and Tromp, 1986, Appendix B.6
+          aspect::Utilities::real_spherical_harmonics(max_degree,
+                                                      spherical_function[ds_num][0],
+                                                      spherical_function[ds_num][1],
+                                                      cos_components,
+                                                      sin_components);
 
-                  cosi.at(ds_num) = (spherical_function.at(ds_num).at(3) * cos_component);
-                  sini.at(ds_num) = (spherical_function.at(ds_num).at(3) * sin_component);
-                }
-              // integrate the contribution of each spherical infinitesimal
-              double cosii = 0;
-              double sinii = 0;
-              for (unsigned int ds_num = 0; ds_num < spherical_function.size(); ds_num++)
-                {
-                  cosii += cosi.at(ds_num) * spherical_function.at(ds_num).at(2);
-                  sinii += sini.at(ds_num) * spherical_function.at(ds_num).at(2);
-                }
-              coecos.push_back(cosii);
-              coesin.push_back(sinii);
+          // the value of the function times the spherical infinitesimal
+          const double weighted_value = spherical_function[ds_num][3] * spherical_function[ds_num][2];
+
+          for (unsigned int i = 0; i < n_coefficients; ++i)
+            {
+              coecos[i] += weighted_value * cos_components[first_index+i];
+              coesin[i] += weighted_value * sin_components[first_index+i];
             }
         }
+
       // sum over each processor
       dealii::Utilities::MPI::sum (coecos,this->get_mpi_communicator(),coecos);
       dealii::Utilities::MPI::sum (coesin,this->get_mpi_communicator(),coesin);
@@ -97,57 +98,67 @@ namespace aspect
       MaterialModel::MaterialModelInputs<dim> in(fe_values.n_quadrature_points, this->n_compositional_fields());
       MaterialModel::MaterialModelOutputs<dim> out(fe_values.n_quadrature_points, this->n_compositional_fields());
 
-      std::vector<std::vector<double> > composition_values (this->n_compositional_fields(),std::vector<double> (quadrature_formula.size()));
+      // the coefficients are stored for all degrees from min_degree to
+      // max_degree and, within each degree, for all orders
+      const unsigned int first_index = min_degree*(min_degree+1)/2;
+      const unsigned int n_coefficients = (max_degree+1)*(max_degree+2)/2 - first_index;
+
+      std::vector<double> SH_density_coecos(n_coefficients, 0.);
+      std::vector<double> SH_density_coesin(n_coefficients, 0.);
+
+      std::vector<double> cos_components;
+      std::vector<double> sin_components;
 
       // Directly do the global 3D integral over each quadrature point of every cell (different from traditional way to do layer integral).
       // This work around ASPECT's adaptive mesh refinement feature.
-      std::vector<double> SH_density_coecos;
-      std::vector<double> SH_density_coesin;
-      for (unsigned int ideg =  min_degree; ideg < max_degree+1; ideg++)
-        {
-          for (unsigned int iord = 0; iord < ideg+1; iord++)
-            {
-              // initialization of the density contribution integral per degree, order.
-              double integrated_density_cos_component = 0;
-              double integrated_density_sin_component = 0;
+      // The material model and the spherical harmonics are evaluated only
+      // once per quadrature point, and the contributions to all degrees and
+      // orders are accumulated in the same sweep over the mesh.
+      typename DoFHandler<dim>::active_cell_iterator
+      cell = this->get_dof_handler().begin_active(),
+      endc = this->get_dof_handler().end();
 
-              // loop over all of the cells
-              typename DoFHandler<dim>::active_cell_iterator
-              cell = this->get_dof_handler().begin_active(),
-              endc = this->get_dof_handler().end();
+      for (; cell!=endc; ++cell)
+        if (cell->is_locally_owned())
+          {
+            fe_values.reinit (cell);
+            // Set use_strain_rates to false since we don't need viscosity
+            in.reinit(fe_values, cell, this->introspection(), this->get_solution(), false);
 
-              for (; cell!=endc; ++cell)
-                if (cell->is_locally_owned())
-                  {
-                    fe_values.reinit (cell);
-                    // Set use_strain_rates to false since we don't need viscosity
-                    in.reinit(fe_values, cell, this->introspection(), this->get_solution(), false);
+            this->get_material_model().evaluate(in, out);
 
-                    this->get_material_model().evaluate(in, out);
+            // Compute the integral of the density function
+            // over the cell, by looping over all quadrature points
+            for (unsigned int q=0; q<quadrature_formula.size(); ++q)
+              {
+                // convert coordinates from [x,y,z] to [r, phi, theta]
+                const std::array<double,dim> scoord = aspect::Utilities::Coordinates::cartesian_to_spherical_coordinates(in.position[q]);
 
-                    // Compute the integral of the density function
-                    // over the cell, by looping over all quadrature points
-                    for (unsigned int q=0; q<quadrature_formula.size(); ++q)
-                      {
-                        // convert coordinates from [x,y,z] to [r, phi, theta]
-                        const std::array<double,dim> scoord = aspect::Utilities::Coordinates::cartesian_to_spherical_coordinates(in.position[q]);
+                // normalization after Dahlen and Tromp, 1986, Appendix B.6
+                aspect::Utilities::real_spherical_harmonics(max_degree, scoord[2], scoord[1],
+                                                            cos_components, sin_components);
 
-                        // normalization after Dahlen and Tromp, 1986, Appendix B.6
-                        const std::pair<double,double> sph_harm_vals = aspect::Utilities::real_spherical_harmonic(ideg,iord,scoord[2],scoord[1]);
-                        const double cos_component = sph_harm_vals.first; // real / cos part
-                        const double sin_component = sph_harm_vals.second; // imaginary / sine part
+                const double density = out.densities[q];
+                const double r_q = in.position[q].norm();
+                const double radius_ratio = r_q/outer_radius;
 
-                        const double density = out.densities[q];
-                        const double r_q = in.position[q].norm();
+                // start with (r_q/outer_radius)^(min_degree+1) and multiply
+                // by the radius ratio for every further degree
+                double weighted_density = density * (1./r_q) * std::pow(radius_ratio,min_degree+1) * fe_values.JxW(q);
 
-                        integrated_density_cos_component += density * (1./r_q) * std::pow(r_q/outer_radius,ideg+1) * cos_component * fe_values.JxW(q);
-                        integrated_density_sin_component += density * (1./r_q) * std::pow(r_q/outer_radius,ideg+1) * sin_component * fe_values.JxW(q);
+                unsigned int ind = 0;
+                for (unsigned int ideg = min_degree; ideg < max_degree+1; ++ideg)
+                  {
+                    for (unsigned int iord = 0; iord < ideg+1; ++iord, ++ind)
+                      {
+                        SH_density_coecos[ind] += weighted_density * cos_components[first_index+ind];
+                        SH_density_coesin[ind] += weighted_density * sin_components[first_index+ind];
                       }
+                    weighted_density *= radius_ratio;
                   }
-              SH_density_coecos.push_back(integrated_density_cos_component);
-              SH_density_coesin.push_back(integrated_density_sin_component);
-            }
-        }
+              }
+          }
+
       // sum over each processor
       dealii::Utilities::MPI::sum (SH_density_coecos,this->get_mpi_communicator(),SH_density_coecos);
       dealii::Utilities::MPI::sum (SH_density_coesin,this->get_mpi_communicator(),SH_density_coesin);
@@ -440,23 +451,22 @@ namespace aspect
 
       // Compute the grid geoid anomaly based on spherical harmonics
       std::vector<double> geoid_anomaly;
+      std::vector<double> cos_components;
+      std::vector<double> sin_components;
+      const unsigned int first_index = min_degree*(min_degree+1)/2;
       for (unsigned int i=0; i<surface_cell_spherical_coordinates.size(); ++i)
         {
-          int ind = 0;
+          // normalization after Dahlen and Tromp, 1986, Appendix B.6
+          aspect::Utilities::real_spherical_harmonics(max_degree,
+                                                      surface_cell_spherical_coordinates[i].first,
+                                                      surface_cell_spherical_coordinates[i].second,
+                                                      cos_components,
+                                                      sin_components);
+
           double geoid_value = 0;
-          for (unsigned int ideg =  min_degree; ideg < max_degree+1; ideg++)
-            {
-              for (unsigned int iord = 0; iord < ideg+1; iord++)
-                {
-                  // normalization after Dahlen and Tromp, 1986, Appendix B.6
-                  const std::pair<double,double> sph_harm_vals = aspect::Utilities::real_spherical_harmonic(ideg,iord,surface_cell_spherical_coordinates.at(i).first,surface_cell_spherical_coordinates.at(i).second);
-                  const double cos_component = sph_harm_vals.first; // real / cos part
-                  const double sin_component = sph_harm_vals.second; // imaginary / sine part
+          for (unsigned int ind = 0; ind < geoid_coecos.size(); ++ind)
+            geoid_value += geoid_coecos[ind]*cos_components[first_index+ind]+geoid_coesin[ind]*sin_components[first_index+ind];
 
-                  geoid_value += geoid_coecos.at(ind)*cos_component+geoid_coesin.at(ind)*sin_component;
-                  ++ind;
-                }
-            }
           geoid_anomaly.push_back(geoid_value);
         }
 
@@ -742,20 +752,23 @@ namespace aspect
 
           for (unsigned int i=0; i<surface_cell_spherical_coordinates.size(); ++i)
             {
-              int ind = 0;
+              // normalization after Dahlen and Tromp, 1986, Appendix B.6
+              aspect::Utilities::real_spherical_harmonics(max_degree,
+                                                          surface_cell_spherical_coordinates[i].first,
+                                                          surface_cell_spherical_coordinates[i].second,
+                                                          cos_components,
+                                                          sin_components);
+
+              unsigned int ind = 0;
               double gravity_value = 0;
               for (unsigned int ideg =  min_degree; ideg < max_degree+1; ++ideg)
                 {
                   for (unsigned int iord = 0; iord < ideg+1; ++iord)
                     {
-                      // normalization after Dahlen and Tromp, 1986, Appendix B.6
-                      const std::pair<double,double> sph_harm_vals = aspect::Utilities::real_spherical_harmonic(ideg,iord,surface_cell_spherical_coordinates.at(i).first,surface_cell_spherical_coordinates.at(i).second);
-                      const double cos_component = sph_harm_vals.first; // real / cos part
-                      const double sin_component = sph_harm_vals.second; // imaginary / sine part
-
                       // the conversion from geoid to gravity anomaly is given by gravity_anomaly = (l-1)*g/R_surface * geoid_anomaly
                       // based on Forte (2007) equation [97]
-                      gravity_value += (geoid_coecos.at(ind)*cos_component+geoid_coesin.at(ind)*sin_component) * (ideg - 1) * surface_gravity / outer_radius;
+                      gravity_value += (geoid_coecos[ind]*cos_components[first_index+ind]
+                                        +geoid_coesin[ind]*sin_components[first_index+ind]) * (ideg - 1) * surface_gravity / outer_radius;
                       ++ind;
                     }
                 }
@@ -867,15 +880,16 @@ namespace aspect
       const double phi = scoord[1];
       double value = 0.;
 
-      for (unsigned int ideg=min_degree, k=0; ideg < max_degree+1; ideg++)
-        for (unsigned int iord = 0; iord < ideg+1; iord++, k++)
-          {
-            std::pair<double,double> val = aspect::Utilities::real_spherical_harmonic( ideg, iord, theta, phi );
+      std::vector<double> cos_components;
+      std::vector<double> sin_components;
+      aspect::Utilities::real_spherical_harmonics(max_degree, theta, phi,
+                                                  cos_components, sin_components);
 
-            value += geoid_coecos[k] * val.first +
-                     geoid_coesin[k] * val.second;
+      const unsigned int first_index = min_degree*(min_degree+1)/2;
+      for (unsigned int k = 0; k < geoid_coecos.size(); ++k)
+        value += geoid_coecos[k] * cos_components[first_index+k] +
+                 geoid_coesin[k] * sin_components[first_index+k];
 
-          }
       return value;
     }
 
@@ -942,6 +956,9 @@ namespace aspect
         {
           max_degree = prm.get_integer ("Maximum degree");
           min_degree = prm.get_integer ("Minimum degree");
+          AssertThrow (min_degree <= max_degree,
+                       ExcMessage("The minimum degree of the geoid postprocessor must not be "
+                                  "larger than its maximum degree."));
           output_in_lat_lon = prm.get_bool ("Output data in geographical coordinates");
           density_above = prm.get_double ("Density above");
           density_below = prm.get_double ("Density below");
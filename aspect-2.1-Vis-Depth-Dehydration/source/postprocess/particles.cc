@@ -25,6 +25,11 @@
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
 #include <stdio.h>
 #include <unistd.h>
 
@@ -144,7 +149,8 @@ namespace aspect
 #if DEAL_II_VERSION_GTE(9,0,0)
       ,output_file_number (numbers::invalid_unsigned_int),
       group_files(0),
-      write_in_background_thread(false)
+      write_in_background_thread(false),
+      binary_series_file_size(0)
 #endif
     {}
 
@@ -317,6 +323,156 @@ namespace aspect
                                                              output_file_names_by_timestep[timestep]));
       DataOutBase::write_visit_record (global_visit_master, times_and_output_file_names);
     }
+
+
+
+    template <int dim>
+    void
+    Particles<dim>::write_binary_series (const double time_in_years_or_seconds)
+    {
+      const MPI_Comm comm = this->get_mpi_communicator();
+      const unsigned int my_rank = Utilities::MPI::this_mpi_process(comm);
+
+      const Particle::ParticleHandler<dim> &particle_handler = world.get_particle_handler();
+      const Particle::Property::ParticlePropertyInformation &property_information
+        = world.get_property_manager().get_data_info();
+
+      // Find the properties that should be written, and describe them for
+      // the index file
+      std::vector<unsigned int> selected_components;
+      std::ostringstream record_description;
+      record_description << "id (1 uint64), position (" << dim << " doubles)";
+      for (unsigned int field_index = 0; field_index < property_information.n_fields(); ++field_index)
+        {
+          const std::string field_name = property_information.get_field_name_by_index(field_index);
+          if (binary_series_properties.size() > 0
+              && std::find(binary_series_properties.begin(), binary_series_properties.end(), field_name)
+              == binary_series_properties.end())
+            continue;
+
+          const unsigned int n_components = property_information.get_components_by_field_index(field_index);
+          const unsigned int field_position = property_information.get_position_by_field_index(field_index);
+          for (unsigned int component_index=0; component_index<n_components; ++component_index)
+            selected_components.push_back(field_position + component_index);
+
+          record_description << ", " << field_name << " (" << n_components
+                             << (n_components == 1 ? " double)" : " doubles)");
+        }
+
+      const std::uint64_t record_size = sizeof(std::uint64_t) + (dim + selected_components.size()) * sizeof(double);
+
+      // Determine where the records of this process start within the
+      // current output step. MPI_Exscan leaves the result on the first
+      // process undefined.
+      const std::uint64_t n_local_particles = particle_handler.n_locally_owned_particles();
+      const std::uint64_t n_global_particles = world.n_global_particles();
+      std::uint64_t first_record = 0;
+      MPI_Exscan (&n_local_particles, &first_record, 1, MPI_UINT64_T, MPI_SUM, comm);
+      if (my_rank == 0)
+        first_record = 0;
+
+      // Every process packs at most this many particles into its buffer
+      // before writing them. Since the writes are collective, all processes
+      // have to take part in the same number of them, even if they have
+      // nothing left to write.
+      const std::uint64_t max_records_per_write = 65536;
+      const unsigned int n_writes
+        = Utilities::MPI::max (static_cast<unsigned int>((n_local_particles + max_records_per_write - 1)
+                                                         / max_records_per_write),
+                               comm);
+
+      const std::string filename = this->get_output_directory() + "particles/particles.bin";
+      MPI_File file;
+      int ierr = MPI_File_open (comm, const_cast<char *>(filename.c_str()),
+                                MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &file);
+      AssertThrow (ierr == MPI_SUCCESS,
+                   ExcMessage ("Could not open the particle output file <" + filename + "> for writing."));
+
+      MPI_Datatype record_type;
+      MPI_Type_contiguous (static_cast<int>(record_size), MPI_BYTE, &record_type);
+      MPI_Type_commit (&record_type);
+
+      std::vector<char> buffer (std::min(n_local_particles, max_records_per_write) * record_size);
+      typename Particle::ParticleHandler<dim>::particle_iterator particle = particle_handler.begin();
+      std::uint64_t n_written_records = 0;
+
+      for (unsigned int write = 0; write < n_writes; ++write)
+        {
+          const std::uint64_t n_records = std::min (max_records_per_write,
+                                                    n_local_particles - n_written_records);
+
+          char *record = buffer.data();
+          const auto pack = [&record](const void *data, const std::size_t size)
+          {
+            std::memcpy (record, data, size);
+            record += size;
+          };
+
+          for (std::uint64_t i = 0; i < n_records; ++i, ++particle)
+            {
+              const std::uint64_t id = particle->get_id();
+              const Point<dim> location = particle->get_location();
+
+              pack (&id, sizeof(id));
+              for (unsigned int d=0; d<dim; ++d)
+                pack (&location[d], sizeof(double));
+
+              if (selected_components.size() > 0)
+                {
+                  const ArrayView<const double> properties = particle->get_properties();
+                  for (unsigned int c=0; c<selected_components.size(); ++c)
+                    pack (&properties[selected_components[c]], sizeof(double));
+                }
+            }
+
+          ierr = MPI_File_write_at_all (file,
+                                        binary_series_file_size + (first_record + n_written_records) * record_size,
+                                        buffer.data(),
+                                        static_cast<int>(n_records),
+                                        record_type,
+                                        MPI_STATUS_IGNORE);
+          AssertThrow (ierr == MPI_SUCCESS,
+                       ExcMessage ("Could not write particles to the particle output file <" + filename + ">."));
+
+          n_written_records += n_records;
+        }
+
+      MPI_Type_free (&record_type);
+
+      // Cut off anything that may be left behind the new output step, for
+      // example output steps written after the checkpoint we resumed from.
+      const std::uint64_t step_offset = binary_series_file_size;
+      binary_series_file_size += n_global_particles * record_size;
+      MPI_File_set_size (file, binary_series_file_size);
+      MPI_File_close (&file);
+
+      std::ostringstream index_entry;
+      index_entry << std::setprecision(16)
+                  << output_file_number << ' '
+                  << time_in_years_or_seconds << ' '
+                  << n_global_particles << ' '
+                  << step_offset;
+      binary_series_index_entries.push_back (index_entry.str());
+
+      // The index is small, so rewrite it completely on the root process
+      if (my_rank == 0)
+        {
+          const std::string index_filename = filename + ".index";
+          std::ofstream index_file (index_filename.c_str());
+          AssertThrow (index_file,
+                       ExcMessage ("Unable to open file for writing: " + index_filename + "."));
+
+          index_file << "# The particles of all output steps, written one output step after\n"
+                     << "# the other into the file particles.bin. Every particle is stored as\n"
+                     << "# one record of " << record_size << " bytes in native byte order, containing:\n"
+                     << "# " << record_description.str() << '\n'
+                     << "# Each of the following lines describes one output step by its\n"
+                     << "# output number, time, number of particles, and the position of its\n"
+                     << "# first record in bytes from the start of the file.\n";
+          for (unsigned int i=0; i<binary_series_index_entries.size(); ++i)
+            index_file << binary_series_index_entries[i] << '\n';
+        }
+    }
 #endif
 
     template <int dim>
@@ -354,12 +510,14 @@ namespace aspect
       else
         ++output_file_number;
 
-      // Create the particle output
+      // Create the particle output. The binary series format does not need
+      // the patches, so do not build them if it is the only output format.
       const bool output_hdf5 = std::find(output_formats.begin(), output_formats.end(),"hdf5") != output_formats.end();
       internal::ParticleOutput<dim> data_out;
-      data_out.build_patches(world.get_particle_handler(),
-                             world.get_property_manager().get_data_info(),
-                             output_hdf5);
+      if (output_formats.size() > 1 || output_formats[0] != "binary series")
+        data_out.build_patches(world.get_particle_handler(),
+                               world.get_property_manager().get_data_info(),
+                               output_hdf5);
 
       // Now prepare everything for writing the output and choose output format
       std::string particle_file_prefix = "particles-" + Utilities::int_to_string (output_file_number, 5);
@@ -378,6 +536,10 @@ namespace aspect
               return std::make_pair("Number of advected particles:",
                                     Utilities::int_to_string(world.n_global_particles()));
             }
+          else if (*output_format == "binary series")
+            {
+              write_binary_series (time_in_years_or_seconds);
+            }
           else if (*output_format=="hdf5")
             {
               const std::string particle_file_name = "particles/" + particle_file_prefix + ".h5";
@@ -569,6 +731,8 @@ namespace aspect
       & times_and_pvtu_file_names
       & output_file_names_by_timestep
       & xdmf_entries
+      & binary_series_file_size
+      & binary_series_index_entries
 #endif
       ;
     }
@@ -629,11 +793,27 @@ namespace aspect
           // in deal.II was implemented. It is nearly identical to the gnuplot format, thus
           // we now simply replace "ascii" by "gnuplot" should it be selected.
           prm.declare_entry ("Data output format", "vtu",
-                             Patterns::MultipleSelection (DataOutBase::get_output_format_names ()+"|ascii"),
+                             Patterns::MultipleSelection (DataOutBase::get_output_format_names ()+"|ascii|binary series"),
                              "A comma separated list of file formats to be used for graphical "
                              "output. The list of possible output formats that can be given "
                              "here is documented in the appendix of the manual where the current "
-                             "parameter is described.");
+                             "parameter is described.\n\n"
+                             "The format `binary series' does not create new files for every "
+                             "output step. Instead, the ids, locations, and properties of all "
+                             "particles are appended to the single file "
+                             "\\texttt{particles/particles.bin} as fixed-size binary records, "
+                             "and the file \\texttt{particles/particles.bin.index} describes the "
+                             "layout of the records and lists the time, number of particles, and "
+                             "position in the file of every output step. This is much more compact "
+                             "than the other formats and can be read with a few lines of code, "
+                             "for example with numpy.memmap.");
+
+          prm.declare_entry ("Binary series output properties", "all",
+                             Patterns::Anything(),
+                             "A comma separated list of the names of the particle properties "
+                             "that are written by the `binary series' output format, or `all' "
+                             "to write all of them. The ids and locations of the particles "
+                             "are always written.");
 
           prm.declare_entry ("Number of grouped files", "16",
                              Patterns::Integer(0),
@@ -716,6 +896,10 @@ namespace aspect
           if (output_format != output_formats.end())
             *output_format = "gnuplot";
 
+          binary_series_properties = Utilities::split_string_list(prm.get("Binary series output properties"));
+          if (binary_series_properties.size() == 1 && binary_series_properties[0] == "all")
+            binary_series_properties.clear();
+
           group_files     = prm.get_integer("Number of grouped files");
           write_in_background_thread = prm.get_bool("Write in background thread");
           temporary_output_location = prm.get("Temporary output location");
@@ -742,6 +926,13 @@ namespace aspect
         sim->initialize_simulator (this->get_simulator());
       world.parse_parameters(prm);
       world.initialize();
+
+#if DEAL_II_VERSION_GTE(9,0,0)
+      for (unsigned int i=0; i<binary_series_properties.size(); ++i)
+        AssertThrow(world.get_property_manager().get_data_info().fieldname_exists(binary_series_properties[i]),
+                    ExcMessage("The particle property <" + binary_series_properties[i] + "> that was selected "
+                               "in the parameter 'Binary series output properties' does not exist."));
+#endif
     }
   }
 }
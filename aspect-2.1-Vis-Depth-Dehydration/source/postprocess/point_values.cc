@@ -25,8 +25,11 @@
 #include <aspect/geometry_model/spherical_shell.h>
 #include <aspect/global.h>
 #include <deal.II/numerics/vector_tools.h>
+#include <deal.II/grid/grid_tools.h>
+#include <deal.II/fe/fe_values.h>
 
 #include <math.h>
+#include <sstream>
 
 namespace aspect
 {
@@ -42,53 +45,106 @@ namespace aspect
       last_output_time (std::numeric_limits<double>::quiet_NaN()),
       evaluation_points_cartesian (std::vector<Point<dim> >() ),
       point_values (std::vector<std::pair<double, std::vector<Vector<double> > > >() ),
-      use_natural_coordinates (false)
+      use_natural_coordinates (false),
+      evaluation_points_outdated (true),
+      n_point_values_written (0)
     {}
 
+
+
     template <int dim>
-    std::pair<std::string,std::string>
-    PointValues<dim>::execute (TableHandler &)
+    PointValues<dim>::~PointValues ()
     {
-      // if this is the first time we get here, set the next output time
-      // to the current time. this makes sure we always produce data during
-      // the first time step
-      if (std::isnan(last_output_time))
-        last_output_time = this->get_time() - output_interval;
+      mesh_change_connection.disconnect();
+    }
 
-      // see if output is requested at this time
-      if (this->get_time() < last_output_time + output_interval)
-        return std::pair<std::string,std::string>();
 
-      // evaluate the solution at all of our evaluation points
-      std::vector<Vector<double> >
-      current_point_values (evaluation_points_cartesian.size(),
-                            Vector<double> (this->introspection().n_components));
 
-      for (unsigned int p=0; p<evaluation_points_cartesian.size(); ++p)
+    template <int dim>
+    void
+    PointValues<dim>::initialize ()
+    {
+      mesh_change_connection = this->get_triangulation().signals.any_change.connect([this]()
+      {
+        this->evaluation_points_outdated = true;
+      });
+    }
+
+
+
+    template <int dim>
+    void
+    PointValues<dim>::locate_evaluation_points ()
+    {
+      const unsigned int n_points = evaluation_points_cartesian.size();
+      const unsigned int my_rank = Utilities::MPI::this_mpi_process(this->get_mpi_communicator());
+
+      std::vector<typename DoFHandler<dim>::active_cell_iterator> cells (n_points);
+      std::vector<Point<dim> > reference_locations (n_points);
+
+      // find a locally owned cell around each point. many evaluation
+      // points (e.g. along a depth profile) are close to each other, so
+      // first try the cell found for the previous point before searching
+      // the whole mesh
+      std::vector<unsigned int> owner (n_points, numbers::invalid_unsigned_int);
+      typename DoFHandler<dim>::active_cell_iterator previous_cell;
+      for (unsigned int p=0; p<n_points; ++p)
         {
-          // try to evaluate the solution at this point. in parallel, the point
-          // will be on only one processor's owned cells, so the others are
-          // going to throw an exception. make sure at least one processor
-          // finds the given point
           bool point_found = false;
 
-          try
+          if (previous_cell.state() == IteratorState::valid)
             {
-              VectorTools::point_value(this->get_mapping(),
-                                       this->get_dof_handler(),
-                                       this->get_solution(),
-                                       evaluation_points_cartesian[p],
-                                       current_point_values[p]);
-              point_found = true;
+              try
+                {
+                  const Point<dim> p_unit
+                    = this->get_mapping().transform_real_to_unit_cell(previous_cell,
+                                                                      evaluation_points_cartesian[p]);
+                  if (GeometryInfo<dim>::is_inside_unit_cell(p_unit))
+                    {
+                      cells[p] = previous_cell;
+                      reference_locations[p] = p_unit;
+                      point_found = true;
+                    }
+                }
+              catch (const typename Mapping<dim>::ExcTransformationFailed &)
+                {}
             }
-          catch (const VectorTools::ExcPointNotAvailableHere &)
+
+          if (!point_found)
             {
-              // ignore
+              try
+                {
+                  const std::pair<typename DoFHandler<dim>::active_cell_iterator, Point<dim> >
+                  cell_and_position
+                    = GridTools::find_active_cell_around_point (this->get_mapping(),
+                                                                this->get_dof_handler(),
+                                                                evaluation_points_cartesian[p]);
+                  cells[p] = cell_and_position.first;
+                  reference_locations[p] = GeometryInfo<dim>::project_to_unit_cell(cell_and_position.second);
+                  point_found = true;
+                }
+              catch (const GridTools::ExcPointNotFound<dim> &)
+                {}
             }
 
-          // ensure that at least one processor found things
-          const int n_procs = Utilities::MPI::sum (point_found ? 1 : 0, this->get_mpi_communicator());
-          AssertThrow (n_procs > 0,
+          if (point_found && cells[p]->is_locally_owned())
+            {
+              owner[p] = my_rank;
+              previous_cell = cells[p];
+            }
+        }
+
+      // a point that lies on the boundary between cells of different
+      // processes may have been found by several of them; the one with
+      // the lowest rank evaluates it
+      std::vector<unsigned int> global_owner (n_points);
+      MPI_Allreduce (owner.data(), global_owner.data(), n_points,
+                     MPI_UNSIGNED, MPI_MIN, this->get_mpi_communicator());
+
+      local_point_indices.clear();
+      for (unsigned int p=0; p<n_points; ++p)
+        {
+          AssertThrow (global_owner[p] != numbers::invalid_unsigned_int,
                        ExcMessage ("While trying to evaluate the solution at point " +
                                    Utilities::to_string(evaluation_points_cartesian[p][0]) + ", " +
                                    Utilities::to_string(evaluation_points_cartesian[p][1]) +
@@ -102,73 +158,174 @@ namespace aspect
                                    "solution at a point that lies outside of the domain?"
                                   ));
 
-          // Reduce all collected values into local Vector
-          Utilities::MPI::sum (current_point_values[p], this->get_mpi_communicator(),
-                               current_point_values[p]);
+          if (global_owner[p] == my_rank)
+            local_point_indices.push_back (p);
+        }
+
+      // sort the local points by their cells, so that all points in one
+      // cell can be evaluated together
+      std::stable_sort (local_point_indices.begin(), local_point_indices.end(),
+                        [&](const unsigned int a, const unsigned int b) -> bool
+      {
+        return cells[a] < cells[b];
+      });
+
+      local_point_cells.resize (local_point_indices.size());
+      local_point_reference_locations.resize (local_point_indices.size());
+      for (unsigned int i=0; i<local_point_indices.size(); ++i)
+        {
+          local_point_cells[i] = cells[local_point_indices[i]];
+          local_point_reference_locations[i] = reference_locations[local_point_indices[i]];
+        }
+
+      evaluation_points_outdated = false;
+    }
+
+    template <int dim>
+    std::pair<std::string,std::string>
+    PointValues<dim>::execute (TableHandler &)
+    {
+      // if this is the first time we get here, set the next output time
+      // to the current time. this makes sure we always produce data during
+      // the first time step
+      if (std::isnan(last_output_time))
+        last_output_time = this->get_time() - output_interval;
+
+      // see if output is requested at this time
+      if (this->get_time() < last_output_time + output_interval)
+        return std::pair<std::string,std::string>();
 
-          // Normalize in cases where points are claimed by multiple processors
-          if (n_procs > 1)
-            current_point_values[p] /= n_procs;
+      // find the cells around the evaluation points, if this has not
+      // happened yet on the current mesh. with a free surface, the mesh
+      // moves through the mapping without the triangulation signaling a
+      // change, so the points may be in other cells or at other reference
+      // locations at every output
+      if (evaluation_points_outdated || this->get_parameters().free_surface_enabled)
+        locate_evaluation_points ();
+
+      // evaluate the solution at all of the evaluation points owned by this
+      // process. we do this cell by cell, evaluating all points in a cell
+      // at once by using their reference locations as quadrature points
+      const unsigned int n_components = this->introspection().n_components;
+      std::vector<double> local_values (evaluation_points_cartesian.size() * n_components, 0.);
+
+      for (unsigned int first=0; first<local_point_indices.size(); )
+        {
+          unsigned int last = first+1;
+          while (last < local_point_indices.size()
+                 && local_point_cells[last] == local_point_cells[first])
+            ++last;
+
+          const Quadrature<dim> quadrature (std::vector<Point<dim> > (local_point_reference_locations.begin() + first,
+                                                                      local_point_reference_locations.begin() + last));
+          FEValues<dim> fe_values (this->get_mapping(),
+                                   this->get_fe(),
+                                   quadrature,
+                                   update_values);
+          fe_values.reinit (local_point_cells[first]);
+
+          std::vector<Vector<double> > cell_values (last-first, Vector<double> (n_components));
+          fe_values.get_function_values (this->get_solution(), cell_values);
+
+          for (unsigned int i=first; i<last; ++i)
+            for (unsigned int c=0; c<n_components; ++c)
+              local_values[local_point_indices[i]*n_components + c] = cell_values[i-first][c];
+
+          first = last;
         }
 
+      // every point is evaluated on exactly one process, so a single sum
+      // over all processes collects all values everywhere
+      std::vector<double> global_values (local_values.size());
+      Utilities::MPI::sum (local_values, this->get_mpi_communicator(), global_values);
+
+      std::vector<Vector<double> >
+      current_point_values (evaluation_points_cartesian.size(),
+                            Vector<double> (n_components));
+      for (unsigned int p=0; p<evaluation_points_cartesian.size(); ++p)
+        for (unsigned int c=0; c<n_components; ++c)
+          current_point_values[p][c] = global_values[p*n_components + c];
+
       // finally push these point values all onto the list we keep
       point_values.push_back (std::make_pair (this->get_time(),
                                               current_point_values));
 
-      // now write all of the data to the file of choice. start with a pre-amble that
-      // explains the meaning of the various fields
+      // now write the data to the file of choice. if the file already
+      // contains all previous time points and we are allowed to append to
+      // it, only write the new one. otherwise write everything, starting
+      // with a pre-amble that explains the meaning of the various fields.
+      // the file is only written by the root process
       const std::string filename = (this->get_output_directory() +
                                     "point_values.txt");
-      std::ofstream f (filename.c_str());
-      f << ("# <time> "
-            "<evaluation_point_x> "
-            "<evaluation_point_y> ")
-        << (dim == 3 ? "<evaluation_point_z> " : "")
-        << ("<velocity_x> "
-            "<velocity_y> ")
-        << (dim == 3 ? "<velocity_z> " : "")
-        << "<pressure> <temperature>";
-      for (unsigned int c=0; c<this->n_compositional_fields(); ++c)
-        f << " <" << this->introspection().name_for_compositional_index(c) << ">";
-      f << '\n';
-
-      for (std::vector<std::pair<double, std::vector<Vector<double> > > >::iterator
-           time_point = point_values.begin();
-           time_point != point_values.end();
-           ++time_point)
+      if (Utilities::MPI::this_mpi_process(this->get_mpi_communicator()) == 0)
         {
-          Assert (time_point->second.size() == evaluation_points_cartesian.size(),
-                  ExcInternalError());
-          for (unsigned int i=0; i<evaluation_points_cartesian.size(); ++i)
+          const bool append = (this->get_parameters().append_to_output_files
+                               && n_point_values_written > 0
+                               && n_point_values_written == point_values.size()-1);
+
+          // collect the output in a string first, so that appended data
+          // is written to the file in one piece
+          std::ostringstream output;
+          if (!append)
             {
-              f << /* time = */ time_point->first / (this->convert_output_to_years() ? year_in_seconds : 1.)
-                << ' '
-                << /* location = */ evaluation_points_cartesian[i] << ' ';
+              output << ("# <time> "
+                         "<evaluation_point_x> "
+                         "<evaluation_point_y> ")
+                     << (dim == 3 ? "<evaluation_point_z> " : "")
+                     << ("<velocity_x> "
+                         "<velocity_y> ")
+                     << (dim == 3 ? "<velocity_z> " : "")
+                     << "<pressure> <temperature>";
+              for (unsigned int c=0; c<this->n_compositional_fields(); ++c)
+                output << " <" << this->introspection().name_for_compositional_index(c) << ">";
+              output << '\n';
+            }
 
-              for (unsigned int c=0; c<time_point->second[i].size(); ++c)
+          for (std::vector<std::pair<double, std::vector<Vector<double> > > >::iterator
+               time_point = point_values.begin() + (append ? n_point_values_written : 0);
+               time_point != point_values.end();
+               ++time_point)
+            {
+              Assert (time_point->second.size() == evaluation_points_cartesian.size(),
+                      ExcInternalError());
+              for (unsigned int i=0; i<evaluation_points_cartesian.size(); ++i)
                 {
-                  // output a data element. internally, we store all point
-                  // values in the same format in which they were computed,
-                  // but we convert velocities to meters per year if so
-                  // requested
-                  if ((this->introspection().component_masks.velocities[c] == false)
-                      ||
-                      (this->convert_output_to_years() == false))
-                    f << time_point->second[i][c];
-                  else
-                    f << time_point->second[i][c] * year_in_seconds;
-
-                  f << (c != time_point->second[i].size()-1 ? ' ' : '\n');
+                  output << /* time = */ time_point->first / (this->convert_output_to_years() ? year_in_seconds : 1.)
+                         << ' '
+                         << /* location = */ evaluation_points_cartesian[i] << ' ';
+
+                  for (unsigned int c=0; c<time_point->second[i].size(); ++c)
+                    {
+                      // output a data element. internally, we store all point
+                      // values in the same format in which they were computed,
+                      // but we convert velocities to meters per year if so
+                      // requested
+                      if ((this->introspection().component_masks.velocities[c] == false)
+                          ||
+                          (this->convert_output_to_years() == false))
+                        output << time_point->second[i][c];
+                      else
+                        output << time_point->second[i][c] * year_in_seconds;
+
+                      output << (c != time_point->second[i].size()-1 ? ' ' : '\n');
+                    }
                 }
+
+              // have an empty line between time steps
+              output << '\n';
             }
 
-          // have an empty line between time steps
-          f << '\n';
-        }
+          std::ofstream f (filename.c_str(),
+                           append ? std::ios::app : std::ios::out);
+          f << output.str();
+          f.flush();
 
-      AssertThrow (f, ExcMessage("Writing data to <" + filename +
-                                 "> did not succeed in the `point values' "
-                                 "postprocessor."));
+          AssertThrow (f, ExcMessage("Writing data to <" + filename +
+                                     "> did not succeed in the `point values' "
+                                     "postprocessor."));
+
+          n_point_values_written = point_values.size();
+        }
 
       // Update time
       set_last_output_time (this->get_time());
@@ -361,9 +518,12 @@ namespace aspect
                                   "to meters/year, instead of meters/second."
                                   "\n\n"
                                   "\\note{Evaluating the solution of a finite element field at "
-                                  "arbitrarily chosen points is an expensive process. Using this "
-                                  "postprocessor will only be efficient if the number of evaluation "
-                                  "points or output times is relatively small. If you need a very large number of "
+                                  "arbitrarily chosen points is an expensive process. This "
+                                  "postprocessor finds the cells around the evaluation points only "
+                                  "once after every change of the mesh and then evaluates all "
+                                  "points in one pass, but writing the output file still becomes "
+                                  "expensive if the number of evaluation points and output times "
+                                  "is very large. If you need a very large number of "
                                   "evaluation points, you should consider extracting this "
                                   "information from the visualization program you use to display "
                                   "the output of the `visualization' postprocessor.}")
@@ -31,6 +31,7 @@
 #include <boost/archive/text_oarchive.hpp>
 #include <boost/archive/text_iarchive.hpp>
 
+#include <limits>
 #include <math.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -209,6 +210,90 @@ namespace aspect
     }
 
 
+    namespace
+    {
+      /**
+       * Collect the vtu files that each process in @p comm has written into
+       * @p local_file on the first process of @p comm, and merge them into
+       * one file that contains the pieces of all processes in the order of
+       * their ranks. This is the file write_vtu_in_parallel() would write,
+       * but it is assembled in memory, so that it can be written in a
+       * background thread. Return the merged file on the first process and
+       * a null pointer on all others. The caller takes over ownership of
+       * the returned object.
+       */
+      std::string *
+      merge_vtu_files (const std::string &local_file,
+                       const MPI_Comm comm)
+      {
+        const unsigned int my_rank = Utilities::MPI::this_mpi_process(comm);
+        const unsigned int n_ranks = Utilities::MPI::n_mpi_processes(comm);
+
+        // The header (including the time and cycle) and the footer are
+        // taken from the file of the first process, so all other processes
+        // only need to send the <Piece> element with their part of the mesh.
+        const std::string piece_end_tag = "</Piece>";
+        const std::size_t pieces_begin = local_file.find("<Piece");
+        const std::size_t pieces_end = local_file.rfind(piece_end_tag);
+        AssertThrow (pieces_begin != std::string::npos && pieces_end != std::string::npos,
+                     ExcMessage ("The visualization output is not in the vtu format."));
+
+        const std::size_t end_of_local_pieces = pieces_end + piece_end_tag.size();
+        std::string piece;
+        if (my_rank != 0)
+          piece = local_file.substr(pieces_begin, end_of_local_pieces - pieces_begin);
+
+        // The size checks below are collective, so that all processes of the
+        // group throw rather than wait for the ones that did.
+        const int piece_too_large = Utilities::MPI::max (piece.size() > static_cast<std::size_t>(std::numeric_limits<int>::max())
+                                                         ? 1 : 0,
+                                                         comm);
+        AssertThrow (piece_too_large == 0,
+                     ExcMessage ("The visualization output of one process is too large to be sent to "
+                                 "the process writing the file. Please increase 'Number of grouped files'."));
+        int piece_size = static_cast<int>(piece.size());
+
+        std::vector<int> piece_sizes (my_rank == 0 ? n_ranks : 0);
+        MPI_Gather (&piece_size, 1, MPI_INT, piece_sizes.data(), 1, MPI_INT, 0, comm);
+
+        std::vector<int> piece_offsets (my_rank == 0 ? n_ranks : 0);
+        std::size_t total_size = 0;
+        for (unsigned int i=0; i<piece_sizes.size(); ++i)
+          {
+            piece_offsets[i] = static_cast<int>(total_size);
+            total_size += piece_sizes[i];
+          }
+        const int total_too_large = Utilities::MPI::max (total_size > static_cast<std::size_t>(std::numeric_limits<int>::max())
+                                                         ? 1 : 0,
+                                                         comm);
+        AssertThrow (total_too_large == 0,
+                     ExcMessage ("The visualization output of one group of processes is too large to "
+                                 "be collected on one process. Please increase 'Number of grouped files'."));
+
+        std::vector<char> received_pieces (total_size);
+        MPI_Gatherv (const_cast<char *>(piece.data()), piece_size, MPI_CHAR,
+                     received_pieces.data(), piece_sizes.data(), piece_offsets.data(), MPI_CHAR,
+                     0, comm);
+
+        if (my_rank != 0)
+          return nullptr;
+
+        std::string *merged_file = new std::string;
+        merged_file->reserve (local_file.size() + total_size + n_ranks);
+        merged_file->append (local_file, 0, end_of_local_pieces);
+        for (unsigned int i=1; i<n_ranks; ++i)
+          {
+            merged_file->push_back ('\n');
+            merged_file->append (received_pieces.data() + piece_offsets[i], piece_sizes[i]);
+          }
+        merged_file->append (local_file, end_of_local_pieces, std::string::npos);
+
+        return merged_file;
+      }
+    }
+
+
+
     template <int dim>
     Visualization<dim>::Visualization ()
       :
@@ -573,6 +658,8 @@ namespace aspect
           vtk_flags.cycle = this->get_timestep_number();
           vtk_flags.time = time_in_years_or_seconds;
 
+          vtk_flags.compression_level = compression_level;
+
 #if DEAL_II_VERSION_GTE(9,1,0)
           vtk_flags.write_higher_order_cells = write_higher_order_output;
 #endif
@@ -609,6 +696,37 @@ namespace aspect
               else
                 writer(filename,temporary_output_location,file_contents);
             }
+          // Write as many output files as 'group_files' groups, where the first
+          // process of each group collects the file from the other processes
+          // of its group and writes it in the background. A single file is
+          // always written with MPI I/O below, because it can be too large
+          // to be held by one process.
+          else if (write_in_background_thread && (group_files > 1))
+            {
+              const int color = my_id % group_files;
+
+              MPI_Comm comm;
+              MPI_Comm_split(this->get_mpi_communicator(), color, my_id, &comm);
+
+              std::ostringstream tmp;
+              data_out.write (tmp, DataOutBase::parse_output_format(output_format));
+              const std::string *file_contents = merge_vtu_files (tmp.str(), comm);
+
+              MPI_Comm_free(&comm);
+
+              if (file_contents != nullptr)
+                {
+                  // Wait for all previous write operations to finish, should
+                  // any be still active,
+                  background_thread.join ();
+
+                  // then continue with writing our own data.
+                  background_thread = Threads::new_thread (&writer,
+                                                           filename,
+                                                           temporary_output_location,
+                                                           file_contents);
+                }
+            }
           // Just write one data file in parallel
           else if (group_files == 1)
             {
@@ -794,7 +912,18 @@ namespace aspect
                              "File operations can potentially take a long time, blocking the "
                              "progress of the rest of the model run. Setting this variable to "
                              "`true' moves this process into a background thread, while the "
-                             "rest of the model continues.");
+                             "rest of the model continues. If vtu output is grouped into more "
+                             "than one, but fewer files than there are processes, the processes "
+                             "of each group send their part of the file to the first process of "
+                             "the group, which writes the whole file in its background thread, "
+                             "rather than writing the file together with MPI I/O. A single "
+                             "grouped file is always written with MPI I/O.");
+
+          prm.declare_entry ("Compression level", "best compression",
+                             Patterns::Selection ("best compression|best speed|default|none"),
+                             "The zlib compression level of the data in vtu files. `best speed' "
+                             "produces somewhat larger files than `best compression', but "
+                             "compresses the data several times faster.");
 
           prm.declare_entry ("Temporary output location", "",
                              Patterns::Anything(),
@@ -976,6 +1105,17 @@ namespace aspect
                                      "after writing. The system() command did not succeed in finding such a terminal."));
             }
 
+          if (prm.get("Compression level") == "best compression")
+            compression_level = DataOutBase::VtkFlags::best_compression;
+          else if (prm.get("Compression level") == "best speed")
+            compression_level = DataOutBase::VtkFlags::best_speed;
+          else if (prm.get("Compression level") == "default")
+            compression_level = DataOutBase::VtkFlags::default_compression;
+          else if (prm.get("Compression level") == "none")
+            compression_level = DataOutBase::VtkFlags::no_compression;
+          else
+            AssertThrow (false, ExcNotImplemented());
+
           interpolate_output = prm.get_bool("Interpolate output");
           filter_output = prm.get_bool("Filter output");
           write_higher_order_output = prm.get_bool("Write higher order output");
@@ -62,7 +62,7 @@ namespace aspect
                                                          this->n_compositional_fields());
 
             // Compute the melt fraction...
-            this->get_material_model().evaluate(in, out);
+            this->evaluate_material_model(in, out);
 
             std::vector<double> melt_fractions(n_quadrature_points);
             melt_material_model->melt_fractions(in, melt_fractions);
@@ -126,7 +126,7 @@ namespace aspect
                                                      this->n_compositional_fields());
 
         this->get_material_model().create_additional_named_outputs(out);
-        this->get_material_model().evaluate(in, out);
+        this->evaluate_material_model(in, out);
 
         unsigned int field_index = 0;
         for (unsigned int k=0; k<out.additional_outputs.size(); ++k)
@@ -83,7 +83,7 @@ namespace aspect
 
                     out.additional_outputs.push_back(
                       std::make_shared<MaterialModel::SeismicAdditionalOutputs<dim>> (n_q_points));
-                    this->get_material_model().evaluate(in, out);
+                    this->evaluate_material_model(in, out);
 
 
 
@@ -94,7 +94,7 @@ namespace aspect
 
                     adiabatic_out.additional_outputs.push_back(
                       std::make_shared<MaterialModel::SeismicAdditionalOutputs<dim>> (n_q_points));
-                    this->get_material_model().evaluate(in, adiabatic_out);
+                    this->evaluate_material_model(in, adiabatic_out);
 
 
 
@@ -170,7 +170,7 @@ namespace aspect
 
                     out.additional_outputs.push_back(
                       std::make_shared<MaterialModel::SeismicAdditionalOutputs<dim>> (n_q_points));
-                    this->get_material_model().evaluate(in, out);
+                    this->evaluate_material_model(in, out);
 
                     MaterialModel::SeismicAdditionalOutputs<dim> *seismic_outputs
                       = out.template get_additional_output<MaterialModel::SeismicAdditionalOutputs<dim> >();
@@ -250,7 +250,7 @@ namespace aspect
 
                     out.additional_outputs.push_back(
                       std::make_shared<MaterialModel::SeismicAdditionalOutputs<dim>>(n_q_points));
-                    this->get_material_model().evaluate(in, out);
+                    this->evaluate_material_model(in, out);
 
                     // Substitute the adiabatic reference state for temperature and pressure,
                     // then reevaluate the material model.
@@ -259,7 +259,7 @@ namespace aspect
 
                     adiabatic_out.additional_outputs.push_back(
                       std::make_shared<MaterialModel::SeismicAdditionalOutputs<dim>> (n_q_points));
-                    this->get_material_model().evaluate(in, adiabatic_out);
+                    this->evaluate_material_model(in, adiabatic_out);
 
 
 
@@ -336,7 +336,7 @@ namespace aspect
 
                     out.additional_outputs.push_back(
                       std::make_shared<MaterialModel::SeismicAdditionalOutputs<dim>> (n_q_points));
-                    this->get_material_model().evaluate(in, out);
+                    this->evaluate_material_model(in, out);
 
                     MaterialModel::SeismicAdditionalOutputs<dim> *seismic_outputs
                       = out.template get_additional_output<MaterialModel::SeismicAdditionalOutputs<dim> >();
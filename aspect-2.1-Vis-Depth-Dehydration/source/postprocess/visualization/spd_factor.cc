@@ -61,7 +61,7 @@ namespace aspect
         out.additional_outputs.push_back(
           std::make_shared<MaterialModel::MaterialModelDerivatives<dim>> (n_quadrature_points));
 
-        this->get_material_model().evaluate(in, out);
+        this->evaluate_material_model(in, out);
 
         const MaterialModel::MaterialModelDerivatives<dim> *derivatives = out.template get_additional_output<MaterialModel::MaterialModelDerivatives<dim> >();
 
@@ -57,7 +57,7 @@ namespace aspect
         MaterialModel::MaterialModelOutputs<dim> out(n_quadrature_points,
                                                      this->n_compositional_fields());
 
-        this->get_material_model().evaluate(in, out);
+        this->evaluate_material_model(in, out);
 
         for (unsigned int q=0; q<n_quadrature_points; ++q)
 
@@ -55,8 +55,8 @@ namespace aspect
     AdvectionSystem<dim>::execute (internal::Assembly::Scratch::ScratchBase<dim>   &scratch_base,
                                    internal::Assembly::CopyData::CopyDataBase<dim> &data_base) const
     {
-      internal::Assembly::Scratch::AdvectionSystem<dim> &scratch = dynamic_cast<internal::Assembly::Scratch::AdvectionSystem<dim>& > (scratch_base);
-      internal::Assembly::CopyData::AdvectionSystem<dim> &data = dynamic_cast<internal::Assembly::CopyData::AdvectionSystem<dim>& > (data_base);
+      internal::Assembly::Scratch::AdvectionSystem<dim> &scratch = internal::Assembly::checked_cast<internal::Assembly::Scratch::AdvectionSystem<dim>> (scratch_base);
+      internal::Assembly::CopyData::AdvectionSystem<dim> &data = internal::Assembly::checked_cast<internal::Assembly::CopyData::AdvectionSystem<dim>> (data_base);
 
       const Introspection<dim> &introspection = this->introspection();
       const FiniteElement<dim> &fe = this->get_fe();
@@ -87,15 +87,11 @@ namespace aspect
           // We only need to look up values of shape functions if they
           // belong to 'our' component. They are zero otherwise anyway.
           // Note that we later only look at the values that we do set here.
-          for (unsigned int i=0, i_advection=0; i_advection<advection_dofs_per_cell;/*increment at end of loop*/)
+          for (unsigned int i_advection=0; i_advection<advection_dofs_per_cell; ++i_advection)
             {
-              if (fe.system_to_component_index(i).first == solution_component)
-                {
-                  scratch.grad_phi_field[i_advection] = scratch.finite_element_values[solution_field].gradient (i,q);
-                  scratch.phi_field[i_advection]      = scratch.finite_element_values[solution_field].value (i,q);
-                  ++i_advection;
-                }
-              ++i;
+              const unsigned int i = fe.component_to_system_index(solution_component, i_advection);
+              scratch.grad_phi_field[i_advection] = scratch.finite_element_values[solution_field].gradient (i,q);
+              scratch.phi_field[i_advection]      = scratch.finite_element_values[solution_field].value (i,q);
             }
 
           const double density_c_P              =
@@ -208,7 +204,7 @@ namespace aspect
     std::vector<double>
     AdvectionSystem<dim>::compute_residual(internal::Assembly::Scratch::ScratchBase<dim> &scratch_base) const
     {
-      internal::Assembly::Scratch::AdvectionSystem<dim> &scratch = dynamic_cast<internal::Assembly::Scratch::AdvectionSystem<dim>& > (scratch_base);
+      internal::Assembly::Scratch::AdvectionSystem<dim> &scratch = internal::Assembly::checked_cast<internal::Assembly::Scratch::AdvectionSystem<dim>> (scratch_base);
 
       const typename Simulator<dim>::AdvectionField advection_field = *scratch.advection_field;
       const unsigned int n_q_points = scratch.finite_element_values.n_quadrature_points;
@@ -264,8 +260,8 @@ namespace aspect
     DiffusionSystem<dim>::execute (internal::Assembly::Scratch::ScratchBase<dim>   &scratch_base,
                                    internal::Assembly::CopyData::CopyDataBase<dim> &data_base) const
     {
-      internal::Assembly::Scratch::AdvectionSystem<dim> &scratch = dynamic_cast<internal::Assembly::Scratch::AdvectionSystem<dim>& > (scratch_base);
-      internal::Assembly::CopyData::AdvectionSystem<dim> &data = dynamic_cast<internal::Assembly::CopyData::AdvectionSystem<dim>& > (data_base);
+      internal::Assembly::Scratch::AdvectionSystem<dim> &scratch = internal::Assembly::checked_cast<internal::Assembly::Scratch::AdvectionSystem<dim>> (scratch_base);
+      internal::Assembly::CopyData::AdvectionSystem<dim> &data = internal::Assembly::checked_cast<internal::Assembly::CopyData::AdvectionSystem<dim>> (data_base);
 
       const Parameters<dim> &parameters = this->get_parameters();
       const Introspection<dim> &introspection = this->introspection();
@@ -289,15 +285,11 @@ namespace aspect
           // We only need to look up values of shape functions if they
           // belong to 'our' component. They are zero otherwise anyway.
           // Note that we later only look at the values that we do set here.
-          for (unsigned int i=0, i_advection=0; i_advection<advection_dofs_per_cell;/*increment at end of loop*/)
+          for (unsigned int i_advection=0; i_advection<advection_dofs_per_cell; ++i_advection)
             {
-              if (fe.system_to_component_index(i).first == solution_component)
-                {
-                  scratch.grad_phi_field[i_advection] = scratch.finite_element_values[solution_field].gradient (i,q);
-                  scratch.phi_field[i_advection]      = scratch.finite_element_values[solution_field].value (i,q);
-                  ++i_advection;
-                }
-              ++i;
+              const unsigned int i = fe.component_to_system_index(solution_component, i_advection);
+              scratch.grad_phi_field[i_advection] = scratch.finite_element_values[solution_field].gradient (i,q);
+              scratch.phi_field[i_advection]      = scratch.finite_element_values[solution_field].value (i,q);
             }
 
           const double JxW = scratch.finite_element_values.JxW(q);
@@ -330,7 +322,7 @@ namespace aspect
     std::vector<double>
     DiffusionSystem<dim>::compute_residual(internal::Assembly::Scratch::ScratchBase<dim> &scratch_base) const
     {
-      internal::Assembly::Scratch::AdvectionSystem<dim> &scratch = dynamic_cast<internal::Assembly::Scratch::AdvectionSystem<dim>& > (scratch_base);
+      internal::Assembly::Scratch::AdvectionSystem<dim> &scratch = internal::Assembly::checked_cast<internal::Assembly::Scratch::AdvectionSystem<dim>> (scratch_base);
       std::vector<double> residuals(scratch.finite_element_values.n_quadrature_points, 0.0);
 
       return residuals;
@@ -343,8 +335,8 @@ namespace aspect
     AdvectionSystemBoundaryHeatFlux<dim>::execute(internal::Assembly::Scratch::ScratchBase<dim>   &scratch_base,
                                                   internal::Assembly::CopyData::CopyDataBase<dim> &data_base) const
     {
-      internal::Assembly::Scratch::AdvectionSystem<dim> &scratch = dynamic_cast<internal::Assembly::Scratch::AdvectionSystem<dim>& > (scratch_base);
-      internal::Assembly::CopyData::AdvectionSystem<dim> &data = dynamic_cast<internal::Assembly::CopyData::AdvectionSystem<dim>& > (data_base);
+      internal::Assembly::Scratch::AdvectionSystem<dim> &scratch = internal::Assembly::checked_cast<internal::Assembly::Scratch::AdvectionSystem<dim>> (scratch_base);
+      internal::Assembly::CopyData::AdvectionSystem<dim> &data = internal::Assembly::checked_cast<internal::Assembly::CopyData::AdvectionSystem<dim>> (data_base);
 
       const Introspection<dim> &introspection = this->introspection();
       const FiniteElement<dim> &fe = this->get_fe();
@@ -394,14 +386,10 @@ namespace aspect
               // We only need to look up values of shape functions if they
               // belong to 'our' component. They are zero otherwise anyway.
               // Note that we later only look at the values that we do set here.
-              for (unsigned int i=0, i_advection=0; i_advection<advection_dofs_per_cell; /*increment at end of loop*/)
+              for (unsigned int i_advection=0; i_advection<advection_dofs_per_cell; ++i_advection)
                 {
-                  if (fe.system_to_component_index(i).first == solution_component)
-                    {
-                      scratch.face_phi_field[i_advection]      = (*scratch.face_finite_element_values)[solution_field].value (i, q);
-                      ++i_advection;
-                    }
-                  ++i;
+                  const unsigned int i = fe.component_to_system_index(solution_component, i_advection);
+                  scratch.face_phi_field[i_advection]      = (*scratch.face_finite_element_values)[solution_field].value (i, q);
                 }
 
               for (unsigned int i=0; i<advection_dofs_per_cell; ++i)
@@ -423,8 +411,8 @@ namespace aspect
     AdvectionSystemBoundaryFace<dim>::execute(internal::Assembly::Scratch::ScratchBase<dim>   &scratch_base,
                                               internal::Assembly::CopyData::CopyDataBase<dim> &data_base) const
     {
-      internal::Assembly::Scratch::AdvectionSystem<dim> &scratch = dynamic_cast<internal::Assembly::Scratch::AdvectionSystem<dim>& > (scratch_base);
-      internal::Assembly::CopyData::AdvectionSystem<dim> &data = dynamic_cast<internal::Assembly::CopyData::AdvectionSystem<dim>& > (data_base);
+      internal::Assembly::Scratch::AdvectionSystem<dim> &scratch = internal::Assembly::checked_cast<internal::Assembly::Scratch::AdvectionSystem<dim>> (scratch_base);
+      internal::Assembly::CopyData::AdvectionSystem<dim> &data = internal::Assembly::checked_cast<internal::Assembly::CopyData::AdvectionSystem<dim>> (data_base);
 
       const Parameters<dim> &parameters = this->get_parameters();
       const Introspection<dim> &introspection = this->introspection();
@@ -482,15 +470,11 @@ namespace aspect
               // We only need to look up values of shape functions if they
               // belong to 'our' component. They are zero otherwise anyway.
               // Note that we later only look at the values that we do set here.
-              for (unsigned int i=0, i_advection=0; i_advection<advection_dofs_per_cell; /*increment at end of loop*/)
+              for (unsigned int i_advection=0; i_advection<advection_dofs_per_cell; ++i_advection)
                 {
-                  if (fe.system_to_component_index(i).first == solution_component)
-                    {
-                      scratch.face_grad_phi_field[i_advection] = (*scratch.face_finite_element_values)[solution_field].gradient (i, q);
-                      scratch.face_phi_field[i_advection]      = (*scratch.face_finite_element_values)[solution_field].value (i, q);
-                      ++i_advection;
-                    }
-                  ++i;
+                  const unsigned int i = fe.component_to_system_index(solution_component, i_advection);
+                  scratch.face_grad_phi_field[i_advection] = (*scratch.face_finite_element_values)[solution_field].gradient (i, q);
+                  scratch.face_phi_field[i_advection]      = (*scratch.face_finite_element_values)[solution_field].value (i, q);
                 }
 
               const double density_c_P              =
@@ -634,8 +618,8 @@ namespace aspect
     AdvectionSystemInteriorFace<dim>::execute(internal::Assembly::Scratch::ScratchBase<dim>   &scratch_base,
                                               internal::Assembly::CopyData::CopyDataBase<dim> &data_base) const
     {
-      internal::Assembly::Scratch::AdvectionSystem<dim> &scratch = dynamic_cast<internal::Assembly::Scratch::AdvectionSystem<dim>& > (scratch_base);
-      internal::Assembly::CopyData::AdvectionSystem<dim> &data = dynamic_cast<internal::Assembly::CopyData::AdvectionSystem<dim>& > (data_base);
+      internal::Assembly::Scratch::AdvectionSystem<dim> &scratch = internal::Assembly::checked_cast<internal::Assembly::Scratch::AdvectionSystem<dim>> (scratch_base);
+      internal::Assembly::CopyData::AdvectionSystem<dim> &data = internal::Assembly::checked_cast<internal::Assembly::CopyData::AdvectionSystem<dim>> (data_base);
 
       const Parameters<dim> &parameters = this->get_parameters();
       const Introspection<dim> &introspection = this->introspection();
@@ -727,14 +711,10 @@ namespace aspect
               // get all dof indices on the neighbor, then extract those
               // that correspond to the solution_field we are interested in
               neighbor->get_dof_indices (neighbor_dof_indices);
-              for (unsigned int i=0, i_advection=0; i_advection<advection_dofs_per_cell;/*increment at end of loop*/)
+              for (unsigned int i_advection=0; i_advection<advection_dofs_per_cell; ++i_advection)
                 {
-                  if (fe.system_to_component_index(i).first == solution_component)
-                    {
-                      data.neighbor_dof_indices[face_no * GeometryInfo<dim>::max_children_per_face][i_advection] = neighbor_dof_indices[i];
-                      ++i_advection;
-                    }
-                  ++i;
+                  const unsigned int i = fe.component_to_system_index(solution_component, i_advection);
+                  data.neighbor_dof_indices[face_no * GeometryInfo<dim>::max_children_per_face][i_advection] = neighbor_dof_indices[i];
                 }
               data.assembled_matrices[face_no * GeometryInfo<dim>::max_children_per_face] = true;
 
@@ -744,17 +724,13 @@ namespace aspect
                   // We only need to look up values of shape functions if they
                   // belong to 'our' component. They are zero otherwise anyway.
                   // Note that we later only look at the values that we do set here.
-                  for (unsigned int i=0, i_advection=0; i_advection<advection_dofs_per_cell;/*increment at end of loop*/)
+                  for (unsigned int i_advection=0; i_advection<advection_dofs_per_cell; ++i_advection)
                     {
-                      if (fe.system_to_component_index(i).first == solution_component)
-                        {
-                          scratch.face_grad_phi_field[i_advection]          = (*scratch.face_finite_element_values)[solution_field].gradient (i, q);
-                          scratch.face_phi_field[i_advection]               = (*scratch.face_finite_element_values)[solution_field].value (i, q);
-                          scratch.neighbor_face_grad_phi_field[i_advection] = (*scratch.neighbor_face_finite_element_values)[solution_field].gradient (i, q);
-                          scratch.neighbor_face_phi_field[i_advection]      = (*scratch.neighbor_face_finite_element_values)[solution_field].value (i, q);
-                          ++i_advection;
-                        }
-                      ++i;
+                      const unsigned int i = fe.component_to_system_index(solution_component, i_advection);
+                      scratch.face_grad_phi_field[i_advection]          = (*scratch.face_finite_element_values)[solution_field].gradient (i, q);
+                      scratch.face_phi_field[i_advection]               = (*scratch.face_finite_element_values)[solution_field].value (i, q);
+                      scratch.neighbor_face_grad_phi_field[i_advection] = (*scratch.neighbor_face_finite_element_values)[solution_field].gradient (i, q);
+                      scratch.neighbor_face_phi_field[i_advection]      = (*scratch.neighbor_face_finite_element_values)[solution_field].value (i, q);
                     }
 
                   const double density_c_P              =
@@ -1083,14 +1059,10 @@ namespace aspect
               // get all dof indices on the neighbor, then extract those
               // that correspond to the solution_field we are interested in
               neighbor_child->get_dof_indices (neighbor_dof_indices);
-              for (unsigned int i=0, i_advection=0; i_advection<advection_dofs_per_cell;/*increment at end of loop*/)
+              for (unsigned int i_advection=0; i_advection<advection_dofs_per_cell; ++i_advection)
                 {
-                  if (fe.system_to_component_index(i).first == solution_component)
-                    {
-                      data.neighbor_dof_indices[face_no * GeometryInfo<dim>::max_children_per_face + subface_no][i_advection] = neighbor_dof_indices[i];
-                      ++i_advection;
-                    }
-                  ++i;
+                  const unsigned int i = fe.component_to_system_index(solution_component, i_advection);
+                  data.neighbor_dof_indices[face_no * GeometryInfo<dim>::max_children_per_face + subface_no][i_advection] = neighbor_dof_indices[i];
                 }
               data.assembled_matrices[face_no * GeometryInfo<dim>::max_children_per_face + subface_no] = true;
 
@@ -1100,17 +1072,13 @@ namespace aspect
                   // We only need to look up values of shape functions if they
                   // belong to 'our' component. They are zero otherwise anyway.
                   // Note that we later only look at the values that we do set here.
-                  for (unsigned int i=0, i_advection=0; i_advection<advection_dofs_per_cell; /*increment at end of loop*/)
+                  for (unsigned int i_advection=0; i_advection<advection_dofs_per_cell; ++i_advection)
                     {
-                      if (fe.system_to_component_index(i).first == solution_component)
-                        {
-                          scratch.face_grad_phi_field[i_advection]          = (*scratch.subface_finite_element_values)[solution_field].gradient (i, q);
-                          scratch.face_phi_field[i_advection]               = (*scratch.subface_finite_element_values)[solution_field].value (i, q);
-                          scratch.neighbor_face_grad_phi_field[i_advection] = (*scratch.neighbor_face_finite_element_values)[solution_field].gradient (i, q);
-                          scratch.neighbor_face_phi_field[i_advection]      = (*scratch.neighbor_face_finite_element_values)[solution_field].value (i, q);
-                          ++i_advection;
-                        }
-                      ++i;
+                      const unsigned int i = fe.component_to_system_index(solution_component, i_advection);
+                      scratch.face_grad_phi_field[i_advection]          = (*scratch.subface_finite_element_values)[solution_field].gradient (i, q);
+                      scratch.face_phi_field[i_advection]               = (*scratch.subface_finite_element_values)[solution_field].value (i, q);
+                      scratch.neighbor_face_grad_phi_field[i_advection] = (*scratch.neighbor_face_finite_element_values)[solution_field].gradient (i, q);
+                      scratch.neighbor_face_phi_field[i_advection]      = (*scratch.neighbor_face_finite_element_values)[solution_field].value (i, q);
                     }
 
                   const double density_c_P              =
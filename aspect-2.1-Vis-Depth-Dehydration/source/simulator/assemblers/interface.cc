@@ -397,17 +397,15 @@ namespace aspect
                                    const Introspection<dim>                   &introspection,
                                    const FiniteElement<dim>           &finite_element)
         {
-          const unsigned int dofs_per_cell = finite_element.dofs_per_cell;
-
-          for (unsigned int i=0, i_stokes=0; i<dofs_per_cell; /*increment at end of loop*/)
-            {
-              if (introspection.is_stokes_component(finite_element.system_to_component_index(i).first))
-                {
-                  this->local_dof_indices[i_stokes] = all_dof_indices[i];
-                  ++i_stokes;
-                }
-              ++i;
-            }
+          (void)finite_element;
+          Assert (introspection.stokes_shape_function_indices.size() <= this->local_dof_indices.size(),
+                  ExcInternalError());
+          Assert (all_dof_indices.size() == finite_element.dofs_per_cell,
+                  ExcInternalError());
+
+          const unsigned int n_stokes_shape_functions = introspection.stokes_shape_function_indices.size();
+          for (unsigned int i_stokes=0; i_stokes<n_stokes_shape_functions; ++i_stokes)
+            this->local_dof_indices[i_stokes] = all_dof_indices[introspection.stokes_shape_function_indices[i_stokes]];
         }
 
 
@@ -20,6 +20,7 @@
 
 
 #include <aspect/simulator.h>
+#include <aspect/stokes_matrix_free.h>
 #include <aspect/utilities.h>
 #include <aspect/compat.h>
 #include <aspect/simulator_access.h>
@@ -44,11 +45,27 @@
 #include <deal.II/dofs/dof_tools.h>
 #include <deal.II/fe/fe_values.h>
 
+#include <chrono>
 #include <limits>
 
 
 namespace aspect
 {
+  template <int dim>
+  void
+  Simulator<dim>::
+  evaluate_material_model (const MaterialModel::MaterialModelInputs<dim> &in,
+                           MaterialModel::MaterialModelOutputs<dim> &out) const
+  {
+    if (material_model_cache)
+      material_model_cache->evaluate (*material_model, in, out,
+                                      timestep_number, nonlinear_iteration);
+    else
+      material_model->evaluate (in, out);
+  }
+
+
+
   template <int dim>
   void
   Simulator<dim>::
@@ -328,8 +345,8 @@ namespace aspect
     for (unsigned int i=0; i<assemblers->stokes_preconditioner.size(); ++i)
       assemblers->stokes_preconditioner[i]->create_additional_material_model_outputs(scratch.material_model_outputs);
 
-    material_model->evaluate(scratch.material_model_inputs,
-                             scratch.material_model_outputs);
+    evaluate_material_model(scratch.material_model_inputs,
+                            scratch.material_model_outputs);
     MaterialModel::MaterialAveraging::average (parameters.material_averaging,
                                                cell,
                                                scratch.finite_element_values.get_quadrature(),
@@ -385,7 +402,15 @@ namespace aspect
                       internal::Assembly::Scratch::StokesPreconditioner<dim> &scratch,
                       internal::Assembly::CopyData::StokesPreconditioner<dim> &data)
     {
-      this->local_assemble_stokes_preconditioner(cell, scratch, data);
+      if (measured_cell_costs.size() > 0)
+        {
+          const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+          this->local_assemble_stokes_preconditioner(cell, scratch, data);
+          measured_cell_costs(cell->active_cell_index())
+          += std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+        }
+      else
+        this->local_assemble_stokes_preconditioner(cell, scratch, data);
     };
 
     auto copier = [&](const internal::Assembly::CopyData::StokesPreconditioner<dim> &data)
@@ -429,6 +454,58 @@ namespace aspect
     TimerOutput::Scope timer (computing_timer, "Build Stokes preconditioner");
     pcout << "   Rebuilding Stokes preconditioner..." << std::flush;
 
+    // the matrix-free solver builds its own geometric multigrid
+    // preconditioner and does not need any assembled matrices
+    if (stokes_matrix_free)
+      {
+        stokes_matrix_free->build_preconditioner();
+        rebuild_stokes_preconditioner = false;
+
+        pcout << std::endl;
+        return;
+      }
+
+    // see if we can keep the existing preconditioner, or at least the
+    // hierarchy of the AMG preconditioner for the velocity block
+    if (stokes_preconditioner_can_be_reused())
+      {
+        if (parameters.AMG_reuse_policy == Parameters<dim>::AMGReusePolicy::reuse_preconditioner)
+          {
+            pcout << " reusing previous preconditioner." << std::endl;
+            rebuild_stokes_preconditioner = false;
+            return;
+          }
+
+#ifndef ASPECT_USE_PETSC
+        if (parameters.AMG_reuse_policy == Parameters<dim>::AMGReusePolicy::reuse_hierarchy)
+          {
+            assemble_stokes_preconditioner ();
+
+            // recompute the level matrices of the AMG preconditioners from
+            // the new matrices, but keep their aggregates. the matrices
+            // are the same objects the preconditioners were initialized
+            // with, they only contain new values
+            if (parameters.include_melt_transport == false)
+              {
+                LinearAlgebra::PreconditionILU *Mp_preconditioner_ILU
+                  = dynamic_cast<LinearAlgebra::PreconditionILU *> (Mp_preconditioner.get());
+                Mp_preconditioner_ILU->initialize (system_preconditioner_matrix.block(1,1));
+              }
+            else
+              {
+                LinearAlgebra::PreconditionAMG *Mp_preconditioner_AMG
+                  = dynamic_cast<LinearAlgebra::PreconditionAMG *> (Mp_preconditioner.get());
+                Mp_preconditioner_AMG->reinit ();
+              }
+            Amg_preconditioner->reinit ();
+
+            pcout << " reusing previous AMG hierarchy." << std::endl;
+            rebuild_stokes_preconditioner = false;
+            return;
+          }
+#endif
+      }
+
     // first assemble the raw matrices necessary for the preconditioner
     assemble_stokes_preconditioner ();
 
@@ -521,6 +598,9 @@ namespace aspect
       Amg_preconditioner->initialize (system_preconditioner_matrix.block(0,0),
                                       Amg_data);
 
+    // remember the viscosity this preconditioner was built for
+    amg_cell_log_viscosities = stokes_cell_log_viscosities;
+
     rebuild_stokes_preconditioner = false;
 
     pcout << std::endl;
@@ -528,6 +608,46 @@ namespace aspect
 
 
 
+  template <int dim>
+  bool
+  Simulator<dim>::stokes_preconditioner_can_be_reused () const
+  {
+    if (parameters.AMG_reuse_policy == Parameters<dim>::AMGReusePolicy::never)
+      return false;
+
+    // we need an existing preconditioner. this is not the case in the
+    // first time step and after the matrices have been set up anew, for
+    // example after mesh refinement
+    if (!Amg_preconditioner || !Mp_preconditioner)
+      return false;
+
+    // if the last solve was expensive, the old preconditioner is apparently
+    // no longer good enough
+    if (n_last_stokes_solver_iterations > parameters.AMG_reuse_iteration_threshold)
+      return false;
+
+    if (stokes_cell_log_viscosities.size() != triangulation.n_active_cells()
+        ||
+        amg_cell_log_viscosities.size() != triangulation.n_active_cells())
+      return false;
+
+    double max_viscosity_change = 0;
+    for (typename DoFHandler<dim>::active_cell_iterator cell = dof_handler.begin_active();
+         cell != dof_handler.end(); ++cell)
+      if (cell->is_locally_owned())
+        {
+          const unsigned int index = cell->active_cell_index();
+          max_viscosity_change = std::max<double> (max_viscosity_change,
+                                                   std::abs(stokes_cell_log_viscosities(index)
+                                                            - amg_cell_log_viscosities(index)));
+        }
+    max_viscosity_change = Utilities::MPI::max (max_viscosity_change, mpi_communicator);
+
+    return (max_viscosity_change <= parameters.AMG_reuse_viscosity_change_threshold);
+  }
+
+
+
   template <int dim>
   void
   Simulator<dim>::
@@ -564,8 +684,8 @@ namespace aspect
     for (unsigned int i=0; i<assemblers->stokes_system.size(); ++i)
       assemblers->stokes_system[i]->create_additional_material_model_outputs(scratch.material_model_outputs);
 
-    material_model->evaluate(scratch.material_model_inputs,
-                             scratch.material_model_outputs);
+    evaluate_material_model(scratch.material_model_inputs,
+                            scratch.material_model_outputs);
     MaterialModel::MaterialAveraging::average (parameters.material_averaging,
                                                cell,
                                                scratch.finite_element_values.get_quadrature(),
@@ -593,6 +713,18 @@ namespace aspect
       }
 
 
+    // record the viscosity that goes into the matrix, so that we can later
+    // decide whether the AMG preconditioner needs to be rebuilt. every
+    // cell writes a different entry, so this is safe to do in parallel
+    if (rebuild_stokes_matrix && stokes_cell_log_viscosities.size() > 0)
+      {
+        double mean_log_viscosity = 0;
+        for (unsigned int q=0; q<scratch.finite_element_values.n_quadrature_points; ++q)
+          mean_log_viscosity += std::log10(scratch.material_model_outputs.viscosities[q]);
+        stokes_cell_log_viscosities(cell->active_cell_index())
+          = mean_log_viscosity / scratch.finite_element_values.n_quadrature_points;
+      }
+
     // trigger the invocation of the various functions that actually do
     // all of the assembling
     for (unsigned int i=0; i<assemblers->stokes_system.size(); ++i)
@@ -651,7 +783,7 @@ namespace aspect
   Simulator<dim>::
   copy_local_to_global_stokes_system (const internal::Assembly::CopyData::StokesSystem<dim> &data)
   {
-    if (rebuild_stokes_matrix == true)
+    if (rebuild_stokes_matrix == true && !stokes_matrix_free)
       current_constraints.distribute_local_to_global (data.local_matrix,
                                                       data.local_rhs,
                                                       data.local_dof_indices,
@@ -691,14 +823,31 @@ namespace aspect
     // when having inhomogeneous constraints. Make sure that we can not have
     // this situation (no active boundary conditions means that only
     // no-slip/free slip are used). This should not happen as we set this up
-    // correctly before calling this function.
-    Assert(rebuild_stokes_matrix || boundary_velocity_manager.get_active_boundary_velocity_conditions().size()==0,
+    // correctly before calling this function. The matrix-free solver
+    // takes care of inhomogeneous constraints separately below.
+    Assert(rebuild_stokes_matrix || stokes_matrix_free || boundary_velocity_manager.get_active_boundary_velocity_conditions().size()==0,
            ExcInternalError("If we have inhomogeneous constraints, we must re-assemble the system matrix."));
 
+    // The matrix-free solver only needs the right hand side from the
+    // assembly below, the operator is applied without a matrix.
+    const bool assemble_stokes_matrix = rebuild_stokes_matrix && !stokes_matrix_free;
+
     system_rhs = 0;
     if (do_pressure_rhs_compatibility_modification)
       pressure_shape_function_integrals = 0;
 
+    // if the AMG preconditioner may be reused, keep track of the viscosity
+    // in each cell (see stokes_preconditioner_can_be_reused())
+    if (assemble_stokes_matrix)
+      {
+        if (parameters.stokes_solver_type == Parameters<dim>::StokesSolverType::block_amg
+            &&
+            parameters.AMG_reuse_policy != Parameters<dim>::AMGReusePolicy::never)
+          stokes_cell_log_viscosities.reinit (triangulation.n_active_cells());
+        else
+          stokes_cell_log_viscosities.reinit (0);
+      }
+
     const QGauss<dim>   quadrature_formula(parameters.stokes_velocity_degree+1);
     const QGauss<dim-1> face_quadrature_formula(parameters.stokes_velocity_degree+1);
 
@@ -750,7 +899,15 @@ namespace aspect
                       internal::Assembly::Scratch::StokesSystem<dim> &scratch,
                       internal::Assembly::CopyData::StokesSystem<dim> &data)
     {
-      this->local_assemble_stokes_system(cell, scratch, data);
+      if (measured_cell_costs.size() > 0)
+        {
+          const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+          this->local_assemble_stokes_system(cell, scratch, data);
+          measured_cell_costs(cell->active_cell_index())
+          += std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+        }
+      else
+        this->local_assemble_stokes_system(cell, scratch, data);
     };
 
     auto copier = [&](const internal::Assembly::CopyData::StokesSystem<dim> &data)
@@ -774,7 +931,7 @@ namespace aspect
                             stokes_dofs_per_cell,
                             parameters.include_melt_transport,
                             use_reference_density_profile,
-                            rebuild_stokes_matrix,
+                            assemble_stokes_matrix,
                             assemble_newton_stokes_matrix),
          internal::Assembly::CopyData::
          StokesSystem<dim> (stokes_dofs_per_cell,
@@ -783,6 +940,17 @@ namespace aspect
     system_matrix.compress(VectorOperation::add);
     system_rhs.compress(VectorOperation::add);
 
+    // for the matrix-free solver, update the viscosity stored in the
+    // operators whenever the matrix would have been rebuilt, and move
+    // inhomogeneous constraints to the right hand side
+    if (stokes_matrix_free)
+      {
+        if (rebuild_stokes_matrix)
+          stokes_matrix_free->evaluate_material_model();
+
+        stokes_matrix_free->correct_stokes_rhs();
+      }
+
     // if the model is compressible then we need to adjust the right hand
     // side of the equation to make it compatible with the matrix on the
     // left
@@ -887,8 +1055,8 @@ namespace aspect
                                                           scratch.finite_element_values,
                                                           introspection);
 
-    material_model->evaluate(scratch.material_model_inputs,
-                             scratch.material_model_outputs);
+    evaluate_material_model(scratch.material_model_inputs,
+                            scratch.material_model_outputs);
     if (parameters.formulation_temperature_equation ==
         Parameters<dim>::Formulation::TemperatureEquation::reference_density_profile)
       {
@@ -1156,7 +1324,15 @@ namespace aspect
                       internal::Assembly::Scratch::AdvectionSystem<dim> &scratch,
                       internal::Assembly::CopyData::AdvectionSystem<dim> &data)
     {
-      this->local_assemble_advection_system(advection_field, viscosity_per_cell, cell, scratch, data);
+      if (measured_cell_costs.size() > 0)
+        {
+          const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+          this->local_assemble_advection_system(advection_field, viscosity_per_cell, cell, scratch, data);
+          measured_cell_costs(cell->active_cell_index())
+          += std::chrono::duration<float>(std::chrono::steady_clock::now() - start).count();
+        }
+      else
+        this->local_assemble_advection_system(advection_field, viscosity_per_cell, cell, scratch, data);
     };
 
     auto copier = [&](const internal::Assembly::CopyData::AdvectionSystem<dim> &data)
@@ -1210,6 +1386,7 @@ namespace aspect
                                                                              const internal::Assembly::CopyData::StokesPreconditioner<dim> &data); \
   template void Simulator<dim>::assemble_stokes_preconditioner (); \
   template void Simulator<dim>::build_stokes_preconditioner (); \
+  template bool Simulator<dim>::stokes_preconditioner_can_be_reused () const; \
   template void Simulator<dim>::local_assemble_stokes_system ( \
                                                                const DoFHandler<dim>::active_cell_iterator &cell, \
                                                                internal::Assembly::Scratch::StokesSystem<dim>  &scratch, \
@@ -1234,7 +1411,10 @@ namespace aspect
                                                                       const FEValuesBase<dim,dim>                           &input_finite_element_values, \
                                                                       const DoFHandler<dim>::active_cell_iterator  &cell, \
                                                                       const bool                                             compute_strainrate, \
-                                                                      MaterialModel::MaterialModelInputs<dim>               &material_model_inputs) const;
+                                                                      MaterialModel::MaterialModelInputs<dim>               &material_model_inputs) const; \
+  template void Simulator<dim>::evaluate_material_model ( \
+                                                          const MaterialModel::MaterialModelInputs<dim> &in, \
+                                                          MaterialModel::MaterialModelOutputs<dim> &out) const;
 
 
 
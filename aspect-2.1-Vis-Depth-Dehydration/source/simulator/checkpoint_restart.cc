@@ -25,6 +25,7 @@
 #include <aspect/melt.h>
 
 #include <deal.II/base/mpi.h>
+#include <deal.II/base/parallel.h>
 #include <deal.II/grid/grid_tools.h>
 #include <deal.II/distributed/solution_transfer.h>
 
@@ -32,6 +33,8 @@
 #  include <zlib.h>
 #endif
 
+#include <limits>
+
 namespace aspect
 {
   namespace
@@ -66,6 +69,258 @@ namespace aspect
                                               + Utilities::to_string(error) + "."));
         }
     }
+
+
+
+    /**
+     * The files that deal.II's parallel::distributed::Triangulation::save()
+     * may create for a given file name, given as the suffixes that are
+     * appended to that file name. Which ones are actually written depends
+     * on the deal.II version and on whether data was attached to the
+     * triangulation. The last entry is the file into which the particle
+     * world writes its particles if they are not attached to the
+     * triangulation (see Particle::World::write_particle_checkpoint()).
+     */
+    const char *const mesh_file_suffixes[] = { "", ".info", "_fixed.data", "_variable.data", ".particles" };
+
+
+
+    /**
+     * Rename all existing files of the last checkpoint to <tt>*.old</tt>
+     * so that they are kept in case writing the new checkpoint fails.
+     */
+    void rotate_checkpoint_files (const std::string &output_directory)
+    {
+      for (const char *suffix : mesh_file_suffixes)
+        if (Utilities::fexists(output_directory + "restart.mesh" + suffix))
+          move_file (output_directory + "restart.mesh" + suffix,
+                     output_directory + "restart.mesh" + suffix + ".old");
+
+      move_file (output_directory + "restart.resume.z",
+                 output_directory + "restart.resume.z.old");
+    }
+
+
+
+    /**
+     * The size of the blocks into which the serialized resume data is split
+     * before compressing it. Each block is compressed independently, so that
+     * the blocks can be compressed in parallel, and only one block at a time
+     * needs to be uncompressed when reading the data back.
+     */
+    const uint32_t resume_file_block_size = 4*1024*1024;
+
+
+
+    /**
+     * Compress the serialized resume data given in @p data with zlib, using
+     * the given @p compression_level, and write it to the file @p filename.
+     *
+     * The file starts with a header of 32 bit integers that contains the
+     * number of blocks, the uncompressed size of each block, the
+     * uncompressed size of the last block, and then the list of the
+     * compressed sizes of all blocks. The compressed blocks follow the
+     * header. Files written by earlier versions consist of a single block
+     * in the same format.
+     */
+    void write_compressed_resume_file (const std::string &filename,
+                                       const std::string &data,
+                                       const int compression_level)
+    {
+#ifdef DEAL_II_WITH_ZLIB
+      const std::size_t n_blocks = std::max<std::size_t> ((data.size() + resume_file_block_size - 1)
+                                                          / resume_file_block_size,
+                                                          1);
+      AssertThrow (n_blocks < std::numeric_limits<uint32_t>::max(),
+                   ExcMessage ("The serialized checkpoint data is too large to be written."));
+
+      // compress all blocks independently of each other, and in parallel
+      std::vector<std::vector<Bytef> > compressed_blocks (n_blocks);
+      std::vector<int> errors (n_blocks, Z_OK);
+      parallel::apply_to_subranges (0U, static_cast<unsigned int>(n_blocks),
+                                    [&](const unsigned int begin,
+                                        const unsigned int end)
+      {
+        for (unsigned int b=begin; b<end; ++b)
+          {
+            const std::size_t offset = static_cast<std::size_t>(b) * resume_file_block_size;
+            const std::size_t block_size = std::min<std::size_t> (resume_file_block_size,
+                                                                  data.size() - offset);
+
+            uLongf compressed_size = compressBound (block_size);
+            compressed_blocks[b].resize (compressed_size);
+            errors[b] = compress2 (compressed_blocks[b].data(),
+                                   &compressed_size,
+                                   reinterpret_cast<const Bytef *>(data.data() + offset),
+                                   block_size,
+                                   compression_level);
+            compressed_blocks[b].resize (compressed_size);
+          }
+      },
+      1);
+
+      for (unsigned int b=0; b<n_blocks; ++b)
+        AssertThrow (errors[b] == Z_OK,
+                     ExcMessage ("Compressing the checkpoint data resulted in an error with code <"
+                                 + Utilities::int_to_string(errors[b]) + ">."));
+
+      // build compression header
+      std::vector<uint32_t> compression_header (3 + n_blocks);
+      compression_header[0] = n_blocks;                                    /* number of blocks */
+      compression_header[1] = (n_blocks == 1 ? data.size() : resume_file_block_size); /* size of block */
+      compression_header[2] = data.size() - (n_blocks-1) * resume_file_block_size;  /* size of last block */
+      std::size_t file_size = compression_header.size() * sizeof(uint32_t);
+      for (unsigned int b=0; b<n_blocks; ++b)                             /* list of compressed sizes of blocks */
+        {
+          compression_header[3+b] = compressed_blocks[b].size();
+          file_size += compressed_blocks[b].size();
+        }
+
+      std::ofstream f (filename.c_str(), std::ios::binary);
+      f.write((const char *)compression_header.data(), compression_header.size() * sizeof(uint32_t));
+      for (unsigned int b=0; b<n_blocks; ++b)
+        f.write((const char *)compressed_blocks[b].data(), compressed_blocks[b].size());
+      f.close();
+
+      // We check the fail state of the stream _after_ closing the file to
+      // make sure the writes were completed correctly. This also catches
+      // the cases where the file could not be opened in the first place
+      // or one of the write() commands fails, as the fail state is
+      // "sticky".
+      if (!f)
+        AssertThrow(false, ExcMessage ("Writing of the checkpoint file '" + filename
+                                       + "' with size "
+                                       + Utilities::to_string(file_size)
+                                       + " failed on processor 0."));
+#else
+      (void)filename;
+      (void)data;
+      (void)compression_level;
+      AssertThrow (false,
+                   ExcMessage ("You need to have deal.II configured with the `libz' "
+                               "option to support checkpoint/restart, but deal.II "
+                               "did not detect its presence when you called `cmake'."));
+#endif
+    }
+
+
+
+#ifdef DEAL_II_WITH_ZLIB
+    /**
+     * A stream buffer that reads a file written by
+     * write_compressed_resume_file() and uncompresses it one block at a
+     * time while the data is being read, so that neither the whole
+     * compressed nor the whole uncompressed data have to be kept in memory.
+     */
+    class CompressedResumeFileBuffer : public std::streambuf
+    {
+      public:
+        explicit CompressedResumeFileBuffer (const std::string &filename)
+          :
+          file (filename.c_str(), std::ios::binary),
+          current_block (0)
+        {
+          AssertThrow(file.is_open(),
+                      ExcMessage("Cannot open snapshot resume file."));
+
+          uint32_t n_blocks = 0;
+          file.read((char *)&n_blocks, sizeof(n_blocks));
+          AssertThrow(file && n_blocks > 0,
+                      ExcMessage("The snapshot resume file has an invalid header."));
+
+          compression_header.resize (3 + n_blocks);
+          compression_header[0] = n_blocks;
+          file.read((char *)&compression_header[1], (2 + n_blocks) * sizeof(uint32_t));
+          AssertThrow(file,
+                      ExcMessage("The snapshot resume file has an invalid header."));
+        }
+
+      protected:
+        int_type underflow () override
+        {
+          if (gptr() < egptr())
+            return traits_type::to_int_type(*gptr());
+
+          const uint32_t n_blocks = compression_header[0];
+          if (current_block == n_blocks)
+            return traits_type::eof();
+
+          const uint32_t uncompressed_block_size
+            = (current_block == n_blocks-1 ? compression_header[2] : compression_header[1]);
+          const uint32_t compressed_block_size = compression_header[3+current_block];
+
+          compressed.resize (compressed_block_size);
+          uncompressed.resize (std::max<uint32_t>(uncompressed_block_size, 1));
+          file.read(compressed.data(), compressed_block_size);
+          AssertThrow(file,
+                      ExcMessage("The snapshot resume file is shorter than its header says."));
+
+          uLongf uncompressed_size = uncompressed_block_size;
+          const int err = uncompress((Bytef *)uncompressed.data(), &uncompressed_size,
+                                     (Bytef *)compressed.data(), compressed_block_size);
+          AssertThrow (err == Z_OK,
+                       ExcMessage (std::string("Uncompressing the data buffer resulted in an error with code <")
+                                   +
+                                   Utilities::int_to_string(err)));
+          ++current_block;
+
+          setg (uncompressed.data(), uncompressed.data(), uncompressed.data() + uncompressed_size);
+          if (uncompressed_size == 0)
+            return underflow();
+          return traits_type::to_int_type(*gptr());
+        }
+
+      private:
+        std::ifstream file;
+        std::vector<uint32_t> compression_header;
+        uint32_t current_block;
+        std::vector<char> compressed;
+        std::vector<char> uncompressed;
+    };
+#endif
+
+
+
+    /**
+     * The part of creating a snapshot that is done on a background thread
+     * on processor 0 if checkpoints are written in the background: move
+     * the files of the previous checkpoint out of the way, move the mesh
+     * files that were written under a temporary name into place, and
+     * write the compressed resume data.
+     *
+     * All arguments are passed by value since this function runs on a
+     * separate thread while the simulation continues. Since exceptions
+     * can not be propagated out of the thread, an error message is
+     * instead written into @p error_message, to be checked after the
+     * thread has been joined.
+     */
+    // We need to pass the arguments by value, as this function is called on a separate thread:
+    void write_checkpoint_files (const std::string output_directory,       //NOLINT(performance-unnecessary-value-param)
+                                 const std::string temporary_mesh_name,    //NOLINT(performance-unnecessary-value-param)
+                                 const std::string serialized_resume_data, //NOLINT(performance-unnecessary-value-param)
+                                 const bool previous_snapshot_exists,
+                                 const int compression_level,
+                                 std::string *error_message)
+    {
+      try
+        {
+          if (previous_snapshot_exists)
+            rotate_checkpoint_files (output_directory);
+
+          for (const char *suffix : mesh_file_suffixes)
+            if (Utilities::fexists(temporary_mesh_name + suffix))
+              move_file (temporary_mesh_name + suffix,
+                         output_directory + "restart.mesh" + suffix);
+
+          write_compressed_resume_file (output_directory + "restart.resume.z",
+                                        serialized_resume_data,
+                                        compression_level);
+        }
+      catch (std::exception &e)
+        {
+          *error_message = e.what();
+        }
+    }
   }
 
 
@@ -119,34 +374,72 @@ namespace aspect
 
 
   template <int dim>
-  void Simulator<dim>::create_snapshot()
+  void Simulator<dim>::wait_for_checkpoint_writer()
   {
-    TimerOutput::Scope timer (computing_timer, "Create snapshot");
-    unsigned int my_id = Utilities::MPI::this_mpi_process (mpi_communicator);
+    if (parameters.checkpoint_in_background == false)
+      return;
 
-    if (my_id == 0)
-      {
-        // if we have previously written a snapshot, then keep the last
-        // snapshot in case this one fails to save. Note: static variables
-        // will only be initialized once per model run.
-        static bool previous_snapshot_exists = (parameters.resume_computation == true);
+    checkpoint_writer_thread.join();
 
-        if (previous_snapshot_exists == true)
-          {
-            move_file (parameters.output_directory + "restart.mesh",
-                       parameters.output_directory + "restart.mesh.old");
-            move_file (parameters.output_directory + "restart.mesh.info",
-                       parameters.output_directory + "restart.mesh.info.old");
-            move_file (parameters.output_directory + "restart.resume.z",
-                       parameters.output_directory + "restart.resume.z.old");
-          }
-        // from now on, we know that if we get into this
-        // function again that a snapshot has previously
-        // been written
-        previous_snapshot_exists = true;
+    // the files are only written on processor zero, but all processes
+    // have to stop if that failed, since they are about to enter
+    // collective operations
+    const std::string error = checkpoint_writer_error;
+    checkpoint_writer_error.clear();
+    const bool writing_failed
+      = (Utilities::MPI::max (error.size() > 0 ? 1 : 0, mpi_communicator) == 1);
+
+    if (writing_failed)
+      {
+        if (Utilities::MPI::this_mpi_process(mpi_communicator) == 0)
+          AssertThrow (false,
+                       ExcMessage ("Writing the checkpoint files in the background "
+                                   "failed with the following error:\n" + error));
+        else
+          throw QuietException();
       }
+  }
+
+
+
+  template <int dim>
+  void Simulator<dim>::create_snapshot()
+  {
+    TimerOutput::Scope timer (computing_timer, "Create snapshot");
+    unsigned int my_id = Utilities::MPI::this_mpi_process (mpi_communicator);
 
-    // save Triangulation and Solution vectors:
+    // if the previous checkpoint is still being written in the background,
+    // wait for it to finish before we start to overwrite its files
+    wait_for_checkpoint_writer();
+
+    // if we have previously written a snapshot, then keep the last
+    // snapshot in case this one fails to save. Note: static variables
+    // will only be initialized once per model run.
+    static bool previous_snapshot_exists = (parameters.resume_computation == true);
+    const bool rotate_previous_snapshot = previous_snapshot_exists;
+
+    // from now on, we know that if we get into this
+    // function again that a snapshot has previously
+    // been written
+    previous_snapshot_exists = true;
+
+    // when writing in the background, the mesh is first saved under a
+    // temporary name, and only moved into place after the files of the
+    // previous snapshot have been renamed
+    const std::string mesh_file_name
+      = (parameters.checkpoint_in_background
+         ?
+         parameters.output_directory + "restart.mesh.tmp"
+         :
+         parameters.output_directory + "restart.mesh");
+
+    if (my_id == 0 && rotate_previous_snapshot && !parameters.checkpoint_in_background)
+      rotate_checkpoint_files (parameters.output_directory);
+
+    // save Triangulation and Solution vectors. triangulation.save() is a
+    // collective operation that copies the solution vectors into the
+    // data attached to the cells and writes the mesh files, so this part
+    // can not be done in the background:
     {
       std::vector<const LinearAlgebra::BlockVector *> x_system (3);
       x_system[0] = &solution;
@@ -187,7 +480,7 @@ namespace aspect
 
       signals.pre_checkpoint_store_user_data(triangulation);
 
-      triangulation.save ((parameters.output_directory + "restart.mesh").c_str());
+      triangulation.save (mesh_file_name.c_str());
     }
 
     // save general information This calls the serialization functions on all
@@ -201,51 +494,24 @@ namespace aspect
       save_critical_parameters (this->parameters, oa);
       oa << (*this);
 
-      // compress with zlib and write to file on the root processor
-#ifdef DEAL_II_WITH_ZLIB
+      // compress with zlib and write to file on the root processor, either
+      // right away or on a background thread that works on its own copy of
+      // the serialized data
       if (my_id == 0)
         {
-          uLongf compressed_data_length = compressBound (oss.str().length());
-          std::vector<char *> compressed_data (compressed_data_length);
-          int err = compress2 ((Bytef *) &compressed_data[0],
-                               &compressed_data_length,
-                               (const Bytef *) oss.str().data(),
-                               oss.str().length(),
-                               Z_BEST_COMPRESSION);
-          (void)err;
-          Assert (err == Z_OK, ExcInternalError());
-
-          // build compression header
-          const uint32_t compression_header[4]
-            = { 1,                                   /* number of blocks */
-                (uint32_t)oss.str().length(), /* size of block */
-                (uint32_t)oss.str().length(), /* size of last block */
-                (uint32_t)compressed_data_length
-              }; /* list of compressed sizes of blocks */
-
-          std::ofstream f ((parameters.output_directory + "restart.resume.z").c_str());
-          f.write((const char *)compression_header, 4 * sizeof(compression_header[0]));
-          f.write((char *)&compressed_data[0], compressed_data_length);
-          f.close();
-
-          // We check the fail state of the stream _after_ closing the file to
-          // make sure the writes were completed correctly. This also catches
-          // the cases where the file could not be opened in the first place
-          // or one of the write() commands fails, as the fail state is
-          // "sticky".
-          if (!f)
-            AssertThrow(false, ExcMessage ("Writing of the checkpoint file '" + parameters.output_directory
-                                           + "restart.resume.z' with size "
-                                           + Utilities::to_string(4 * sizeof(compression_header[0])+compressed_data_length)
-                                           + " failed on processor 0."));
+          if (parameters.checkpoint_in_background)
+            checkpoint_writer_thread = Threads::new_thread (&write_checkpoint_files,
+                                                            parameters.output_directory,
+                                                            mesh_file_name,
+                                                            oss.str(),
+                                                            rotate_previous_snapshot,
+                                                            parameters.checkpoint_compression_level,
+                                                            &checkpoint_writer_error);
+          else
+            write_compressed_resume_file (parameters.output_directory + "restart.resume.z",
+                                          oss.str(),
+                                          parameters.checkpoint_compression_level);
         }
-#else
-      AssertThrow (false,
-                   ExcMessage ("You need to have deal.II configured with the `libz' "
-                               "option to support checkpoint/restart, but deal.II "
-                               "did not detect its presence when you called `cmake'."));
-#endif
-
     }
 
     pcout << "*** Snapshot created!" << std::endl << std::endl;
@@ -343,29 +609,15 @@ namespace aspect
     try
       {
 #ifdef DEAL_II_WITH_ZLIB
-        std::ifstream ifs ((parameters.output_directory + "restart.resume.z").c_str());
-        AssertThrow(ifs.is_open(),
-                    ExcMessage("Cannot open snapshot resume file."));
-
-        uint32_t compression_header[4];
-        ifs.read((char *)compression_header, 4 * sizeof(compression_header[0]));
-        Assert(compression_header[0]==1, ExcInternalError());
-
-        std::vector<char> compressed(compression_header[3]);
-        std::vector<char> uncompressed(compression_header[1]);
-        ifs.read(&compressed[0],compression_header[3]);
-        uLongf uncompressed_size = compression_header[1];
-
-        const int err = uncompress((Bytef *)&uncompressed[0], &uncompressed_size,
-                                   (Bytef *)&compressed[0], compression_header[3]);
-        AssertThrow (err == Z_OK,
-                     ExcMessage (std::string("Uncompressing the data buffer resulted in an error with code <")
-                                 +
-                                 Utilities::int_to_string(err)));
-
+        // uncompress the data block by block while the archive reads it
         {
-          std::istringstream ss;
-          ss.str(std::string (&uncompressed[0], uncompressed_size));
+          CompressedResumeFileBuffer buffer (parameters.output_directory + "restart.resume.z");
+          std::istream ss (&buffer);
+
+          // errors while reading or uncompressing a block are reported
+          // as exceptions from the stream buffer; make sure the stream
+          // passes them on instead of just setting its error state
+          ss.exceptions (std::ios::badbit);
 
           aspect::iarchive ia (ss);
           load_and_check_critical_parameters(this->parameters, ia);
@@ -429,6 +681,7 @@ namespace aspect
 {
 #define INSTANTIATE(dim) \
   template void Simulator<dim>::create_snapshot(); \
+  template void Simulator<dim>::wait_for_checkpoint_writer(); \
   template void Simulator<dim>::resume_from_snapshot();
 
   ASPECT_INSTANTIATE(INSTANTIATE)
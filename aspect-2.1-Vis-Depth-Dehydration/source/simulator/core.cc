@@ -26,6 +26,7 @@
 #include <aspect/volume_of_fluid/handler.h>
 #include <aspect/newton.h>
 #include <aspect/free_surface.h>
+#include <aspect/stokes_matrix_free.h>
 #include <aspect/citation_info.h>
 
 #ifdef ASPECT_USE_WORLD_BUILDER
@@ -172,6 +173,7 @@ namespace aspect
                      pcout,
                      TimerOutput::never,
                      TimerOutput::wall_times),
+    n_statistics_rows_written (0),
     initial_topography_model(InitialTopographyModel::create_initial_topography_model<dim>(prm)),
     geometry_model (GeometryModel::create_geometry_model<dim>(prm)),
     // make sure the parameters object gets a chance to
@@ -198,10 +200,25 @@ namespace aspect
     timestep_number (numbers::invalid_unsigned_int),
     nonlinear_iteration (numbers::invalid_unsigned_int),
 
+    // the geometric multigrid Stokes solver needs the level hierarchy
+    // of the mesh and at most one level difference at each vertex
     triangulation (mpi_communicator,
+                   parameters.stokes_solver_type == StokesSolverType::block_gmg
+                   ?
+                   typename Triangulation<dim>::MeshSmoothing
+                   (Triangulation<dim>::smoothing_on_refinement |
+                    Triangulation<dim>::smoothing_on_coarsening |
+                    Triangulation<dim>::limit_level_difference_at_vertices)
+                   :
                    typename Triangulation<dim>::MeshSmoothing
                    (Triangulation<dim>::smoothing_on_refinement |
                     Triangulation<dim>::smoothing_on_coarsening),
+                   parameters.stokes_solver_type == StokesSolverType::block_gmg
+                   ?
+                   typename parallel::distributed::Triangulation<dim>::Settings
+                   (parallel::distributed::Triangulation<dim>::mesh_reconstruction_after_repartitioning |
+                    parallel::distributed::Triangulation<dim>::construct_multigrid_hierarchy)
+                   :
                    parallel::distributed::Triangulation<dim>::mesh_reconstruction_after_repartitioning),
 
     mapping(construct_mapping<dim>(*geometry_model,*initial_topography_model)),
@@ -216,7 +233,10 @@ namespace aspect
     rebuild_stokes_matrix (true),
     assemble_newton_stokes_matrix (true),
     assemble_newton_stokes_system (parameters.nonlinear_solver == NonlinearSolver::iterated_Advection_and_Newton_Stokes ? true : false),
-    rebuild_stokes_preconditioner (true)
+    rebuild_stokes_preconditioner (true),
+    n_last_stokes_solver_iterations (0),
+    n_stokes_solves_since_cheap_phase_failed (numbers::invalid_unsigned_int),
+    measured_cost_to_cell_weight (0.)
   {
     if (Utilities::MPI::this_mpi_process(mpi_communicator) == 0)
       {
@@ -355,6 +375,39 @@ namespace aspect
         melt_handler->initialize();
       }
 
+    if (parameters.cache_material_model_evaluations)
+      material_model_cache = std_cxx14::make_unique<MaterialModel::EvaluationCache<dim> >();
+
+    if (parameters.use_measured_cell_costs)
+      triangulation.signals.cell_weight.connect(
+        [&] (const typename parallel::distributed::Triangulation<dim>::cell_iterator &cell,
+             const typename parallel::distributed::Triangulation<dim>::CellStatus status)
+        -> unsigned int
+      {
+        return this->measured_cost_cell_weight(cell, status);
+      });
+
+    // Allocate the matrix-free Stokes solver if it was requested
+    if (parameters.stokes_solver_type == StokesSolverType::block_gmg)
+      {
+#if DEAL_II_VERSION_GTE(9,1,0)
+        switch (parameters.stokes_velocity_degree)
+          {
+            case 2:
+              stokes_matrix_free = std_cxx14::make_unique<StokesMatrixFreeHandlerImplementation<dim,2>>(*this, prm);
+              break;
+            case 3:
+              stokes_matrix_free = std_cxx14::make_unique<StokesMatrixFreeHandlerImplementation<dim,3>>(*this, prm);
+              break;
+            default:
+              AssertThrow(false, ExcMessage("The 'block GMG' Stokes solver only supports "
+                                            "a Stokes velocity polynomial degree of 2 or 3."));
+          }
+#else
+        AssertThrow(false, ExcMessage("The 'block GMG' Stokes solver requires deal.II 9.1 or newer."));
+#endif
+      }
+
     // If the solver type is a Newton type of solver, we need to set make sure
     // assemble_newton_stokes_system set to true.
     if (parameters.nonlinear_solver == NonlinearSolver::iterated_Advection_and_Newton_Stokes)
@@ -486,6 +539,11 @@ namespace aspect
     // object (set from the output_statistics() function)
     output_statistics_thread.join();
 
+    // also wait for the files of the last checkpoint to be written.
+    // we can not throw an exception from the destructor, so we
+    // do not check whether writing these files was successful here
+    checkpoint_writer_thread.join();
+
     // If an exception is being thrown (for example due to AssertThrow()), we
     // might end up here with currently active timing sections. The destructor
     // of TimerOutput does MPI communication, which can lead to deadlocks,
@@ -869,9 +927,14 @@ namespace aspect
       const typename Introspection<dim>::ComponentIndices &x
         = introspection.component_indices;
 
-      for (unsigned int c=0; c<dim; ++c)
-        for (unsigned int d=0; d<dim; ++d)
-          coupling[x.velocities[c]][x.velocities[d]] = DoFTools::always;
+      // the matrix-free Stokes solver never needs the Stokes blocks
+      // of the system matrix
+      const bool assemble_stokes_blocks = (parameters.stokes_solver_type != StokesSolverType::block_gmg);
+
+      if (assemble_stokes_blocks)
+        for (unsigned int c=0; c<dim; ++c)
+          for (unsigned int d=0; d<dim; ++d)
+            coupling[x.velocities[c]][x.velocities[d]] = DoFTools::always;
 
       if (parameters.include_melt_transport)
         {
@@ -897,7 +960,7 @@ namespace aspect
           [introspection.variable("compaction pressure").first_component_index]
             = DoFTools::always;
         }
-      else
+      else if (assemble_stokes_blocks)
         {
           for (unsigned int d=0; d<dim; ++d)
             {
@@ -1014,8 +1077,8 @@ namespace aspect
     system_preconditioner_matrix.clear ();
 
     // The preconditioner matrix is only used for the Stokes block (velocity and Schur complement) and is of course not
-    // used if we use a direct solver.
-    if (parameters.use_direct_stokes_solver)
+    // used if we use a direct solver or the matrix-free solver.
+    if (parameters.stokes_solver_type != StokesSolverType::block_amg)
       return;
 
     Table<2,DoFTools::Coupling> coupling (introspection.n_components,
@@ -1334,6 +1397,18 @@ namespace aspect
     if (do_pressure_rhs_compatibility_modification)
       pressure_shape_function_integrals.reinit (introspection.index_sets.system_partitioning, mpi_communicator);
 
+    if (stokes_matrix_free)
+      stokes_matrix_free->setup_dofs();
+
+    if (material_model_cache)
+      material_model_cache->reinit (triangulation.n_active_cells());
+
+    // the measured costs belong to the cells of the previous mesh, so
+    // start measuring again
+    if (parameters.use_measured_cell_costs)
+      measured_cell_costs.reinit (triangulation.n_active_cells());
+    measured_cost_to_cell_weight = 0.;
+
     rebuild_stokes_matrix         = true;
     rebuild_stokes_preconditioner = true;
   }
@@ -1345,6 +1420,20 @@ namespace aspect
   template <int dim>
   void Simulator<dim>::setup_introspection ()
   {
+    // find the shape functions that belong to the Stokes system, so that
+    // assemblers do not need to search for them on every cell
+    introspection.stokes_shape_function_indices.clear();
+    introspection.stokes_shape_function_components.clear();
+    for (unsigned int i=0; i<finite_element.dofs_per_cell; ++i)
+      {
+        const unsigned int component = finite_element.system_to_component_index(i).first;
+        if (introspection.is_stokes_component(component))
+          {
+            introspection.stokes_shape_function_indices.push_back(i);
+            introspection.stokes_shape_function_components.push_back(component);
+          }
+      }
+
     // compute the various partitionings between processors and blocks
     // of vectors and matrices
     DoFTools::count_dofs_per_block (dof_handler,
@@ -1441,6 +1530,31 @@ namespace aspect
         pcout << std::endl;
       }
 
+    // if material model evaluations are cached, report how many of the
+    // evaluations since the last postprocessing step were served from
+    // the cache
+    if (material_model_cache)
+      {
+        const std::pair<unsigned long int, unsigned long int> local_statistics
+          = material_model_cache->get_statistics();
+        const double n_hits = Utilities::MPI::sum (static_cast<double>(local_statistics.first),
+                                                   mpi_communicator);
+        const double n_misses = Utilities::MPI::sum (static_cast<double>(local_statistics.second),
+                                                     mpi_communicator);
+        material_model_cache->reset_statistics();
+
+        statistics.add_value ("Material model cache hits",
+                              static_cast<unsigned long long int>(n_hits));
+        statistics.add_value ("Material model cache misses",
+                              static_cast<unsigned long long int>(n_misses));
+
+        pcout << "   Material model evaluations served from the cache: "
+              << n_hits << "/" << n_hits + n_misses;
+        if (n_hits + n_misses > 0)
+          pcout << " (" << 100. * n_hits / (n_hits + n_misses) << "%)";
+        pcout << std::endl << std::endl;
+      }
+
     // finally, write the entire set of current results to disk
     output_statistics();
   }
@@ -1533,6 +1647,9 @@ namespace aspect
       // Possibly store data of plugins associated with cells
       signals.pre_refinement_store_user_data(triangulation);
 
+      if (parameters.use_measured_cell_costs)
+        prepare_measured_cost_cell_weights();
+
       triangulation.prepare_coarsening_and_refinement();
       system_trans.prepare_for_coarsening_and_refinement(x_system);
 
@@ -1855,6 +1972,9 @@ namespace aspect
       }
     while (true);
 
+    // make sure the last checkpoint is completely written before we end
+    wait_for_checkpoint_writer();
+
     // we disable automatic summary printing so that it won't happen when
     // throwing an exception. Therefore, we have to do this manually here:
     computing_timer.print_summary ();
@@ -22,92 +22,107 @@
 #include <aspect/simulator/assemblers/interface.h>
 #include <aspect/melt.h>
 
+#include <deal.II/base/quadrature_lib.h>
 #include <deal.II/base/signaling_nan.h>
+#include <deal.II/base/work_stream.h>
 #include <deal.II/fe/fe_values.h>
 
+#include <limits>
+
 
 namespace aspect
 {
-  /**
-   * Compute the variation in the entropy needed in the definition of the
-   * artificial viscosity used to stabilize the composition/temperature equation.
-   */
-  template <int dim>
-  double
-  Simulator<dim>::get_entropy_variation (const double average_field,
-                                         const AdvectionField &advection_field) const
+  namespace internal
   {
-    // only do this if we really need entropy
-    // variation. otherwise return something that's obviously
-    // nonsensical
-    if (parameters.stabilization_alpha != 2)
-      return numbers::signaling_nan<double>();
-
-    // record maximal entropy on Gauss quadrature points
-    const QGauss<dim> quadrature_formula (advection_field.polynomial_degree(introspection)+1);
-    const unsigned int n_q_points = quadrature_formula.size();
-
-    const FEValuesExtractors::Scalar field = advection_field.scalar_extractor(introspection);
-
-    FEValues<dim> fe_values (finite_element, quadrature_formula,
-                             update_values | update_JxW_values);
-    std::vector<double> old_field_values(n_q_points);
-    std::vector<double> old_old_field_values(n_q_points);
-
-    double min_entropy = std::numeric_limits<double>::max(),
-           max_entropy = -std::numeric_limits<double>::max(),
-           area = 0,
-           entropy_integrated = 0;
-
-    // loop over all locally owned cells and evaluate the entropy
-    // at all quadrature points. keep a running tally of the
-    // integral over the entropy as well as the area and the
-    // maximal and minimal entropy
-    typename DoFHandler<dim>::active_cell_iterator
-    cell = dof_handler.begin_active(),
-    endc = dof_handler.end();
-    for (; cell!=endc; ++cell)
-      if (cell->is_locally_owned())
-        {
-          fe_values.reinit (cell);
-          fe_values[field].get_function_values (old_solution,
-                                                old_field_values);
-          fe_values[field].get_function_values (old_old_solution,
-                                                old_old_field_values);
-          for (unsigned int q=0; q<n_q_points; ++q)
-            {
-              const double field_value = (old_field_values[q] +
-                                          old_old_field_values[q]) / 2;
-              const double entropy = ((field_value-average_field) *
-                                      (field_value-average_field));
-
-              min_entropy = std::min (min_entropy, entropy);
-              max_entropy = std::max (max_entropy, entropy);
-
-              area += fe_values.JxW(q);
-              entropy_integrated += fe_values.JxW(q) * entropy;
-            }
-        }
-
-    // do MPI data exchange: we need to sum over
-    // the two integrals (area,
-    // entropy_integrated), and get the extrema
-    // for maximum and minimum. combine
-    // MPI_Allreduce for two values since that is
-    // an expensive operation
-    const double local_for_sum[2] = { entropy_integrated, area },
-                                    local_for_max[2] = { -min_entropy, max_entropy };
-    double global_for_sum[2], global_for_max[2];
-
-    dealii::Utilities::MPI::sum (local_for_sum, mpi_communicator, global_for_sum);
-    dealii::Utilities::MPI::max (local_for_max, mpi_communicator, global_for_max);
-
-    const double average_entropy = global_for_sum[0] / global_for_sum[1];
-
-    // return the maximal deviation of the entropy everywhere from the
-    // average value
-    return std::max(global_for_max[1] - average_entropy,
-                    average_entropy - (-global_for_max[0]));
+    namespace EntropyViscosity
+    {
+      /**
+       * Scratch data for the loop over all cells in
+       * Simulator::get_artificial_viscosity(). In addition to the scratch
+       * object that is also used for the assembly of the advection systems,
+       * it contains what is needed to evaluate the entropy $(T-\bar T)^2$
+       * on a cell.
+       */
+      template <int dim>
+      struct ScratchData
+      {
+        ScratchData (const Assembly::Scratch::AdvectionSystem<dim> &advection_scratch,
+                     const FiniteElement<dim>                      &finite_element,
+                     const Quadrature<dim>                         &entropy_quadrature);
+
+        ScratchData (const ScratchData &scratch);
+
+        Assembly::Scratch::AdvectionSystem<dim> advection_scratch;
+
+        FEValues<dim>       entropy_fe_values;
+        std::vector<double> old_field_values;
+        std::vector<double> old_old_field_values;
+      };
+
+
+
+      template <int dim>
+      ScratchData<dim>::
+      ScratchData (const Assembly::Scratch::AdvectionSystem<dim> &advection_scratch,
+                   const FiniteElement<dim>                      &finite_element,
+                   const Quadrature<dim>                         &entropy_quadrature)
+        :
+        advection_scratch (advection_scratch),
+        entropy_fe_values (finite_element, entropy_quadrature,
+                           update_values | update_JxW_values),
+        old_field_values (entropy_quadrature.size()),
+        old_old_field_values (entropy_quadrature.size())
+      {}
+
+
+
+      template <int dim>
+      ScratchData<dim>::
+      ScratchData (const ScratchData &scratch)
+        :
+        advection_scratch (scratch.advection_scratch),
+        entropy_fe_values (scratch.entropy_fe_values.get_fe(),
+                           scratch.entropy_fe_values.get_quadrature(),
+                           scratch.entropy_fe_values.get_update_flags()),
+        old_field_values (scratch.old_field_values),
+        old_old_field_values (scratch.old_old_field_values)
+      {}
+
+
+
+      /**
+       * The results of the work on one cell: whether the artificial
+       * viscosity was computed on the cell at all, its value, possibly still
+       * to be limited by the entropy variation (see
+       * Simulator::compute_viscosity()), and the contributions of the cell
+       * to the integral, area, and extrema of the entropy from which the
+       * entropy variation is computed.
+       */
+      struct CopyData
+      {
+        CopyData ()
+          :
+          active_cell_index (numbers::invalid_unsigned_int),
+          viscosity_computed (false),
+          viscosity (0),
+          entropy_viscosity_numerator (-1),
+          entropy_integrated (0),
+          area (0),
+          min_entropy (std::numeric_limits<double>::max()),
+          max_entropy (-std::numeric_limits<double>::max())
+        {}
+
+        unsigned int active_cell_index;
+        bool         viscosity_computed;
+        double       viscosity;
+        double       entropy_viscosity_numerator;
+
+        double       entropy_integrated;
+        double       area;
+        double       min_entropy;
+        double       max_entropy;
+      };
+    }
   }
 
 
@@ -119,10 +134,12 @@ namespace aspect
                      const double                        global_u_infty,
                      const double                        global_field_variation,
                      const double                        average_field,
-                     const double                        global_entropy_variation,
                      const double                        cell_diameter,
-                     const AdvectionField               &advection_field) const
+                     const AdvectionField               &advection_field,
+                     double                             &entropy_viscosity_numerator) const
   {
+    entropy_viscosity_numerator = -1;
+
     // discontinuous Galerkin doesn't require an artificial viscosity
     if (advection_field.is_discontinuous(introspection))
       return 0.;
@@ -204,27 +221,27 @@ namespace aspect
                                  max_velocity * cell_diameter;
 
     if (timestep_number <= 1
-        || std::abs(global_entropy_variation) < 1e-50
         || std::abs(global_field_variation) < 1e-50)
       // we don't have sensible time-steps during the first two iterations
-      // and we can not divide by the entropy_variation if it is zero
       return max_viscosity;
     else
       {
         Assert (old_time_step > 0, ExcInternalError());
 
-        double entropy_viscosity;
         if (parameters.stabilization_alpha == 2)
-          entropy_viscosity = (parameters.stabilization_c_R[advection_field.field_index()] *
-                               cell_diameter * cell_diameter *
-                               max_residual /
-                               global_entropy_variation);
-        else
-          entropy_viscosity = (parameters.stabilization_c_R[advection_field.field_index()] *
-                               cell_diameter * global_Omega_diameter *
-                               max_velocity * max_residual /
-                               (global_u_infty * global_field_variation));
+          {
+            // the entropy variation is only known once all cells have
+            // been visited, so let the caller divide by it
+            entropy_viscosity_numerator = (parameters.stabilization_c_R[advection_field.field_index()] *
+                                           cell_diameter * cell_diameter *
+                                           max_residual);
+            return max_viscosity;
+          }
 
+        const double entropy_viscosity = (parameters.stabilization_c_R[advection_field.field_index()] *
+                                          cell_diameter * global_Omega_diameter *
+                                          max_velocity * max_residual /
+                                          (global_u_infty * global_field_variation));
 
         return std::min (max_viscosity, entropy_viscosity);
       }
@@ -251,12 +268,21 @@ namespace aspect
     if (advection_field.is_discontinuous(introspection))
       return;
 
+    // get the range of the field and the maximal velocity in one sweep
+    // over the cells
+    double global_max_velocity = 0;
     const std::pair<double,double>
-    global_field_range = get_extrapolated_advection_field_range (advection_field);
-    const double global_entropy_variation = get_entropy_variation ((global_field_range.first +
-                                                                    global_field_range.second) / 2,
-                                                                   advection_field);
-    const double global_max_velocity = get_maximal_velocity(old_solution);
+    global_field_range = get_extrapolated_advection_field_range (advection_field,
+                                                                 &global_max_velocity);
+    const double average_field = 0.5 * (global_field_range.second + global_field_range.first);
+
+    // the entropy variation used for stabilization_alpha==2 requires an
+    // integral of the entropy over the whole domain. rather than looping
+    // over all cells a second time, we compute the contributions of each
+    // cell in the loop below, and apply the variation to the viscosities
+    // once all cells have been visited
+    const bool need_entropy_variation = (parameters.stabilization_alpha == 2
+                                         && timestep_number > 1);
 
     const UpdateFlags update_flags = update_values |
                                      update_gradients |
@@ -270,197 +296,290 @@ namespace aspect
      */
     const UpdateFlags face_update_flags = update_default;
 
-    internal::Assembly::Scratch::
-    AdvectionSystem<dim> scratch (finite_element,
-                                  finite_element.base_element(advection_field.base_element(introspection)),
-                                  *mapping,
-                                  QGauss<dim>(advection_field.polynomial_degree(introspection)
-                                              +
-                                              (parameters.stokes_velocity_degree+1)/2),
-                                  Quadrature<dim-1> (),
-                                  update_flags,
-                                  face_update_flags,
-                                  introspection.n_compositional_fields,
-                                  advection_field);
-
-    typename DoFHandler<dim>::active_cell_iterator cell = dof_handler.begin_active();
-    for (; cell<dof_handler.end(); ++cell)
-      {
-        // Skip cells for which we can not/do not need to compute the
-        // stabilization. We need to compute the artificial viscosity
-        // on all locally owned cells, but if we want to
-        // smooth/average it over a neighborhood of a locally owned
-        // cell, then we also need it on ghost cells; we could get it
-        // there through parallel communication, but the easier way is
-        // to simply compute it there as well
-        if (cell->is_artificial()
-            ||
-            (cell->is_ghost() &&
-             parameters.use_artificial_viscosity_smoothing == false))
-          {
-            viscosity_per_cell[cell->active_cell_index()] = numbers::signaling_nan<T>();
-            continue;
-          }
-        // Also skip all interior cells if we are asked to do so. Do not
-        // skip neighbor cells of boundary cells if smoothing is on, because
-        // the smoothing uses both the boundary cell and its neighbor.
-        else if (skip_interior_cells && !cell->at_boundary())
-          {
-            bool neighbor_at_boundary = false;
-            for (unsigned int face_no=0; face_no<GeometryInfo<dim>::faces_per_cell; ++face_no)
-              if (cell->neighbor(face_no)->at_boundary() == true)
-                neighbor_at_boundary = true;
-
-            if (parameters.use_artificial_viscosity_smoothing == false ||
-                neighbor_at_boundary == false)
-              {
-                viscosity_per_cell[cell->active_cell_index()] = numbers::signaling_nan<T>();
-                continue;
-              }
-          }
-
-        const unsigned int n_q_points    = scratch.finite_element_values.n_quadrature_points;
+    const internal::Assembly::Scratch::
+    AdvectionSystem<dim> advection_scratch (finite_element,
+                                            finite_element.base_element(advection_field.base_element(introspection)),
+                                            *mapping,
+                                            QGauss<dim>(advection_field.polynomial_degree(introspection)
+                                                        +
+                                                        (parameters.stokes_velocity_degree+1)/2),
+                                            Quadrature<dim-1> (),
+                                            update_flags,
+                                            face_update_flags,
+                                            introspection.n_compositional_fields,
+                                            advection_field);
+
+    const FEValuesExtractors::Scalar solution_field = advection_field.scalar_extractor(introspection);
+
+    auto worker = [&](const typename DoFHandler<dim>::active_cell_iterator &cell,
+                      internal::EntropyViscosity::ScratchData<dim> &scratch_data,
+                      internal::EntropyViscosity::CopyData &data)
+    {
+      internal::Assembly::Scratch::AdvectionSystem<dim> &scratch = scratch_data.advection_scratch;
+
+      data = internal::EntropyViscosity::CopyData();
+      data.active_cell_index = cell->active_cell_index();
+
+      // accumulate the integral, area, and extrema of the entropy over
+      // all locally owned cells, including the ones we skip below
+      if (need_entropy_variation && cell->is_locally_owned())
+        {
+          FEValues<dim> &fe_values = scratch_data.entropy_fe_values;
+          fe_values.reinit (cell);
+          fe_values[solution_field].get_function_values (old_solution,
+                                                         scratch_data.old_field_values);
+          fe_values[solution_field].get_function_values (old_old_solution,
+                                                         scratch_data.old_old_field_values);
+          for (unsigned int q=0; q<fe_values.n_quadrature_points; ++q)
+            {
+              const double field_value = (scratch_data.old_field_values[q] +
+                                          scratch_data.old_old_field_values[q]) / 2;
+              const double entropy = ((field_value-average_field) *
+                                      (field_value-average_field));
 
-        // also have the number of dofs that correspond just to the element for
-        // the system we are currently trying to assemble
-        const unsigned int advection_dofs_per_cell = scratch.phi_field.size();
-        (void)advection_dofs_per_cell;
-        Assert (advection_dofs_per_cell < scratch.finite_element_values.get_fe().dofs_per_cell, ExcInternalError());
-        Assert (scratch.grad_phi_field.size() == advection_dofs_per_cell, ExcInternalError());
-        Assert (scratch.phi_field.size() == advection_dofs_per_cell, ExcInternalError());
+              data.min_entropy = std::min (data.min_entropy, entropy);
+              data.max_entropy = std::max (data.max_entropy, entropy);
 
-        const FEValuesExtractors::Scalar solution_field = advection_field.scalar_extractor(introspection);
+              data.area += fe_values.JxW(q);
+              data.entropy_integrated += fe_values.JxW(q) * entropy;
+            }
+        }
 
-        scratch.finite_element_values.reinit (cell);
+      // Skip cells for which we can not/do not need to compute the
+      // stabilization. We need to compute the artificial viscosity
+      // on all locally owned cells, but if we want to
+      // smooth/average it over a neighborhood of a locally owned
+      // cell, then we also need it on ghost cells; we could get it
+      // there through parallel communication, but the easier way is
+      // to simply compute it there as well
+      if (cell->is_artificial()
+          ||
+          (cell->is_ghost() &&
+           parameters.use_artificial_viscosity_smoothing == false))
+        return;
+      // Also skip all interior cells if we are asked to do so. Do not
+      // skip neighbor cells of boundary cells if smoothing is on, because
+      // the smoothing uses both the boundary cell and its neighbor.
+      else if (skip_interior_cells && !cell->at_boundary())
+        {
+          bool neighbor_at_boundary = false;
+          for (unsigned int face_no=0; face_no<GeometryInfo<dim>::faces_per_cell; ++face_no)
+            if (cell->neighbor(face_no)->at_boundary() == true)
+              neighbor_at_boundary = true;
+
+          if (parameters.use_artificial_viscosity_smoothing == false ||
+              neighbor_at_boundary == false)
+            return;
+        }
 
-        // get all dof indices on the current cell, then extract those
-        // that correspond to the solution_field we are interested in
-        cell->get_dof_indices (scratch.local_dof_indices);
+      const unsigned int n_q_points    = scratch.finite_element_values.n_quadrature_points;
 
-        // initialize all of the scratch fields for further down
-        scratch.finite_element_values[introspection.extractors.temperature].get_function_values (old_solution,
-            scratch.old_temperature_values);
-        scratch.finite_element_values[introspection.extractors.temperature].get_function_values (old_old_solution,
-            scratch.old_old_temperature_values);
+      // also have the number of dofs that correspond just to the element for
+      // the system we are currently trying to assemble
+      const unsigned int advection_dofs_per_cell = scratch.phi_field.size();
+      (void)advection_dofs_per_cell;
+      Assert (advection_dofs_per_cell < scratch.finite_element_values.get_fe().dofs_per_cell, ExcInternalError());
+      Assert (scratch.grad_phi_field.size() == advection_dofs_per_cell, ExcInternalError());
+      Assert (scratch.phi_field.size() == advection_dofs_per_cell, ExcInternalError());
 
-        scratch.finite_element_values[introspection.extractors.velocities].get_function_symmetric_gradients (old_solution,
-            scratch.old_strain_rates);
-        scratch.finite_element_values[introspection.extractors.velocities].get_function_symmetric_gradients (old_old_solution,
-            scratch.old_old_strain_rates);
+      scratch.finite_element_values.reinit (cell);
 
-        scratch.finite_element_values[introspection.extractors.pressure].get_function_values (old_solution,
-            scratch.old_pressure);
-        scratch.finite_element_values[introspection.extractors.pressure].get_function_values (old_old_solution,
-            scratch.old_old_pressure);
+      // get all dof indices on the current cell, then extract those
+      // that correspond to the solution_field we are interested in
+      cell->get_dof_indices (scratch.local_dof_indices);
 
-        for (unsigned int c=0; c<introspection.n_compositional_fields; ++c)
-          {
-            scratch.finite_element_values[introspection.extractors.compositional_fields[c]].get_function_values(old_solution,
-                scratch.old_composition_values[c]);
-            scratch.finite_element_values[introspection.extractors.compositional_fields[c]].get_function_values(old_old_solution,
-                scratch.old_old_composition_values[c]);
-          }
+      // initialize all of the scratch fields for further down
+      scratch.finite_element_values[introspection.extractors.temperature].get_function_values (old_solution,
+          scratch.old_temperature_values);
+      scratch.finite_element_values[introspection.extractors.temperature].get_function_values (old_old_solution,
+          scratch.old_old_temperature_values);
 
-        scratch.finite_element_values[introspection.extractors.velocities].get_function_values (old_solution,
-            scratch.old_velocity_values);
-        scratch.finite_element_values[introspection.extractors.velocities].get_function_values (old_old_solution,
-            scratch.old_old_velocity_values);
-        scratch.finite_element_values[introspection.extractors.velocities].get_function_values(current_linearization_point,
-            scratch.current_velocity_values);
-
-        scratch.finite_element_values[introspection.extractors.pressure].get_function_gradients (old_solution,
-            scratch.old_pressure_gradients);
-        scratch.finite_element_values[introspection.extractors.pressure].get_function_gradients (old_old_solution,
-            scratch.old_old_pressure_gradients);
-
-
-        scratch.old_field_values = (advection_field.is_temperature()
-                                    ?
-                                    scratch.old_temperature_values
-                                    :
-                                    scratch.old_composition_values[advection_field.compositional_variable]);
-        scratch.old_old_field_values = (advection_field.is_temperature()
-                                        ?
-                                        scratch.old_old_temperature_values
-                                        :
-                                        scratch.old_old_composition_values[advection_field.compositional_variable]);
-
-        scratch.finite_element_values[solution_field].get_function_gradients (old_solution,
-                                                                              scratch.old_field_grads);
-        scratch.finite_element_values[solution_field].get_function_gradients (old_old_solution,
-                                                                              scratch.old_old_field_grads);
+      scratch.finite_element_values[introspection.extractors.velocities].get_function_symmetric_gradients (old_solution,
+          scratch.old_strain_rates);
+      scratch.finite_element_values[introspection.extractors.velocities].get_function_symmetric_gradients (old_old_solution,
+          scratch.old_old_strain_rates);
 
-        if (advection_field.is_temperature())
-          {
-            scratch.finite_element_values[solution_field].get_function_laplacians (old_solution,
-                                                                                   scratch.old_field_laplacians);
-            scratch.finite_element_values[solution_field].get_function_laplacians (old_old_solution,
-                                                                                   scratch.old_old_field_laplacians);
-          }
+      scratch.finite_element_values[introspection.extractors.pressure].get_function_values (old_solution,
+          scratch.old_pressure);
+      scratch.finite_element_values[introspection.extractors.pressure].get_function_values (old_old_solution,
+          scratch.old_old_pressure);
 
-        if (parameters.include_melt_transport && melt_handler->is_porosity(advection_field))
-          {
-            scratch.finite_element_values[introspection.extractors.velocities].get_function_divergences (current_linearization_point,
-                scratch.current_velocity_divergences);
-          }
+      for (unsigned int c=0; c<introspection.n_compositional_fields; ++c)
+        {
+          scratch.finite_element_values[introspection.extractors.compositional_fields[c]].get_function_values(old_solution,
+              scratch.old_composition_values[c]);
+          scratch.finite_element_values[introspection.extractors.compositional_fields[c]].get_function_values(old_old_solution,
+              scratch.old_old_composition_values[c]);
+        }
 
-        /**
-         * Explicit material model inputs and outputs.
-         */
-        for (unsigned int q=0; q<n_q_points; ++q)
-          {
-            scratch.material_model_inputs.temperature[q] = (scratch.old_temperature_values[q] + scratch.old_old_temperature_values[q]) / 2;
-            scratch.material_model_inputs.position[q] = scratch.finite_element_values.quadrature_point(q);
-            scratch.material_model_inputs.pressure[q] = (scratch.old_pressure[q] + scratch.old_old_pressure[q]) / 2;
-            scratch.material_model_inputs.velocity[q] = (scratch.old_velocity_values[q] + scratch.old_old_velocity_values[q]) / 2;
-            scratch.material_model_inputs.pressure_gradient[q] = (scratch.old_pressure_gradients[q] + scratch.old_old_pressure_gradients[q]) / 2;
-
-            for (unsigned int c=0; c<introspection.n_compositional_fields; ++c)
-              scratch.material_model_inputs.composition[q][c] = (scratch.old_composition_values[c][q] + scratch.old_old_composition_values[c][q]) / 2;
-            scratch.material_model_inputs.strain_rate[q] = (scratch.old_strain_rates[q] + scratch.old_old_strain_rates[q]) / 2;
-          }
-        scratch.material_model_inputs.current_cell = cell;
+      scratch.finite_element_values[introspection.extractors.velocities].get_function_values (old_solution,
+          scratch.old_velocity_values);
+      scratch.finite_element_values[introspection.extractors.velocities].get_function_values (old_old_solution,
+          scratch.old_old_velocity_values);
+      scratch.finite_element_values[introspection.extractors.velocities].get_function_values(current_linearization_point,
+          scratch.current_velocity_values);
+
+      scratch.finite_element_values[introspection.extractors.pressure].get_function_gradients (old_solution,
+          scratch.old_pressure_gradients);
+      scratch.finite_element_values[introspection.extractors.pressure].get_function_gradients (old_old_solution,
+          scratch.old_old_pressure_gradients);
+
+
+      scratch.old_field_values = (advection_field.is_temperature()
+                                  ?
+                                  scratch.old_temperature_values
+                                  :
+                                  scratch.old_composition_values[advection_field.compositional_variable]);
+      scratch.old_old_field_values = (advection_field.is_temperature()
+                                      ?
+                                      scratch.old_old_temperature_values
+                                      :
+                                      scratch.old_old_composition_values[advection_field.compositional_variable]);
+
+      scratch.finite_element_values[solution_field].get_function_gradients (old_solution,
+                                                                            scratch.old_field_grads);
+      scratch.finite_element_values[solution_field].get_function_gradients (old_old_solution,
+                                                                            scratch.old_old_field_grads);
+
+      if (advection_field.is_temperature())
+        {
+          scratch.finite_element_values[solution_field].get_function_laplacians (old_solution,
+                                                                                 scratch.old_field_laplacians);
+          scratch.finite_element_values[solution_field].get_function_laplacians (old_old_solution,
+                                                                                 scratch.old_old_field_laplacians);
+        }
 
-        for (unsigned int i=0; i<assemblers->advection_system.size(); ++i)
-          assemblers->advection_system[i]->create_additional_material_model_outputs(scratch.material_model_outputs);
-        heating_model_manager.create_additional_material_model_inputs_and_outputs(scratch.material_model_inputs,
-                                                                                  scratch.material_model_outputs);
+      if (parameters.include_melt_transport && melt_handler->is_porosity(advection_field))
+        {
+          scratch.finite_element_values[introspection.extractors.velocities].get_function_divergences (current_linearization_point,
+              scratch.current_velocity_divergences);
+        }
 
-        material_model->fill_additional_material_model_inputs(scratch.material_model_inputs,
-                                                              solution,
-                                                              scratch.finite_element_values,
-                                                              introspection);
-        material_model->evaluate(scratch.material_model_inputs,scratch.material_model_outputs);
+      /**
+       * Explicit material model inputs and outputs.
+       */
+      for (unsigned int q=0; q<n_q_points; ++q)
+        {
+          scratch.material_model_inputs.temperature[q] = (scratch.old_temperature_values[q] + scratch.old_old_temperature_values[q]) / 2;
+          scratch.material_model_inputs.position[q] = scratch.finite_element_values.quadrature_point(q);
+          scratch.material_model_inputs.pressure[q] = (scratch.old_pressure[q] + scratch.old_old_pressure[q]) / 2;
+          scratch.material_model_inputs.velocity[q] = (scratch.old_velocity_values[q] + scratch.old_old_velocity_values[q]) / 2;
+          scratch.material_model_inputs.pressure_gradient[q] = (scratch.old_pressure_gradients[q] + scratch.old_old_pressure_gradients[q]) / 2;
+
+          for (unsigned int c=0; c<introspection.n_compositional_fields; ++c)
+            scratch.material_model_inputs.composition[q][c] = (scratch.old_composition_values[c][q] + scratch.old_old_composition_values[c][q]) / 2;
+          scratch.material_model_inputs.strain_rate[q] = (scratch.old_strain_rates[q] + scratch.old_old_strain_rates[q]) / 2;
+        }
+      scratch.material_model_inputs.current_cell = cell;
+
+      for (unsigned int i=0; i<assemblers->advection_system.size(); ++i)
+        assemblers->advection_system[i]->create_additional_material_model_outputs(scratch.material_model_outputs);
+      heating_model_manager.create_additional_material_model_inputs_and_outputs(scratch.material_model_inputs,
+                                                                                scratch.material_model_outputs);
+
+      material_model->fill_additional_material_model_inputs(scratch.material_model_inputs,
+                                                            solution,
+                                                            scratch.finite_element_values,
+                                                            introspection);
+      // go through the cache of material model evaluations: the same
+      // inputs are evaluated again if this function is called repeatedly
+      // within one time step, e.g., by postprocessors or mesh refinement
+      evaluate_material_model(scratch.material_model_inputs,scratch.material_model_outputs);
+
+      if (parameters.formulation_temperature_equation
+          == Parameters<dim>::Formulation::TemperatureEquation::reference_density_profile)
+        {
+          // Overwrite the density by the reference density coming from the
+          // adiabatic conditions as required by the formulation
+          for (unsigned int q=0; q<n_q_points; ++q)
+            scratch.material_model_outputs.densities[q] = adiabatic_conditions->density(scratch.material_model_inputs.position[q]);
+        }
+      else if (parameters.formulation_temperature_equation
+               == Parameters<dim>::Formulation::TemperatureEquation::real_density)
+        {
+          // use real density
+        }
+      else
+        AssertThrow(false, ExcNotImplemented());
+
+      MaterialModel::MaterialAveraging::average (parameters.material_averaging,
+                                                 cell,
+                                                 scratch.finite_element_values.get_quadrature(),
+                                                 scratch.finite_element_values.get_mapping(),
+                                                 scratch.material_model_outputs);
+
+      data.viscosity_computed = true;
+      data.viscosity = compute_viscosity(scratch,
+                                         global_max_velocity,
+                                         global_field_range.second - global_field_range.first,
+                                         average_field,
+                                         cell->diameter(),
+                                         advection_field,
+                                         data.entropy_viscosity_numerator);
+    };
+
+    // the copier is called in the order of the cells, so the sums below
+    // do not depend on the number of threads
+    Vector<double> entropy_viscosity_numerator (triangulation.n_active_cells());
+    double min_entropy = std::numeric_limits<double>::max(),
+           max_entropy = -std::numeric_limits<double>::max(),
+           area = 0,
+           entropy_integrated = 0;
 
-        if (parameters.formulation_temperature_equation
-            == Parameters<dim>::Formulation::TemperatureEquation::reference_density_profile)
-          {
-            // Overwrite the density by the reference density coming from the
-            // adiabatic conditions as required by the formulation
-            for (unsigned int q=0; q<n_q_points; ++q)
-              scratch.material_model_outputs.densities[q] = adiabatic_conditions->density(scratch.material_model_inputs.position[q]);
-          }
-        else if (parameters.formulation_temperature_equation
-                 == Parameters<dim>::Formulation::TemperatureEquation::real_density)
-          {
-            // use real density
-          }
-        else
-          AssertThrow(false, ExcNotImplemented());
-
-        MaterialModel::MaterialAveraging::average (parameters.material_averaging,
-                                                   cell,
-                                                   scratch.finite_element_values.get_quadrature(),
-                                                   scratch.finite_element_values.get_mapping(),
-                                                   scratch.material_model_outputs);
-
-        viscosity_per_cell[cell->active_cell_index()] = compute_viscosity(scratch,
-                                                                          global_max_velocity,
-                                                                          global_field_range.second - global_field_range.first,
-                                                                          0.5 * (global_field_range.second + global_field_range.first),
-                                                                          global_entropy_variation,
-                                                                          cell->diameter(),
-                                                                          advection_field);
+    auto copier = [&](const internal::EntropyViscosity::CopyData &data)
+    {
+      if (data.viscosity_computed)
+        viscosity_per_cell[data.active_cell_index] = data.viscosity;
+      else
+        viscosity_per_cell[data.active_cell_index] = numbers::signaling_nan<T>();
+      entropy_viscosity_numerator[data.active_cell_index] = data.entropy_viscosity_numerator;
+
+      min_entropy = std::min (min_entropy, data.min_entropy);
+      max_entropy = std::max (max_entropy, data.max_entropy);
+      area += data.area;
+      entropy_integrated += data.entropy_integrated;
+    };
+
+    WorkStream::
+    run (dof_handler.begin_active(),
+         dof_handler.end(),
+         worker,
+         copier,
+         internal::EntropyViscosity::
+         ScratchData<dim> (advection_scratch,
+                           finite_element,
+                           QGauss<dim>(advection_field.polynomial_degree(introspection)+1)),
+         internal::EntropyViscosity::CopyData());
+
+    if (need_entropy_variation)
+      {
+        // do MPI data exchange: we need to sum over
+        // the two integrals (area,
+        // entropy_integrated), and get the extrema
+        // for maximum and minimum. combine
+        // MPI_Allreduce for two values since that is
+        // an expensive operation
+        const double local_for_sum[2] = { entropy_integrated, area },
+                                        local_for_max[2] = { -min_entropy, max_entropy };
+        double global_for_sum[2], global_for_max[2];
+
+        dealii::Utilities::MPI::sum (local_for_sum, mpi_communicator, global_for_sum);
+        dealii::Utilities::MPI::max (local_for_max, mpi_communicator, global_for_max);
+
+        const double average_entropy = global_for_sum[0] / global_for_sum[1];
+
+        // the maximal deviation of the entropy everywhere from the
+        // average value
+        const double global_entropy_variation = std::max(global_for_max[1] - average_entropy,
+                                                         average_entropy - (-global_for_max[0]));
+
+        // we can not divide by the entropy_variation if it is zero, in
+        // which case the viscosity stays at its maximal value
+        if (std::abs(global_entropy_variation) >= 1e-50)
+          for (unsigned int i=0; i<entropy_viscosity_numerator.size(); ++i)
+            if (entropy_viscosity_numerator[i] >= 0)
+              viscosity_per_cell[i] = std::min (static_cast<double>(viscosity_per_cell[i]),
+                                                entropy_viscosity_numerator[i] / global_entropy_variation);
       }
 
     // if set to true, the maximum of the artificial viscosity in the cell as well
@@ -49,8 +49,8 @@ namespace aspect
     execute (internal::Assembly::Scratch::ScratchBase<dim>       &scratch_base,
              internal::Assembly::CopyData::CopyDataBase<dim>      &data_base) const
     {
-      internal::Assembly::Scratch::StokesSystem<dim> &scratch = dynamic_cast<internal::Assembly::Scratch::StokesSystem<dim>& > (scratch_base);
-      internal::Assembly::CopyData::StokesSystem<dim> &data = dynamic_cast<internal::Assembly::CopyData::StokesSystem<dim>& > (data_base);
+      internal::Assembly::Scratch::StokesSystem<dim> &scratch = internal::Assembly::checked_cast<internal::Assembly::Scratch::StokesSystem<dim>> (scratch_base);
+      internal::Assembly::CopyData::StokesSystem<dim> &data = internal::Assembly::checked_cast<internal::Assembly::CopyData::StokesSystem<dim>> (data_base);
 
       if (!this->get_parameters().free_surface_enabled)
         return;
@@ -65,7 +65,6 @@ namespace aspect
         }
 
       const Introspection<dim> &introspection = this->introspection();
-      const FiniteElement<dim> &fe = this->get_fe();
 
       const typename DoFHandler<dim>::active_cell_iterator cell (&this->get_triangulation(),
                                                                  scratch.finite_element_values.get_cell()->level(),
@@ -99,14 +98,10 @@ namespace aspect
 
               for (unsigned int q_point = 0; q_point < n_face_q_points; ++q_point)
                 {
-                  for (unsigned int i = 0, i_stokes = 0; i_stokes < stokes_dofs_per_cell; /*increment at end of loop*/)
+                  for (unsigned int i_stokes = 0; i_stokes < stokes_dofs_per_cell; ++i_stokes)
                     {
-                      if (introspection.is_stokes_component(fe.system_to_component_index(i).first))
-                        {
-                          scratch.phi_u[i_stokes] = scratch.face_finite_element_values[introspection.extractors.velocities].value(i, q_point);
-                          ++i_stokes;
-                        }
-                      ++i;
+                      const unsigned int i = introspection.stokes_shape_function_indices[i_stokes];
+                      scratch.phi_u[i_stokes] = scratch.face_finite_element_values[introspection.extractors.velocities].value(i, q_point);
                     }
 
                   const Tensor<1,dim>
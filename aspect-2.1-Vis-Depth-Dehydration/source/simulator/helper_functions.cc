@@ -21,6 +21,7 @@
 
 #include <aspect/simulator.h>
 #include <aspect/melt.h>
+#include <aspect/stokes_matrix_free.h>
 #include <aspect/volume_of_fluid/handler.h>
 #include <aspect/newton.h>
 #include <aspect/global.h>
@@ -40,6 +41,7 @@
 #include <deal.II/base/conditional_ostream.h>
 #include <deal.II/base/quadrature_lib.h>
 #include <deal.II/base/signaling_nan.h>
+#include <deal.II/base/work_stream.h>
 #include <deal.II/lac/block_sparsity_pattern.h>
 #include <deal.II/grid/grid_tools.h>
 
@@ -63,6 +65,8 @@
 #include <iomanip>
 #include <locale>
 #include <string>
+#include <sstream>
+#include <algorithm>
 
 
 namespace aspect
@@ -223,6 +227,131 @@ namespace aspect
       // delete the copy now:
       delete copy_of_table;
     }
+
+
+
+    /**
+     * A function that writes rows of the statistics object that have
+     * already been formatted into a file.
+     *
+     * @param stat_file_name The name of the file into which the result
+     * should go
+     * @param text The formatted rows, deleted at the end of this function.
+     * @param rewrite Whether @p text contains the whole file (including
+     * the column descriptions), or only rows that are to be appended to
+     * the file.
+     */
+    // We need to pass the arguments by value, as this function can be called on a separate thread:
+    void do_append_statistics (const std::string stat_file_name, //NOLINT(performance-unnecessary-value-param)
+                               const std::string *text,
+                               const bool rewrite)
+    {
+      if (rewrite)
+        {
+          // as above, write into a temporary file first
+          const std::string tmp_file_name = stat_file_name + " tmp";
+          std::ofstream stat_file (tmp_file_name.c_str());
+          stat_file << *text;
+          stat_file.close();
+          std::rename(tmp_file_name.c_str(), stat_file_name.c_str());
+        }
+      else
+        {
+          std::ofstream stat_file (stat_file_name.c_str(), std::ios::app);
+          stat_file << *text;
+        }
+
+      delete text;
+    }
+
+
+
+    /**
+     * TableHandler::write_text() can only write the whole table. This
+     * class formats the column descriptions and a range of rows of a
+     * table in the same way as the TableHandler::simple_table_with_separate_column_description
+     * format, so that new rows can be appended to a file without
+     * formatting the rows that are already in it. It derives from
+     * TableHandler only to be allowed to access the columns of a table.
+     */
+    class StatisticsTableFormatter : public TableHandler
+    {
+      public:
+        /**
+         * Return the descriptions of the columns of @p table, one line
+         * per column.
+         */
+        static
+        std::string
+        format_header (const TableHandler &table)
+        {
+          std::vector<std::string> column_keys;
+          (table.*(&StatisticsTableFormatter::get_selected_columns))(column_keys);
+
+          std::ostringstream header;
+          for (unsigned int j=0; j<column_keys.size(); ++j)
+            header << "# " << j+1 << ": " << column_keys[j] << '\n';
+          return header.str();
+        }
+
+        /**
+         * Return the number of rows of @p table.
+         */
+        static
+        unsigned int
+        n_rows (const TableHandler &table)
+        {
+          unsigned int n = 0;
+          for (const auto &column : table.*(&StatisticsTableFormatter::columns))
+            n = std::max (n, static_cast<unsigned int>(column.second.entries.size()));
+          return n;
+        }
+
+        /**
+         * Return the rows with indices @p first_row to @p end_row - 1 of
+         * @p table, one line per row.
+         */
+        static
+        std::string
+        format_rows (const TableHandler &table,
+                     const unsigned int first_row,
+                     const unsigned int end_row)
+        {
+          const auto &table_columns = table.*(&StatisticsTableFormatter::columns);
+
+          std::vector<std::string> column_keys;
+          (table.*(&StatisticsTableFormatter::get_selected_columns))(column_keys);
+
+          std::ostringstream rows;
+          for (unsigned int i=first_row; i<end_row; ++i)
+            {
+              for (unsigned int j=0; j<column_keys.size(); ++j)
+                {
+                  const auto &column = table_columns.find(column_keys[j])->second;
+
+                  // a column that did not get a value in the last row yet
+                  // is padded like write_text() does it
+                  const dealii::internal::TableEntry entry = (i < column.entries.size()
+                                                      ?
+                                                      column.entries[i]
+                                                      :
+                                                      column.entries.back().get_default_constructed_copy());
+                  entry.cache_string (column.scientific, column.precision);
+
+                  // keep the number of columns of each row the same
+                  if (entry.get_cached_string().size() == 0)
+                    rows << "\"\"";
+                  else
+                    rows << entry.get_cached_string();
+
+                  if (j+1 < column_keys.size())
+                    rows << ' ';
+                }
+              rows << '\n';
+            }
+          return rows.str();
+        }
+    };
   }
 
 
@@ -310,9 +439,107 @@ namespace aspect
     // make sure that the previous thread is done or they'll
     // stomp on each other's feet
     output_statistics_thread.join();
-    output_statistics_thread = Threads::new_thread (&do_output_statistics,
+
+    if (parameters.append_to_output_files == false)
+      {
+        output_statistics_thread = Threads::new_thread (&do_output_statistics,
+                                                        parameters.output_directory+"statistics",
+                                                        new TableHandler(statistics));
+        return;
+      }
+
+    // If we only append to the file, only format the rows that are not in
+    // the file yet, rather than copying and formatting the whole table. The
+    // whole file is only rewritten if the columns changed (or the file has
+    // not been written yet in this run).
+    const std::string header = StatisticsTableFormatter::format_header (statistics);
+    const unsigned int n_rows = StatisticsTableFormatter::n_rows (statistics);
+    const bool rewrite = (header != statistics_file_header
+                          ||
+                          n_rows < n_statistics_rows_written);
+
+    std::string *text = new std::string (rewrite ? header : std::string());
+    *text += StatisticsTableFormatter::format_rows (statistics,
+                                                   (rewrite ? 0 : n_statistics_rows_written),
+                                                   n_rows);
+
+    statistics_file_header = header;
+    n_statistics_rows_written = n_rows;
+
+    output_statistics_thread = Threads::new_thread (&do_append_statistics,
                                                     parameters.output_directory+"statistics",
-                                                    new TableHandler(statistics));
+                                                    text,
+                                                    rewrite);
+  }
+
+
+
+  template <int dim>
+  void Simulator<dim>::prepare_measured_cost_cell_weights()
+  {
+    double local_cost = 0;
+    for (const auto &cell : triangulation.active_cell_iterators())
+      if (cell->is_locally_owned())
+        local_cost += measured_cell_costs(cell->active_cell_index());
+
+    const double global_cost = Utilities::MPI::sum (local_cost, mpi_communicator);
+    const double max_cost = Utilities::MPI::max (local_cost, mpi_communicator);
+    const double min_cost = Utilities::MPI::min (local_cost, mpi_communicator);
+    const double average_cost = global_cost / Utilities::MPI::n_mpi_processes(mpi_communicator);
+
+    // if nothing has been measured yet (e.g., during initial refinement
+    // before the first assembly), do not add any weights
+    if (global_cost == 0)
+      {
+        measured_cost_to_cell_weight = 0.;
+        return;
+      }
+
+    // scale the weights so that a cell with the average cost gets the
+    // weight given in the input file
+    measured_cost_to_cell_weight = parameters.measured_cell_cost_weight
+                                   * triangulation.n_global_active_cells()
+                                   / global_cost;
+
+    const double imbalance = max_cost / average_cost;
+    statistics.add_value ("Assembly time imbalance (max/average)", imbalance);
+    statistics.set_precision ("Assembly time imbalance (max/average)", 3);
+
+    pcout << "   Measured assembly time per process (min/average/max): "
+          << min_cost << "/" << average_cost << "/" << max_cost
+          << " s, imbalance: " << imbalance << std::endl;
+  }
+
+
+
+  template <int dim>
+  unsigned int
+  Simulator<dim>::measured_cost_cell_weight (const typename parallel::distributed::Triangulation<dim>::cell_iterator &cell,
+                                             const typename parallel::distributed::Triangulation<dim>::CellStatus status) const
+  {
+    if (measured_cost_to_cell_weight == 0.)
+      return 0;
+
+    if (cell->active() && !cell->is_locally_owned())
+      return 0;
+
+    double cost = 0;
+    if (status == parallel::distributed::Triangulation<dim>::CELL_PERSIST)
+      cost = measured_cell_costs(cell->active_cell_index());
+    else if (status == parallel::distributed::Triangulation<dim>::CELL_REFINE)
+      {
+        // the cost of the cell is split between its future children
+        cost = measured_cell_costs(cell->active_cell_index()) / GeometryInfo<dim>::max_children_per_cell;
+      }
+    else if (status == parallel::distributed::Triangulation<dim>::CELL_COARSEN)
+      {
+        for (unsigned int child_index = 0; child_index < GeometryInfo<dim>::max_children_per_cell; ++child_index)
+          cost += measured_cell_costs(cell->child(child_index)->active_cell_index());
+      }
+    else
+      Assert (false, ExcInternalError());
+
+    return static_cast<unsigned int>(std::round(cost * measured_cost_to_cell_weight));
   }
 
 
@@ -563,7 +790,7 @@ namespace aspect
                         introspection,
                         solution);
 
-              material_model->evaluate(in, out);
+              evaluate_material_model(in, out);
 
 
               // Evaluate thermal diffusivity at each quadrature point and
@@ -632,7 +859,8 @@ namespace aspect
   template <int dim>
   std::pair<double,double>
   Simulator<dim>::
-  get_extrapolated_advection_field_range (const AdvectionField &advection_field) const
+  get_extrapolated_advection_field_range (const AdvectionField &advection_field,
+                                          double *maximal_old_velocity) const
   {
     const QIterated<dim> quadrature_formula (QTrapez<1>(),
                                              advection_field.polynomial_degree(introspection));
@@ -646,6 +874,17 @@ namespace aspect
     std::vector<double> old_field_values(n_q_points);
     std::vector<double> old_old_field_values(n_q_points);
 
+    // if requested, also evaluate the old velocity in the same loop, on the
+    // same points as get_maximal_velocity() does
+    const QIterated<dim> velocity_quadrature_formula (QTrapez<1>(),
+                                                      parameters.stokes_velocity_degree);
+    std::unique_ptr<FEValues<dim> > velocity_fe_values;
+    if (maximal_old_velocity != nullptr)
+      velocity_fe_values = std_cxx14::make_unique<FEValues<dim> > (*mapping, finite_element,
+                                                                   velocity_quadrature_formula,
+                                                                   update_values);
+    std::vector<Tensor<1,dim> > velocity_values(velocity_quadrature_formula.size());
+
     // This presets the minimum with a bigger
     // and the maximum with a smaller number
     // than one that is going to appear. Will
@@ -653,19 +892,21 @@ namespace aspect
     // the communication step at the
     // latest.
     double min_local_field = std::numeric_limits<double>::max(),
-           max_local_field = -std::numeric_limits<double>::max();
+           max_local_field = -std::numeric_limits<double>::max(),
+           max_local_velocity = 0;
 
-    if (timestep_number > 1)
-      {
-        typename DoFHandler<dim>::active_cell_iterator
-        cell = dof_handler.begin_active(),
-        endc = dof_handler.end();
-        for (; cell!=endc; ++cell)
-          if (cell->is_locally_owned())
+    typename DoFHandler<dim>::active_cell_iterator
+    cell = dof_handler.begin_active(),
+    endc = dof_handler.end();
+    for (; cell!=endc; ++cell)
+      if (cell->is_locally_owned())
+        {
+          fe_values.reinit (cell);
+          fe_values[field].get_function_values (old_solution,
+                                                old_field_values);
+
+          if (timestep_number > 1)
             {
-              fe_values.reinit (cell);
-              fe_values[field].get_function_values (old_solution,
-                                                    old_field_values);
               fe_values[field].get_function_values (old_old_solution,
                                                     old_old_field_values);
 
@@ -681,19 +922,8 @@ namespace aspect
                                               extrapolated_field);
                 }
             }
-      }
-    else
-      {
-        typename DoFHandler<dim>::active_cell_iterator
-        cell = dof_handler.begin_active(),
-        endc = dof_handler.end();
-        for (; cell!=endc; ++cell)
-          if (cell->is_locally_owned())
+          else
             {
-              fe_values.reinit (cell);
-              fe_values[field].get_function_values (old_solution,
-                                                    old_field_values);
-
               for (unsigned int q=0; q<n_q_points; ++q)
                 {
                   const double extrapolated_field = old_field_values[q];
@@ -704,12 +934,29 @@ namespace aspect
                                               extrapolated_field);
                 }
             }
-      }
 
-    return std::make_pair(Utilities::MPI::min (min_local_field,
-                                               mpi_communicator),
-                          Utilities::MPI::max (max_local_field,
-                                               mpi_communicator));
+          if (maximal_old_velocity != nullptr)
+            {
+              velocity_fe_values->reinit (cell);
+              (*velocity_fe_values)[introspection.extractors.velocities].get_function_values (old_solution,
+                  velocity_values);
+
+              for (unsigned int q=0; q<velocity_values.size(); ++q)
+                max_local_velocity = std::max (max_local_velocity,
+                                               velocity_values[q].norm());
+            }
+        }
+
+    // combine all extrema into a single MPI reduction
+    const double local_for_max[3] = { -min_local_field, max_local_field, max_local_velocity };
+    double global_for_max[3];
+    Utilities::MPI::max (local_for_max, mpi_communicator, global_for_max);
+
+    if (maximal_old_velocity != nullptr)
+      *maximal_old_velocity = global_for_max[2];
+
+    return std::make_pair(-global_for_max[0],
+                          global_for_max[1]);
   }
 
 
@@ -1183,6 +1430,11 @@ namespace aspect
   double
   Simulator<dim>::compute_initial_stokes_residual()
   {
+    // the matrix-free solver does not assemble the Stokes blocks of
+    // the system matrix, but it can apply the Stokes operator
+    if (stokes_matrix_free)
+      return stokes_matrix_free->compute_initial_stokes_residual();
+
     LinearAlgebra::BlockVector linearized_stokes_variables (introspection.index_sets.stokes_partitioning, mpi_communicator);
     LinearAlgebra::BlockVector residual (introspection.index_sets.stokes_partitioning, mpi_communicator);
     const unsigned int block_p =
@@ -1508,6 +1760,94 @@ namespace aspect
 
 
 
+  namespace
+  {
+    /**
+     * A set of support points on one cell at which the reactions are
+     * computed in Simulator::compute_reactions(): the cell, whether these
+     * are the support points of the temperature element or of the element
+     * of the compositional fields (or both, if they coincide), and the
+     * indices of those support points for which this cell is responsible.
+     */
+    template <int dim>
+    struct ReactionPointSet
+    {
+      typename DoFHandler<dim>::active_cell_iterator cell;
+      bool                                           temperature_points;
+      bool                                           composition_points;
+      std::vector<unsigned int>                      support_points;
+    };
+
+
+
+    /**
+     * Scratch data for the loop over the batches of support points in
+     * Simulator::compute_reactions().
+     */
+    template <int dim>
+    struct ReactionScratchData
+    {
+      ReactionScratchData (const Mapping<dim>       &mapping,
+                           const FiniteElement<dim> &finite_element,
+                           const Quadrature<dim>    &quadrature_C,
+                           const Quadrature<dim>    &quadrature_T);
+
+      ReactionScratchData (const ReactionScratchData &scratch);
+
+      FEValues<dim> fe_values_C;
+      FEValues<dim> fe_values_T;
+    };
+
+
+
+    template <int dim>
+    ReactionScratchData<dim>::
+    ReactionScratchData (const Mapping<dim>       &mapping,
+                         const FiniteElement<dim> &finite_element,
+                         const Quadrature<dim>    &quadrature_C,
+                         const Quadrature<dim>    &quadrature_T)
+      :
+      fe_values_C (mapping, finite_element, quadrature_C,
+                   update_quadrature_points | update_values | update_gradients),
+      fe_values_T (mapping, finite_element, quadrature_T,
+                   update_quadrature_points | update_values | update_gradients)
+    {}
+
+
+
+    template <int dim>
+    ReactionScratchData<dim>::
+    ReactionScratchData (const ReactionScratchData &scratch)
+      :
+      fe_values_C (scratch.fe_values_C.get_mapping(),
+                   scratch.fe_values_C.get_fe(),
+                   scratch.fe_values_C.get_quadrature(),
+                   scratch.fe_values_C.get_update_flags()),
+      fe_values_T (scratch.fe_values_T.get_mapping(),
+                   scratch.fe_values_T.get_fe(),
+                   scratch.fe_values_T.get_quadrature(),
+                   scratch.fe_values_T.get_update_flags())
+    {}
+
+
+
+    /**
+     * The result of one batch of support points: the global indices of
+     * the degrees of freedom that are updated, their new values, their
+     * accumulated change by the reactions, and the largest number of
+     * reaction time steps any of the points needed.
+     */
+    struct ReactionCopyData
+    {
+      std::vector<types::global_dof_index> dof_indices;
+      std::vector<double>                  new_values;
+      std::vector<double>                  reaction_changes;
+      unsigned int                         max_reaction_steps;
+    };
+  }
+
+
+
   template <int dim>
   void Simulator<dim>::compute_reactions ()
   {
@@ -1533,166 +1873,457 @@ namespace aspect
     Assert (reaction_time_step_size > 0,
             ExcMessage("Reaction time step must be greater than 0."));
 
-    pcout << "   Solving composition reactions in "
-          << number_of_reaction_steps
-          << " substep(s)."
-          << std::endl;
+    // with the adaptive scheme, the step size above is only the initial one
+    const bool adaptive_time_stepping
+      = (parameters.reaction_solver_type == Parameters<dim>::ReactionSolverType::adaptive_runge_kutta);
 
-    // make one fevalues for the composition, and one for the temperature (they might use different finite elements)
-    const Quadrature<dim> quadrature_C(dof_handler.get_fe().base_element(introspection.base_elements.compositional_fields).get_unit_support_points());
+    if (adaptive_time_stepping == false)
+      pcout << "   Solving composition reactions in "
+            << number_of_reaction_steps
+            << " substep(s)."
+            << std::endl;
 
-    FEValues<dim> fe_values_C (*mapping,
-                               dof_handler.get_fe(),
-                               quadrature_C,
-                               update_quadrature_points | update_values | update_gradients);
+    const unsigned int n_compositional_fields = introspection.n_compositional_fields;
 
-    std::vector<types::global_dof_index> local_dof_indices (dof_handler.get_fe().dofs_per_cell);
-    MaterialModel::MaterialModelInputs<dim> in_C(quadrature_C.size(), introspection.n_compositional_fields);
-    MaterialModel::MaterialModelOutputs<dim> out_C(quadrature_C.size(), introspection.n_compositional_fields);
-    HeatingModel::HeatingModelOutputs heating_model_outputs_C(quadrature_C.size(), introspection.n_compositional_fields);
+    // the state of the ordinary differential equation at every support point consists
+    // of the temperature followed by all compositional fields
+    const unsigned int n_fields = 1 + n_compositional_fields;
 
-    // temperature element
+    // the support points of the composition and of the temperature element (they might
+    // use different finite elements)
+    const Quadrature<dim> quadrature_C(dof_handler.get_fe().base_element(introspection.base_elements.compositional_fields).get_unit_support_points());
     const Quadrature<dim> quadrature_T(dof_handler.get_fe().base_element(introspection.base_elements.temperature).get_unit_support_points());
 
-    FEValues<dim> fe_values_T (*mapping,
-                               dof_handler.get_fe(),
-                               quadrature_T,
-                               update_quadrature_points | update_values | update_gradients);
+    // if both elements have the same support points, the reactions of the temperature and
+    // of the compositional fields at a point are the same ordinary differential equation,
+    // and we only need to solve it once
+    const bool shared_support_points = (quadrature_C.get_points() == quadrature_T.get_points());
 
-    MaterialModel::MaterialModelInputs<dim> in_T(quadrature_T.size(), introspection.n_compositional_fields);
-    MaterialModel::MaterialModelOutputs<dim> out_T(quadrature_T.size(), introspection.n_compositional_fields);
-    HeatingModel::HeatingModelOutputs heating_model_outputs_T(quadrature_T.size(), introspection.n_compositional_fields);
-
-    // add reaction rate outputs
-    material_model->create_additional_named_outputs(out_C);
-    material_model->create_additional_named_outputs(out_T);
+    // check that the material model supports operator splitting, and find out whether
+    // the heating models need additional inputs. those can only be computed from the
+    // finite element values on a single cell
+    bool need_cell_inputs = false;
+    {
+      MaterialModel::MaterialModelInputs<dim> in(1, n_compositional_fields);
+      MaterialModel::MaterialModelOutputs<dim> out(1, n_compositional_fields);
+      material_model->create_additional_named_outputs(out);
+
+      AssertThrow(out.template get_additional_output<MaterialModel::ReactionRateOutputs<dim> >() != nullptr,
+                  ExcMessage("You are trying to use the operator splitting solver scheme, "
+                             "but the material model you use does not support operator splitting "
+                             "(it does not create ReactionRateOutputs, which are required for this "
+                             "solver scheme)."));
+
+      heating_model_manager.create_additional_material_model_inputs_and_outputs(in, out);
+      need_cell_inputs = (in.additional_inputs.size() > 0);
+    }
 
-    MaterialModel::ReactionRateOutputs<dim> *reaction_rate_outputs_C
-      = out_C.template get_additional_output<MaterialModel::ReactionRateOutputs<dim> >();
+    // The reactions only depend on the temperature and composition values at a given
+    // degree of freedom, and are independent of the solution in other points. We
+    // therefore assign every locally owned node to exactly one of the cells it belongs
+    // to, and then solve the reactions at the nodes of many cells at once, so that the
+    // material and heating models are evaluated for large batches of points instead of
+    // a few points per cell. The batches are processed in parallel.
+    //
+    // Nodes are identified by the degree of freedom of the temperature (or of the first
+    // compositional field) that is located there; all fields at one support point are
+    // owned by the same process. If the heating models need additional inputs, these
+    // have to be computed from the finite element values of a cell, so in that case
+    // every batch consists of all support points of a single cell, and we only write
+    // back the locally owned degrees of freedom (which get the same value from every
+    // cell they belong to).
+    const unsigned int dofs_per_cell = dof_handler.get_fe().dofs_per_cell;
+    const IndexSet &locally_owned_dofs = dof_handler.locally_owned_dofs();
+    std::vector<bool> node_assigned (locally_owned_dofs.n_elements(), false);
+    std::vector<types::global_dof_index> local_dof_indices (dofs_per_cell);
+
+    // the number of points per batch we aim for
+    const unsigned int target_batch_size = 1024;
+
+    std::vector<std::vector<ReactionPointSet<dim> > > batches (1);
+    unsigned int points_in_current_batch = 0;
+
+    auto add_point_set = [&] (const typename DoFHandler<dim>::active_cell_iterator &cell,
+                              const bool temperature_points,
+                              const bool composition_points)
+    {
+      const unsigned int n_support_points = (temperature_points ? quadrature_T.size() : quadrature_C.size());
+      const unsigned int key_component = (temperature_points
+                                          ?
+                                          introspection.component_indices.temperature
+                                          :
+                                          introspection.component_indices.compositional_fields[0]);
+
+      ReactionPointSet<dim> point_set;
+      point_set.cell = cell;
+      point_set.temperature_points = temperature_points;
+      point_set.composition_points = composition_points;
+
+      for (unsigned int j=0; j<n_support_points; ++j)
+        {
+          const types::global_dof_index key_dof
+            = local_dof_indices[dof_handler.get_fe().component_to_system_index(key_component, j)];
 
-    MaterialModel::ReactionRateOutputs<dim> *reaction_rate_outputs_T
-      = out_T.template get_additional_output<MaterialModel::ReactionRateOutputs<dim> >();
+          if (need_cell_inputs)
+            point_set.support_points.push_back(j);
+          else if (locally_owned_dofs.is_element(key_dof))
+            {
+              const unsigned int node = locally_owned_dofs.index_within_set(key_dof);
+              if (node_assigned[node] == false)
+                {
+                  node_assigned[node] = true;
+                  point_set.support_points.push_back(j);
+                }
+            }
+        }
 
-    AssertThrow(reaction_rate_outputs_C != nullptr && reaction_rate_outputs_T != nullptr,
-                ExcMessage("You are trying to use the operator splitting solver scheme, "
-                           "but the material model you use does not support operator splitting "
-                           "(it does not create ReactionRateOutputs, which are required for this "
-                           "solver scheme)."));
+      if (point_set.support_points.size() == 0)
+        return;
 
-    // some heating models require the additional outputs
-    heating_model_manager.create_additional_material_model_inputs_and_outputs(in_C, out_C);
-    heating_model_manager.create_additional_material_model_inputs_and_outputs(in_T, out_T);
+      if (points_in_current_batch > 0
+          &&
+          (need_cell_inputs
+           || points_in_current_batch + point_set.support_points.size() > target_batch_size))
+        {
+          batches.emplace_back();
+          points_in_current_batch = 0;
+        }
 
-    // Make a loop first over all cells, than over all reaction time steps, and then over
-    // all degrees of freedom in each element to compute the reactions. This is possible
-    // because the reactions only depend on the temperature and composition values at a given
-    // degree of freedom (and are independent of the solution in other points).
+      points_in_current_batch += point_set.support_points.size();
+      batches.back().push_back(point_set);
+    };
 
-    // Note that the values for some degrees of freedom are set more than once in the loop
-    // below where we assign the new values to distributed_vector (if they are located on the
-    // interface between cells), as we loop over all cells, and then over all degrees of freedom
-    // on each cell. Although this means we do some additional work, the results are still
-    // correct, as we never read from distributed_vector inside the loop over all cells.
-    // We initialize the material model inputs objects in_T and in_C using the solution vector
-    // on every cell, compute the update, and then on every cell put the result into the
-    // distributed_vector vector. Only after the loop over all cells do we copy distributed_vector
-    // back onto the solution vector.
-    // So even though we touch some DoF more than once, we always start from the same value, compute the
-    // same value, and then overwrite the same value in distributed_vector.
-    // TODO: make this more effective
-    typename DoFHandler<dim>::active_cell_iterator cell = dof_handler.begin_active(),
-                                                   endc = dof_handler.end();
-    for (; cell!=endc; ++cell)
+    for (const auto &cell : dof_handler.active_cell_iterators())
       if (cell->is_locally_owned())
         {
-          fe_values_C.reinit (cell);
           cell->get_dof_indices (local_dof_indices);
-          in_C.reinit(fe_values_C, cell, introspection, solution);
 
-          fe_values_T.reinit (cell);
-          in_T.reinit(fe_values_T, cell, introspection, solution);
+          if (shared_support_points)
+            add_point_set (cell, true, n_compositional_fields > 0);
+          else
+            {
+              if (n_compositional_fields > 0)
+                add_point_set (cell, false, true);
+              add_point_set (cell, true, false);
+            }
+        }
+
+    if (batches.back().size() == 0)
+      batches.pop_back();
+
+    auto worker = [&](const typename std::vector<std::vector<ReactionPointSet<dim> > >::const_iterator &batch,
+                      ReactionScratchData<dim> &scratch,
+                      ReactionCopyData &data)
+    {
+      unsigned int n_points = 0;
+      for (unsigned int s=0; s<batch->size(); ++s)
+        n_points += (*batch)[s].support_points.size();
+
+      // Collect the inputs of the material model at all points of the batch, and the
+      // degrees of freedom we have to update. The reactions do not change any inputs
+      // other than temperature and composition, so we only need to do this once.
+      MaterialModel::MaterialModelInputs<dim> batch_in(n_points, n_compositional_fields);
+      std::vector<double> initial_state (n_points * n_fields);
+
+      data.dof_indices.clear();
+      data.new_values.clear();
+      data.reaction_changes.clear();
+      data.max_reaction_steps = 0;
+
+      // for every degree of freedom in the copy data, the entry of the state vector
+      // it is taken from
+      std::vector<unsigned int> state_index;
+
+      std::vector<types::global_dof_index> cell_dof_indices (dofs_per_cell);
+      FEValues<dim> *fe_values = nullptr;
+
+      unsigned int p = 0;
+      for (unsigned int s=0; s<batch->size(); ++s)
+        {
+          const ReactionPointSet<dim> &point_set = (*batch)[s];
+
+          fe_values = (point_set.temperature_points ? &scratch.fe_values_T : &scratch.fe_values_C);
+          fe_values->reinit (point_set.cell);
+          point_set.cell->get_dof_indices (cell_dof_indices);
 
-          std::vector<std::vector<double> > accumulated_reactions_C (quadrature_C.size(),std::vector<double> (introspection.n_compositional_fields));
-          std::vector<double> accumulated_reactions_T (quadrature_T.size());
+          const MaterialModel::MaterialModelInputs<dim> cell_in(*fe_values, point_set.cell, introspection, solution);
 
-          // Make the reaction time steps: We have to update the values of compositional fields and the temperature.
-          // Because temperature and composition might use different finite elements, we loop through their elements
-          // separately, and update the temperature and the compositions for both.
-          // We can reuse the same material model inputs and outputs structure for each reaction time step.
-          // We store the computed updates to temperature and composition in a separate (accumulated_reactions) vector,
-          // so that we can later copy it over to the solution vector.
-          for (unsigned int i=0; i<number_of_reaction_steps; ++i)
+          for (unsigned int i=0; i<point_set.support_points.size(); ++i, ++p)
             {
-              // Loop over composition element
-              material_model->fill_additional_material_model_inputs(in_C, solution, fe_values_C, introspection);
+              const unsigned int j = point_set.support_points[i];
 
-              material_model->evaluate(in_C, out_C);
-              heating_model_manager.evaluate(in_C, out_C, heating_model_outputs_C);
+              batch_in.position[p] = cell_in.position[j];
+              batch_in.pressure[p] = cell_in.pressure[j];
+              batch_in.pressure_gradient[p] = cell_in.pressure_gradient[j];
+              batch_in.velocity[p] = cell_in.velocity[j];
+              batch_in.strain_rate[p] = cell_in.strain_rate[j];
 
-              for (unsigned int j=0; j<dof_handler.get_fe().base_element(introspection.base_elements.compositional_fields).dofs_per_cell; ++j)
+              initial_state[p*n_fields] = cell_in.temperature[j];
+              for (unsigned int c=0; c<n_compositional_fields; ++c)
+                initial_state[p*n_fields+1+c] = cell_in.composition[j][c];
+
+              if (point_set.temperature_points)
                 {
-                  for (unsigned int c=0; c<introspection.n_compositional_fields; ++c)
+                  const types::global_dof_index dof
+                    = cell_dof_indices[dof_handler.get_fe().component_to_system_index(introspection.component_indices.temperature, j)];
+                  if (locally_owned_dofs.is_element(dof))
                     {
-                      // simple forward euler
-                      in_C.composition[j][c] = in_C.composition[j][c]
-                                               + reaction_time_step_size * reaction_rate_outputs_C->reaction_rates[j][c];
-                      accumulated_reactions_C[j][c] += reaction_time_step_size * reaction_rate_outputs_C->reaction_rates[j][c];
+                      data.dof_indices.push_back(dof);
+                      state_index.push_back(p*n_fields);
                     }
-                  in_C.temperature[j] = in_C.temperature[j]
-                                        + reaction_time_step_size * heating_model_outputs_C.rates_of_temperature_change[j];
                 }
 
-              // loop over temperature element
-              material_model->fill_additional_material_model_inputs(in_T, solution, fe_values_T, introspection);
+              if (point_set.composition_points)
+                for (unsigned int c=0; c<n_compositional_fields; ++c)
+                  {
+                    const types::global_dof_index dof
+                      = cell_dof_indices[dof_handler.get_fe().component_to_system_index(introspection.component_indices.compositional_fields[c], j)];
+                    if (locally_owned_dofs.is_element(dof))
+                      {
+                        data.dof_indices.push_back(dof);
+                        state_index.push_back(p*n_fields+1+c);
+                      }
+                  }
+            }
+        }
+
+      if (need_cell_inputs)
+        batch_in.current_cell = batch->front().cell;
 
-              material_model->evaluate(in_T, out_T);
-              heating_model_manager.evaluate(in_T, out_T, heating_model_outputs_T);
+      // Set up the material model inputs and outputs for a subset of the points of
+      // the batch. The adaptive scheme shrinks this subset as points reach the end of
+      // the advection time step, so that we do not keep evaluating the material model
+      // at points that are already done.
+      std::vector<unsigned int> points;
+      std::unique_ptr<MaterialModel::MaterialModelInputs<dim> > in;
+      std::unique_ptr<MaterialModel::MaterialModelOutputs<dim> > out;
+      std::unique_ptr<HeatingModel::HeatingModelOutputs> heating_model_outputs;
+      MaterialModel::ReactionRateOutputs<dim> *reaction_rate_outputs = nullptr;
+
+      auto select_points = [&] (const std::vector<unsigned int> &selected_points)
+      {
+        points = selected_points;
+        const unsigned int n_selected_points = points.size();
+
+        in = std_cxx14::make_unique<MaterialModel::MaterialModelInputs<dim> > (n_selected_points, n_compositional_fields);
+        out = std_cxx14::make_unique<MaterialModel::MaterialModelOutputs<dim> > (n_selected_points, n_compositional_fields);
+        heating_model_outputs = std_cxx14::make_unique<HeatingModel::HeatingModelOutputs> (n_selected_points, n_compositional_fields);
+
+        for (unsigned int i=0; i<n_selected_points; ++i)
+          {
+            in->position[i] = batch_in.position[points[i]];
+            in->pressure[i] = batch_in.pressure[points[i]];
+            in->pressure_gradient[i] = batch_in.pressure_gradient[points[i]];
+            in->velocity[i] = batch_in.velocity[points[i]];
+            in->strain_rate[i] = batch_in.strain_rate[points[i]];
+          }
+        in->current_cell = batch_in.current_cell;
+
+        // add reaction rate outputs, and the additional outputs some heating models require
+        material_model->create_additional_named_outputs(*out);
+        reaction_rate_outputs = out->template get_additional_output<MaterialModel::ReactionRateOutputs<dim> >();
+        heating_model_manager.create_additional_material_model_inputs_and_outputs(*in, *out);
+
+        // if there are additional inputs, the batch consists of all support points
+        // of a single cell, in the order of the support points, and these are
+        // never reduced
+        if (need_cell_inputs)
+          material_model->fill_additional_material_model_inputs(*in, solution, *fe_values, introspection);
+      };
+
+      // evaluate the rates of change of all fields for the given state at the
+      // selected points
+      auto compute_rates = [&] (const std::vector<double> &state,
+                                std::vector<double> &rates)
+      {
+        for (unsigned int i=0; i<points.size(); ++i)
+          {
+            in->temperature[i] = state[points[i]*n_fields];
+            for (unsigned int c=0; c<n_compositional_fields; ++c)
+              in->composition[i][c] = state[points[i]*n_fields+1+c];
+          }
 
-              for (unsigned int j=0; j<dof_handler.get_fe().base_element(introspection.base_elements.temperature).dofs_per_cell; ++j)
+        material_model->evaluate(*in, *out);
+        heating_model_manager.evaluate(*in, *out, *heating_model_outputs);
+
+        for (unsigned int i=0; i<points.size(); ++i)
+          {
+            rates[points[i]*n_fields] = heating_model_outputs->rates_of_temperature_change[i];
+            for (unsigned int c=0; c<n_compositional_fields; ++c)
+              rates[points[i]*n_fields+1+c] = reaction_rate_outputs->reaction_rates[i][c];
+          }
+      };
+
+      std::vector<unsigned int> all_points (n_points);
+      for (unsigned int i=0; i<n_points; ++i)
+        all_points[i] = i;
+      select_points (all_points);
+
+      std::vector<double> state (initial_state);
+      std::vector<double> k1 (n_points * n_fields);
+
+      if (adaptive_time_stepping == false)
+        {
+          // simple forward euler with a fixed step size
+          for (unsigned int step=0; step<number_of_reaction_steps; ++step)
+            {
+              compute_rates (state, k1);
+              for (unsigned int i=0; i<state.size(); ++i)
+                state[i] += reaction_time_step_size * k1[i];
+            }
+          data.max_reaction_steps = number_of_reaction_steps;
+        }
+      else
+        {
+          // Bogacki-Shampine 3(2) method with a separate step size for every point.
+          // It has the first-same-as-last property, i.e., the rates at the end of
+          // an accepted step are the rates at the beginning of the next one.
+          std::vector<double> k2 (n_points * n_fields);
+          std::vector<double> k3 (n_points * n_fields);
+          std::vector<double> k4 (n_points * n_fields);
+          std::vector<double> stage_state (state);
+          std::vector<double> new_state (state);
+
+          std::vector<double> reaction_time (n_points, 0.);
+          std::vector<double> step_size (n_points, reaction_time_step_size);
+          std::vector<unsigned int> n_steps (n_points, 0);
+          std::vector<bool> done (n_points, false);
+          unsigned int n_remaining_points = n_points;
+
+          const double relative_tolerance = parameters.reaction_solver_relative_tolerance;
+          const double absolute_tolerance = parameters.reaction_solver_absolute_tolerance;
+
+          compute_rates (state, k1);
+
+          while (n_remaining_points > 0)
+            {
+              // points that are done only remain in the selected set if there are
+              // additional inputs, and are then advanced by steps of size zero
+              std::vector<double> h (points.size());
+              for (unsigned int i=0; i<points.size(); ++i)
+                h[i] = (done[points[i]]
+                        ?
+                        0.
+                        :
+                        std::min (step_size[points[i]], time_step - reaction_time[points[i]]));
+
+              for (unsigned int i=0; i<points.size(); ++i)
+                for (unsigned int f=points[i]*n_fields; f<(points[i]+1)*n_fields; ++f)
+                  stage_state[f] = state[f] + h[i] / 2 * k1[f];
+              compute_rates (stage_state, k2);
+
+              for (unsigned int i=0; i<points.size(); ++i)
+                for (unsigned int f=points[i]*n_fields; f<(points[i]+1)*n_fields; ++f)
+                  stage_state[f] = state[f] + 3 * h[i] / 4 * k2[f];
+              compute_rates (stage_state, k3);
+
+              for (unsigned int i=0; i<points.size(); ++i)
+                for (unsigned int f=points[i]*n_fields; f<(points[i]+1)*n_fields; ++f)
+                  new_state[f] = state[f] + h[i] * (2./9. * k1[f] + 1./3. * k2[f] + 4./9. * k3[f]);
+              compute_rates (new_state, k4);
+
+              std::vector<unsigned int> remaining_points;
+              for (unsigned int i=0; i<points.size(); ++i)
                 {
-                  // simple forward euler
-                  in_T.temperature[j] = in_T.temperature[j]
-                                        + reaction_time_step_size * heating_model_outputs_T.rates_of_temperature_change[j];
-                  accumulated_reactions_T[j] += reaction_time_step_size * heating_model_outputs_T.rates_of_temperature_change[j];
-
-                  for (unsigned int c=0; c<introspection.n_compositional_fields; ++c)
-                    in_T.composition[j][c] = in_T.composition[j][c]
-                                             + reaction_time_step_size * reaction_rate_outputs_T->reaction_rates[j][c];
+                  const unsigned int point = points[i];
+                  if (done[point])
+                    continue;
+
+                  // the difference to the embedded second order solution, relative
+                  // to the tolerance
+                  double error = 0;
+                  for (unsigned int f=point*n_fields; f<(point+1)*n_fields; ++f)
+                    {
+                      const double local_error = h[i] * (-5./72. * k1[f] + 1./12. * k2[f]
+                                                         + 1./9. * k3[f] - 1./8. * k4[f]);
+                      const double scale = absolute_tolerance
+                                           + relative_tolerance * std::max(std::abs(state[f]), std::abs(new_state[f]));
+                      error = std::max (error, std::abs(local_error) / scale);
+                    }
+
+                  if (error <= 1)
+                    {
+                      for (unsigned int f=point*n_fields; f<(point+1)*n_fields; ++f)
+                        {
+                          state[f] = new_state[f];
+                          k1[f] = k4[f];
+                        }
+                      reaction_time[point] += h[i];
+                      ++n_steps[point];
+                    }
+
+                  if (reaction_time[point] >= time_step * (1. - 1e-12))
+                    {
+                      done[point] = true;
+                      --n_remaining_points;
+                      data.max_reaction_steps = std::max (data.max_reaction_steps, n_steps[point]);
+                      continue;
+                    }
+
+                  // choose the next step size from the error estimate, but do not
+                  // change it by more than a factor of five in either direction
+                  const double factor = (error > 0
+                                         ?
+                                         std::min (5., std::max (0.2, 0.9 * std::pow(error, -1./3.)))
+                                         :
+                                         5.);
+                  step_size[point] = h[i] * factor;
+
+                  AssertThrow (step_size[point] > 1e-12 * time_step,
+                               ExcMessage ("The adaptive reaction solver could not reach the requested "
+                                           "tolerances within a reasonable step size. Consider increasing "
+                                           "the ``Reaction solver relative tolerance'' or the ``Reaction "
+                                           "solver absolute tolerance''."));
+                  remaining_points.push_back(point);
                 }
-            }
 
-          // copy reaction rates and new values for the compositional fields
-          for (unsigned int j=0; j<dof_handler.get_fe().base_element(introspection.base_elements.compositional_fields).dofs_per_cell; ++j)
-            for (unsigned int c=0; c<introspection.n_compositional_fields; ++c)
-              {
-                const unsigned int composition_idx
-                  = dof_handler.get_fe().component_to_system_index(introspection.component_indices.compositional_fields[c],
-                                                                   /*dof index within component=*/ j);
+              // the additional inputs can not be restricted to a subset of the
+              // points, otherwise only keep evaluating the points that are not done
+              if (need_cell_inputs == false
+                  && remaining_points.size() > 0
+                  && remaining_points.size() < points.size())
+                select_points (remaining_points);
+            }
+        }
 
-                // skip entries that are not locally owned:
-                if (dof_handler.locally_owned_dofs().is_element(local_dof_indices[composition_idx]))
-                  {
-                    distributed_vector(local_dof_indices[composition_idx]) = in_C.composition[j][c];
-                    distributed_reaction_vector(local_dof_indices[composition_idx]) = accumulated_reactions_C[j][c];
-                  }
-              }
+      // copy the new values and the accumulated reactions of the fields we update
+      data.new_values.resize (data.dof_indices.size());
+      data.reaction_changes.resize (data.dof_indices.size());
+      for (unsigned int i=0; i<data.dof_indices.size(); ++i)
+        {
+          data.new_values[i] = state[state_index[i]];
+          data.reaction_changes[i] = state[state_index[i]] - initial_state[state_index[i]];
+        }
+    };
 
-          // copy reaction rates and new values for the temperature field
-          for (unsigned int j=0; j<dof_handler.get_fe().base_element(introspection.base_elements.temperature).dofs_per_cell; ++j)
-            for (unsigned int c=0; c<introspection.n_compositional_fields; ++c)
-              {
-                const unsigned int temperature_idx
-                  = dof_handler.get_fe().component_to_system_index(introspection.component_indices.temperature,
-                                                                   /*dof index within component=*/ j);
+    unsigned int max_reaction_steps = 0;
 
-                // skip entries that are not locally owned:
-                if (dof_handler.locally_owned_dofs().is_element(local_dof_indices[temperature_idx]))
-                  {
-                    distributed_vector(local_dof_indices[temperature_idx]) = in_T.temperature[j];
-                    distributed_reaction_vector(local_dof_indices[temperature_idx]) = accumulated_reactions_T[j];
-                  }
-              }
+    auto copier = [&](const ReactionCopyData &data)
+    {
+      for (unsigned int i=0; i<data.dof_indices.size(); ++i)
+        {
+          distributed_vector(data.dof_indices[i]) = data.new_values[i];
+          distributed_reaction_vector(data.dof_indices[i]) = data.reaction_changes[i];
         }
+      max_reaction_steps = std::max (max_reaction_steps, data.max_reaction_steps);
+    };
+
+    WorkStream::
+    run (batches.cbegin(),
+         batches.cend(),
+         worker,
+         copier,
+         ReactionScratchData<dim> (*mapping,
+                                   dof_handler.get_fe(),
+                                   quadrature_C,
+                                   quadrature_T),
+         ReactionCopyData());
+
+    if (adaptive_time_stepping == true)
+      pcout << "   Solved composition reactions in at most "
+            << Utilities::MPI::max (max_reaction_steps, mpi_communicator)
+            << " adaptive substep(s)."
+            << std::endl;
 
     // put the final values into the solution vector
     for (unsigned int c=0; c<introspection.n_compositional_fields; ++c)
@@ -2348,7 +2979,7 @@ namespace aspect
                                                      LinearAlgebra::BlockVector &vector, \
                                                      const LinearAlgebra::BlockVector &relevant_vector) const; \
   template double Simulator<dim>::get_maximal_velocity (const LinearAlgebra::BlockVector &solution) const; \
-  template std::pair<double,double> Simulator<dim>::get_extrapolated_advection_field_range (const AdvectionField &advection_field) const; \
+  template std::pair<double,double> Simulator<dim>::get_extrapolated_advection_field_range (const AdvectionField &advection_field, double *maximal_old_velocity) const; \
   template void Simulator<dim>::maybe_write_timing_output () const; \
   template bool Simulator<dim>::maybe_write_checkpoint (const time_t last_checkpoint_time, const std::pair<bool,bool> termination_output); \
   template bool Simulator<dim>::maybe_do_initial_refinement (const unsigned int max_refinement_level); \
@@ -2356,6 +2987,9 @@ namespace aspect
   template double Simulator<dim>::compute_time_step () const; \
   template void Simulator<dim>::make_pressure_rhs_compatible(LinearAlgebra::BlockVector &vector); \
   template void Simulator<dim>::output_statistics(); \
+  template void Simulator<dim>::prepare_measured_cost_cell_weights(); \
+  template unsigned int Simulator<dim>::measured_cost_cell_weight(const parallel::distributed::Triangulation<dim>::cell_iterator &cell, \
+                                                                  const parallel::distributed::Triangulation<dim>::CellStatus status) const; \
   template void Simulator<dim>::write_plugin_graph(std::ostream &) const; \
   template double Simulator<dim>::compute_initial_stokes_residual(); \
   template bool Simulator<dim>::stokes_matrix_depends_on_solution() const; \
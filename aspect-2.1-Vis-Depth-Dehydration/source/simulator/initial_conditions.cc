@@ -194,10 +194,13 @@ namespace aspect
 
 
   template <int dim>
-  void Simulator<dim>::interpolate_particle_properties (const AdvectionField &advection_field)
+  void Simulator<dim>::interpolate_particle_properties (const std::vector<AdvectionField> &advection_fields)
   {
     TimerOutput::Scope timer (computing_timer, "Particles: Interpolate");
 
+    if (advection_fields.size() == 0)
+      return;
+
     // below, we would want to call VectorTools::interpolate on the
     // entire FESystem. there currently is no way to restrict the
     // interpolation operations to only a subset of vector
@@ -212,7 +215,7 @@ namespace aspect
     //
     // to work around this problem, the following code is essentially
     // a (simplified) copy of the code in VectorTools::interpolate
-    // that only works on the given component
+    // that only works on the given components
 
     // create a fully distributed vector since we
     // need to write into it and we can not
@@ -224,30 +227,44 @@ namespace aspect
     const Particle::Interpolator::Interface<dim> *particle_interpolator = &particle_postprocessor.get_particle_world().get_interpolator();
     const Particle::Property::Manager<dim> *particle_property_manager = &particle_postprocessor.get_particle_world().get_property_manager();
 
-    unsigned int particle_property;
+    // find the particle property that belongs to each of the fields, and
+    // collect all of them in one mask so that we only have to interpolate
+    // once per cell
+    std::vector<unsigned int> particle_properties (advection_fields.size());
+    ComponentMask property_mask (particle_property_manager->get_data_info().n_components(),false);
 
-    if (parameters.mapped_particle_properties.size() != 0)
+    for (unsigned int f=0; f<advection_fields.size(); ++f)
       {
-        const std::pair<std::string,unsigned int> particle_property_and_component = parameters.mapped_particle_properties.find(advection_field.compositional_variable)->second;
+        const AdvectionField &advection_field = advection_fields[f];
 
-        particle_property = particle_property_manager->get_data_info().get_position_by_field_name(particle_property_and_component.first)
-                            + particle_property_and_component.second;
-      }
-    else
-      {
-        particle_property = std::count(introspection.compositional_field_methods.begin(),
-                                       introspection.compositional_field_methods.begin() + advection_field.compositional_variable,
-                                       Parameters<dim>::AdvectionFieldMethod::particles);
-        AssertThrow(particle_property <= particle_property_manager->get_data_info().n_components(),
-                    ExcMessage("Can not automatically match particle properties to fields, because there are"
-                               "more fields that are marked as particle advected than particle properties"));
+        if (parameters.mapped_particle_properties.size() != 0)
+          {
+            const std::pair<std::string,unsigned int> particle_property_and_component = parameters.mapped_particle_properties.find(advection_field.compositional_variable)->second;
+
+            particle_properties[f] = particle_property_manager->get_data_info().get_position_by_field_name(particle_property_and_component.first)
+                                     + particle_property_and_component.second;
+          }
+        else
+          {
+            particle_properties[f] = std::count(introspection.compositional_field_methods.begin(),
+                                                introspection.compositional_field_methods.begin() + advection_field.compositional_variable,
+                                                Parameters<dim>::AdvectionFieldMethod::particles);
+            AssertThrow(particle_properties[f] <= particle_property_manager->get_data_info().n_components(),
+                        ExcMessage("Can not automatically match particle properties to fields, because there are"
+                                   "more fields that are marked as particle advected than particle properties"));
+          }
+
+        property_mask.set(particle_properties[f],true);
+
+        Assert (advection_field.base_element(introspection) == advection_fields[0].base_element(introspection),
+                ExcInternalError());
       }
 
     LinearAlgebra::BlockVector particle_solution;
 
     particle_solution.reinit(system_rhs, false);
 
-    const unsigned int base_element = advection_field.base_element(introspection);
+    const unsigned int base_element = advection_fields[0].base_element(introspection);
 
     // get the temperature/composition support points
     const std::vector<Point<dim> > support_points
@@ -267,12 +284,9 @@ namespace aspect
       if (cell->is_locally_owned())
         {
           fe_values.reinit (cell);
-          const std::vector<Point<dim> > quadrature_points = fe_values.get_quadrature_points();
-
-          ComponentMask property_mask  (particle_property_manager->get_data_info().n_components(),false);
-          property_mask.set(particle_property,true);
+          const std::vector<Point<dim> > &quadrature_points = fe_values.get_quadrature_points();
 
-          const std::vector<std::vector<double> > particle_properties =
+          const std::vector<std::vector<double> > interpolated_properties =
             particle_interpolator->properties_at_points(particle_postprocessor.get_particle_world().get_particle_handler(),
                                                         quadrature_points,
                                                         property_mask,
@@ -281,37 +295,45 @@ namespace aspect
           // go through the composition dofs and set their global values
           // to the particle field interpolated at these points
           cell->get_dof_indices (local_dof_indices);
-          for (unsigned int i=0; i<finite_element.base_element(base_element).dofs_per_cell; ++i)
-            {
-              const unsigned int system_local_dof
-                = finite_element.component_to_system_index(advection_field.component_index(introspection),
-                                                           /*dof index within component=*/i);
+          for (unsigned int f=0; f<advection_fields.size(); ++f)
+            for (unsigned int i=0; i<finite_element.base_element(base_element).dofs_per_cell; ++i)
+              {
+                const unsigned int system_local_dof
+                  = finite_element.component_to_system_index(advection_fields[f].component_index(introspection),
+                                                             /*dof index within component=*/i);
 
-              particle_solution(local_dof_indices[system_local_dof]) = particle_properties[i][particle_property];
-            }
+                particle_solution(local_dof_indices[system_local_dof]) = interpolated_properties[i][particle_properties[f]];
+              }
         }
 
     particle_solution.compress(VectorOperation::insert);
 
     // we should not have written at all into any of the blocks with
-    // the exception of the current composition block
+    // the exception of the current composition blocks
+    std::vector<bool> is_particle_block (particle_solution.n_blocks(), false);
+    for (unsigned int f=0; f<advection_fields.size(); ++f)
+      is_particle_block[advection_fields[f].block_index(introspection)] = true;
+
     for (unsigned int b=0; b<particle_solution.n_blocks(); ++b)
-      if (b != advection_field.block_index(introspection))
+      if (is_particle_block[b] == false)
         Assert (particle_solution.block(b).l2_norm() == 0,
                 ExcInternalError());
 
-    // overwrite the relevant composition block only
-    const unsigned int blockidx = advection_field.block_index(introspection);
-    solution.block(blockidx) = particle_solution.block(blockidx);
-
-    // In the first timestep initialize all solution vectors with the initial
-    // particle solution, identical to the end of the
-    // Simulator<dim>::set_initial_temperature_and_compositional_fields ()
-    // function.
-    if (timestep_number == 0)
+    for (unsigned int f=0; f<advection_fields.size(); ++f)
       {
-        old_solution.block(blockidx) = particle_solution.block(blockidx);
-        old_old_solution.block(blockidx) = particle_solution.block(blockidx);
+        // overwrite the relevant composition block only
+        const unsigned int blockidx = advection_fields[f].block_index(introspection);
+        solution.block(blockidx) = particle_solution.block(blockidx);
+
+        // In the first timestep initialize all solution vectors with the initial
+        // particle solution, identical to the end of the
+        // Simulator<dim>::set_initial_temperature_and_compositional_fields ()
+        // function.
+        if (timestep_number == 0)
+          {
+            old_solution.block(blockidx) = particle_solution.block(blockidx);
+            old_old_solution.block(blockidx) = particle_solution.block(blockidx);
+          }
       }
   }
 
@@ -481,7 +503,7 @@ namespace aspect
 #define INSTANTIATE(dim) \
   template void Simulator<dim>::set_initial_temperature_and_compositional_fields(); \
   template void Simulator<dim>::compute_initial_pressure_field(); \
-  template void Simulator<dim>::interpolate_particle_properties(const AdvectionField &);
+  template void Simulator<dim>::interpolate_particle_properties(const std::vector<AdvectionField> &);
 
 
   ASPECT_INSTANTIATE(INSTANTIATE)
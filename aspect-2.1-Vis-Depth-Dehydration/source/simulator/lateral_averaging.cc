@@ -359,7 +359,7 @@ namespace aspect
                         cell,
                         this->introspection(),
                         this->get_solution());
-              this->get_material_model().evaluate(in, out);
+              this->evaluate_material_model(in, out);
             }
 
           for (unsigned int i = 0; i < n_properties; ++i)
@@ -26,6 +26,7 @@
 #include <aspect/volume_of_fluid/handler.h>
 #include <aspect/newton.h>
 #include <aspect/free_surface.h>
+#include <aspect/stokes_matrix_free.h>
 
 #include <deal.II/base/parameter_handler.h>
 
@@ -290,6 +291,22 @@ namespace aspect
                        "The name of the directory into which all output files should be "
                        "placed. This may be an absolute or a relative path.");
 
+    prm.declare_entry ("Append to output files", "false",
+                       Patterns::Bool(),
+                       "Whether files that contain the whole history of a computation "
+                       "should only be extended by the data of the current output, instead "
+                       "of being rewritten completely every time. This affects the "
+                       "<statistics> file, the <point\\_values.txt> file of the `point "
+                       "values' postprocessor, and the <depth\\_average.txt> file of "
+                       "the `depth average' postprocessor if it uses the `txt' output "
+                       "format. Since rewriting these files takes time proportional to "
+                       "the number of outputs already written, appending is considerably "
+                       "cheaper for long computations. On the other hand, the columns of "
+                       "the statistics file are then no longer aligned across all rows, "
+                       "and a file is still rewritten completely once after the "
+                       "computation was started or resumed, and whenever a new column "
+                       "appears in the statistics file.");
+
     prm.declare_entry ("Use operator splitting", "false",
                        Patterns::Bool(),
                        "If set to true, the advection and reactions of compositional fields and "
@@ -318,12 +335,29 @@ namespace aspect
 
       prm.enter_subsection ("Stokes solver parameters");
       {
+        prm.declare_entry ("Stokes solver type", "block AMG",
+                           Patterns::Selection ("block AMG|direct solver|block GMG"),
+                           "This is the type of solver used on the Stokes system. The ``block AMG'' "
+                           "solver uses an iterative Schur complement solver in which the velocity "
+                           "block is preconditioned by an algebraic multigrid method built from the "
+                           "assembled matrix. The ``direct solver'' uses Trilinos klu and is only "
+                           "efficient for small problems. The ``block GMG'' solver uses the same outer "
+                           "Schur complement iteration, but applies the Stokes operator matrix-free "
+                           "with the viscosity evaluated in every quadrature point, and preconditions "
+                           "the velocity block with a geometric multigrid V-cycle with Chebyshev "
+                           "smoothing on the levels of the mesh. It does not assemble the Stokes "
+                           "blocks of the system matrix and therefore needs considerably less memory "
+                           "and setup time, but it currently does not support models with melt "
+                           "transport, a free surface, the Newton solver, periodic boundaries, or "
+                           "no-normal-flux boundaries in geometries other than a box.");
+
         prm.declare_entry ("Use direct solver for Stokes system", "false",
                            Patterns::Bool(),
                            "If set to true the linear system for the Stokes equation will "
                            "be solved using Trilinos klu, otherwise an iterative Schur "
                            "complement solver is used. The direct solver is only efficient "
-                           "for small problems.");
+                           "for small problems. Setting this parameter to true is equivalent "
+                           "to setting `Stokes solver type' to ``direct solver''.");
 
         prm.declare_entry ("Linear solver tolerance", "1e-7",
                            Patterns::Double(0,1),
@@ -372,6 +406,30 @@ namespace aspect
                            "not converge and return an error message pointing out that the user didn't allow "
                            "a sufficiently large number of iterations for the iterative solver to converge.");
 
+        prm.declare_entry ("Stokes solver phase selection", "fixed",
+                           Patterns::Selection("fixed|automatic"),
+                           "How to decide whether a solve of the Stokes system starts with the "
+                           "cheap solver phase described in the documentation of the "
+                           "`Number of cheap Stokes solver steps' parameter. For `fixed', "
+                           "every solve tries the cheap phase first. For `automatic', the "
+                           "cheap phase is skipped after it failed to converge, and only "
+                           "tried again after 10 solves that went straight to the "
+                           "expensive phase. This avoids spending the cheap iterations in "
+                           "every time step for models where they almost never succeed, "
+                           "while still returning to the cheap solver if the problem "
+                           "becomes easier.");
+
+        prm.declare_entry ("Keep Krylov space between solver phases", "false",
+                           Patterns::Bool(),
+                           "If set to false, the expensive solver phase is a new GMRES "
+                           "solve that starts from the last iterate of the cheap phase. "
+                           "If set to true, both phases are done in a single flexible "
+                           "GMRES iteration whose preconditioner switches from the cheap "
+                           "to the expensive one after the number of cheap steps. This "
+                           "keeps the Krylov space built up in the cheap phase, up to the "
+                           "restart length of GMRES, which for the expensive phase is "
+                           "used for the whole iteration.");
+
         prm.declare_entry ("GMRES solver restart length", "50",
                            Patterns::Integer(1),
                            "This is the number of iterations that define the GMRES solver restart length. "
@@ -458,6 +516,43 @@ namespace aspect
         prm.declare_entry ("AMG output details", "false",
                            Patterns::Bool(),
                            "Turns on extra information on the AMG solver. Note that this will generate much more output.");
+
+        prm.declare_entry ("AMG reuse policy", "never",
+                           Patterns::Selection ("never|reuse hierarchy|reuse preconditioner"),
+                           "Whenever the Stokes matrix is reassembled, ASPECT by default also "
+                           "builds a new AMG preconditioner for the velocity block from scratch. "
+                           "For models in which the viscosity changes only a little from one "
+                           "assembly to the next, this setup can be a significant part of the "
+                           "time step. This parameter allows to avoid it: ``never'' always "
+                           "rebuilds the preconditioner. ``reuse hierarchy'' keeps the "
+                           "aggregates and the multilevel hierarchy of the previous "
+                           "preconditioner and only recomputes the level operators from the "
+                           "new matrix. ``reuse preconditioner'' does not touch the previous "
+                           "preconditioner at all and also skips the assembly of the "
+                           "preconditioner matrix. In both cases, the preconditioner is rebuilt "
+                           "from scratch anyway if the viscosity changed by more than the "
+                           "``AMG reuse viscosity change threshold'' since the last full "
+                           "rebuild, if the previous Stokes solve needed more than ``AMG reuse "
+                           "iteration threshold'' iterations, or if the mesh changed. The "
+                           "``reuse hierarchy'' option is only available with Trilinos; with "
+                           "PETSc, it behaves like ``never''. This parameter is only used "
+                           "for the ``block AMG'' Stokes solver.");
+
+        prm.declare_entry ("AMG reuse viscosity change threshold", "0.1",
+                           Patterns::Double(0),
+                           "The maximal change of the viscosity, measured as the largest "
+                           "difference over all cells of the cell average of the base-10 "
+                           "logarithm of the viscosity, since the last full rebuild of the AMG "
+                           "preconditioner up to which the preconditioner can be reused "
+                           "according to the ``AMG reuse policy''. A value of 0.1 corresponds "
+                           "to a change of the viscosity by a factor of about 1.26 in any cell.");
+
+        prm.declare_entry ("AMG reuse iteration threshold", "100",
+                           Patterns::Integer(0),
+                           "If the previous solve of the Stokes system needed more than this "
+                           "number of iterations, the AMG preconditioner is rebuilt from scratch "
+                           "regardless of the ``AMG reuse policy'', because a reused "
+                           "preconditioner has apparently become too inaccurate.");
       }
       prm.leave_subsection ();
       prm.enter_subsection ("Operator splitting parameters");
@@ -485,6 +580,38 @@ namespace aspect
                            "this criterion and the ``Reaction time step'', whichever yields the "
                            "smaller time step. "
                            "Units: none.");
+
+        prm.declare_entry ("Reaction solver type", "forward euler",
+                           Patterns::Selection ("forward euler|adaptive runge kutta"),
+                           "The scheme used to integrate the reactions of the temperature "
+                           "and the compositional fields over one advection time step in case "
+                           "operator splitting is used. ``forward euler'' makes a fixed number of "
+                           "explicit Euler steps of the size determined by the ``Reaction time "
+                           "step'' and the ``Reaction time steps per advection step'' everywhere "
+                           "in the domain. ``adaptive runge kutta'' uses an embedded Runge-Kutta "
+                           "method of order 3(2) (Bogacki-Shampine) instead, and chooses the "
+                           "size of the reaction time steps separately for every node from an "
+                           "estimate of the local error, controlled by the ``Reaction solver "
+                           "relative tolerance'' and ``Reaction solver absolute tolerance''. "
+                           "The step size determined by the other two parameters is then only "
+                           "used as the size of the first step. This allows to take large "
+                           "reaction steps where reactions are slow, and small ones only where "
+                           "they are fast.");
+
+        prm.declare_entry ("Reaction solver relative tolerance", "1e-4",
+                           Patterns::Double (0),
+                           "The relative tolerance of the local error estimate of one reaction "
+                           "time step if the ``Reaction solver type'' is ``adaptive runge kutta''. "
+                           "Units: none.");
+
+        prm.declare_entry ("Reaction solver absolute tolerance", "1e-8",
+                           Patterns::Double (0),
+                           "The absolute tolerance of the local error estimate of one reaction "
+                           "time step if the ``Reaction solver type'' is ``adaptive runge kutta''. "
+                           "It is applied to the temperature and all compositional fields alike, "
+                           "and prevents the step size from becoming very small where a field "
+                           "is close to zero. "
+                           "Units: the units of the respective field.");
       }
       prm.leave_subsection ();
       prm.enter_subsection ("Diffusion solver parameters");
@@ -715,6 +842,27 @@ namespace aspect
                          "Use fraction of the total number of cells instead of "
                          "fraction of the total error as the limit for refinement "
                          "and coarsening.");
+      prm.declare_entry ("Use measured cell costs for load balancing", "false",
+                         Patterns::Bool(),
+                         "Whether to measure the time spent assembling the Stokes and "
+                         "advection systems on each cell, which includes evaluating "
+                         "the material model, and to use these times as additional "
+                         "weights when the mesh is repartitioned after refinement. "
+                         "This leads to a better balanced load between processes if "
+                         "the cost of a cell varies strongly, for example because of a "
+                         "nonlinear rheology that is expensive to evaluate in parts of "
+                         "the domain. If enabled, the ratio between the largest and the "
+                         "average measured time per process is also written to the "
+                         "statistics file whenever the mesh is refined.");
+      prm.declare_entry ("Measured cell cost weight", "1000",
+                         Patterns::Double (0),
+                         "If measured cell costs are used for load balancing, the "
+                         "weight a cell with the average measured cost gets in addition "
+                         "to its weight as a cell, which is 1000. Cells with higher or "
+                         "lower measured costs get proportionally larger or smaller "
+                         "weights. This weight is added to the weight of the particles "
+                         "in a cell if particles are used for load balancing as well. "
+                         "Units: None.");
       prm.declare_entry ("Minimum refinement level", "0",
                          Patterns::Integer (0),
                          "The minimum refinement level each cell should have, "
@@ -777,6 +925,29 @@ namespace aspect
                          "If 0 and time between checkpoint is not specified, "
                          "checkpointing will not be performed. "
                          "Units: None.");
+      prm.declare_entry ("Write checkpoint in background thread", "false",
+                         Patterns::Bool(),
+                         "Whether the files of a checkpoint should be written on a "
+                         "separate thread. If set to true, the mesh and the solution "
+                         "vectors are still stored on all processors before the "
+                         "computation continues, but compressing and writing the "
+                         "serialized state of the simulation to the "
+                         "`restart.resume.z' file and renaming the files of the "
+                         "previous checkpoint is done in the background on "
+                         "processor zero. The next checkpoint, and the end of the "
+                         "simulation, wait for these writes to finish. Until then, "
+                         "the new mesh files are stored as `restart.mesh.tmp', and "
+                         "the previous checkpoint remains the one that is used when "
+                         "resuming the computation.");
+      prm.declare_entry ("Compression level", "9",
+                         Patterns::Integer (0, 9),
+                         "The zlib compression level used for the serialized state of "
+                         "the simulation in the `restart.resume.z' file, from 0 (no "
+                         "compression) to 9 (best compression). The data is split into "
+                         "blocks of a few megabytes that are compressed in parallel, "
+                         "and uncompressed one at a time when resuming a computation. "
+                         "Lower levels make writing a checkpoint faster at the cost of "
+                         "larger files.");
     }
     prm.leave_subsection ();
 
@@ -1124,6 +1295,24 @@ namespace aspect
                          "More averaging schemes are available in the averaging material "
                          "model. This material model is a ``compositing material model'' "
                          "which can be used in combination with other material models.");
+
+      prm.declare_entry ("Cache material model evaluations", "false",
+                         Patterns::Bool (),
+                         "Whether to store the results of evaluations of the material "
+                         "model on each cell and reuse them if the material model is "
+                         "evaluated again for exactly the same inputs in the same time "
+                         "step and nonlinear iteration, for example in the assembly of "
+                         "different equations or in several postprocessors that use the "
+                         "same quadrature formula. This can save a significant amount of "
+                         "time for expensive material models, at the cost of memory for "
+                         "the stored inputs and outputs. Evaluations that use additional "
+                         "material model inputs or outputs are never cached. This option "
+                         "should only be used with material models whose results depend "
+                         "on nothing but their inputs, the time, and the current time step "
+                         "and nonlinear iteration. The number of evaluations served from "
+                         "the cache and the number of evaluations of the material model "
+                         "since the previous postprocessing step are written to the "
+                         "statistics file.");
     }
     prm.leave_subsection ();
 
@@ -1141,6 +1330,9 @@ namespace aspect
     // also declare the parameters that the FreeSurfaceHandler needs
     FreeSurfaceHandler<dim>::declare_parameters (prm);
 
+    // and the parameters of the matrix-free Stokes solver
+    StokesMatrixFreeHandler<dim>::declare_parameters (prm);
+
     // then, finally, let user additions that do not go through the usual
     // plugin mechanism, declare their parameters if they have subscribed
     // to the relevant signals
@@ -1205,10 +1397,15 @@ namespace aspect
 
       prm.enter_subsection ("Stokes solver parameters");
       {
-        use_direct_stokes_solver        = prm.get_bool("Use direct solver for Stokes system");
+        stokes_solver_type              = StokesSolverType::parse(prm.get("Stokes solver type"));
+        if (prm.get_bool("Use direct solver for Stokes system"))
+          stokes_solver_type = StokesSolverType::direct_solver;
+        use_direct_stokes_solver        = (stokes_solver_type == StokesSolverType::direct_solver);
         linear_stokes_solver_tolerance  = prm.get_double ("Linear solver tolerance");
         n_cheap_stokes_solver_steps     = prm.get_integer ("Number of cheap Stokes solver steps");
         n_expensive_stokes_solver_steps = prm.get_integer ("Maximum number of expensive Stokes solver steps");
+        stokes_solver_phase_selection   = StokesSolverPhaseSelection::parse(prm.get("Stokes solver phase selection"));
+        keep_stokes_krylov_space_between_phases = prm.get_bool ("Keep Krylov space between solver phases");
         linear_solver_A_block_tolerance = prm.get_double ("Linear solver A block tolerance");
         use_full_A_block_preconditioner = prm.get_bool ("Use full A block as preconditioner");
         linear_solver_S_block_tolerance = prm.get_double ("Linear solver S block tolerance");
@@ -1221,6 +1418,9 @@ namespace aspect
         AMG_smoother_sweeps                    = prm.get_integer ("AMG smoother sweeps");
         AMG_aggregation_threshold              = prm.get_double ("AMG aggregation threshold");
         AMG_output_details                     = prm.get_bool ("AMG output details");
+        AMG_reuse_policy                       = AMGReusePolicy::parse (prm.get ("AMG reuse policy"));
+        AMG_reuse_viscosity_change_threshold   = prm.get_double ("AMG reuse viscosity change threshold");
+        AMG_reuse_iteration_threshold          = prm.get_integer ("AMG reuse iteration threshold");
       }
       prm.leave_subsection ();
       prm.enter_subsection ("Operator splitting parameters");
@@ -1231,6 +1431,11 @@ namespace aspect
         if (convert_to_years == true)
           reaction_time_step *= year_in_seconds;
         reaction_steps_per_advection_step = prm.get_integer ("Reaction time steps per advection step");
+        reaction_solver_type = ReactionSolverType::parse (prm.get ("Reaction solver type"));
+        reaction_solver_relative_tolerance = prm.get_double ("Reaction solver relative tolerance");
+        reaction_solver_absolute_tolerance = prm.get_double ("Reaction solver absolute tolerance");
+        AssertThrow (reaction_solver_relative_tolerance > 0 || reaction_solver_absolute_tolerance > 0,
+                     ExcMessage("At least one of the reaction solver tolerances must be greater than 0."));
       }
       prm.leave_subsection ();
       prm.enter_subsection ("Diffusion solver parameters");
@@ -1260,6 +1465,8 @@ namespace aspect
                                  mpi_communicator,
                                  false);
 
+    append_to_output_files  = prm.get_bool ("Append to output files");
+
     if (prm.get ("Resume computation") == "true")
       resume_computation = true;
     else if (prm.get ("Resume computation") == "false")
@@ -1294,6 +1501,8 @@ namespace aspect
       refinement_fraction          = prm.get_double ("Refinement fraction");
       coarsening_fraction          = prm.get_double ("Coarsening fraction");
       adapt_by_fraction_of_cells   = prm.get_bool ("Adapt by fraction of cells");
+      use_measured_cell_costs      = prm.get_bool ("Use measured cell costs for load balancing");
+      measured_cell_cost_weight    = prm.get_double ("Measured cell cost weight");
       min_grid_level               = prm.get_integer ("Minimum refinement level");
 
       AssertThrow(refinement_fraction >= 0 && coarsening_fraction >= 0,
@@ -1435,6 +1644,8 @@ namespace aspect
     {
       checkpoint_time_secs = prm.get_integer ("Time between checkpoint");
       checkpoint_steps     = prm.get_integer ("Steps between checkpoint");
+      checkpoint_in_background = prm.get_bool ("Write checkpoint in background thread");
+      checkpoint_compression_level = prm.get_integer ("Compression level");
 
 #ifndef DEAL_II_WITH_ZLIB
       AssertThrow ((checkpoint_time_secs == 0)
@@ -1746,6 +1957,7 @@ namespace aspect
       material_averaging
         = MaterialModel::MaterialAveraging::parse_averaging_operation_name
           (prm.get ("Material averaging"));
+      cache_material_model_evaluations = prm.get_bool ("Cache material model evaluations");
     }
     prm.leave_subsection ();
 
@@ -1760,6 +1972,30 @@ namespace aspect
                            "Please turn off one or both of the options 'Nullspace removal/Remove nullspace', "
                            "or 'Use direct solver for Stokes system', or contribute code to enable "
                            "this feature combination."));
+
+    if (stokes_solver_type == StokesSolverType::block_gmg)
+      {
+        AssertThrow(DEAL_II_VERSION_GTE(9,1,0),
+                    ExcMessage("The 'block GMG' Stokes solver requires deal.II 9.1 or newer."));
+#ifdef ASPECT_USE_PETSC
+        AssertThrow(false,
+                    ExcMessage("The 'block GMG' Stokes solver is only available with Trilinos."));
+#endif
+        AssertThrow(!include_melt_transport,
+                    ExcMessage("The 'block GMG' Stokes solver does not support melt transport."));
+        AssertThrow(nonlinear_solver != NonlinearSolver::iterated_Advection_and_Newton_Stokes,
+                    ExcMessage("The 'block GMG' Stokes solver does not support the Newton solver."));
+        AssertThrow(stokes_velocity_degree == 2 || stokes_velocity_degree == 3,
+                    ExcMessage("The 'block GMG' Stokes solver is only implemented for "
+                               "velocity elements of degree 2 and 3."));
+        AssertThrow(!use_locally_conservative_discretization,
+                    ExcMessage("The 'block GMG' Stokes solver does not support a "
+                               "locally conservative discretization."));
+        AssertThrow((nullspace_removal & (NullspaceRemoval::linear_momentum
+                                          | NullspaceRemoval::net_translation)) == 0,
+                    ExcMessage("The 'block GMG' Stokes solver can not remove the "
+                               "translational nullspace by constraints."));
+      }
   }
 
 
@@ -377,6 +377,16 @@ namespace aspect
   }
 
 
+  template <int dim>
+  void
+  SimulatorAccess<dim>::evaluate_material_model (const MaterialModel::MaterialModelInputs<dim> &material_model_inputs,
+                                                 MaterialModel::MaterialModelOutputs<dim>      &material_model_outputs) const
+  {
+    simulator->evaluate_material_model(material_model_inputs,
+                                       material_model_outputs);
+  }
+
+
 
   template <int dim>
   const std::map<types::boundary_id,std::unique_ptr<BoundaryTraction::Interface<dim> > > &
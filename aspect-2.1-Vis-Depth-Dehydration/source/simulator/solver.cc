@@ -20,6 +20,7 @@
 
 
 #include <aspect/simulator.h>
+#include <aspect/stokes_matrix_free.h>
 #include <aspect/global.h>
 #include <aspect/melt.h>
 
@@ -372,6 +373,85 @@ namespace aspect
         }
     }
 
+
+
+    /**
+     * A preconditioner that applies the cheap preconditioner for the first
+     * @p n_cheap_applications calls of vmult(), and the expensive one for
+     * all following calls. Used together with a flexible Krylov method like
+     * FGMRES, this allows switching from the cheap to the expensive solver
+     * phase without restarting the iteration.
+     */
+    template <class PreconditionerType>
+    class TwoPhasePreconditioner : public Subscriptor
+    {
+      public:
+        TwoPhasePreconditioner (const PreconditionerType &cheap_preconditioner,
+                                const PreconditionerType &expensive_preconditioner,
+                                const unsigned int        n_cheap_applications)
+          :
+          cheap_preconditioner (cheap_preconditioner),
+          expensive_preconditioner (expensive_preconditioner),
+          n_cheap_applications (n_cheap_applications),
+          n_applications (0)
+        {}
+
+        void vmult (LinearAlgebra::BlockVector       &dst,
+                    const LinearAlgebra::BlockVector &src) const
+        {
+          if (n_applications < n_cheap_applications)
+            cheap_preconditioner.vmult (dst, src);
+          else
+            expensive_preconditioner.vmult (dst, src);
+          ++n_applications;
+        }
+
+      private:
+        const PreconditionerType &cheap_preconditioner;
+        const PreconditionerType &expensive_preconditioner;
+        const unsigned int n_cheap_applications;
+        mutable unsigned int n_applications;
+    };
+
+
+
+    /**
+     * A solver control object for an iteration that uses
+     * TwoPhasePreconditioner. It allows as many iterations as the two
+     * solver controls given to the constructor together, and forwards the
+     * convergence checks of the first iterations to the first and those of
+     * the remaining iterations to the second object, so that these
+     * contain the iteration counts and convergence history of the two
+     * phases just as if they had been two separate solves.
+     */
+    class TwoPhaseSolverControl : public SolverControl
+    {
+      public:
+        TwoPhaseSolverControl (SolverControl &solver_control_cheap,
+                               SolverControl &solver_control_expensive)
+          :
+          SolverControl (solver_control_cheap.max_steps() + solver_control_expensive.max_steps(),
+                         solver_control_expensive.tolerance()),
+          solver_control_cheap (solver_control_cheap),
+          solver_control_expensive (solver_control_expensive)
+        {}
+
+        State check (const unsigned int step,
+                     const double       check_value) override
+        {
+          const unsigned int n_cheap_steps = solver_control_cheap.max_steps();
+          if (step <= n_cheap_steps)
+            solver_control_cheap.check (step, check_value);
+          if (step >= n_cheap_steps)
+            solver_control_expensive.check (step - n_cheap_steps, check_value);
+
+          return SolverControl::check (step, check_value);
+        }
+
+      private:
+        SolverControl &solver_control_cheap;
+        SolverControl &solver_control_expensive;
+    };
   }
 
   template <int dim>
@@ -639,6 +719,15 @@ namespace aspect
 
         pcout << "done." << std::endl;
       }
+    else if (stokes_matrix_free)
+      {
+        // the matrix-free solver follows the same two-phase strategy as
+        // the block AMG solver below, and writes the solution into
+        // both distributed_stokes_solution and solution
+        const std::pair<double,double> residuals = stokes_matrix_free->solve(distributed_stokes_solution);
+        initial_nonlinear_residual = residuals.first;
+        final_linear_residual      = residuals.second;
+      }
     else
       {
         // Many parts of the solver depend on the block layout (velocity = 0,
@@ -750,8 +839,18 @@ namespace aspect
 
         PrimitiveVectorMemory< LinearAlgebra::BlockVector > mem;
 
+        // determine how many iterations we allow with the cheap
+        // preconditioner. if the phase is chosen automatically, skip the
+        // cheap phase if it recently failed to converge, but try it again
+        // every once in a while since the problem may have become easier
+        const unsigned int n_solves_before_retrying_cheap_phase = 10;
+        unsigned int n_cheap_stokes_solver_steps = parameters.n_cheap_stokes_solver_steps;
+        if (parameters.stokes_solver_phase_selection == Parameters<dim>::StokesSolverPhaseSelection::automatic
+            && n_stokes_solves_since_cheap_phase_failed < n_solves_before_retrying_cheap_phase)
+          n_cheap_stokes_solver_steps = 0;
+
         // create Solver controls for the cheap and expensive solver phase
-        SolverControl solver_control_cheap (parameters.n_cheap_stokes_solver_steps,
+        SolverControl solver_control_cheap (n_cheap_stokes_solver_steps,
                                             solver_tolerance);
 
         SolverControl solver_control_expensive (parameters.n_expensive_stokes_solver_steps,
@@ -778,42 +877,97 @@ namespace aspect
                                         parameters.linear_solver_A_block_tolerance,
                                         parameters.linear_solver_S_block_tolerance);
 
-        // step 1a: try if the simple and fast solver
-        // succeeds in n_cheap_stokes_solver_steps steps or less.
-        try
-          {
-            // if this cheaper solver is not desired, then simply short-cut
-            // the attempt at solving with the cheaper preconditioner
-            if (parameters.n_cheap_stokes_solver_steps == 0)
-              throw SolverControl::NoConvergence(0,0);
+        // the number of temporary vectors for the expensive solver phase:
+        // use the value defined by the user
+        // OR
+        // at least a restart length of 100 for melt models
+        const unsigned int number_of_temporary_vectors = (parameters.include_melt_transport == false ?
+                                                          parameters.stokes_gmres_restart_length :
+                                                          std::max(parameters.stokes_gmres_restart_length, 100U));
 
-            SolverFGMRES<LinearAlgebra::BlockVector>
-            solver(solver_control_cheap, mem,
-                   SolverFGMRES<LinearAlgebra::BlockVector>::
-                   AdditionalData(parameters.stokes_gmres_restart_length));
+        // if the solver fails, report the error from processor 0 with some additional
+        // information about its location, and throw a quiet exception on all other
+        // processors
+        auto report_solver_failure = [&] (const std::exception &exc)
+        {
+          signals.post_stokes_solver(*this,
+                                     preconditioner_cheap.n_iterations_S() + preconditioner_expensive.n_iterations_S(),
+                                     preconditioner_cheap.n_iterations_A() + preconditioner_expensive.n_iterations_A(),
+                                     solver_control_cheap,
+                                     solver_control_expensive);
 
-            solver.solve (stokes_block,
-                          distributed_stokes_solution,
-                          distributed_stokes_rhs,
-                          preconditioner_cheap);
+          if (Utilities::MPI::this_mpi_process(mpi_communicator) == 0)
+            {
+              // output solver history
+              std::ofstream f((parameters.output_directory+"solver_history.txt").c_str());
 
-            final_linear_residual = solver_control_cheap.last_value();
-          }
+              // Only request the solver history if a history has actually been created
+              if (n_cheap_stokes_solver_steps > 0)
+                {
+                  for (unsigned int i=0; i<solver_control_cheap.get_history_data().size(); ++i)
+                    f << i << " " << solver_control_cheap.get_history_data()[i] << "\n";
+
+                  f << "\n";
+                }
 
-        // step 1b: take the stronger solver in case
-        // the simple solver failed and attempt solving
-        // it in n_expensive_stokes_solver_steps steps or less.
-        catch (const SolverControl::NoConvergence &)
+
+              for (unsigned int i=0; i<solver_control_expensive.get_history_data().size(); ++i)
+                f << i << " " << solver_control_expensive.get_history_data()[i] << "\n";
+
+              f.close();
+
+              // avoid a deadlock that was fixed after deal.II 8.5.0
+#if DEAL_II_VERSION_GTE(9,0,0)
+              AssertThrow (false,
+                           ExcMessage (std::string("The iterative Stokes solver "
+                                                   "did not converge. It reported the following error:\n\n")
+                                       +
+                                       exc.what()
+                                       + "\n See " + parameters.output_directory+"solver_history.txt"
+                                       + " for convergence history."));
+#else
+              std::cerr << "The iterative Stokes solver "
+                        << "did not converge. It reported the following error:\n\n"
+                        << exc.what()
+                        << "\n See "
+                        << parameters.output_directory
+                        << "solver_history.txt for convergence history."
+                        << std::endl;
+              std::abort();
+#endif
+            }
+          else
+            {
+#if DEAL_II_VERSION_GTE(9,0,0)
+              throw QuietException();
+#else
+              std::abort();
+#endif
+            }
+        };
+
+        bool cheap_phase_failed = false;
+
+        if (parameters.keep_stokes_krylov_space_between_phases
+            && n_cheap_stokes_solver_steps > 0)
           {
-            // use the value defined by the user
-            // OR
-            // at least a restart length of 100 for melt models
-            const unsigned int number_of_temporary_vectors = (parameters.include_melt_transport == false ?
-                                                              parameters.stokes_gmres_restart_length :
-                                                              std::max(parameters.stokes_gmres_restart_length, 100U));
+            // solve with a single FGMRES iteration whose preconditioner
+            // switches from the cheap to the expensive one after
+            // n_cheap_stokes_solver_steps iterations. since FGMRES allows
+            // the preconditioner to change in every iteration, this keeps
+            // both the current iterate and the Krylov space built up in
+            // the cheap phase
+            const internal::TwoPhasePreconditioner<internal::BlockSchurPreconditioner<LinearAlgebra::PreconditionAMG,
+                  LinearAlgebra::PreconditionBase> >
+                  preconditioner (preconditioner_cheap,
+                                  preconditioner_expensive,
+                                  n_cheap_stokes_solver_steps);
+
+            internal::TwoPhaseSolverControl solver_control (solver_control_cheap,
+                                                            solver_control_expensive);
 
             SolverFGMRES<LinearAlgebra::BlockVector>
-            solver(solver_control_expensive, mem,
+            solver(solver_control, mem,
                    SolverFGMRES<LinearAlgebra::BlockVector>::
                    AdditionalData(number_of_temporary_vectors));
 
@@ -822,72 +976,85 @@ namespace aspect
                 solver.solve(stokes_block,
                              distributed_stokes_solution,
                              distributed_stokes_rhs,
-                             preconditioner_expensive);
+                             preconditioner);
 
-                final_linear_residual = solver_control_expensive.last_value();
+                final_linear_residual = solver_control.last_value();
               }
-            // if the solver fails, report the error from processor 0 with some additional
-            // information about its location, and throw a quiet exception on all other
-            // processors
             catch (const std::exception &exc)
               {
-                signals.post_stokes_solver(*this,
-                                           preconditioner_cheap.n_iterations_S() + preconditioner_expensive.n_iterations_S(),
-                                           preconditioner_cheap.n_iterations_A() + preconditioner_expensive.n_iterations_A(),
-                                           solver_control_cheap,
-                                           solver_control_expensive);
+                report_solver_failure(exc);
+              }
 
-                if (Utilities::MPI::this_mpi_process(mpi_communicator) == 0)
-                  {
-                    // output solver history
-                    std::ofstream f((parameters.output_directory+"solver_history.txt").c_str());
+            cheap_phase_failed = (solver_control.last_step() > n_cheap_stokes_solver_steps);
+          }
+        else
+          {
+            // step 1a: try if the simple and fast solver
+            // succeeds in n_cheap_stokes_solver_steps steps or less.
+            try
+              {
+                // if this cheaper solver is not desired, then simply short-cut
+                // the attempt at solving with the cheaper preconditioner
+                if (n_cheap_stokes_solver_steps == 0)
+                  throw SolverControl::NoConvergence(0,0);
 
-                    // Only request the solver history if a history has actually been created
-                    if (parameters.n_cheap_stokes_solver_steps > 0)
-                      {
-                        for (unsigned int i=0; i<solver_control_cheap.get_history_data().size(); ++i)
-                          f << i << " " << solver_control_cheap.get_history_data()[i] << "\n";
+                SolverFGMRES<LinearAlgebra::BlockVector>
+                solver(solver_control_cheap, mem,
+                       SolverFGMRES<LinearAlgebra::BlockVector>::
+                       AdditionalData(parameters.stokes_gmres_restart_length));
 
-                        f << "\n";
-                      }
+                solver.solve (stokes_block,
+                              distributed_stokes_solution,
+                              distributed_stokes_rhs,
+                              preconditioner_cheap);
 
+                final_linear_residual = solver_control_cheap.last_value();
+              }
 
-                    for (unsigned int i=0; i<solver_control_expensive.get_history_data().size(); ++i)
-                      f << i << " " << solver_control_expensive.get_history_data()[i] << "\n";
+            // step 1b: take the stronger solver in case
+            // the simple solver failed and attempt solving
+            // it in n_expensive_stokes_solver_steps steps or less.
+            // the expensive solver starts from the last iterate of the
+            // cheap one, which SolverFGMRES leaves in the solution vector
+            catch (const SolverControl::NoConvergence &)
+              {
+                cheap_phase_failed = (n_cheap_stokes_solver_steps > 0);
 
-                    f.close();
+                SolverFGMRES<LinearAlgebra::BlockVector>
+                solver(solver_control_expensive, mem,
+                       SolverFGMRES<LinearAlgebra::BlockVector>::
+                       AdditionalData(number_of_temporary_vectors));
 
-                    // avoid a deadlock that was fixed after deal.II 8.5.0
-#if DEAL_II_VERSION_GTE(9,0,0)
-                    AssertThrow (false,
-                                 ExcMessage (std::string("The iterative Stokes solver "
-                                                         "did not converge. It reported the following error:\n\n")
-                                             +
-                                             exc.what()
-                                             + "\n See " + parameters.output_directory+"solver_history.txt"
-                                             + " for convergence history."));
-#else
-                    std::cerr << "The iterative Stokes solver "
-                              << "did not converge. It reported the following error:\n\n"
-                              << exc.what()
-                              << "\n See "
-                              << parameters.output_directory
-                              << "solver_history.txt for convergence history."
-                              << std::endl;
-                    std::abort();
-#endif
+                try
+                  {
+                    solver.solve(stokes_block,
+                                 distributed_stokes_solution,
+                                 distributed_stokes_rhs,
+                                 preconditioner_expensive);
+
+                    final_linear_residual = solver_control_expensive.last_value();
                   }
-                else
+                catch (const std::exception &exc)
                   {
-#if DEAL_II_VERSION_GTE(9,0,0)
-                    throw QuietException();
-#else
-                    std::abort();
-#endif
+                    report_solver_failure(exc);
                   }
               }
           }
 
+        // remember whether the cheap phase was good enough, to decide
+        // whether to try it again in the next solve
+        if (cheap_phase_failed)
+          n_stokes_solves_since_cheap_phase_failed = 0;
+        else if (n_cheap_stokes_solver_steps > 0)
+          n_stokes_solves_since_cheap_phase_failed = numbers::invalid_unsigned_int;
+        else if (n_stokes_solves_since_cheap_phase_failed != numbers::invalid_unsigned_int)
+          ++n_stokes_solves_since_cheap_phase_failed;
+
+        // remember how hard this solve was, so that we know whether
+        // the preconditioner can be reused next time
+        n_last_stokes_solver_iterations = solver_control_cheap.last_step()
+                                          + solver_control_expensive.last_step();
+
         // signal successful solver
         signals.post_stokes_solver(*this,
                                    preconditioner_cheap.n_iterations_S() + preconditioner_expensive.n_iterations_S(),
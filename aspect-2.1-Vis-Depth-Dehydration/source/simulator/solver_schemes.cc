@@ -171,6 +171,17 @@ namespace aspect
         Assert(initial_residual->size() == introspection.n_compositional_fields, ExcInternalError());
       }
 
+    // all fields advected by particles are interpolated together, because
+    // the interpolator can then compute the values for all of them in one
+    // go for every cell
+    std::vector<AdvectionField> particle_fields;
+    for (unsigned int c=0; c < introspection.n_compositional_fields; ++c)
+      if (introspection.compositional_field_methods[c] == Parameters<dim>::AdvectionFieldMethod::particles)
+        particle_fields.push_back (AdvectionField::composition(c));
+
+    if (particle_fields.size() > 0)
+      interpolate_particle_properties(particle_fields);
+
     for (unsigned int c=0; c < introspection.n_compositional_fields; ++c)
       {
         const AdvectionField adv_field (AdvectionField::composition(c));
@@ -206,7 +217,7 @@ namespace aspect
 
             case Parameters<dim>::AdvectionFieldMethod::particles:
             {
-              interpolate_particle_properties(adv_field);
+              // already interpolated above
               break;
             }
 
@@ -0,0 +1,1688 @@
+/*
+  Copyright (C) 2019 by the authors of the ASPECT code.
+
+  This file is part of ASPECT.
+
+  ASPECT is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2, or (at your option)
+  any later version.
+
+  ASPECT is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with ASPECT; see the file LICENSE.  If not see
+  <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <aspect/stokes_matrix_free.h>
+#include <aspect/global.h>
+#include <aspect/geometry_model/box.h>
+
+#include <deal.II/base/quadrature_lib.h>
+#include <deal.II/base/signaling_nan.h>
+
+#include <deal.II/lac/solver_cg.h>
+#include <deal.II/lac/solver_gmres.h>
+#include <deal.II/lac/read_write_vector.h>
+#include <deal.II/lac/vector_memory.h>
+
+#include <deal.II/dofs/dof_tools.h>
+#include <deal.II/dofs/dof_renumbering.h>
+
+#include <deal.II/fe/fe_values.h>
+#include <deal.II/fe/mapping_cartesian.h>
+
+#include <deal.II/multigrid/multigrid.h>
+#include <deal.II/multigrid/mg_tools.h>
+
+#include <deal.II/numerics/vector_tools.h>
+
+
+namespace aspect
+{
+  template <int dim>
+  void
+  StokesMatrixFreeHandler<dim>::declare_parameters (ParameterHandler &prm)
+  {
+    prm.enter_subsection ("Solver parameters");
+    {
+      prm.enter_subsection ("Matrix Free");
+      {
+        prm.declare_entry ("GMG Chebyshev degree", "4",
+                           Patterns::Integer(1),
+                           "The polynomial degree of the Chebyshev smoother that is used "
+                           "on all but the coarsest level of the geometric multigrid "
+                           "preconditioner of the 'block GMG' Stokes solver. This is the "
+                           "number of matrix-vector products done per smoothing step.");
+
+        prm.declare_entry ("GMG Chebyshev smoothing range", "15",
+                           Patterns::Double(1),
+                           "The ratio between the largest eigenvalue of the level operator "
+                           "and the smallest eigenvalue the Chebyshev smoother of the "
+                           "'block GMG' Stokes solver targets. Larger values smooth a wider "
+                           "range of frequencies at the cost of a weaker reduction per step.");
+      }
+      prm.leave_subsection ();
+    }
+    prm.leave_subsection ();
+  }
+
+
+
+#if DEAL_II_VERSION_GTE(9,1,0)
+  namespace internal
+  {
+    /**
+     * Functions to move vectors between the (Trilinos or PETSc) vectors of the
+     * Simulator and the deal.II vectors used by the matrix-free
+     * operators. This only works because the DoFHandlers of the
+     * matrix-free solver are numbered in the same way as the velocity and
+     * pressure blocks of the Simulator's DoFHandler.
+     */
+    namespace ChangeVectorTypes
+    {
+      void import(LinearAlgebra::Vector &out,
+                  const dealii::LinearAlgebra::ReadWriteVector<double> &rwv,
+                  const VectorOperation::values operation)
+      {
+        Assert(out.size() == rwv.size(),
+               ExcMessage("Both vectors need to have the same size for import() to work!"));
+
+        Assert(out.locally_owned_elements() == rwv.get_stored_elements(),
+               ExcNotImplemented());
+
+        if (operation == VectorOperation::insert)
+          {
+            for (const auto idx : out.locally_owned_elements())
+              out[idx] = rwv[idx];
+          }
+        else if (operation == VectorOperation::add)
+          {
+            for (const auto idx : out.locally_owned_elements())
+              out[idx] += rwv[idx];
+          }
+        else
+          AssertThrow(false, ExcNotImplemented());
+
+        out.compress(operation);
+      }
+
+
+
+      void copy(LinearAlgebra::Vector &out,
+                const dealii::LinearAlgebra::distributed::Vector<double> &in)
+      {
+        dealii::LinearAlgebra::ReadWriteVector<double> rwv(out.locally_owned_elements());
+        rwv.import(in, VectorOperation::insert);
+        import(out, rwv, VectorOperation::insert);
+      }
+
+
+
+      void copy(dealii::LinearAlgebra::distributed::Vector<double> &out,
+                const LinearAlgebra::Vector &in)
+      {
+        dealii::LinearAlgebra::ReadWriteVector<double> rwv(in.locally_owned_elements());
+        rwv.import(in, VectorOperation::insert);
+        out.import(rwv, VectorOperation::insert);
+      }
+
+
+
+      void copy(LinearAlgebra::BlockVector &out,
+                const dealii::LinearAlgebra::distributed::BlockVector<double> &in)
+      {
+        const unsigned int n_blocks = in.n_blocks();
+        for (unsigned int b=0; b<n_blocks; ++b)
+          copy(out.block(b),in.block(b));
+      }
+
+
+
+      void copy(dealii::LinearAlgebra::distributed::BlockVector<double> &out,
+                const LinearAlgebra::BlockVector &in)
+      {
+        const unsigned int n_blocks = in.n_blocks();
+        for (unsigned int b=0; b<n_blocks; ++b)
+          copy(out.block(b),in.block(b));
+      }
+    }
+
+
+
+    /**
+     * Implement the block Schur preconditioner for the Stokes system,
+     * with matrix-free operators and a geometric multigrid preconditioner
+     * for the velocity block. This is the matrix-free equivalent of the
+     * BlockSchurPreconditioner in solver.cc.
+     */
+    template <class StokesMatrixType, class ABlockMatrixType, class SchurComplementMatrixType,
+              class ABlockPreconditionerType>
+    class BlockSchurGMGPreconditioner : public Subscriptor
+    {
+      public:
+        /**
+         * @brief Constructor
+         *
+         * @param Stokes_matrix The entire Stokes operator
+         * @param A_block The velocity block of the Stokes operator
+         * @param Schur_complement_block The weighted pressure mass matrix
+         *     that approximates the Schur complement
+         * @param A_block_preconditioner Preconditioner object for the A block,
+         *     i.e., the geometric multigrid V-cycle.
+         * @param do_solve_A A flag indicating whether we should actually solve with
+         *     the matrix $A$, or only apply one preconditioner step with it.
+         * @param A_block_tolerance The tolerance for the CG solver which computes
+         *     the inverse of the A block.
+         * @param S_block_tolerance The tolerance for the CG solver which computes
+         *     the inverse of the S block (Schur complement matrix).
+         **/
+        BlockSchurGMGPreconditioner (const StokesMatrixType          &Stokes_matrix,
+                                     const ABlockMatrixType          &A_block,
+                                     const SchurComplementMatrixType &Schur_complement_block,
+                                     const ABlockPreconditionerType  &A_block_preconditioner,
+                                     const bool                       do_solve_A,
+                                     const double                     A_block_tolerance,
+                                     const double                     S_block_tolerance);
+
+        /**
+         * Matrix vector product with this preconditioner object.
+         */
+        void vmult (dealii::LinearAlgebra::distributed::BlockVector<double>       &dst,
+                    const dealii::LinearAlgebra::distributed::BlockVector<double> &src) const;
+
+        unsigned int n_iterations_A() const;
+        unsigned int n_iterations_S() const;
+
+      private:
+        /**
+         * References to the various operators this preconditioner works on.
+         */
+        const StokesMatrixType          &stokes_matrix;
+        const ABlockMatrixType          &velocity_matrix;
+        const SchurComplementMatrixType &mass_matrix;
+        const ABlockPreconditionerType  &mg_preconditioner;
+
+        /**
+         * Whether to actually invert the $\tilde A$ part of the preconditioner matrix
+         * or to just apply a single preconditioner step with it.
+         **/
+        const bool do_solve_A;
+        mutable unsigned int n_iterations_A_;
+        mutable unsigned int n_iterations_S_;
+        const double A_block_tolerance;
+        const double S_block_tolerance;
+    };
+
+
+
+    template <class StokesMatrixType, class ABlockMatrixType, class SchurComplementMatrixType,
+              class ABlockPreconditionerType>
+    BlockSchurGMGPreconditioner<StokesMatrixType, ABlockMatrixType, SchurComplementMatrixType, ABlockPreconditionerType>::
+    BlockSchurGMGPreconditioner (const StokesMatrixType          &Stokes_matrix,
+                                 const ABlockMatrixType          &A_block,
+                                 const SchurComplementMatrixType &Schur_complement_block,
+                                 const ABlockPreconditionerType  &A_block_preconditioner,
+                                 const bool                       do_solve_A,
+                                 const double                     A_block_tolerance,
+                                 const double                     S_block_tolerance)
+      :
+      stokes_matrix     (Stokes_matrix),
+      velocity_matrix   (A_block),
+      mass_matrix       (Schur_complement_block),
+      mg_preconditioner (A_block_preconditioner),
+      do_solve_A        (do_solve_A),
+      n_iterations_A_(0),
+      n_iterations_S_(0),
+      A_block_tolerance(A_block_tolerance),
+      S_block_tolerance(S_block_tolerance)
+    {}
+
+
+
+    template <class StokesMatrixType, class ABlockMatrixType, class SchurComplementMatrixType,
+              class ABlockPreconditionerType>
+    unsigned int
+    BlockSchurGMGPreconditioner<StokesMatrixType, ABlockMatrixType, SchurComplementMatrixType, ABlockPreconditionerType>::
+    n_iterations_A() const
+    {
+      return n_iterations_A_;
+    }
+
+
+
+    template <class StokesMatrixType, class ABlockMatrixType, class SchurComplementMatrixType,
+              class ABlockPreconditionerType>
+    unsigned int
+    BlockSchurGMGPreconditioner<StokesMatrixType, ABlockMatrixType, SchurComplementMatrixType, ABlockPreconditionerType>::
+    n_iterations_S() const
+    {
+      return n_iterations_S_;
+    }
+
+
+
+    template <class StokesMatrixType, class ABlockMatrixType, class SchurComplementMatrixType,
+              class ABlockPreconditionerType>
+    void
+    BlockSchurGMGPreconditioner<StokesMatrixType, ABlockMatrixType, SchurComplementMatrixType, ABlockPreconditionerType>::
+    vmult (dealii::LinearAlgebra::distributed::BlockVector<double>       &dst,
+           const dealii::LinearAlgebra::distributed::BlockVector<double> &src) const
+    {
+      dealii::LinearAlgebra::distributed::BlockVector<double> utmp(src);
+
+      // first solve with the bottom left block, which we have built
+      // as a mass matrix with the inverse of the viscosity
+      {
+        SolverControl solver_control(1000, src.block(1).l2_norm() * S_block_tolerance);
+        SolverCG<dealii::LinearAlgebra::distributed::Vector<double> > solver(solver_control);
+
+        // Skip the solve in case src=dst=0, for consistency with the
+        // matrix-based preconditioner
+        if (src.block(1).l2_norm() > 1e-50)
+          {
+            try
+              {
+                dst.block(1) = 0.0;
+                solver.solve(mass_matrix,
+                             dst.block(1), src.block(1),
+                             *mass_matrix.get_matrix_diagonal_inverse());
+                n_iterations_S_ += solver_control.last_step();
+              }
+            // if the solver fails, report the error from processor 0 with some additional
+            // information about its location, and throw a quiet exception on all other
+            // processors
+            catch (const std::exception &exc)
+              {
+                if (Utilities::MPI::this_mpi_process(src.block(0).get_mpi_communicator()) == 0)
+                  AssertThrow (false,
+                               ExcMessage (std::string("The iterative (bottom right) solver in BlockSchurGMGPreconditioner::vmult "
+                                                       "did not converge to a tolerance of "
+                                                       + Utilities::to_string(solver_control.tolerance()) +
+                                                       ". It reported the following error:\n\n")
+                                           +
+                                           exc.what()))
+                  else
+                    throw QuietException();
+              }
+          }
+        dst.block(1) *= -1.0;
+      }
+
+      // apply the top right block by applying the entire Stokes operator
+      // to a vector with zero velocity
+      {
+        dealii::LinearAlgebra::distributed::BlockVector<double> dst_tmp(dst);
+        dst_tmp.block(0) = 0.0;
+        stokes_matrix.vmult(utmp, dst_tmp); // B^T
+        utmp.block(0) *= -1.0;
+        utmp.block(0) += src.block(0);
+      }
+
+      // now either solve with the top left block (if do_solve_A==true)
+      // or just apply one preconditioner sweep (for the first few
+      // iterations of our two-stage outer GMRES iteration)
+      if (do_solve_A == true)
+        {
+          SolverControl solver_control(10000, utmp.block(0).l2_norm() * A_block_tolerance);
+          SolverCG<dealii::LinearAlgebra::distributed::Vector<double> > solver(solver_control);
+          try
+            {
+              dst.block(0) = 0.0;
+              solver.solve(velocity_matrix, dst.block(0), utmp.block(0),
+                           mg_preconditioner);
+              n_iterations_A_ += solver_control.last_step();
+            }
+          // if the solver fails, report the error from processor 0 with some additional
+          // information about its location, and throw a quiet exception on all other
+          // processors
+          catch (const std::exception &exc)
+            {
+              if (Utilities::MPI::this_mpi_process(src.block(0).get_mpi_communicator()) == 0)
+                AssertThrow (false,
+                             ExcMessage (std::string("The iterative (top left) solver in BlockSchurGMGPreconditioner::vmult "
+                                                     "did not converge to a tolerance of "
+                                                     + Utilities::to_string(solver_control.tolerance()) +
+                                                     ". It reported the following error:\n\n")
+                                         +
+                                         exc.what()))
+                else
+                  throw QuietException();
+            }
+        }
+      else
+        {
+          mg_preconditioner.vmult (dst.block(0), utmp.block(0));
+          n_iterations_A_ += 1;
+        }
+    }
+  }
+
+
+
+  namespace MatrixFreeStokesOperators
+  {
+    template <int dim, typename number>
+    std::size_t
+    OperatorCellData<dim,number>::memory_consumption () const
+    {
+      return viscosity_x_2.memory_consumption() + sizeof(*this);
+    }
+
+
+
+    template <int dim, int degree_v, typename number>
+    StokesOperator<dim,degree_v,number>::StokesOperator ()
+      :
+      MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::BlockVector<number> >(),
+      cell_data (nullptr)
+    {}
+
+
+
+    template <int dim, int degree_v, typename number>
+    void
+    StokesOperator<dim,degree_v,number>::clear ()
+    {
+      cell_data = nullptr;
+      MatrixFreeOperators::Base<dim,dealii::LinearAlgebra::distributed::BlockVector<number> >::clear();
+    }
+
+
+
+    template <int dim, int degree_v, typename number>
+    void
+    StokesOperator<dim,degree_v,number>::
+    set_cell_data (const OperatorCellData<dim,number> &data)
+    {
+      cell_data = &data;
+    }
+
+
+
+    template <int dim, int degree_v, typename number>
+    void
+    StokesOperator<dim,degree_v,number>::compute_diagonal ()
+    {
+      // There is currently no need in the code for the diagonal of the entire Stokes
+      // block. If needed, one could easily construct based on the diagonal of the A
+      // block and append zeros to the end for the number of pressure DoFs.
+      Assert(false, ExcNotImplemented());
+    }
+
+
+
+    template <int dim, int degree_v, typename number>
+    void
+    StokesOperator<dim,degree_v,number>::
+    local_apply (const dealii::MatrixFree<dim, number> &data,
+                 dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+                 const dealii::LinearAlgebra::distributed::BlockVector<number> &src,
+                 const std::pair<unsigned int, unsigned int> &cell_range) const
+    {
+      do_local_apply (data, dst, src, cell_range, true);
+    }
+
+
+
+    template <int dim, int degree_v, typename number>
+    void
+    StokesOperator<dim,degree_v,number>::
+    local_apply_without_constraints (const dealii::MatrixFree<dim, number> &data,
+                                     dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+                                     const dealii::LinearAlgebra::distributed::BlockVector<number> &src,
+                                     const std::pair<unsigned int, unsigned int> &cell_range) const
+    {
+      do_local_apply (data, dst, src, cell_range, false);
+    }
+
+
+
+    template <int dim, int degree_v, typename number>
+    void
+    StokesOperator<dim,degree_v,number>::
+    do_local_apply (const dealii::MatrixFree<dim, number> &data,
+                    dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+                    const dealii::LinearAlgebra::distributed::BlockVector<number> &src,
+                    const std::pair<unsigned int, unsigned int> &cell_range,
+                    const bool resolve_constraints) const
+    {
+      typedef VectorizedArray<number> vector_t;
+      FEEvaluation<dim,degree_v,degree_v+1,dim,number> velocity (data, 0);
+      FEEvaluation<dim,degree_v-1,degree_v+1,1,number> pressure (data, 1);
+
+      const number pressure_scaling = cell_data->pressure_scaling;
+
+      for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+        {
+          velocity.reinit (cell);
+          pressure.reinit (cell);
+          if (resolve_constraints)
+            {
+              velocity.read_dof_values (src.block(0));
+              pressure.read_dof_values (src.block(1));
+            }
+          else
+            {
+              velocity.read_dof_values_plain (src.block(0));
+              pressure.read_dof_values_plain (src.block(1));
+            }
+          velocity.evaluate (false,true,false);
+          pressure.evaluate (true,false,false);
+
+          for (unsigned int q=0; q<velocity.n_q_points; ++q)
+            {
+              const vector_t viscosity_x_2 = cell_data->viscosity_x_2(cell,q);
+
+              SymmetricTensor<2,dim,vector_t> sym_grad_u =
+                velocity.get_symmetric_gradient (q);
+              const vector_t pres = pressure.get_value(q);
+              const vector_t div = trace(sym_grad_u);
+
+              // assemble the term -div(u) as -(div u, q)
+              pressure.submit_value (-pressure_scaling*div, q);
+
+              sym_grad_u *= viscosity_x_2;
+
+              for (unsigned int d=0; d<dim; ++d)
+                {
+                  if (cell_data->is_compressible)
+                    sym_grad_u[d][d] -= viscosity_x_2/number(3.0)*div;
+
+                  // assemble \nabla p as -(p, div v)
+                  sym_grad_u[d][d] -= pressure_scaling*pres;
+                }
+
+              velocity.submit_symmetric_gradient(sym_grad_u, q);
+            }
+
+          velocity.integrate (false,true);
+          velocity.distribute_local_to_global (dst.block(0));
+          pressure.integrate (true,false);
+          pressure.distribute_local_to_global (dst.block(1));
+        }
+    }
+
+
+
+    template <int dim, int degree_v, typename number>
+    void
+    StokesOperator<dim,degree_v,number>::
+    apply_add (dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+               const dealii::LinearAlgebra::distributed::BlockVector<number> &src) const
+    {
+      Assert(cell_data != nullptr, ExcNotInitialized());
+      MatrixFreeOperators::Base<dim,dealii::LinearAlgebra::distributed::BlockVector<number> >::
+      data->cell_loop(&StokesOperator::local_apply, this, dst, src);
+    }
+
+
+
+    template <int dim, int degree_v, typename number>
+    void
+    StokesOperator<dim,degree_v,number>::
+    apply_without_constraints (dealii::LinearAlgebra::distributed::BlockVector<number> &dst,
+                               const dealii::LinearAlgebra::distributed::BlockVector<number> &src) const
+    {
+      Assert(cell_data != nullptr, ExcNotInitialized());
+      dst = 0.;
+      MatrixFreeOperators::Base<dim,dealii::LinearAlgebra::distributed::BlockVector<number> >::
+      data->cell_loop(&StokesOperator::local_apply_without_constraints, this, dst, src);
+    }
+
+
+
+    template <int dim, int degree_p, typename number>
+    MassMatrixOperator<dim,degree_p,number>::MassMatrixOperator ()
+      :
+      MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::Vector<number> >(),
+      cell_data (nullptr)
+    {}
+
+
+
+    template <int dim, int degree_p, typename number>
+    void
+    MassMatrixOperator<dim,degree_p,number>::clear ()
+    {
+      cell_data = nullptr;
+      MatrixFreeOperators::Base<dim,dealii::LinearAlgebra::distributed::Vector<number> >::clear();
+    }
+
+
+
+    template <int dim, int degree_p, typename number>
+    void
+    MassMatrixOperator<dim,degree_p,number>::
+    set_cell_data (const OperatorCellData<dim,number> &data)
+    {
+      cell_data = &data;
+    }
+
+
+
+    template <int dim, int degree_p, typename number>
+    void
+    MassMatrixOperator<dim,degree_p,number>::
+    local_apply (const dealii::MatrixFree<dim, number> &data,
+                 dealii::LinearAlgebra::distributed::Vector<number> &dst,
+                 const dealii::LinearAlgebra::distributed::Vector<number> &src,
+                 const std::pair<unsigned int, unsigned int> &cell_range) const
+    {
+      typedef VectorizedArray<number> vector_t;
+      FEEvaluation<dim,degree_p,degree_p+2,1,number> pressure (data, 1);
+
+      const number pressure_scaling = cell_data->pressure_scaling;
+
+      for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+        {
+          pressure.reinit (cell);
+          pressure.read_dof_values(src);
+          pressure.evaluate (true, false);
+          for (unsigned int q=0; q<pressure.n_q_points; ++q)
+            {
+              const vector_t one_over_viscosity = number(2.0) / cell_data->viscosity_x_2(cell,q);
+              pressure.submit_value(one_over_viscosity*pressure_scaling*pressure_scaling*
+                                    pressure.get_value(q),q);
+            }
+          pressure.integrate (true, false);
+          pressure.distribute_local_to_global (dst);
+        }
+    }
+
+
+
+    template <int dim, int degree_p, typename number>
+    void
+    MassMatrixOperator<dim,degree_p,number>::
+    apply_add (dealii::LinearAlgebra::distributed::Vector<number> &dst,
+               const dealii::LinearAlgebra::distributed::Vector<number> &src) const
+    {
+      Assert(cell_data != nullptr, ExcNotInitialized());
+      MatrixFreeOperators::Base<dim,dealii::LinearAlgebra::distributed::Vector<number> >::
+      data->cell_loop(&MassMatrixOperator::local_apply, this, dst, src);
+    }
+
+
+
+    template <int dim, int degree_p, typename number>
+    void
+    MassMatrixOperator<dim,degree_p,number>::compute_diagonal ()
+    {
+      this->inverse_diagonal_entries.
+      reset(new DiagonalMatrix<dealii::LinearAlgebra::distributed::Vector<number> >());
+      dealii::LinearAlgebra::distributed::Vector<number> &inverse_diagonal =
+        this->inverse_diagonal_entries->get_vector();
+      this->initialize_dof_vector(inverse_diagonal);
+
+      unsigned int dummy = 0;
+      this->data->cell_loop (&MassMatrixOperator::local_compute_diagonal, this,
+                             inverse_diagonal, dummy);
+
+      this->set_constrained_entries_to_one(inverse_diagonal);
+
+      for (unsigned int i=0; i<inverse_diagonal.local_size(); ++i)
+        {
+          Assert(inverse_diagonal.local_element(i) > 0.,
+                 ExcMessage("No diagonal entry in a positive definite operator "
+                            "should be zero or negative."));
+          inverse_diagonal.local_element(i) = 1./inverse_diagonal.local_element(i);
+        }
+    }
+
+
+
+    template <int dim, int degree_p, typename number>
+    void
+    MassMatrixOperator<dim,degree_p,number>::
+    local_compute_diagonal (const MatrixFree<dim,number> &data,
+                            dealii::LinearAlgebra::distributed::Vector<number> &dst,
+                            const unsigned int &,
+                            const std::pair<unsigned int,unsigned int> &cell_range) const
+    {
+      typedef VectorizedArray<number> vector_t;
+      FEEvaluation<dim,degree_p,degree_p+2,1,number> pressure (data, 1);
+
+      const number pressure_scaling = cell_data->pressure_scaling;
+
+      AlignedVector<vector_t> diagonal(pressure.dofs_per_cell);
+
+      for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+        {
+          pressure.reinit (cell);
+          for (unsigned int i=0; i<pressure.dofs_per_cell; ++i)
+            {
+              for (unsigned int j=0; j<pressure.dofs_per_cell; ++j)
+                pressure.begin_dof_values()[j] = vector_t();
+              pressure.begin_dof_values()[i] = make_vectorized_array<number> (1.);
+
+              pressure.evaluate (true,false,false);
+              for (unsigned int q=0; q<pressure.n_q_points; ++q)
+                {
+                  const vector_t one_over_viscosity = number(2.0) / cell_data->viscosity_x_2(cell,q);
+                  pressure.submit_value(one_over_viscosity*pressure_scaling*pressure_scaling*
+                                        pressure.get_value(q),q);
+                }
+              pressure.integrate (true,false);
+
+              diagonal[i] = pressure.begin_dof_values()[i];
+            }
+
+          for (unsigned int i=0; i<pressure.dofs_per_cell; ++i)
+            pressure.begin_dof_values()[i] = diagonal[i];
+          pressure.distribute_local_to_global (dst);
+        }
+    }
+
+
+
+    template <int dim, int degree_v, typename number>
+    ABlockOperator<dim,degree_v,number>::ABlockOperator ()
+      :
+      MatrixFreeOperators::Base<dim, dealii::LinearAlgebra::distributed::Vector<number> >(),
+      cell_data (nullptr)
+    {}
+
+
+
+    template <int dim, int degree_v, typename number>
+    void
+    ABlockOperator<dim,degree_v,number>::clear ()
+    {
+      cell_data = nullptr;
+      MatrixFreeOperators::Base<dim,dealii::LinearAlgebra::distributed::Vector<number> >::clear();
+    }
+
+
+
+    template <int dim, int degree_v, typename number>
+    void
+    ABlockOperator<dim,degree_v,number>::
+    set_cell_data (const OperatorCellData<dim,number> &data)
+    {
+      cell_data = &data;
+    }
+
+
+
+    template <int dim, int degree_v, typename number>
+    void
+    ABlockOperator<dim,degree_v,number>::
+    local_apply (const dealii::MatrixFree<dim, number> &data,
+                 dealii::LinearAlgebra::distributed::Vector<number> &dst,
+                 const dealii::LinearAlgebra::distributed::Vector<number> &src,
+                 const std::pair<unsigned int, unsigned int> &cell_range) const
+    {
+      typedef VectorizedArray<number> vector_t;
+      FEEvaluation<dim,degree_v,degree_v+1,dim,number> velocity (data, 0);
+
+      for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+        {
+          velocity.reinit (cell);
+          velocity.read_dof_values(src);
+          velocity.evaluate (false, true, false);
+          for (unsigned int q=0; q<velocity.n_q_points; ++q)
+            {
+              const vector_t viscosity_x_2 = cell_data->viscosity_x_2(cell,q);
+
+              SymmetricTensor<2,dim,vector_t> sym_grad_u =
+                velocity.get_symmetric_gradient (q);
+              const vector_t div = trace(sym_grad_u);
+
+              sym_grad_u *= viscosity_x_2;
+
+              if (cell_data->is_compressible)
+                for (unsigned int d=0; d<dim; ++d)
+                  sym_grad_u[d][d] -= viscosity_x_2/number(3.0)*div;
+
+              velocity.submit_symmetric_gradient(sym_grad_u, q);
+            }
+          velocity.integrate (false, true);
+          velocity.distribute_local_to_global (dst);
+        }
+    }
+
+
+
+    template <int dim, int degree_v, typename number>
+    void
+    ABlockOperator<dim,degree_v,number>::
+    apply_add (dealii::LinearAlgebra::distributed::Vector<number> &dst,
+               const dealii::LinearAlgebra::distributed::Vector<number> &src) const
+    {
+      Assert(cell_data != nullptr, ExcNotInitialized());
+      MatrixFreeOperators::Base<dim,dealii::LinearAlgebra::distributed::Vector<number> >::
+      data->cell_loop(&ABlockOperator::local_apply, this, dst, src);
+    }
+
+
+
+    template <int dim, int degree_v, typename number>
+    void
+    ABlockOperator<dim,degree_v,number>::compute_diagonal ()
+    {
+      this->inverse_diagonal_entries.
+      reset(new DiagonalMatrix<dealii::LinearAlgebra::distributed::Vector<number> >());
+      dealii::LinearAlgebra::distributed::Vector<number> &inverse_diagonal =
+        this->inverse_diagonal_entries->get_vector();
+      this->initialize_dof_vector(inverse_diagonal);
+
+      unsigned int dummy = 0;
+      this->data->cell_loop (&ABlockOperator::local_compute_diagonal, this,
+                             inverse_diagonal, dummy);
+
+      this->set_constrained_entries_to_one(inverse_diagonal);
+
+      for (unsigned int i=0; i<inverse_diagonal.local_size(); ++i)
+        {
+          Assert(inverse_diagonal.local_element(i) > 0.,
+                 ExcMessage("No diagonal entry in a positive definite operator "
+                            "should be zero or negative."));
+          inverse_diagonal.local_element(i) = 1./inverse_diagonal.local_element(i);
+        }
+    }
+
+
+
+    template <int dim, int degree_v, typename number>
+    void
+    ABlockOperator<dim,degree_v,number>::
+    local_compute_diagonal (const MatrixFree<dim,number> &data,
+                            dealii::LinearAlgebra::distributed::Vector<number> &dst,
+                            const unsigned int &,
+                            const std::pair<unsigned int,unsigned int> &cell_range) const
+    {
+      typedef VectorizedArray<number> vector_t;
+      FEEvaluation<dim,degree_v,degree_v+1,dim,number> velocity (data, 0);
+
+      AlignedVector<vector_t> diagonal(velocity.dofs_per_cell);
+
+      for (unsigned int cell=cell_range.first; cell<cell_range.second; ++cell)
+        {
+          velocity.reinit (cell);
+          for (unsigned int i=0; i<velocity.dofs_per_cell; ++i)
+            {
+              for (unsigned int j=0; j<velocity.dofs_per_cell; ++j)
+                velocity.begin_dof_values()[j] = vector_t();
+              velocity.begin_dof_values()[i] = make_vectorized_array<number> (1.);
+
+              velocity.evaluate (false,true,false);
+              for (unsigned int q=0; q<velocity.n_q_points; ++q)
+                {
+                  const vector_t viscosity_x_2 = cell_data->viscosity_x_2(cell,q);
+
+                  SymmetricTensor<2,dim,vector_t> sym_grad_u =
+                    velocity.get_symmetric_gradient (q);
+                  const vector_t div = trace(sym_grad_u);
+
+                  sym_grad_u *= viscosity_x_2;
+
+                  if (cell_data->is_compressible)
+                    for (unsigned int d=0; d<dim; ++d)
+                      sym_grad_u[d][d] -= viscosity_x_2/number(3.0)*div;
+
+                  velocity.submit_symmetric_gradient(sym_grad_u, q);
+                }
+              velocity.integrate (false,true);
+
+              diagonal[i] = velocity.begin_dof_values()[i];
+            }
+
+          for (unsigned int i=0; i<velocity.dofs_per_cell; ++i)
+            velocity.begin_dof_values()[i] = diagonal[i];
+          velocity.distribute_local_to_global (dst);
+        }
+    }
+  }
+
+
+
+  namespace
+  {
+    /**
+     * Translate the component selector of a prescribed velocity boundary
+     * (a string like "xz", or an empty string for all components) into a
+     * component mask for an element with @p dim velocity components.
+     */
+    template <int dim>
+    ComponentMask
+    velocity_component_mask (const std::string &components)
+    {
+      if (components.length() == 0)
+        return ComponentMask(dim, true);
+
+      ComponentMask mask(dim, false);
+      for (const char direction : components)
+        {
+          switch (direction)
+            {
+              case 'x':
+                mask.set(0, true);
+                break;
+              case 'y':
+                mask.set(1, true);
+                break;
+              case 'z':
+                // we must be in 3d, or 'z' should never have gotten through
+                Assert (dim==3, ExcInternalError());
+                if (dim==3)
+                  mask.set(dim-1, true);
+                break;
+              default:
+                Assert (false, ExcInternalError());
+            }
+        }
+      return mask;
+    }
+  }
+
+
+
+  template <int dim, int velocity_degree>
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree>::
+  StokesMatrixFreeHandlerImplementation (Simulator<dim> &simulator,
+                                         ParameterHandler &prm)
+    :
+    sim(simulator),
+    dof_handler_v(simulator.triangulation),
+    dof_handler_p(simulator.triangulation),
+    dof_handler_projection(simulator.triangulation),
+    fe_v (FE_Q<dim>(velocity_degree), dim),
+    fe_p (FE_Q<dim>(velocity_degree-1), 1),
+    fe_projection(0)
+  {
+    parse_parameters(prm);
+
+    AssertThrow(!sim.parameters.free_surface_enabled,
+                ExcMessage("The 'block GMG' Stokes solver does not support a free surface."));
+    AssertThrow(sim.geometry_model->get_periodic_boundary_pairs().size() == 0,
+                ExcMessage("The 'block GMG' Stokes solver does not support periodic boundaries."));
+
+    // On the multigrid levels, no-normal-flux boundaries are represented by
+    // constraining the velocity component normal to the boundary, which is
+    // only correct if all boundaries are aligned with the coordinate axes.
+    AssertThrow(sim.boundary_velocity_manager.get_tangential_boundary_velocity_indicators().empty()
+                ||
+                (dynamic_cast<const GeometryModel::Box<dim>*>(sim.geometry_model.get()) != nullptr
+                 &&
+                 dynamic_cast<const MappingCartesian<dim>*>(sim.mapping.get()) != nullptr),
+                ExcMessage("The 'block GMG' Stokes solver only supports tangential velocity "
+                           "boundaries in box geometries without initial topography."));
+  }
+
+
+
+  template <int dim, int velocity_degree>
+  void
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree>::
+  parse_parameters (ParameterHandler &prm)
+  {
+    prm.enter_subsection ("Solver parameters");
+    {
+      prm.enter_subsection ("Matrix Free");
+      {
+        chebyshev_degree          = prm.get_integer ("GMG Chebyshev degree");
+        chebyshev_smoothing_range = prm.get_double ("GMG Chebyshev smoothing range");
+      }
+      prm.leave_subsection ();
+    }
+    prm.leave_subsection ();
+  }
+
+
+
+  template <int dim, int velocity_degree>
+  void
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree>::
+  setup_mg_boundary_constraints ()
+  {
+    const BoundaryVelocity::Manager<dim> &bv = sim.boundary_velocity_manager;
+
+    if (!bv.get_zero_boundary_velocity_indicators().empty())
+      mg_constrained_dofs.make_zero_boundary_constraints(dof_handler_v,
+                                                         bv.get_zero_boundary_velocity_indicators());
+
+    // prescribed velocities enter the right hand side, the operator
+    // only sees homogeneous constraints on these boundaries
+    for (const auto &p : bv.get_active_boundary_velocity_names())
+      mg_constrained_dofs.make_zero_boundary_constraints(dof_handler_v,
+                                                         std::set<types::boundary_id> {p.first},
+                                                         velocity_component_mask<dim>(p.second.first));
+
+    // in a box, the boundary with indicator 2*d or 2*d+1 has the normal
+    // vector e_d, so that a no-normal-flux condition just constrains the
+    // d-th velocity component
+    for (const types::boundary_id boundary_id : bv.get_tangential_boundary_velocity_indicators())
+      {
+        ComponentMask mask(dim, false);
+        mask.set(boundary_id / 2, true);
+        mg_constrained_dofs.make_zero_boundary_constraints(dof_handler_v,
+                                                           std::set<types::boundary_id> {boundary_id},
+                                                           mask);
+      }
+  }
+
+
+
+  template <int dim, int velocity_degree>
+  void
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree>::
+  setup_dofs ()
+  {
+    const MPI_Comm mpi_communicator = sim.mpi_communicator;
+    const BoundaryVelocity::Manager<dim> &bv = sim.boundary_velocity_manager;
+    const unsigned int n_levels = sim.triangulation.n_global_levels();
+    const unsigned int n_q_points = Utilities::fixed_power<dim>(velocity_degree+1);
+    const bool is_compressible = sim.material_model->is_compressible();
+
+    // Velocity DoFHandler. We number the degrees of freedom in the same
+    // way as the Simulator does, so that the velocity block of the
+    // Simulator's vectors can be copied element by element
+    {
+      dof_handler_v.clear();
+      dof_handler_v.distribute_dofs(fe_v);
+      DoFRenumbering::hierarchical(dof_handler_v);
+      dof_handler_v.distribute_mg_dofs();
+
+      Assert(dof_handler_v.locally_owned_dofs() ==
+             sim.introspection.index_sets.system_partitioning[sim.introspection.block_indices.velocities],
+             ExcMessage("The numbering of the velocity DoFs of the matrix-free Stokes solver "
+                        "does not match the numbering of the Simulator."));
+
+      IndexSet locally_relevant_dofs;
+      DoFTools::extract_locally_relevant_dofs (dof_handler_v,
+                                               locally_relevant_dofs);
+      constraints_v.clear();
+      constraints_v.reinit(locally_relevant_dofs);
+      DoFTools::make_hanging_node_constraints (dof_handler_v, constraints_v);
+
+      for (const types::boundary_id boundary_id : bv.get_zero_boundary_velocity_indicators())
+        VectorTools::interpolate_boundary_values (*sim.mapping,
+                                                  dof_handler_v,
+                                                  boundary_id,
+                                                  ZeroFunction<dim>(dim),
+                                                  constraints_v);
+
+      for (const auto &p : bv.get_active_boundary_velocity_names())
+        VectorTools::interpolate_boundary_values (*sim.mapping,
+                                                  dof_handler_v,
+                                                  p.first,
+                                                  ZeroFunction<dim>(dim),
+                                                  constraints_v,
+                                                  velocity_component_mask<dim>(p.second.first));
+
+      VectorTools::compute_no_normal_flux_constraints (dof_handler_v,
+                                                       /* first_vector_component= */ 0,
+                                                       bv.get_tangential_boundary_velocity_indicators(),
+                                                       constraints_v,
+                                                       *sim.mapping);
+      constraints_v.close();
+    }
+
+    // Pressure DoFHandler
+    {
+      dof_handler_p.clear();
+      dof_handler_p.distribute_dofs(fe_p);
+      DoFRenumbering::hierarchical(dof_handler_p);
+
+      Assert(dof_handler_p.locally_owned_dofs() ==
+             sim.introspection.index_sets.system_partitioning[sim.introspection.block_indices.pressure],
+             ExcMessage("The numbering of the pressure DoFs of the matrix-free Stokes solver "
+                        "does not match the numbering of the Simulator."));
+
+      IndexSet locally_relevant_dofs;
+      DoFTools::extract_locally_relevant_dofs (dof_handler_p,
+                                               locally_relevant_dofs);
+      constraints_p.clear();
+      constraints_p.reinit(locally_relevant_dofs);
+      DoFTools::make_hanging_node_constraints (dof_handler_p, constraints_p);
+      constraints_p.close();
+    }
+
+    // Piecewise constant DoFHandler used to move the viscosity to the levels
+    {
+      dof_handler_projection.clear();
+      dof_handler_projection.distribute_dofs(fe_projection);
+      dof_handler_projection.distribute_mg_dofs();
+
+      IndexSet locally_relevant_dofs;
+      DoFTools::extract_locally_relevant_dofs (dof_handler_projection,
+                                               locally_relevant_dofs);
+      active_viscosity_vector.reinit(dof_handler_projection.locally_owned_dofs(),
+                                     locally_relevant_dofs,
+                                     mpi_communicator);
+
+      mg_constrained_dofs_projection.clear();
+      mg_constrained_dofs_projection.initialize(dof_handler_projection);
+      mg_transfer_projection.clear();
+      mg_transfer_projection.initialize_constraints(mg_constrained_dofs_projection);
+      mg_transfer_projection.build(dof_handler_projection);
+
+      level_viscosity_vector.resize(0, n_levels-1);
+    }
+
+    // Matrix-free objects on the active level
+    {
+      typename MatrixFree<dim,double>::AdditionalData additional_data;
+      additional_data.tasks_parallel_scheme =
+        MatrixFree<dim,double>::AdditionalData::none;
+      additional_data.mapping_update_flags = (update_values | update_gradients |
+                                              update_JxW_values | update_quadrature_points);
+
+      const std::vector<const DoFHandler<dim>*> stokes_dofs = {&dof_handler_v, &dof_handler_p};
+      const std::vector<const ConstraintMatrix *> stokes_constraints = {&constraints_v, &constraints_p};
+
+      std::shared_ptr<MatrixFree<dim,double> > stokes_mf_storage(new MatrixFree<dim,double>());
+      stokes_mf_storage->reinit(*sim.mapping, stokes_dofs, stokes_constraints,
+                                QGauss<1>(velocity_degree+1), additional_data);
+
+      active_cell_data.viscosity_x_2.reinit(TableIndices<2>(stokes_mf_storage->n_macro_cells(),
+                                                            n_q_points));
+      active_cell_data.pressure_scaling = sim.pressure_scaling;
+      active_cell_data.is_compressible = is_compressible;
+
+      stokes_matrix.clear();
+      stokes_matrix.initialize(stokes_mf_storage);
+      stokes_matrix.set_cell_data(active_cell_data);
+
+      // the A block and the Schur complement approximation work on the
+      // velocity and pressure DoFHandler of the same MatrixFree object
+      velocity_matrix.clear();
+      velocity_matrix.initialize(stokes_mf_storage, std::vector<unsigned int> {0});
+      velocity_matrix.set_cell_data(active_cell_data);
+
+      mass_matrix.clear();
+      mass_matrix.initialize(stokes_mf_storage, std::vector<unsigned int> {1});
+      mass_matrix.set_cell_data(active_cell_data);
+    }
+
+    // Matrix-free objects on the multigrid levels
+    {
+      mg_constrained_dofs.clear();
+      mg_constrained_dofs.initialize(dof_handler_v);
+      setup_mg_boundary_constraints();
+
+      mg_matrices.clear_elements();
+      mg_matrices.resize(0, n_levels-1);
+      level_cell_data.resize(0, n_levels-1);
+      mg_interface_matrices.clear_elements();
+      mg_interface_matrices.resize(0, n_levels-1);
+
+      for (unsigned int level=0; level<n_levels; ++level)
+        {
+          IndexSet relevant_dofs;
+          DoFTools::extract_locally_relevant_level_dofs(dof_handler_v, level, relevant_dofs);
+          ConstraintMatrix level_constraints;
+          level_constraints.reinit(relevant_dofs);
+          level_constraints.add_lines(mg_constrained_dofs.get_boundary_indices(level));
+          level_constraints.close();
+
+          typename MatrixFree<dim,GMGNumberType>::AdditionalData additional_data;
+          additional_data.tasks_parallel_scheme =
+            MatrixFree<dim,GMGNumberType>::AdditionalData::none;
+          additional_data.mapping_update_flags = (update_gradients | update_JxW_values |
+                                                  update_quadrature_points);
+          additional_data.level_mg_handler = level;
+
+          std::shared_ptr<MatrixFree<dim,GMGNumberType> > mg_mf_storage_level(new MatrixFree<dim,GMGNumberType>());
+          mg_mf_storage_level->reinit(*sim.mapping, dof_handler_v, level_constraints,
+                                      QGauss<1>(velocity_degree+1), additional_data);
+
+          level_cell_data[level].viscosity_x_2.reinit(TableIndices<2>(mg_mf_storage_level->n_macro_cells(),
+                                                                      n_q_points));
+          level_cell_data[level].pressure_scaling = sim.pressure_scaling;
+          level_cell_data[level].is_compressible = is_compressible;
+
+          mg_matrices[level].clear();
+          mg_matrices[level].initialize(mg_mf_storage_level, mg_constrained_dofs, level);
+          mg_matrices[level].set_cell_data(level_cell_data[level]);
+
+          mg_interface_matrices[level].initialize(mg_matrices[level]);
+        }
+
+      mg_transfer.clear();
+      mg_transfer.initialize_constraints(mg_constrained_dofs);
+      mg_transfer.build(dof_handler_v);
+    }
+  }
+
+
+
+  template <int dim, int velocity_degree>
+  void
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree>::
+  evaluate_material_model ()
+  {
+    const QGauss<dim> quadrature_formula (velocity_degree+1);
+    const unsigned int n_q_points = quadrature_formula.size();
+
+    FEValues<dim> fe_values (*sim.mapping,
+                             sim.finite_element,
+                             quadrature_formula,
+                             update_values   |
+                             update_gradients |
+                             update_quadrature_points |
+                             update_JxW_values);
+
+    MaterialModel::MaterialModelInputs<dim> in(n_q_points, sim.introspection.n_compositional_fields);
+    MaterialModel::MaterialModelOutputs<dim> out(n_q_points, sim.introspection.n_compositional_fields);
+
+    std::vector<types::global_dof_index> local_dof_indices(fe_projection.dofs_per_cell);
+
+    const MatrixFree<dim,double> &matrix_free = *stokes_matrix.get_matrix_free();
+
+    // the pressure scaling may have changed since setup_dofs()
+    active_cell_data.pressure_scaling = sim.pressure_scaling;
+    active_viscosity_vector = 0.;
+
+    for (unsigned int cell=0; cell<matrix_free.n_macro_cells(); ++cell)
+      {
+        const unsigned int n_components_filled = matrix_free.n_components_filled(cell);
+        for (unsigned int i=0; i<n_components_filled; ++i)
+          {
+            const typename DoFHandler<dim>::cell_iterator matrix_free_cell = matrix_free.get_cell_iterator(cell,i);
+            const typename DoFHandler<dim>::active_cell_iterator simulator_cell (&sim.triangulation,
+                                                                                 matrix_free_cell->level(),
+                                                                                 matrix_free_cell->index(),
+                                                                                 &sim.dof_handler);
+
+            fe_values.reinit (simulator_cell);
+            sim.compute_material_model_input_values (sim.current_linearization_point,
+                                                     fe_values,
+                                                     simulator_cell,
+                                                     true,
+                                                     in);
+            sim.material_model->evaluate(in, out);
+            MaterialModel::MaterialAveraging::average (sim.parameters.material_averaging,
+                                                       simulator_cell,
+                                                       quadrature_formula,
+                                                       *sim.mapping,
+                                                       out);
+
+            double cell_viscosity = 0;
+            double cell_volume = 0;
+            for (unsigned int q=0; q<n_q_points; ++q)
+              {
+                active_cell_data.viscosity_x_2(cell,q)[i] = 2.0*out.viscosities[q];
+                cell_viscosity += out.viscosities[q] * fe_values.JxW(q);
+                cell_volume += fe_values.JxW(q);
+              }
+
+            const typename DoFHandler<dim>::active_cell_iterator projection_cell (&sim.triangulation,
+                                                                                   matrix_free_cell->level(),
+                                                                                   matrix_free_cell->index(),
+                                                                                   &dof_handler_projection);
+            projection_cell->get_dof_indices(local_dof_indices);
+            active_viscosity_vector(local_dof_indices[0]) = cell_viscosity / cell_volume;
+          }
+
+        // fill the unused lanes of the last cell batch with valid values
+        // so that the inverse of the viscosity is well defined there
+        for (unsigned int i=n_components_filled; i<VectorizedArray<double>::n_array_elements; ++i)
+          for (unsigned int q=0; q<n_q_points; ++q)
+            active_cell_data.viscosity_x_2(cell,q)[i] = active_cell_data.viscosity_x_2(cell,q)[0];
+      }
+    active_viscosity_vector.compress(VectorOperation::insert);
+
+    // then move the cell-wise viscosity to the multigrid levels
+    mg_transfer_projection.interpolate_to_mg(dof_handler_projection,
+                                             level_viscosity_vector,
+                                             active_viscosity_vector);
+    fill_level_cell_data();
+  }
+
+
+
+  template <int dim, int velocity_degree>
+  void
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree>::
+  fill_level_cell_data ()
+  {
+    const unsigned int n_q_points = Utilities::fixed_power<dim>(velocity_degree+1);
+    std::vector<types::global_dof_index> local_dof_indices(fe_projection.dofs_per_cell);
+
+    for (unsigned int level=0; level<sim.triangulation.n_global_levels(); ++level)
+      {
+        level_viscosity_vector[level].update_ghost_values();
+
+        const MatrixFree<dim,GMGNumberType> &matrix_free = *mg_matrices[level].get_matrix_free();
+        Table<2, VectorizedArray<GMGNumberType> > &viscosity_x_2 = level_cell_data[level].viscosity_x_2;
+        level_cell_data[level].pressure_scaling = sim.pressure_scaling;
+
+        for (unsigned int cell=0; cell<matrix_free.n_macro_cells(); ++cell)
+          {
+            const unsigned int n_components_filled = matrix_free.n_components_filled(cell);
+            for (unsigned int i=0; i<n_components_filled; ++i)
+              {
+                const typename DoFHandler<dim>::level_cell_iterator matrix_free_cell = matrix_free.get_cell_iterator(cell,i);
+                const typename DoFHandler<dim>::level_cell_iterator projection_cell (&sim.triangulation,
+                                                                                      matrix_free_cell->level(),
+                                                                                      matrix_free_cell->index(),
+                                                                                      &dof_handler_projection);
+                projection_cell->get_mg_dof_indices(local_dof_indices);
+
+                const GMGNumberType viscosity = level_viscosity_vector[level](local_dof_indices[0]);
+                for (unsigned int q=0; q<n_q_points; ++q)
+                  viscosity_x_2(cell,q)[i] = 2.0*viscosity;
+              }
+
+            for (unsigned int i=n_components_filled; i<VectorizedArray<GMGNumberType>::n_array_elements; ++i)
+              for (unsigned int q=0; q<n_q_points; ++q)
+                viscosity_x_2(cell,q)[i] = viscosity_x_2(cell,q)[0];
+          }
+      }
+  }
+
+
+
+  template <int dim, int velocity_degree>
+  void
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree>::
+  correct_stokes_rhs ()
+  {
+    // put the values of all (inhomogeneous) constraints into a vector
+    // that is zero otherwise
+    LinearAlgebra::BlockVector constrained_values (sim.introspection.index_sets.stokes_partitioning,
+                                                   sim.mpi_communicator);
+    constrained_values = 0.;
+    sim.current_constraints.distribute (constrained_values);
+    constrained_values.block(1) /= sim.pressure_scaling;
+
+    BlockVectorType u0, rhs_correction;
+    u0.reinit(2);
+    rhs_correction.reinit(2);
+    stokes_matrix.initialize_dof_vector(u0);
+    stokes_matrix.initialize_dof_vector(rhs_correction);
+    internal::ChangeVectorTypes::copy(u0, constrained_values);
+
+    // apply the Stokes operator without imposing the homogeneous
+    // constraints on the input, so that the constrained values enter
+    // the result, and subtract this from the right hand side
+    stokes_matrix.apply_without_constraints(rhs_correction, u0);
+
+    LinearAlgebra::BlockVector stokes_rhs_correction (sim.introspection.index_sets.stokes_partitioning,
+                                                      sim.mpi_communicator);
+    internal::ChangeVectorTypes::copy(stokes_rhs_correction, rhs_correction);
+
+    // the right hand side remains zero in constrained rows, as in the
+    // matrix-based assembly
+    sim.current_constraints.set_zero (stokes_rhs_correction);
+    sim.system_rhs.block(0) -= stokes_rhs_correction.block(0);
+    sim.system_rhs.block(1) -= stokes_rhs_correction.block(1);
+  }
+
+
+
+  template <int dim, int velocity_degree>
+  void
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree>::
+  build_preconditioner ()
+  {
+    const unsigned int n_levels = sim.triangulation.n_global_levels();
+
+    mass_matrix.compute_diagonal();
+
+    MGLevelObject<typename SmootherType::AdditionalData> smoother_data;
+    smoother_data.resize(0, n_levels-1);
+
+    for (unsigned int level=0; level<n_levels; ++level)
+      {
+        mg_matrices[level].compute_diagonal();
+
+        if (level > 0)
+          {
+            smoother_data[level].smoothing_range = chebyshev_smoothing_range;
+            smoother_data[level].degree = chebyshev_degree;
+            smoother_data[level].eig_cg_n_iterations = 10;
+          }
+        else
+          {
+            // on the coarsest level, use the Chebyshev iteration as
+            // a solver
+            smoother_data[0].smoothing_range = 1e-3;
+            smoother_data[0].degree = numbers::invalid_unsigned_int;
+            smoother_data[0].eig_cg_n_iterations = mg_matrices[0].m();
+          }
+        smoother_data[level].preconditioner = mg_matrices[level].get_matrix_diagonal_inverse();
+      }
+
+    mg_smoother.initialize(mg_matrices, smoother_data);
+    mg_coarse.initialize(mg_smoother);
+  }
+
+
+
+  template <int dim, int velocity_degree>
+  double
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree>::
+  compute_initial_stokes_residual ()
+  {
+    const unsigned int block_vel = sim.introspection.block_indices.velocities;
+    const unsigned int block_p = sim.introspection.block_indices.pressure;
+
+    // Put the pressure of the current linearization point into a vector
+    // with zero velocity, scale it, and move it into the vector type of
+    // the matrix-free operators
+    LinearAlgebra::BlockVector linearized_stokes_variables (sim.introspection.index_sets.stokes_partitioning,
+                                                            sim.mpi_communicator);
+    linearized_stokes_variables.block (block_p) = sim.current_linearization_point.block (block_p);
+    sim.denormalize_pressure (sim.last_pressure_normalization_adjustment,
+                              linearized_stokes_variables,
+                              sim.current_linearization_point);
+    sim.current_constraints.set_zero (linearized_stokes_variables);
+    linearized_stokes_variables.block (block_p) /= sim.pressure_scaling;
+
+    BlockVectorType pressure_only, rhs_copy, tmp;
+    pressure_only.reinit(2);
+    rhs_copy.reinit(2);
+    tmp.reinit(2);
+    stokes_matrix.initialize_dof_vector(pressure_only);
+    stokes_matrix.initialize_dof_vector(rhs_copy);
+    stokes_matrix.initialize_dof_vector(tmp);
+
+    internal::ChangeVectorTypes::copy(pressure_only, linearized_stokes_variables);
+    {
+      LinearAlgebra::BlockVector distributed_stokes_rhs (sim.introspection.index_sets.stokes_partitioning,
+                                                         sim.mpi_communicator);
+      distributed_stokes_rhs.block(block_vel) = sim.system_rhs.block(block_vel);
+      distributed_stokes_rhs.block(block_p) = sim.system_rhs.block(block_p);
+      internal::ChangeVectorTypes::copy(rhs_copy, distributed_stokes_rhs);
+    }
+
+    // with zero velocity, the velocity part of the residual is only the
+    // part of the right hand side not balanced by the static pressure
+    stokes_matrix.vmult(tmp, pressure_only);
+    tmp.block(0).sadd(-1.0, 1.0, rhs_copy.block(0));
+
+    const double residual_u = tmp.block(0).l2_norm();
+    const double residual_p = rhs_copy.block(1).l2_norm();
+
+    return std::sqrt(residual_u*residual_u+residual_p*residual_p);
+  }
+
+
+
+  template <int dim, int velocity_degree>
+  std::pair<double,double>
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree>::
+  solve (LinearAlgebra::BlockVector &distributed_stokes_solution)
+  {
+    const unsigned int block_vel = sim.introspection.block_indices.velocities;
+    const unsigned int block_p = sim.introspection.block_indices.pressure;
+    Assert(block_vel == 0, ExcNotImplemented());
+    Assert(block_p == 1, ExcNotImplemented());
+
+    double initial_nonlinear_residual = numbers::signaling_nan<double>();
+    double final_linear_residual      = numbers::signaling_nan<double>();
+
+    // Put the current linearization point into a completely distributed
+    // vector, scale the pressure, and move it into the vector type of the
+    // matrix-free operators
+    LinearAlgebra::BlockVector linearized_stokes_initial_guess (sim.introspection.index_sets.stokes_partitioning,
+                                                                sim.mpi_communicator);
+    linearized_stokes_initial_guess.block (block_vel) = sim.current_linearization_point.block (block_vel);
+    linearized_stokes_initial_guess.block (block_p) = sim.current_linearization_point.block (block_p);
+    sim.denormalize_pressure (sim.last_pressure_normalization_adjustment,
+                              linearized_stokes_initial_guess,
+                              sim.current_linearization_point);
+    sim.current_constraints.set_zero (linearized_stokes_initial_guess);
+    linearized_stokes_initial_guess.block (block_p) /= sim.pressure_scaling;
+
+    BlockVectorType solution_copy, rhs_copy, tmp;
+    solution_copy.reinit(2);
+    rhs_copy.reinit(2);
+    tmp.reinit(2);
+    stokes_matrix.initialize_dof_vector(solution_copy);
+    stokes_matrix.initialize_dof_vector(rhs_copy);
+    stokes_matrix.initialize_dof_vector(tmp);
+
+    internal::ChangeVectorTypes::copy(solution_copy, linearized_stokes_initial_guess);
+    {
+      LinearAlgebra::BlockVector distributed_stokes_rhs (sim.introspection.index_sets.stokes_partitioning,
+                                                         sim.mpi_communicator);
+      distributed_stokes_rhs.block(block_vel) = sim.system_rhs.block(block_vel);
+      distributed_stokes_rhs.block(block_p) = sim.system_rhs.block(block_p);
+      internal::ChangeVectorTypes::copy(rhs_copy, distributed_stokes_rhs);
+    }
+
+    // compute the initial nonlinear residual || A^{k+1} U^k - F^{k+1} ||,
+    // see Simulator::solve_stokes() for a discussion
+    stokes_matrix.vmult(tmp, solution_copy);
+    tmp.sadd(-1.0, 1.0, rhs_copy);
+    initial_nonlinear_residual = tmp.l2_norm();
+
+    // then the residual with zero velocity, which we use for the solver
+    // tolerance
+    const double solver_tolerance = sim.parameters.linear_stokes_solver_tolerance *
+                                    compute_initial_stokes_residual();
+
+    // create the geometric multigrid preconditioner for the A block
+    mg::Matrix<GMGVectorType> mg_matrix(mg_matrices);
+    mg::Matrix<GMGVectorType> mg_interface(mg_interface_matrices);
+
+    Multigrid<GMGVectorType> mg(mg_matrix,
+                                mg_coarse,
+                                mg_transfer,
+                                mg_smoother,
+                                mg_smoother,
+                                0,
+                                sim.triangulation.n_global_levels()-1);
+    mg.set_edge_matrices(mg_interface, mg_interface);
+
+    typedef PreconditionMG<dim, GMGVectorType, MGTransferMatrixFree<dim,GMGNumberType> > GMGPreconditioner;
+    GMGPreconditioner prec_A(dof_handler_v, mg, mg_transfer);
+
+    PrimitiveVectorMemory<BlockVectorType> mem;
+
+    // create Solver controls for the cheap and expensive solver phase
+    SolverControl solver_control_cheap (sim.parameters.n_cheap_stokes_solver_steps,
+                                        solver_tolerance);
+    SolverControl solver_control_expensive (sim.parameters.n_expensive_stokes_solver_steps,
+                                            solver_tolerance);
+
+    solver_control_cheap.enable_history_data();
+    solver_control_expensive.enable_history_data();
+
+    // create a cheap preconditioner that consists of only a single V-cycle
+    const internal::BlockSchurGMGPreconditioner<StokesMatrixType, ABlockMatrixType, SchurComplementMatrixType, GMGPreconditioner>
+    preconditioner_cheap (stokes_matrix, velocity_matrix, mass_matrix,
+                          prec_A, false,
+                          sim.parameters.linear_solver_A_block_tolerance,
+                          sim.parameters.linear_solver_S_block_tolerance);
+
+    // create an expensive preconditioner that solves for the A block with CG
+    const internal::BlockSchurGMGPreconditioner<StokesMatrixType, ABlockMatrixType, SchurComplementMatrixType, GMGPreconditioner>
+    preconditioner_expensive (stokes_matrix, velocity_matrix, mass_matrix,
+                              prec_A, true,
+                              sim.parameters.linear_solver_A_block_tolerance,
+                              sim.parameters.linear_solver_S_block_tolerance);
+
+    // step 1a: try if the simple and fast solver
+    // succeeds in n_cheap_stokes_solver_steps steps or less.
+    try
+      {
+        // if this cheaper solver is not desired, then simply short-cut
+        // the attempt at solving with the cheaper preconditioner
+        if (sim.parameters.n_cheap_stokes_solver_steps == 0)
+          throw SolverControl::NoConvergence(0,0);
+
+        SolverFGMRES<BlockVectorType>
+        solver(solver_control_cheap, mem,
+               SolverFGMRES<BlockVectorType>::
+               AdditionalData(sim.parameters.stokes_gmres_restart_length));
+
+        solver.solve (stokes_matrix,
+                      solution_copy,
+                      rhs_copy,
+                      preconditioner_cheap);
+
+        final_linear_residual = solver_control_cheap.last_value();
+      }
+    // step 1b: take the stronger solver in case
+    // the simple solver failed and attempt solving
+    // it in n_expensive_stokes_solver_steps steps or less.
+    catch (const SolverControl::NoConvergence &)
+      {
+        SolverFGMRES<BlockVectorType>
+        solver(solver_control_expensive, mem,
+               SolverFGMRES<BlockVectorType>::
+               AdditionalData(sim.parameters.stokes_gmres_restart_length));
+
+        try
+          {
+            solver.solve(stokes_matrix,
+                         solution_copy,
+                         rhs_copy,
+                         preconditioner_expensive);
+
+            final_linear_residual = solver_control_expensive.last_value();
+          }
+        // if the solver fails, report the error from processor 0 with some additional
+        // information about its location, and throw a quiet exception on all other
+        // processors
+        catch (const std::exception &exc)
+          {
+            sim.signals.post_stokes_solver(sim,
+                                           preconditioner_cheap.n_iterations_S() + preconditioner_expensive.n_iterations_S(),
+                                           preconditioner_cheap.n_iterations_A() + preconditioner_expensive.n_iterations_A(),
+                                           solver_control_cheap,
+                                           solver_control_expensive);
+
+            if (Utilities::MPI::this_mpi_process(sim.mpi_communicator) == 0)
+              {
+                // output solver history
+                std::ofstream f((sim.parameters.output_directory+"solver_history.txt").c_str());
+
+                // Only request the solver history if a history has actually been created
+                if (sim.parameters.n_cheap_stokes_solver_steps > 0)
+                  {
+                    for (unsigned int i=0; i<solver_control_cheap.get_history_data().size(); ++i)
+                      f << i << " " << solver_control_cheap.get_history_data()[i] << "\n";
+
+                    f << "\n";
+                  }
+
+                for (unsigned int i=0; i<solver_control_expensive.get_history_data().size(); ++i)
+                  f << i << " " << solver_control_expensive.get_history_data()[i] << "\n";
+
+                f.close();
+
+                AssertThrow (false,
+                             ExcMessage (std::string("The iterative Stokes solver "
+                                                     "did not converge. It reported the following error:\n\n")
+                                         +
+                                         exc.what()
+                                         + "\n See " + sim.parameters.output_directory+"solver_history.txt"
+                                         + " for convergence history."));
+              }
+            else
+              throw QuietException();
+          }
+      }
+
+    // signal successful solver
+    sim.signals.post_stokes_solver(sim,
+                                   preconditioner_cheap.n_iterations_S() + preconditioner_expensive.n_iterations_S(),
+                                   preconditioner_cheap.n_iterations_A() + preconditioner_expensive.n_iterations_A(),
+                                   solver_control_cheap,
+                                   solver_control_expensive);
+
+    // move the solution back into the Simulator's vector type,
+    // distribute hanging node and other constraints
+    internal::ChangeVectorTypes::copy(distributed_stokes_solution, solution_copy);
+    sim.current_constraints.distribute (distributed_stokes_solution);
+
+    // now rescale the pressure back to real physical units
+    distributed_stokes_solution.block(block_p) *= sim.pressure_scaling;
+
+    // then copy back the solution from the temporary (non-ghosted) vector
+    // into the ghosted one with all solution components
+    sim.solution.block(block_vel) = distributed_stokes_solution.block(block_vel);
+    sim.solution.block(block_p) = distributed_stokes_solution.block(block_p);
+
+    // print the number of iterations to screen
+    sim.pcout << (solver_control_cheap.last_step() != numbers::invalid_unsigned_int ?
+                  solver_control_cheap.last_step():
+                  0)
+              << '+'
+              << (solver_control_expensive.last_step() != numbers::invalid_unsigned_int ?
+                  solver_control_expensive.last_step():
+                  0)
+              << " iterations.";
+    sim.pcout << std::endl;
+
+    return std::pair<double,double>(initial_nonlinear_residual,
+                                    final_linear_residual);
+  }
+
+
+
+  template <int dim, int velocity_degree>
+  std::size_t
+  StokesMatrixFreeHandlerImplementation<dim,velocity_degree>::
+  get_memory_consumption () const
+  {
+    std::size_t memory = dof_handler_v.memory_consumption()
+                         + dof_handler_p.memory_consumption()
+                         + dof_handler_projection.memory_consumption()
+                         + constraints_v.memory_consumption()
+                         + constraints_p.memory_consumption()
+                         + stokes_matrix.memory_consumption()
+                         + active_cell_data.memory_consumption()
+                         + mg_transfer.memory_consumption()
+                         + mg_transfer_projection.memory_consumption()
+                         + active_viscosity_vector.memory_consumption();
+
+    for (unsigned int level=0; level<sim.triangulation.n_global_levels(); ++level)
+      memory += mg_matrices[level].memory_consumption()
+                + level_cell_data[level].memory_consumption()
+                + level_viscosity_vector[level].memory_consumption();
+
+    return memory;
+  }
+#endif
+}
+
+
+
+// explicit instantiation of the functions we implement in this file
+namespace aspect
+{
+#define INSTANTIATE(dim) \
+  template class StokesMatrixFreeHandler<dim>;
+
+  ASPECT_INSTANTIATE(INSTANTIATE)
+
+#undef INSTANTIATE
+
+#if DEAL_II_VERSION_GTE(9,1,0)
+  namespace MatrixFreeStokesOperators
+  {
+#define INSTANTIATE(dim) \
+  template struct OperatorCellData<dim,double>; \
+  template class StokesOperator<dim,2,double>; \
+  template class StokesOperator<dim,3,double>; \
+  template class MassMatrixOperator<dim,1,double>; \
+  template class MassMatrixOperator<dim,2,double>; \
+  template class ABlockOperator<dim,2,double>; \
+  template class ABlockOperator<dim,3,double>;
+
+    ASPECT_INSTANTIATE(INSTANTIATE)
+
+#undef INSTANTIATE
+  }
+
+#define INSTANTIATE(dim) \
+  template class StokesMatrixFreeHandlerImplementation<dim,2>; \
+  template class StokesMatrixFreeHandlerImplementation<dim,3>;
+
+  ASPECT_INSTANTIATE(INSTANTIATE)
+
+#undef INSTANTIATE
+#endif
+}
@@ -45,8 +45,16 @@
 #include <fstream>
 #include <string>
 #include <locale>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <limits>
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
+#include <unistd.h>
 #include <errno.h>
 
 #include <boost/math/special_functions/spherical_harmonic.hpp>
@@ -852,6 +860,81 @@ namespace aspect
     }
 
 
+
+    void real_spherical_harmonics (const unsigned int max_degree,
+                                   const double theta,
+                                   const double phi,
+                                   std::vector<double> &cos_components,
+                                   std::vector<double> &sin_components)
+    {
+      const unsigned int n_coefficients = (max_degree+1)*(max_degree+2)/2;
+      cos_components.resize(n_coefficients);
+      sin_components.resize(n_coefficients);
+
+      const double x = std::cos(theta);
+      const double sin_theta = std::sin(theta);
+      const double sin_phi = std::sin(phi);
+      const double cos_phi = std::cos(phi);
+
+      // The fully normalized associated Legendre function
+      // P_mm = N_mm P_m^m(cos theta) including the Condon-Shortley phase,
+      // starting from P_00 = 1/sqrt(4 pi)
+      double p_mm = 1./std::sqrt(4.*numbers::PI);
+
+      // cos(m phi) and sin(m phi), starting at m=0
+      double cos_m_phi = 1.;
+      double sin_m_phi = 0.;
+
+      for (unsigned int m=0; m<=max_degree; ++m)
+        {
+          if (m > 0)
+            {
+              p_mm *= -std::sqrt((2.*m+1.)/(2.*m)) * sin_theta;
+
+              const double cos_new = cos_m_phi*cos_phi - sin_m_phi*sin_phi;
+              sin_m_phi = sin_m_phi*cos_phi + cos_m_phi*sin_phi;
+              cos_m_phi = cos_new;
+            }
+
+          // the real spherical harmonics carry a factor sqrt(2) for m>0
+          const double factor_cos = (m == 0 ? 1. : numbers::SQRT2 * cos_m_phi);
+          const double factor_sin = (m == 0 ? 0. : numbers::SQRT2 * sin_m_phi);
+
+          // then go up in degree for the current order:
+          // P_{m+1,m} = sqrt(2m+3) x P_mm and
+          // P_lm = a_lm (x P_{l-1,m} - b_lm P_{l-2,m})
+          double p_l_minus_2 = 0.;
+          double p_l_minus_1 = p_mm;
+          for (unsigned int l=m; l<=max_degree; ++l)
+            {
+              double p_lm;
+              if (l == m)
+                p_lm = p_mm;
+              else if (l == m+1)
+                p_lm = std::sqrt(2.*m+3.) * x * p_mm;
+              else
+                {
+                  const double l2 = 1.*l*l;
+                  const double m2 = 1.*m*m;
+                  const double a_lm = std::sqrt((4.*l2-1.)/(l2-m2));
+                  const double b_lm = std::sqrt(((l-1.)*(l-1.)-m2)/(4.*(l-1.)*(l-1.)-1.));
+                  p_lm = a_lm * (x * p_l_minus_1 - b_lm * p_l_minus_2);
+                }
+
+              if (l > m)
+                {
+                  p_l_minus_2 = p_l_minus_1;
+                  p_l_minus_1 = p_lm;
+                }
+
+              const unsigned int index = l*(l+1)/2 + m;
+              cos_components[index] = factor_cos * p_lm;
+              sin_components[index] = factor_sin * p_lm;
+            }
+        }
+    }
+
+
     bool
     fexists(const std::string &filename)
     {
@@ -1442,10 +1525,14 @@ namespace aspect
                                           const double scale_factor)
       :
       components(components),
-      data(components),
       maximum_component_value(components),
       scale_factor(scale_factor),
-      coordinate_values_are_equidistant(false)
+      coordinate_values_are_equidistant(false),
+      data_values(nullptr),
+      shared_data_window(MPI_WIN_NULL),
+      mapped_file(nullptr),
+      mapped_file_size(0),
+      read_file_is_binary(false)
     {}
 
 
@@ -1454,14 +1541,33 @@ namespace aspect
     AsciiDataLookup<dim>::AsciiDataLookup(const double scale_factor)
       :
       components(numbers::invalid_unsigned_int),
-      data(),
       maximum_component_value(),
       scale_factor(scale_factor),
-      coordinate_values_are_equidistant(false)
+      coordinate_values_are_equidistant(false),
+      data_values(nullptr),
+      shared_data_window(MPI_WIN_NULL),
+      mapped_file(nullptr),
+      mapped_file_size(0),
+      read_file_is_binary(false)
     {}
 
 
 
+    template <int dim>
+    AsciiDataLookup<dim>::~AsciiDataLookup()
+    {
+      // freeing the shared window is a collective operation that is no
+      // longer possible once MPI has been shut down
+      int mpi_finalized;
+      MPI_Finalized(&mpi_finalized);
+      if (mpi_finalized != 0)
+        shared_data_window = MPI_WIN_NULL;
+
+      release_data_values();
+    }
+
+
+
     template <int dim>
     std::vector<std::string>
     AsciiDataLookup<dim>::get_column_names() const
@@ -1514,15 +1620,398 @@ namespace aspect
       return maximum_component_value[component];
     }
 
+    namespace
+    {
+      /**
+       * The first bytes of a binary data file for AsciiDataLookup.
+       */
+      const char binary_data_file_magic[8] = {'A','S','P','E','C','T','B','D'};
+
+      /**
+       * The version of the binary data file format.
+       */
+      const std::uint64_t binary_data_file_version = 1;
+
+      /**
+       * The header of a binary data file for AsciiDataLookup, see the
+       * documentation of that class.
+       */
+      struct BinaryDataFileHeader
+      {
+        char          magic[8];
+        std::uint64_t version;
+        std::uint64_t dim;
+        std::uint64_t n_components;
+        std::uint64_t n_points[3];
+        std::uint64_t names_size;
+      };
+
+      /**
+       * Return whether the file with the given name starts like a binary
+       * data file.
+       */
+      bool
+      is_binary_data_file(const std::string &filename)
+      {
+        std::ifstream file(filename.c_str(), std::ios::binary);
+        char magic[sizeof(binary_data_file_magic)];
+        if (!file.read(magic, sizeof(magic)))
+          return false;
+
+        return std::equal(magic, magic + sizeof(magic), binary_data_file_magic);
+      }
+
+      /**
+       * Ask the operating system to start reading the file with the given
+       * name into its cache, without waiting for it.
+       */
+      void
+      advise_file_will_be_needed(const std::string &filename)
+      {
+#ifdef POSIX_FADV_WILLNEED
+        const int file_descriptor = open(filename.c_str(), O_RDONLY);
+        if (file_descriptor != -1)
+          {
+            posix_fadvise(file_descriptor, 0, 0, POSIX_FADV_WILLNEED);
+            close(file_descriptor);
+          }
+#else
+        (void)filename;
+#endif
+      }
+
+      /**
+       * Read the content of a file on the current process. Unlike
+       * read_and_distribute_file_content() this does not make any MPI
+       * calls, and can therefore be called on any thread.
+       */
+      std::string
+      read_local_file_content(const std::string &filename)
+      {
+        std::ifstream filestream(filename.c_str());
+        AssertThrow (filestream,
+                     ExcMessage (std::string("Could not open file <") + filename + ">."));
+
+        std::stringstream datastream;
+        filestream >> datastream.rdbuf();
+        AssertThrow (filestream.eof(),
+                     ExcMessage (std::string("Reading of file ") + filename + " finished " +
+                                 "before the end of file was reached. Is the file corrupted or "
+                                 "too large for the input buffer?"));
+
+        return datastream.str();
+      }
+
+      /**
+       * Broadcast a vector of doubles from the first process of @p comm,
+       * in pieces small enough for the count argument of MPI_Bcast.
+       */
+      void
+      broadcast_values(double *values,
+                       const std::size_t n_values,
+                       const MPI_Comm &comm)
+      {
+        const std::size_t max_chunk_size = std::numeric_limits<int>::max();
+        for (std::size_t start = 0; start < n_values; start += max_chunk_size)
+          MPI_Bcast(values + start,
+                    static_cast<int>(std::min(max_chunk_size, n_values - start)),
+                    MPI_DOUBLE, 0, comm);
+      }
+    }
+
+
+
+    template <int dim>
+    void
+    AsciiDataLookup<dim>::set_table_points(const TableIndices<dim> &points)
+    {
+      for (unsigned int i = 0; i < dim; i++)
+        {
+          if (table_points[i] == 0)
+            table_points[i] = points[i];
+          else
+            AssertThrow (table_points[i] == points[i],
+                         ExcMessage("The file grid must not change over model runtime. "
+                                    "Either you prescribed a conflicting number of points in "
+                                    "the input file, or the POINTS comment in your data files "
+                                    "is changing between following files."));
+        }
+    }
+
+
+
+    template <int dim>
+    void
+    AsciiDataLookup<dim>::release_data_values()
+    {
+      if (shared_data_window != MPI_WIN_NULL)
+        MPI_Win_free(&shared_data_window);
+
+      if (mapped_file != nullptr)
+        {
+          munmap(mapped_file, mapped_file_size);
+          mapped_file = nullptr;
+          mapped_file_size = 0;
+        }
+
+      std::vector<double>().swap(local_data_values);
+      data_values = nullptr;
+    }
+
+
+
     template <int dim>
     void
     AsciiDataLookup<dim>::load_file(const std::string &filename,
                                     const MPI_Comm &comm)
     {
-      // Read data from disk and distribute among processes
-      std::stringstream in(read_and_distribute_file_content(filename, comm));
+      read_file(filename, Utilities::MPI::this_mpi_process(comm) == 0);
+      distribute_file(comm);
+    }
+
+
+
+    template <int dim>
+    void
+    AsciiDataLookup<dim>::read_file(const std::string &filename,
+                                    const bool read_file_content)
+    {
+      read_filename = filename;
+      read_file_is_binary = false;
+      std::vector<double>().swap(read_data_values);
+      read_component_extrema.clear();
+      read_file_exception = std::exception_ptr();
+
+      if (read_file_content == false)
+        return;
+
+      // This function may run on a thread other than the one that called
+      // MPI_Init, so it must not communicate. Keep any error until
+      // distribute_file() can tell the other processes about it.
+      try
+        {
+          read_file_is_binary = is_binary_data_file(filename);
+
+          if (read_file_is_binary)
+            advise_file_will_be_needed(filename);
+          else
+            parse_text_file(read_local_file_content(filename),
+                            filename,
+                            read_data_values,
+                            read_component_extrema);
+        }
+      catch (...)
+        {
+          read_file_exception = std::current_exception();
+        }
+    }
+
+
+
+    template <int dim>
+    void
+    AsciiDataLookup<dim>::distribute_file(const MPI_Comm &comm)
+    {
+      // let the first process tell the others which kind of file it read
+      int binary_file = (read_file_is_binary ? 1 : 0);
+      MPI_Bcast(&binary_file, 1, MPI_INT, 0, comm);
+
+      // the memory of the previous file is no longer needed
+      release_data_values();
+
+      std::vector<double> component_extrema;
+
+      if (binary_file == 1)
+        component_extrema = map_binary_file(read_filename);
+      else
+        {
+          // Only the first process has read and parsed the file, and now
+          // sends the (much smaller) data table to the other processes.
+          std::vector<double> values;
+          values.swap(read_data_values);
+          component_extrema.swap(read_component_extrema);
+
+          // broadcast the failure state, then throw
+          int parse_failed = (read_file_exception ? 1 : 0);
+          MPI_Bcast(&parse_failed, 1, MPI_INT, 0, comm);
+          if (parse_failed == 1)
+            {
+              if (Utilities::MPI::this_mpi_process(comm) == 0)
+                {
+                  std::exception_ptr parse_exception;
+                  std::swap(parse_exception, read_file_exception);
+                  std::rethrow_exception(parse_exception);
+                }
+              else
+                throw QuietException();
+            }
+
+          // distribute the description of the table
+          std::vector<unsigned int> sizes(1+dim);
+          if (Utilities::MPI::this_mpi_process(comm) == 0)
+            {
+              sizes[0] = components;
+              for (unsigned int i = 0; i < dim; i++)
+                sizes[1+i] = table_points[i];
+            }
+          MPI_Bcast(sizes.data(), 1+dim, MPI_UNSIGNED, 0, comm);
+
+          TableIndices<dim> points;
+          for (unsigned int i = 0; i < dim; i++)
+            points[i] = sizes[1+i];
+
+          if (Utilities::MPI::this_mpi_process(comm) != 0)
+            {
+              if (components == numbers::invalid_unsigned_int)
+                components = sizes[0];
+              AssertThrow (components == sizes[0],
+                           ExcMessage("The number of expected data columns does not match "
+                                      "the number of data columns in the data file " + read_filename + "."));
+              set_table_points(points);
+
+              for (unsigned int i = 0; i < dim; i++)
+                coordinate_values[i].resize(table_points[i]);
+              component_extrema.resize(2*components);
+            }
+
+          std::string names;
+          if (Utilities::MPI::this_mpi_process(comm) == 0)
+            for (unsigned int c = 0; c < data_component_names.size(); ++c)
+              names += data_component_names[c] + '\n';
+          unsigned int names_size = names.size();
+          MPI_Bcast(&names_size, 1, MPI_UNSIGNED, 0, comm);
+          names.resize(names_size);
+          MPI_Bcast(&names[0], names_size, MPI_CHAR, 0, comm);
+
+          if (Utilities::MPI::this_mpi_process(comm) != 0)
+            {
+              data_component_names.clear();
+              std::istringstream name_stream(names);
+              std::string name;
+              while (std::getline(name_stream, name))
+                data_component_names.push_back(name);
+            }
+
+          for (unsigned int i = 0; i < dim; i++)
+            broadcast_values(coordinate_values[i].data(), coordinate_values[i].size(), comm);
+          broadcast_values(component_extrema.data(), component_extrema.size(), comm);
+
+          // Now distribute the data values. If possible, put them into a window
+          // that is shared by all processes on one machine, so that each machine
+          // only stores one copy. The first process of each machine receives the
+          // data and writes it into the window.
+          std::size_t n_values = components;
+          for (unsigned int i = 0; i < dim; i++)
+            n_values *= table_points[i];
+
+#if MPI_VERSION >= 3
+          MPI_Comm node_comm;
+          MPI_Comm_split_type(comm, MPI_COMM_TYPE_SHARED, Utilities::MPI::this_mpi_process(comm),
+                              MPI_INFO_NULL, &node_comm);
+          const bool is_node_root = (Utilities::MPI::this_mpi_process(node_comm) == 0);
+
+          double *window_values = nullptr;
+          MPI_Win_allocate_shared((is_node_root ? n_values * sizeof(double) : 0),
+                                  sizeof(double), MPI_INFO_NULL, node_comm,
+                                  &window_values, &shared_data_window);
+          if (!is_node_root)
+            {
+              MPI_Aint window_size;
+              int displacement_unit;
+              MPI_Win_shared_query(shared_data_window, 0, &window_size,
+                                   &displacement_unit, &window_values);
+            }
+
+          // the first process of comm is also the first process on its machine,
+          // and the first process in the communicator of all machine roots
+          MPI_Comm roots_comm;
+          MPI_Comm_split(comm, (is_node_root ? 0 : MPI_UNDEFINED),
+                         Utilities::MPI::this_mpi_process(comm), &roots_comm);
+          if (is_node_root)
+            {
+              if (Utilities::MPI::this_mpi_process(comm) == 0)
+                std::copy(values.begin(), values.end(), window_values);
+              broadcast_values(window_values, n_values, roots_comm);
+              MPI_Comm_free(&roots_comm);
+            }
+
+          // make sure nobody reads from the window before it is filled
+          MPI_Barrier(node_comm);
+          MPI_Comm_free(&node_comm);
+
+          data_values = window_values;
+#else
+          if (Utilities::MPI::this_mpi_process(comm) == 0)
+            local_data_values.swap(values);
+          else
+            local_data_values.resize(n_values);
+          broadcast_values(local_data_values.data(), n_values, comm);
+
+          data_values = local_data_values.data();
+#endif
+        }
+
+      maximum_component_value.resize(components);
+      for (unsigned int c = 0; c < components; ++c)
+        maximum_component_value[c] = std::max(scale_factor * component_extrema[2*c],
+                                              scale_factor * component_extrema[2*c+1]);
+
+      // In case the data is specified on a grid that is equidistant
+      // in each coordinate direction, we only need the number of
+      // intervals in each direction and the begin- and endpoints of
+      // the coordinates. In case the grid is not equidistant, we need
+      // all the coordinates in each direction.
+      // Here we check whether the coordinates are equidistant or not.
+      // We also check the requirement that the coordinates are
+      // strictly ascending.
+      coordinate_values_are_equidistant = true;
+
+      for (unsigned int i = 0; i < dim; i++)
+        {
+          // The minimum and maximum coordinates
+          grid_extent[i].first = coordinate_values[i].front();
+          grid_extent[i].second = coordinate_values[i].back();
+
+          // The grid spacing
+          double grid_spacing = numbers::signaling_nan<double>();
+
+          for (unsigned int n = 1; n < table_points[i]; n++)
+            {
+              const double temp_coord = coordinate_values[i][n-1];
+              const double new_temp_coord = coordinate_values[i][n];
+              AssertThrow(new_temp_coord > temp_coord,
+                          ExcMessage ("Coordinates in dimension "
+                                      + int_to_string(i)
+                                      + " are not strictly ascending. "));
+
+              // Test whether grid is equidistant
+              if (n == 1)
+                grid_spacing = new_temp_coord - temp_coord;
+              else
+                {
+                  const double current_grid_spacing = new_temp_coord - temp_coord;
+                  // Compare current grid spacing with first grid spacing,
+                  // taking into account roundoff of the read-in coordinates
+                  if (std::abs(current_grid_spacing - grid_spacing) > 0.005*(current_grid_spacing+grid_spacing))
+                    coordinate_values_are_equidistant = false;
+                }
+            }
+        }
+    }
+
+
+
+    template <int dim>
+    void
+    AsciiDataLookup<dim>::parse_text_file(const std::string &file_content,
+                                          const std::string &filename,
+                                          std::vector<double> &values,
+                                          std::vector<double> &component_extrema)
+    {
+      std::stringstream in(file_content);
 
       // Read header lines and table size
+      TableIndices<dim> points;
       while (in.peek() == '#')
         {
           std::string line;
@@ -1532,24 +2021,12 @@ namespace aspect
           while (linestream >> word)
             if (word == "POINTS:")
               for (unsigned int i = 0; i < dim; i++)
-                {
-                  unsigned int temp_index;
-                  linestream >> temp_index;
-
-                  if (table_points[i] == 0)
-                    table_points[i] = temp_index;
-                  else
-                    AssertThrow (table_points[i] == temp_index,
-                                 ExcMessage("The file grid must not change over model runtime. "
-                                            "Either you prescribed a conflicting number of points in "
-                                            "the input file, or the POINTS comment in your data files "
-                                            "is changing between following files."));
-                }
+                linestream >> points[i];
         }
 
       for (unsigned int i = 0; i < dim; i++)
         {
-          AssertThrow(table_points[i] != 0,
+          AssertThrow(points[i] != 0,
                       ExcMessage("Could not successfully read in the file header of the "
                                  "ascii data file <" + filename + ">. One header line has to "
                                  "be of the format: '#POINTS: N1 [N2] [N3]', where N1 and "
@@ -1558,9 +2035,12 @@ namespace aspect
                                  "(e.g. a missing space character)."));
         }
 
+      set_table_points(points);
+
       // Read column lines if present
       unsigned int name_column_index = 0;
       double temp_data;
+      data_component_names.clear();
 
       while (true)
         {
@@ -1614,32 +2094,51 @@ namespace aspect
             }
         }
 
-      /**
-       * Create table for the data. This peculiar reinit is necessary, because
-       * there is no constructor for Table, which takes TableIndices as
-       * argument.
-       */
-      data.resize(components);
-      maximum_component_value.resize(components,-std::numeric_limits<double>::max());
-      Table<dim,double> data_table;
-      data_table.TableBase<dim,double>::reinit(table_points);
-      std::vector<Table<dim,double> > data_tables(components+dim,data_table);
+      std::size_t n_points = 1;
+      for (unsigned int i = 0; i < dim; i++)
+        {
+          n_points *= table_points[i];
+          coordinate_values[i].resize(table_points[i]);
+        }
 
+      values.resize(components * n_points);
+      component_extrema.resize(2*components);
+      for (unsigned int c = 0; c < components; ++c)
+        {
+          component_extrema[2*c] = std::numeric_limits<double>::max();
+          component_extrema[2*c+1] = -std::numeric_limits<double>::max();
+        }
 
-      // Read data lines
-      unsigned int read_data_entries = 0;
+      // Read data lines. The coordinates of the points along each axis are
+      // given in the lines in which all other table indices are zero.
+      std::size_t read_data_entries = 0;
       do
         {
           const unsigned int column_num = read_data_entries%(components+dim);
+          const std::size_t point = read_data_entries/(components+dim);
 
-          if (column_num >= dim)
+          if (point < n_points)
             {
-              temp_data *= scale_factor;
-              maximum_component_value[column_num-dim] = std::max(maximum_component_value[column_num-dim], temp_data);
+              if (column_num >= dim)
+                {
+                  const unsigned int c = column_num-dim;
+                  values[c*n_points + point] = temp_data;
+                  component_extrema[2*c] = std::min(component_extrema[2*c], temp_data);
+                  component_extrema[2*c+1] = std::max(component_extrema[2*c+1], temp_data);
+                }
+              else
+                {
+                  const TableIndices<dim> idx = compute_table_indices(read_data_entries);
+                  bool on_axis = true;
+                  for (unsigned int i = 0; i < dim; i++)
+                    if (i != column_num && idx[i] != 0)
+                      on_axis = false;
+
+                  if (on_axis)
+                    coordinate_values[column_num][idx[column_num]] = temp_data;
+                }
             }
 
-          data_tables[column_num](compute_table_indices(read_data_entries)) = temp_data;
-
           ++read_data_entries;
         }
       while (in >> temp_data);
@@ -1650,7 +2149,7 @@ namespace aspect
                               "Please check for malformed data values (e.g. NaN) or superfluous "
                               "lines at the end of the data file."));
 
-      const unsigned int n_expected_data_entries = (components + dim) * data_table.n_elements();
+      const std::size_t n_expected_data_entries = (components + dim) * n_points;
       AssertThrow(read_data_entries == n_expected_data_entries,
                   ExcMessage ("While reading the data file '" + filename + "' the ascii data "
                               "plugin has reached the end of the file, but has not found the "
@@ -1658,87 +2157,152 @@ namespace aspect
                               "data columns, and number of lines prescribed by the POINTS header "
                               "of the file. Please check the number of data "
                               "lines against the POINTS header in the file."));
+    }
 
-      // In case the data is specified on a grid that is equidistant
-      // in each coordinate direction, we only need to store
-      // (besides the data) the number of intervals in each direction and
-      // the begin- and endpoints of the coordinates.
-      // In case the grid is not equidistant, we need to keep
-      // all the coordinates in each direction, which is more costly.
-      // Here we fill the data structures needed for both cases,
-      // and check whether the coordinates are equidistant or not.
-      // We also check the requirement that the coordinates are
-      // strictly ascending.
 
-      // The number of intervals in each direction
-      std::array<unsigned int,dim> table_intervals;
 
-      // Whether or not the grid is equidistant
-      coordinate_values_are_equidistant = true;
+    template <int dim>
+    std::vector<double>
+    AsciiDataLookup<dim>::map_binary_file(const std::string &filename)
+    {
+      const int file_descriptor = open(filename.c_str(), O_RDONLY);
+      AssertThrow (file_descriptor != -1,
+                   ExcMessage (std::string("Could not open file <") + filename + ">."));
+
+      struct stat file_status;
+      const int stat_result = fstat(file_descriptor, &file_status);
+      AssertThrow (stat_result == 0,
+                   ExcMessage (std::string("Could not determine the size of file <") + filename + ">."));
+
+      mapped_file_size = file_status.st_size;
+      AssertThrow (mapped_file_size >= sizeof(BinaryDataFileHeader),
+                   ExcMessage ("The binary data file <" + filename + "> is too small to "
+                               "contain a valid header."));
+
+      mapped_file = mmap(nullptr, mapped_file_size, PROT_READ, MAP_SHARED, file_descriptor, 0);
+      close(file_descriptor);
+      if (mapped_file == MAP_FAILED)
+        {
+          mapped_file = nullptr;
+          mapped_file_size = 0;
+          AssertThrow (false,
+                       ExcMessage (std::string("Could not memory map file <") + filename + ">."));
+        }
 
+      const char *file_begin = static_cast<const char *>(mapped_file);
+
+      BinaryDataFileHeader header;
+      std::memcpy(&header, file_begin, sizeof(header));
+
+      AssertThrow (std::equal(header.magic, header.magic + sizeof(header.magic), binary_data_file_magic)
+                   && header.version == binary_data_file_version,
+                   ExcMessage ("The file <" + filename + "> is not a binary data file of a "
+                               "version that can be read by this version of ASPECT."));
+      AssertThrow (header.dim == static_cast<std::uint64_t>(dim),
+                   ExcMessage ("The binary data file <" + filename + "> contains data in "
+                               + Utilities::to_string(header.dim) + " dimensions, but "
+                               + Utilities::to_string(dim) + " dimensions are needed."));
+
+      if (components == numbers::invalid_unsigned_int)
+        components = header.n_components;
+      AssertThrow (components == header.n_components,
+                   ExcMessage("The number of expected data columns does not match "
+                              "the number of data columns in the data file " + filename + "."));
+
+      TableIndices<dim> points;
+      std::size_t n_points = 1;
+      std::size_t n_coordinates = 0;
       for (unsigned int i = 0; i < dim; i++)
         {
-          table_intervals[i] = table_points[i] - 1;
-
-          TableIndices<dim> idx;
-          double temp_coord = data_tables[i](idx);
-          double new_temp_coord = 0;
-
-          // The minimum coordinates
-          grid_extent[i].first = temp_coord;
+          points[i] = header.n_points[i];
+          n_points *= header.n_points[i];
+          n_coordinates += header.n_points[i];
+        }
+      set_table_points(points);
+
+      const std::size_t values_offset = sizeof(BinaryDataFileHeader) + header.names_size;
+      AssertThrow (header.names_size % sizeof(double) == 0
+                   &&
+                   mapped_file_size == values_offset + sizeof(double) * (2*components
+                                                                         + n_coordinates
+                                                                         + components * n_points),
+                   ExcMessage ("The size of the binary data file <" + filename + "> does "
+                               "not match the size of the table described in its header."));
+
+      data_component_names.clear();
+      std::istringstream name_stream(std::string(file_begin + sizeof(BinaryDataFileHeader),
+                                                 strnlen(file_begin + sizeof(BinaryDataFileHeader),
+                                                         header.names_size)));
+      std::string name;
+      while (std::getline(name_stream, name))
+        data_component_names.push_back(name);
+
+      const double *values = reinterpret_cast<const double *>(file_begin + values_offset);
+
+      std::vector<double> component_extrema(values, values + 2*components);
+      values += 2*components;
 
-          // The first coordinate value
-          coordinate_values[i].push_back(temp_coord);
+      for (unsigned int i = 0; i < dim; i++)
+        {
+          coordinate_values[i].assign(values, values + table_points[i]);
+          values += table_points[i];
+        }
 
-          // The grid spacing
-          double grid_spacing = numbers::signaling_nan<double>();
+      data_values = values;
 
-          // Loop over the rest of the coordinate points
-          for (unsigned int n = 1; n < table_points[i]; n++)
-            {
-              idx[i] = n;
-              new_temp_coord = data_tables[i](idx);
-              AssertThrow(new_temp_coord > temp_coord,
-                          ExcMessage ("Coordinates in dimension "
-                                      + int_to_string(i)
-                                      + " are not strictly ascending. "));
-
-              // Test whether grid is equidistant
-              if (n == 1)
-                grid_spacing = new_temp_coord - temp_coord;
-              else
-                {
-                  const double current_grid_spacing = new_temp_coord - temp_coord;
-                  // Compare current grid spacing with first grid spacing,
-                  // taking into account roundoff of the read-in coordinates
-                  if (std::abs(current_grid_spacing - grid_spacing) > 0.005*(current_grid_spacing+grid_spacing))
-                    coordinate_values_are_equidistant = false;
-                }
+      return component_extrema;
+    }
 
-              // Set the coordinate value
-              coordinate_values[i].push_back(new_temp_coord);
 
-              temp_coord = new_temp_coord;
-            }
 
-          // The maximum coordinate
-          grid_extent[i].second = temp_coord;
+    template <int dim>
+    void
+    AsciiDataLookup<dim>::write_binary_file(const std::string &filename) const
+    {
+      AssertThrow (data_values != nullptr,
+                   ExcMessage ("There is no data table that could be written into a file."));
+
+      BinaryDataFileHeader header;
+      std::copy(binary_data_file_magic, binary_data_file_magic + sizeof(header.magic), header.magic);
+      header.version = binary_data_file_version;
+      header.dim = dim;
+      header.n_components = components;
+      std::size_t n_points = 1;
+      for (unsigned int i = 0; i < 3; i++)
+        {
+          header.n_points[i] = (i < dim ? table_points[i] : 1);
+          n_points *= header.n_points[i];
         }
 
-      // For each data component, set up a GridData,
-      // its type depending on the read-in grid.
-      for (unsigned int i = 0; i < components; i++)
+      std::string names;
+      for (unsigned int c = 0; c < data_component_names.size(); ++c)
+        names += data_component_names[c] + '\n';
+      names.resize((names.size() + sizeof(double) - 1) / sizeof(double) * sizeof(double), '\0');
+      header.names_size = names.size();
+
+      std::vector<double> component_extrema(2*components);
+      for (unsigned int c = 0; c < components; ++c)
         {
-          if (coordinate_values_are_equidistant)
-            data[i]
-              = std_cxx14::make_unique<Functions::InterpolatedUniformGridData<dim>> (grid_extent,
-                                                                                     table_intervals,
-                                                                                     data_tables[dim+i]);
-          else
-            data[i]
-              = std_cxx14::make_unique<Functions::InterpolatedTensorProductGridData<dim>> (coordinate_values,
-                                                                                           data_tables[dim+i]);
+          const double *component_begin = data_values + c*n_points;
+          const auto extrema = std::minmax_element(component_begin, component_begin + n_points);
+          component_extrema[2*c] = *extrema.first;
+          component_extrema[2*c+1] = *extrema.second;
         }
+
+      std::ofstream file(filename.c_str(), std::ios::binary);
+      AssertThrow (file, ExcMessage (std::string("Could not open file <") + filename + "> for writing."));
+
+      file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+      file.write(names.data(), names.size());
+      file.write(reinterpret_cast<const char *>(component_extrema.data()),
+                 component_extrema.size() * sizeof(double));
+      for (unsigned int i = 0; i < dim; i++)
+        file.write(reinterpret_cast<const char *>(coordinate_values[i].data()),
+                   coordinate_values[i].size() * sizeof(double));
+      file.write(reinterpret_cast<const char *>(data_values),
+                 components * n_points * sizeof(double));
+
+      AssertThrow (file, ExcMessage (std::string("Writing to file <") + filename + "> failed."));
     }
 
 
@@ -1747,7 +2311,75 @@ namespace aspect
     AsciiDataLookup<dim>::get_data(const Point<dim> &position,
                                    const unsigned int component) const
     {
-      return data[component]->value(position);
+      Assert (data_values != nullptr, ExcMessage ("No data file has been loaded."));
+      Assert (component < components, ExcIndexRange (component, 0, components));
+
+      // Find the cell of the grid the position lies in, and the relative
+      // position in it. This follows what InterpolatedUniformGridData and
+      // InterpolatedTensorProductGridData do, including the constant
+      // extension of the data outside of the grid.
+      TableIndices<dim> ix;
+      Point<dim> p_unit;
+      for (unsigned int d = 0; d < dim; ++d)
+        {
+          if (coordinate_values_are_equidistant)
+            {
+              const unsigned int n_subintervals = table_points[d] - 1;
+              const double delta_x = ((grid_extent[d].second - grid_extent[d].first) / n_subintervals);
+              if (position[d] <= grid_extent[d].first)
+                ix[d] = 0;
+              else if (position[d] >= grid_extent[d].second - delta_x)
+                ix[d] = n_subintervals - 1;
+              else
+                ix[d] = static_cast<unsigned int>((position[d] - grid_extent[d].first) / delta_x);
+
+              p_unit[d] = std::max(std::min((position[d] - grid_extent[d].first - ix[d] * delta_x) / delta_x, 1.), 0.);
+            }
+          else
+            {
+              const std::vector<double> &x = coordinate_values[d];
+              ix[d] = std::lower_bound(x.begin(), x.end(), position[d]) - x.begin();
+              if (ix[d] == x.size())
+                ix[d] = x.size() - 2;
+              else if (ix[d] > 0)
+                --ix[d];
+
+              const double dx = x[ix[d] + 1] - x[ix[d]];
+              p_unit[d] = std::max(std::min((position[d] - x[ix[d]]) / dx, 1.), 0.);
+            }
+        }
+
+      // Collect the values at the corners of the cell, and interpolate
+      // linearly in one coordinate direction after the other
+      std::size_t n_points = 1;
+      std::size_t stride[dim];
+      for (unsigned int d = 0; d < dim; ++d)
+        {
+          stride[d] = n_points;
+          n_points *= table_points[d];
+        }
+
+      const double *component_values = data_values + component * n_points;
+      std::size_t first_corner = 0;
+      for (unsigned int d = 0; d < dim; ++d)
+        first_corner += ix[d] * stride[d];
+
+      double corner_values[1 << dim];
+      for (unsigned int corner = 0; corner < (1u << dim); ++corner)
+        {
+          std::size_t index = first_corner;
+          for (unsigned int d = 0; d < dim; ++d)
+            if (corner & (1u << d))
+              index += stride[d];
+          corner_values[corner] = component_values[index];
+        }
+
+      for (unsigned int d = 0; d < dim; ++d)
+        for (unsigned int corner = 0; corner < (1u << (dim-d-1)); ++corner)
+          corner_values[corner] = (1 - p_unit[d]) * corner_values[2*corner]
+                                  + p_unit[d] * corner_values[2*corner+1];
+
+      return scale_factor * corner_values[0];
     }
 
 
@@ -1841,11 +2473,23 @@ namespace aspect
       time_weight(0.0),
       time_dependent(true),
       lookups(),
-      old_lookups()
+      old_lookups(),
+      next_lookups(),
+      next_files_prefetched(false),
+      prefetched_file_number(0)
     {}
 
 
 
+    template <int dim>
+    AsciiDataBoundary<dim>::~AsciiDataBoundary ()
+    {
+      // the background thread writes into next_lookups
+      prefetch_thread.join ();
+    }
+
+
+
     template <int dim>
     void
     AsciiDataBoundary<dim>::initialize(const std::set<types::boundary_id> &boundary_ids,
@@ -1871,6 +2515,11 @@ namespace aspect
                                             (components,
                                              this->scale_factor)));
 
+          next_lookups.insert(std::make_pair(boundary_id,
+                                             std_cxx14::make_unique<Utilities::AsciiDataLookup<dim-1>>
+                                             (components,
+                                              this->scale_factor)));
+
           // Set the first file number and load the first files
           current_file_number = first_data_file_number;
 
@@ -1916,6 +2565,47 @@ namespace aspect
                 end_time_dependence ();
             }
         }
+
+      // Start reading the files that follow the two we just loaded.
+      if (time_dependent)
+        prefetch_files ((decreasing_file_order) ?
+                        current_file_number - 2
+                        :
+                        current_file_number + 2);
+    }
+
+
+
+    template <int dim>
+    void
+    AsciiDataBoundary<dim>::prefetch_files (const int file_number)
+    {
+      // Find the file names and check for their existence here, because
+      // create_filename() may write to the screen. If one of the files does
+      // not exist, update_data() will notice that once it needs the file.
+      std::vector<std::pair<Utilities::AsciiDataLookup<dim-1> *, std::string> > files;
+      for (const auto &boundary_id : next_lookups)
+        {
+          const std::string filename (create_filename (file_number, boundary_id.first));
+          if (!Utilities::fexists(filename))
+            return;
+
+          files.emplace_back (boundary_id.second.get(), filename);
+        }
+
+      // Only the first process reads text files. Determine this here,
+      // because the background thread must not make any MPI calls.
+      const bool read_file_content =
+        (Utilities::MPI::this_mpi_process(this->get_mpi_communicator()) == 0);
+
+      next_files_prefetched = true;
+      prefetched_file_number = file_number;
+
+      prefetch_thread = Threads::new_thread (std::function<void ()>([files, read_file_content]()
+      {
+        for (const auto &file : files)
+          file.first->read_file(file.second, read_file_content);
+      }));
     }
 
 
@@ -2086,8 +2776,21 @@ namespace aspect
 
               const bool load_both_files = std::abs(current_file_number - old_file_number) >= 1;
 
+              // The files we need next may still be read in the background.
+              prefetch_thread.join ();
+
               for (const auto &boundary_id : lookups)
                 update_data(boundary_id.first, load_both_files);
+
+              next_files_prefetched = false;
+
+              // Start reading the files of the following interval, so that
+              // they are available once the model time gets there.
+              if (time_dependent)
+                prefetch_files ((decreasing_file_order) ?
+                                current_file_number - 2
+                                :
+                                current_file_number + 2);
             }
 
           time_weight = time_steps_since_start
@@ -2135,8 +2838,19 @@ namespace aspect
                         << filename << "." << std::endl << std::endl;
       if (Utilities::fexists(filename))
         {
-          lookups.find(boundary_id)->second.swap(old_lookups.find(boundary_id)->second);
-          lookups.find(boundary_id)->second->load_file(filename,this->get_mpi_communicator());
+          // If the file was already read in the background, we only need to
+          // distribute its content, and the current data becomes the old data.
+          if (next_files_prefetched && prefetched_file_number == next_file_number)
+            {
+              next_lookups.find(boundary_id)->second->distribute_file(this->get_mpi_communicator());
+              lookups.find(boundary_id)->second.swap(old_lookups.find(boundary_id)->second);
+              lookups.find(boundary_id)->second.swap(next_lookups.find(boundary_id)->second);
+            }
+          else
+            {
+              lookups.find(boundary_id)->second.swap(old_lookups.find(boundary_id)->second);
+              lookups.find(boundary_id)->second->load_file(filename,this->get_mpi_communicator());
+            }
         }
 
       // If next file does not exist, end time dependent part with current_time_step.
@@ -0,0 +1,162 @@
+#include <aspect/simulator.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+ * Decode the file particles.bin in the given directory with the help of
+ * particles.bin.index, and write the particles of every output step, sorted
+ * by their id, into a text file.
+ */
+void decode (const std::string &directory,
+             const std::string &output_filename)
+{
+  std::ofstream out (output_filename.c_str());
+
+  std::ifstream index ((directory + "/particles.bin.index").c_str());
+  std::ifstream data ((directory + "/particles.bin").c_str(), std::ios::binary);
+  if (!index || !data)
+    {
+      out << "Could not open the particle output in " << directory << std::endl;
+      return;
+    }
+
+  data.seekg (0, std::ios::end);
+  const std::uint64_t file_size = data.tellg();
+
+  // the record size is part of the comment at the top of the index
+  std::uint64_t record_size = 0;
+  std::uint64_t expected_file_size = 0;
+  std::string line;
+  while (std::getline (index, line))
+    {
+      if (line.find ("# one record of ") == 0)
+        {
+          std::istringstream s (line.substr (std::string("# one record of ").size()));
+          s >> record_size;
+          out << "# record size: " << record_size << " bytes" << std::endl;
+        }
+      if (line.size() == 0 || line[0] == '#')
+        continue;
+
+      unsigned int output_number;
+      double time;
+      std::uint64_t n_particles, offset;
+      std::istringstream s (line);
+      s >> output_number >> time >> n_particles >> offset;
+
+      out << "# output " << output_number << ", time " << time
+          << ", " << n_particles << " particles at byte " << offset << std::endl;
+
+      const unsigned int n_values = (record_size - sizeof(std::uint64_t)) / sizeof(double);
+      std::vector<std::pair<std::uint64_t, std::vector<double> > > records (n_particles);
+      data.seekg (offset);
+      for (unsigned int p=0; p<n_particles; ++p)
+        {
+          records[p].second.resize (n_values);
+          data.read (reinterpret_cast<char *>(&records[p].first), sizeof(std::uint64_t));
+          data.read (reinterpret_cast<char *>(records[p].second.data()), n_values * sizeof(double));
+        }
+      std::sort (records.begin(), records.end());
+
+      for (unsigned int p=0; p<n_particles; ++p)
+        {
+          out << records[p].first;
+          for (unsigned int i=0; i<n_values; ++i)
+            out << ' ' << records[p].second[i];
+          out << std::endl;
+        }
+
+      expected_file_size = offset + n_particles * record_size;
+    }
+
+  out << "# file size: " << file_size << " bytes, expected: "
+      << expected_file_size << " bytes" << std::endl;
+}
+
+
+/*
+ * Launch the following function when this plugin is created. Launch ASPECT
+ * twice to test the binary series output across checkpoint/resume and then
+ * terminate the outer ASPECT run.
+ */
+int f()
+{
+  std::cout << "* starting from beginning:" << std::endl;
+
+  // call ASPECT with "--" and pipe an existing input file into it.
+  int ret;
+  std::string command;
+
+  command = ("cd output-particle_output_binary_series ; "
+             "(cat " ASPECT_SOURCE_DIR "/tests/particle_output_binary_series.prm "
+             " ; "
+             " echo 'set Output directory = output1.tmp' "
+             " ; "
+             " rm -rf output1.tmp ; mkdir output1.tmp "
+             ") "
+             "| ../../aspect -- > /dev/null");
+  std::cout << "Executing the following command:\n"
+            << command
+            << std::endl;
+  ret = system (command.c_str());
+  if (ret!=0)
+    std::cout << "system() returned error " << ret << std::endl;
+
+  command = ("cd output-particle_output_binary_series ; "
+             " rm -rf output2.tmp ; mkdir output2.tmp ; "
+             " cp output1.tmp/restart* output2.tmp/ ; "
+             " cp -r output1.tmp/particles output2.tmp/");
+  std::cout << "Executing the following command:\n"
+            << command
+            << std::endl;
+  ret = system (command.c_str());
+  if (ret!=0)
+    std::cout << "system() returned error " << ret << std::endl;
+
+
+  std::cout << "* now resuming:" << std::endl;
+  command = ("cd output-particle_output_binary_series ; "
+             "(cat " ASPECT_SOURCE_DIR "/tests/particle_output_binary_series.prm "
+             " ; "
+             " echo 'set Output directory = output2.tmp' "
+             " ; "
+             " echo 'set Resume computation = true' "
+             " ; "
+             " echo 'set End time = 1.5' "
+             ") "
+             "| ../../aspect -- > /dev/null");
+  std::cout << "Executing the following command:\n"
+            << command
+            << std::endl;
+  ret = system (command.c_str());
+  if (ret!=0)
+    std::cout << "system() returned error " << ret << std::endl;
+
+  std::cout << "* now comparing:" << std::endl;
+
+  ret = system ("cd output-particle_output_binary_series ; "
+                "cp output1.tmp/particles/particles.bin.index particles.bin.index1;"
+                "cp output2.tmp/particles/particles.bin.index particles.bin.index2;"
+                "");
+  if (ret!=0)
+    std::cout << "system() returned error " << ret << std::endl;
+
+  decode ("output-particle_output_binary_series/output1.tmp/particles",
+          "output-particle_output_binary_series/particles.bin.txt1");
+  decode ("output-particle_output_binary_series/output2.tmp/particles",
+          "output-particle_output_binary_series/particles.bin.txt2");
+
+  // terminate current process:
+  exit (0);
+  return 42;
+}
+
+
+// run this function by initializing a global variable by it
+int i = f();
@@ -0,0 +1,179 @@
+/*
+  Copyright (C) 2019 by the authors of the ASPECT code.
+
+  This file is part of ASPECT.
+
+  ASPECT is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2, or (at your option)
+  any later version.
+
+  ASPECT is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with ASPECT; see the file LICENSE.  If not see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "common.h"
+#include <aspect/material_model/evaluation_cache.h>
+
+#include <deal.II/dofs/dof_handler.h>
+#include <deal.II/fe/fe_q.h>
+#include <deal.II/grid/grid_generator.h>
+#include <deal.II/grid/tria.h>
+
+#include <iterator>
+
+// Verify that the cache of material model evaluations returns stored
+// results only for identical inputs on the same cell in the same time step
+// and nonlinear iteration, that it forgets everything when the mesh
+// changes, and that it counts hits and misses correctly.
+
+namespace
+{
+  using namespace dealii;
+  using namespace aspect;
+
+  // A material model that counts how often it is evaluated and whose
+  // density is the temperature, so that the outputs identify the inputs.
+  template <int dim>
+  class CountingMaterial : public MaterialModel::Interface<dim>
+  {
+    public:
+      CountingMaterial ()
+        :
+        n_evaluations (0)
+      {}
+
+      void evaluate (const MaterialModel::MaterialModelInputs<dim> &in,
+                     MaterialModel::MaterialModelOutputs<dim> &out) const override
+      {
+        ++n_evaluations;
+        for (unsigned int q=0; q<in.temperature.size(); ++q)
+          {
+            out.viscosities[q] = 1e21;
+            out.densities[q] = in.temperature[q];
+            out.thermal_expansion_coefficients[q] = 3e-5;
+            out.specific_heat[q] = 1250.;
+            out.thermal_conductivities[q] = 4.7;
+            out.compressibilities[q] = 0.;
+            out.entropy_derivative_pressure[q] = 0.;
+            out.entropy_derivative_temperature[q] = 0.;
+          }
+      }
+
+      bool is_compressible () const override
+      {
+        return false;
+      }
+
+      double reference_viscosity () const override
+      {
+        return 1e21;
+      }
+
+      mutable unsigned int n_evaluations;
+  };
+}
+
+
+TEST_CASE("EvaluationCache hits, misses and invalidation")
+{
+  const int dim=2;
+  using namespace aspect::MaterialModel;
+
+  Triangulation<dim> triangulation;
+  GridGenerator::hyper_cube (triangulation);
+  triangulation.refine_global (1);
+
+  const FE_Q<dim> fe (1);
+  DoFHandler<dim> dof_handler (triangulation);
+  dof_handler.distribute_dofs (fe);
+
+  const CountingMaterial<dim> material_model;
+  EvaluationCache<dim> cache;
+  cache.reinit (triangulation.n_active_cells());
+
+  const unsigned int n_points = 3;
+  MaterialModelInputs<dim> in (n_points, 1);
+  for (unsigned int q=0; q<n_points; ++q)
+    {
+      in.position[q] = Point<dim>(0.1*q, 0.2);
+      in.temperature[q] = 1000. + q;
+      in.pressure[q] = 1e9;
+      in.composition[q][0] = 0.5;
+    }
+  in.current_cell = dof_handler.begin_active();
+
+  MaterialModelOutputs<dim> out (n_points, 1);
+
+  // the first evaluation is a miss, the second one a hit
+  cache.evaluate (material_model, in, out, 0, 0);
+  REQUIRE(material_model.n_evaluations == 1);
+  cache.evaluate (material_model, in, out, 0, 0);
+  REQUIRE(material_model.n_evaluations == 1);
+  REQUIRE(out.densities[2] == 1002.);
+  REQUIRE(cache.get_statistics() == std::make_pair(1ul, 1ul));
+
+  // another cell is a miss
+  in.current_cell = std::next(dof_handler.begin_active());
+  cache.evaluate (material_model, in, out, 0, 0);
+  REQUIRE(material_model.n_evaluations == 2);
+  in.current_cell = dof_handler.begin_active();
+
+  // a new nonlinear iteration is a miss, even with the same inputs
+  cache.evaluate (material_model, in, out, 0, 1);
+  REQUIRE(material_model.n_evaluations == 3);
+  cache.evaluate (material_model, in, out, 0, 1);
+  REQUIRE(material_model.n_evaluations == 3);
+
+  // so is a new time step
+  cache.evaluate (material_model, in, out, 1, 0);
+  REQUIRE(material_model.n_evaluations == 4);
+
+  // a changed solution vector leads to different inputs, which are a
+  // miss and produce the new outputs
+  in.temperature[2] = 2000.;
+  cache.evaluate (material_model, in, out, 1, 0);
+  REQUIRE(material_model.n_evaluations == 5);
+  REQUIRE(out.densities[2] == 2000.);
+
+  // switching back to the previous inputs is a hit, since several
+  // evaluations per cell are kept
+  in.temperature[2] = 1002.;
+  cache.evaluate (material_model, in, out, 1, 0);
+  REQUIRE(material_model.n_evaluations == 5);
+  REQUIRE(out.densities[2] == 1002.);
+
+  // inputs without strain rates are different from inputs with them
+  in.strain_rate.resize (0);
+  cache.evaluate (material_model, in, out, 1, 0);
+  REQUIRE(material_model.n_evaluations == 6);
+
+  REQUIRE(cache.get_statistics() == std::make_pair(3ul, 6ul));
+
+  // mesh refinement invalidates all entries but keeps the counters
+  triangulation.refine_global (1);
+  dof_handler.distribute_dofs (fe);
+  cache.reinit (triangulation.n_active_cells());
+  in.current_cell = dof_handler.begin_active();
+  cache.evaluate (material_model, in, out, 1, 0);
+  REQUIRE(material_model.n_evaluations == 7);
+  cache.evaluate (material_model, in, out, 1, 0);
+  REQUIRE(material_model.n_evaluations == 7);
+  REQUIRE(cache.get_statistics() == std::make_pair(4ul, 7ul));
+
+  cache.reset_statistics ();
+  REQUIRE(cache.get_statistics() == std::make_pair(0ul, 0ul));
+
+  // evaluations without a cell bypass the cache and are not counted
+  in.current_cell = DoFHandler<dim>::active_cell_iterator();
+  cache.evaluate (material_model, in, out, 1, 0);
+  cache.evaluate (material_model, in, out, 1, 0);
+  REQUIRE(material_model.n_evaluations == 9);
+  REQUIRE(cache.get_statistics() == std::make_pair(0ul, 0ul));
+}
@@ -0,0 +1,101 @@
+/*
+  Copyright (C) 2018 by the authors of the ASPECT code.
+
+  This file is part of ASPECT.
+
+  ASPECT is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; either version 2, or (at your option)
+  any later version.
+
+  ASPECT is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with ASPECT; see the file LICENSE.  If not see
+  <http://www.gnu.org/licenses/>.
+*/
+
+#include "common.h"
+#include <aspect/material_model/interface.h>
+
+#include <cmath>
+
+// Verify that the structure-of-arrays inputs and outputs used for the
+// batched evaluation of material models store every point in the
+// right lane, pad the last batch with valid values, and copy all
+// points back.
+
+TEST_CASE("MaterialModelBatchInputs and MaterialModelBatchOutputs")
+{
+  const int dim=2;
+
+  using namespace aspect::MaterialModel;
+  const unsigned int width = dealii::VectorizedArray<double>::n_array_elements;
+  const unsigned int n_points = 2*width+1;
+  const unsigned int n_comp = 2;
+
+  MaterialModelInputs<dim> in(n_points, n_comp);
+  for (unsigned int i=0; i<n_points; ++i)
+    {
+      in.temperature[i] = 1000. + i;
+      in.pressure[i] = 1e9 * i;
+      for (unsigned int c=0; c<n_comp; ++c)
+        in.composition[i][c] = 0.1 * (i+c);
+
+      in.strain_rate[i] = dealii::SymmetricTensor<2,dim>();
+      in.strain_rate[i][0][0] = 1e-15 * (i+1);
+      in.strain_rate[i][1][1] = -1e-15 * (i+1);
+    }
+
+  const MaterialModelBatchInputs<dim> batch_in (in);
+
+  REQUIRE(batch_in.n_points == n_points);
+  REQUIRE(batch_in.n_batches == 3);
+  REQUIRE(batch_in.composition.size() == n_comp);
+  REQUIRE(batch_in.strain_rate_invariant.size() == 3);
+
+  for (unsigned int batch=0; batch<batch_in.n_batches; ++batch)
+    for (unsigned int v=0; v<width; ++v)
+      {
+        const unsigned int i = std::min(batch*width+v, n_points-1);
+        REQUIRE(batch_in.temperature[batch][v] == in.temperature[i]);
+        REQUIRE(batch_in.pressure[batch][v] == in.pressure[i]);
+        for (unsigned int c=0; c<n_comp; ++c)
+          REQUIRE(batch_in.composition[c][batch][v] == in.composition[i][c]);
+        REQUIRE(batch_in.strain_rate_invariant[batch][v] == Approx(1e-15 * (i+1)));
+      }
+
+  MaterialModelBatchOutputs<dim> batch_out (batch_in);
+  for (unsigned int batch=0; batch<batch_in.n_batches; ++batch)
+    {
+      batch_out.viscosities[batch] = 1e21;
+      batch_out.densities[batch] = 3300. + batch;
+      batch_out.thermal_expansion_coefficients[batch] = 3e-5;
+      batch_out.specific_heat[batch] = 1250.;
+      batch_out.thermal_conductivities[batch] = 4.7;
+      batch_out.compressibilities[batch] = 0.;
+      batch_out.entropy_derivative_pressure[batch] = 0.;
+      batch_out.entropy_derivative_temperature[batch] = 0.;
+    }
+
+  MaterialModelOutputs<dim> out(n_points, n_comp);
+  batch_out.unpack (out, false);
+  for (unsigned int i=0; i<n_points; ++i)
+    {
+      REQUIRE(std::isnan(out.viscosities[i]));
+      REQUIRE(out.densities[i] == 3300. + i/width);
+      REQUIRE(out.thermal_conductivities[i] == 4.7);
+    }
+
+  batch_out.unpack (out, true);
+  for (unsigned int i=0; i<n_points; ++i)
+    REQUIRE(out.viscosities[i] == 1e21);
+
+  // without strain rates, no invariants are computed
+  in.strain_rate.resize(0);
+  const MaterialModelBatchInputs<dim> batch_in_no_strain_rate (in);
+  REQUIRE(batch_in_no_strain_rate.strain_rate_invariant.size() == 0);
+}
@@ -20,6 +20,8 @@
 
 #include "common.h"
 #include <aspect/utilities.h>
+#include <cstdio>
+#include <fstream>
 
 TEST_CASE("Utilities::weighted_p_norm_average")
 {
@@ -35,3 +37,85 @@ TEST_CASE("Utilities::weighted_p_norm_average")
     }
 
 }
+
+TEST_CASE("Utilities::real_spherical_harmonics")
+{
+  const unsigned int max_degree = 30;
+  const std::vector<double> thetas = {0.1, 0.7, 1.5, 2.9};
+  const std::vector<double> phis = {-2.0, 0.2, 3.0};
+
+  std::vector<double> cos_components;
+  std::vector<double> sin_components;
+
+  for (const double theta : thetas)
+    for (const double phi : phis)
+      {
+        aspect::Utilities::real_spherical_harmonics(max_degree, theta, phi,
+                                                    cos_components, sin_components);
+        REQUIRE(cos_components.size() == (max_degree+1)*(max_degree+2)/2);
+
+        for (unsigned int l = 0; l <= max_degree; ++l)
+          for (unsigned int m = 0; m <= l; ++m)
+            {
+              INFO("check l=" << l << ", m=" << m << ", theta=" << theta << ", phi=" << phi);
+              const std::pair<double,double> expected = aspect::Utilities::real_spherical_harmonic(l, m, theta, phi);
+              REQUIRE(cos_components[l*(l+1)/2+m] == Approx(expected.first).margin(1e-12));
+              REQUIRE(sin_components[l*(l+1)/2+m] == Approx(expected.second).margin(1e-12));
+            }
+      }
+}
+
+TEST_CASE("Utilities::AsciiDataLookup binary files")
+{
+  // remove the files written below when the test ends, also if one of
+  // the checks fails
+  struct RemoveFiles
+  {
+    ~RemoveFiles()
+    {
+      std::remove("ascii_data_lookup_test.txt");
+      std::remove("ascii_data_lookup_test.bin");
+    }
+  } remove_files;
+
+  {
+    std::ofstream file("ascii_data_lookup_test.txt");
+    file << "# POINTS: 3 2\n"
+         << "x y temperature composition\n"
+         << "0 0 1 10\n"
+         << "1 0 2 20\n"
+         << "3 0 3 30\n"
+         << "0 2 4 40\n"
+         << "1 2 5 50\n"
+         << "3 2 6 60\n";
+  }
+
+  aspect::Utilities::AsciiDataLookup<2> text_lookup(2.0);
+  text_lookup.load_file("ascii_data_lookup_test.txt", MPI_COMM_WORLD);
+  text_lookup.write_binary_file("ascii_data_lookup_test.bin");
+
+  aspect::Utilities::AsciiDataLookup<2> binary_lookup(2.0);
+  binary_lookup.load_file("ascii_data_lookup_test.bin", MPI_COMM_WORLD);
+
+  REQUIRE(binary_lookup.get_column_names() == text_lookup.get_column_names());
+  REQUIRE(binary_lookup.get_column_index_from_name("composition") == 1);
+  REQUIRE(binary_lookup.has_equidistant_coordinates() == false);
+  REQUIRE(binary_lookup.get_maximum_component_value(0) == Approx(12.0));
+  REQUIRE(binary_lookup.get_maximum_component_value(1) == Approx(120.0));
+
+  // points inside the grid, on its boundary, and outside of it
+  const std::vector<dealii::Point<2> > points = {dealii::Point<2>(0.5,1.0),
+                                                 dealii::Point<2>(2.0,0.5),
+                                                 dealii::Point<2>(3.0,2.0),
+                                                 dealii::Point<2>(-1.0,5.0)
+                                                };
+  const std::vector<double> expected_temperature = {2.0*3.0, 2.0*3.25, 2.0*6.0, 2.0*4.0};
+
+  for (unsigned int i=0; i<points.size(); ++i)
+    {
+      INFO("point i=" << i << ": ");
+      REQUIRE(text_lookup.get_data(points[i],0) == Approx(expected_temperature[i]));
+      REQUIRE(binary_lookup.get_data(points[i],0) == text_lookup.get_data(points[i],0));
+      REQUIRE(binary_lookup.get_data(points[i],1) == text_lookup.get_data(points[i],1));
+    }
+}